@@ -205,15 +205,18 @@ HEADERS += \
   src/fs/navdatabaseflags.h \
   src/fs/sc/connecthandler.h \
   src/fs/sc/datareaderthread.h \
+  src/fs/sc/replayfile.h \
   src/fs/sc/simconnectaircraft.h \
   src/fs/sc/simconnectapi.h \
   src/fs/sc/simconnectdata.h \
   src/fs/sc/simconnectdatabase.h \
+  src/fs/sc/simconnectdelta.h \
   src/fs/sc/simconnectdummy.h \
   src/fs/sc/simconnecthandler.h \
   src/fs/sc/simconnectreply.h \
   src/fs/sc/simconnecttypes.h \
   src/fs/sc/simconnectuseraircraft.h \
+  src/fs/sc/trafficgeneratorhandler.h \
   src/fs/sc/weatherrequest.h \
   src/fs/sc/xpconnecthandler.h \
   src/fs/scenery/aircraftindex.h \
@@ -242,24 +245,29 @@ HEADERS += \
   src/logging/logginghandler.h \
   src/logging/loggingtypes.h \
   src/logging/loggingutil.h \
+  src/logging/loggingwriter.h \
   src/settings/settings.h \
   src/util/average.h \
   src/util/csvreader.h \
+  src/util/dircache.h \
   src/util/filechecker.h \
   src/util/filesystemwatcher.h \
   src/util/flags.h \
   src/util/heap.h \
   src/util/httpdownloader.h \
+  src/util/parallel.h \
   src/util/properties.h \
   src/util/props.h \
   src/util/simplecrypt.h \
   src/util/str.h \
   src/util/timedcache.h \
   src/util/updatecheck.h \
+  src/util/varint.h \
   src/util/version.h \
   src/util/xmlstream.h \
   src/win/activationcontext.h \
   src/zip/gzip.h \
+  src/zip/gzipdevice.h \
   src/zip/zipreader.h \
   src/zip/zipwriter.h \
   src/zlib/crc32.h \
@@ -281,15 +289,18 @@ SOURCES += \
   src/fs/navdatabaseflags.cpp \
   src/fs/sc/connecthandler.cpp \
   src/fs/sc/datareaderthread.cpp \
+  src/fs/sc/replayfile.cpp \
   src/fs/sc/simconnectaircraft.cpp \
   src/fs/sc/simconnectapi.cpp \
   src/fs/sc/simconnectdata.cpp \
   src/fs/sc/simconnectdatabase.cpp \
+  src/fs/sc/simconnectdelta.cpp \
   src/fs/sc/simconnectdummy.cpp \
   src/fs/sc/simconnecthandler.cpp \
   src/fs/sc/simconnectreply.cpp \
   src/fs/sc/simconnecttypes.cpp \
   src/fs/sc/simconnectuseraircraft.cpp \
+  src/fs/sc/trafficgeneratorhandler.cpp \
   src/fs/sc/weatherrequest.cpp \
   src/fs/sc/xpconnecthandler.cpp \
   src/fs/scenery/aircraftindex.cpp \
@@ -315,9 +326,11 @@ SOURCES += \
   src/logging/loggingguiabort.cpp \
   src/logging/logginghandler.cpp \
   src/logging/loggingutil.cpp \
+  src/logging/loggingwriter.cpp \
   src/settings/settings.cpp \
   src/util/average.cpp \
   src/util/csvreader.cpp \
+  src/util/dircache.cpp \
   src/util/filechecker.cpp \
   src/util/filesystemwatcher.cpp \
   src/util/flags.cpp \
@@ -333,6 +346,7 @@ SOURCES += \
   src/util/xmlstream.cpp \
   src/win/activationcontext.cpp \
   src/zip/gzip.cpp \
+  src/zip/gzipdevice.cpp \
   src/zip/zip.cpp \
   src/zlib/adler32.c \
   src/zlib/compress.c \
@@ -371,6 +385,7 @@ SOURCES += \
 !isEqual(ATOOLS_NO_SQL, "true") {
 HEADERS += \
   src/sql/sqlcolumn.h \
+  src/sql/sqlcursor.h \
   src/sql/sqldatabase.h \
   src/sql/sqlexception.h \
   src/sql/sqlexport.h \
@@ -383,6 +398,7 @@ HEADERS += \
 
 SOURCES += \
   src/sql/sqlcolumn.cpp \
+  src/sql/sqlcursor.cpp \
   src/sql/sqldatabase.cpp \
   src/sql/sqlexception.cpp \
   src/sql/sqlexport.cpp \
@@ -535,6 +551,8 @@ HEADERS += \
   src/httpserver/httpconnectionhandler.h \
   src/httpserver/httpconnectionhandlerpool.h \
   src/httpserver/httpcookie.h \
+  src/httpserver/httpeventlooppool.h \
+  src/httpserver/httpeventstream.h \
   src/httpserver/httpglobal.h \
   src/httpserver/httplistener.h \
   src/httpserver/httprequest.h \
@@ -543,6 +561,7 @@ HEADERS += \
   src/httpserver/httpsession.h \
   src/httpserver/httpsessionstore.h \
   src/httpserver/staticfilecontroller.h \
+  src/templateengine/compiledtemplate.h \
   src/templateengine/template.h \
   src/templateengine/templatecache.h \
   src/templateengine/templateglobal.h \
@@ -552,6 +571,8 @@ SOURCES += \
   src/httpserver/httpconnectionhandler.cpp \
   src/httpserver/httpconnectionhandlerpool.cpp \
   src/httpserver/httpcookie.cpp \
+  src/httpserver/httpeventlooppool.cpp \
+  src/httpserver/httpeventstream.cpp \
   src/httpserver/httpglobal.cpp \
   src/httpserver/httplistener.cpp \
   src/httpserver/httprequest.cpp \
@@ -560,6 +581,7 @@ SOURCES += \
   src/httpserver/httpsession.cpp \
   src/httpserver/httpsessionstore.cpp \
   src/httpserver/staticfilecontroller.cpp \
+  src/templateengine/compiledtemplate.cpp \
   src/templateengine/template.cpp \
   src/templateengine/templatecache.cpp \
   src/templateengine/templateloader.cpp
@@ -623,8 +645,11 @@ HEADERS += \
   src/fs/bgl/surface.h \
   src/fs/bgl/util.h \
   src/fs/common/airportindex.h \
+  src/fs/common/airspaceindex.h \
   src/fs/common/binarygeometry.h \
+  src/fs/common/binarytrail.h \
   src/fs/common/binarymsageometry.h \
+  src/fs/common/fixindex.h \
   src/fs/common/globereader.h \
   src/fs/common/magdecreader.h \
   src/fs/common/metadatawriter.h \
@@ -776,8 +801,11 @@ SOURCES += \
   src/fs/bgl/surface.cpp \
   src/fs/bgl/util.cpp \
   src/fs/common/airportindex.cpp \
+  src/fs/common/airspaceindex.cpp \
   src/fs/common/binarygeometry.cpp \
+  src/fs/common/binarytrail.cpp \
   src/fs/common/binarymsageometry.cpp \
+  src/fs/common/fixindex.cpp \
   src/fs/common/globereader.cpp \
   src/fs/common/magdecreader.cpp \
   src/fs/common/metadatawriter.cpp \
@@ -72,7 +72,8 @@ create table logbook
   description varchar(2048) collate nocase,          -- Free text by user
   flightplan blob,                                   -- LNMPLN Gzipped XML file recorded on touchdown
   aircraft_perf blob,                                -- LNMPERF Gzipped XML file recorded on touchdown
-  aircraft_trail blob                                -- Gzipped GPX aircraft trail file recorded on touchdown
+  aircraft_trail blob,                               -- Gzipped GPX aircraft trail file recorded on touchdown
+  aircraft_trail_bin blob                            -- Compact binary version of aircraft_trail for fast drawing
 );
 
 create index if not exists idx_logbook_aircraft_name on logbook(aircraft_name);
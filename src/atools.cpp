@@ -17,6 +17,7 @@
 
 #include "atools.h"
 #include "exception.h"
+#include "util/dircache.h"
 #include "util/simplecrypt.h"
 
 #include <QDebug>
@@ -794,44 +795,18 @@ QString buildPathNoCase(const QStringList& paths)
       dir.setPath(path);
     else
     {
-      // Get entries that match exacly the next path element
-      QStringList entries = dir.entryList({path});
-
-      if(entries.isEmpty())
-      {
-        // Nothing found - do an expensive manual compare
-        bool found = false;
-        entries = dir.entryList();
-
-        for(const QString& str : qAsConst(entries))
-        {
-          if(str.compare(path, Qt::CaseInsensitive) == 0)
-          {
-            // Found something - use it as the single entry
-            entries.clear();
-            entries.append(str);
-            found = true;
-            break;
-          }
-        }
-
-        if(!found)
-          // Nothing found when searching case insensitive
-          entries.clear();
-      }
-
-      if(!entries.isEmpty())
+      // Look up the next path element in the cached directory listing ignoring case
+      QString entryName;
+      bool isDir = false;
+      if(atools::util::DirCache::findEntry(dir.path(), path, entryName, isDir))
       {
-        if(QFileInfo(dir.path() % SEP % entries.constFirst()).isDir())
-        {
+        if(isDir)
           // Directory exists - change into it
-          if(!dir.cd(entries.constFirst()))
-            break;
-        }
+          dir.setPath(dir.path() % SEP % entryName);
         else
         {
           // Is a file - add by name simply
-          file = entries.constFirst();
+          file = entryName;
           break;
         }
       }
@@ -204,7 +204,8 @@ QStringList wrapText(const QStringList& texts, const QFontMetrics& metrics, int
 QString elideTextLinesShort(QString str, int maxLines, int maxLength = 0, bool compressEmpty = false,
                             bool ellipseLastLine = true);
 
-/* Concatenates all paths parts with the QDir::separator() and fetches names correcting the case */
+/* Concatenates all paths parts with the QDir::separator() and fetches names correcting the case.
+ * Uses the process wide atools::util::DirCache to avoid listing directories repeatedly. */
 QString buildPathNoCase(const QStringList& paths);
 
 /* Simply concatenates all paths parts with the QDir::separator() */
@@ -0,0 +1,448 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/airspaceindex.h"
+
+#include "fs/common/binarygeometry.h"
+#include "geo/calculations.h"
+#include "geo/line.h"
+#include "geo/linestring.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlutil.h"
+
+#include <QElapsedTimer>
+#include <QStringBuilder>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+using atools::geo::Pos;
+using atools::geo::Line;
+using atools::geo::LineString;
+using atools::geo::Rect;
+
+/* Maximum number of children per R-tree node */
+static const int NODE_CAPACITY = 16;
+
+AirspaceIndex::AirspaceIndex()
+{
+
+}
+
+void AirspaceIndex::clear()
+{
+  entries.clear();
+  edges.clear();
+  items.clear();
+  levels.clear();
+}
+
+int AirspaceIndex::loadAirspaces(sql::SqlDatabase *db, int source, const QString& table, const QString& idColumn)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  atools::sql::SqlUtil util(db);
+  bool hasType = util.hasTableAndColumn(table, "type"), hasName = util.hasTableAndColumn(table, "name"),
+       hasAltitude = util.hasTableAndColumn(table, "min_altitude") && util.hasTableAndColumn(table, "max_altitude");
+
+  QStringList columns({idColumn, "geometry"});
+  if(hasType)
+    columns.append("type");
+  if(hasName)
+    columns.append("name");
+  if(hasAltitude)
+    columns << "min_altitude" << "max_altitude";
+
+  atools::sql::SqlQuery query(db);
+  query.exec("select " % columns.join(", ") % " from " % table % " where geometry is not null");
+
+  int num = 0;
+  while(query.next())
+  {
+    // Decode points directly from the BLOB without building a line string
+    BinaryGeometryView view(query.value("geometry").toByteArray());
+    if(!view.isValid())
+      continue;
+
+    int minAltitude = 0, maxAltitude = std::numeric_limits<int>::max();
+    if(hasAltitude)
+    {
+      if(!query.isNull("min_altitude"))
+        minAltitude = query.valueInt("min_altitude");
+      if(!query.isNull("max_altitude"))
+        maxAltitude = query.valueInt("max_altitude");
+    }
+
+    if(addPolygon(query.valueInt(idColumn), source, hasType ? query.valueStr("type") : QString(),
+                  hasName ? query.valueStr("name") : QString(), minAltitude, maxAltitude, view, view.boundingRect()))
+      num++;
+  }
+
+  qDebug() << Q_FUNC_INFO << "Loaded" << num << "airspaces from" << table << "in" << timer.elapsed() << "ms";
+  return num;
+}
+
+bool AirspaceIndex::addAirspace(int id, int source, const QString& type, const QString& name, int minAltitude,
+                                int maxAltitude, const geo::LineString& polygon)
+{
+  return addPolygon(id, source, type, name, minAltitude, maxAltitude, polygon, polygon.boundingRect());
+}
+
+template<typename CONTAINER>
+bool AirspaceIndex::addPolygon(int id, int source, const QString& type, const QString& name, int minAltitude,
+                               int maxAltitude, const CONTAINER& polygon, const geo::Rect& rect)
+{
+  if(polygon.size() < 3 || !rect.isValid())
+    return false;
+
+  AirspaceIndexEntry entry;
+  entry.id = id;
+  entry.source = source;
+  entry.type = type;
+  entry.name = name;
+  entry.minAltitude = minAltitude;
+  entry.maxAltitude = maxAltitude;
+  entry.bounding = rect;
+  entry.shifted = rect.crossesAntiMeridian();
+  entry.edgeOffset = edges.size();
+
+  // Unwrap western longitudes for polygons crossing the anti-meridian
+  auto lonX = [&entry](const Pos& pos) -> float {
+                float x = pos.getLonX();
+                return entry.shifted && x < 0.f ? x + 360.f : x;
+              };
+
+  float minX = std::numeric_limits<float>::max(), maxX = std::numeric_limits<float>::lowest(),
+        minY = minX, maxY = maxX;
+  bool first = true;
+  float firstX = 0.f, firstY = 0.f, lastX = 0.f, lastY = 0.f;
+  for(const Pos& pos : polygon)
+  {
+    float x = lonX(pos), y = pos.getLatY();
+    minX = std::min(minX, x);
+    maxX = std::max(maxX, x);
+    minY = std::min(minY, y);
+    maxY = std::max(maxY, y);
+
+    if(first)
+    {
+      firstX = x;
+      firstY = y;
+      first = false;
+    }
+    else
+      edges.append({lastX, lastY, x, y, y != lastY ? (x - lastX) / (y - lastY) : 0.f});
+    lastX = x;
+    lastY = y;
+  }
+
+  // Close polygon if needed
+  if(lastX != firstX || lastY != firstY)
+    edges.append({lastX, lastY, firstX, firstY, firstY != lastY ? (firstX - lastX) / (firstY - lastY) : 0.f});
+
+  entry.edgeCount = edges.size() - entry.edgeOffset;
+
+  int index = entries.size();
+  entries.append(entry);
+
+  // Add R-tree items - two if crossing the anti-meridian to keep query coordinates in the normal range
+  if(maxX > 180.f)
+  {
+    items.append({minX, minY, 180.f, maxY, index, 0});
+    items.append({-180.f, minY, maxX - 360.f, maxY, index, 0});
+  }
+  else
+    items.append({minX, minY, maxX, maxY, index, 0});
+
+  return true;
+}
+
+void AirspaceIndex::updateIndex()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  levels.clear();
+  entries.squeeze();
+  edges.squeeze();
+  items.squeeze();
+
+  // Build packed R-tree bottom up using sort tile recursive packing
+  auto centerX = [](const Box& box) -> float {
+                   return box.minX + box.maxX;
+                 };
+  auto centerY = [](const Box& box) -> float {
+                   return box.minY + box.maxY;
+                 };
+
+  QVector<Box> *children = &items;
+  QVector<QVector<Box> > bottomUp;
+  while(!children->isEmpty())
+  {
+    int numChildren = children->size();
+    int numNodes = (numChildren + NODE_CAPACITY - 1) / NODE_CAPACITY;
+    int numSlices = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(numNodes))));
+    int sliceSize = numSlices * NODE_CAPACITY;
+
+    // Sort into vertical slices and each slice by latitude
+    std::sort(children->begin(), children->end(), [ = ](const Box& b1, const Box& b2) {
+            return centerX(b1) < centerX(b2);
+          });
+    for(int i = 0; i < numChildren; i += sliceSize)
+      std::sort(children->begin() + i, children->begin() + std::min(i + sliceSize, numChildren),
+                [ = ](const Box& b1, const Box& b2) {
+            return centerY(b1) < centerY(b2);
+          });
+
+    QVector<Box> nodes;
+    nodes.reserve(numNodes);
+    for(int i = 0; i < numChildren; i += NODE_CAPACITY)
+    {
+      Box node = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                  std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), i, 0};
+      for(int j = i; j < std::min(i + NODE_CAPACITY, numChildren); j++)
+      {
+        const Box& child = children->at(j);
+        node.minX = std::min(node.minX, child.minX);
+        node.minY = std::min(node.minY, child.minY);
+        node.maxX = std::max(node.maxX, child.maxX);
+        node.maxY = std::max(node.maxY, child.maxY);
+        node.count++;
+      }
+      nodes.append(node);
+    }
+
+    bottomUp.append(nodes);
+    if(nodes.size() == 1)
+      break;
+    children = &bottomUp.last();
+  }
+
+  // Root level first
+  for(int i = bottomUp.size() - 1; i >= 0; i--)
+    levels.append(bottomUp.at(i));
+
+  qDebug() << Q_FUNC_INFO << entries.size() << "airspaces" << edges.size() << "edges"
+           << levels.size() << "levels in" << timer.elapsed() << "ms";
+}
+
+template<typename FUNC>
+void AirspaceIndex::searchBox(float minX, float minY, float maxX, float maxY, FUNC func) const
+{
+  if(levels.isEmpty())
+    return;
+
+  // Level and node index
+  QVarLengthArray<std::pair<int, int>, 64> stack;
+  stack.append(std::make_pair(0, 0));
+
+  while(!stack.isEmpty())
+  {
+    std::pair<int, int> top = stack.last();
+    stack.removeLast();
+
+    const Box& node = levels.at(top.first).at(top.second);
+    if(!node.overlaps(minX, minY, maxX, maxY))
+      continue;
+
+    int childLevel = top.first + 1;
+    for(int i = node.index; i < node.index + node.count; i++)
+    {
+      if(childLevel == levels.size())
+      {
+        const Box& item = items.at(i);
+        if(item.overlaps(minX, minY, maxX, maxY))
+          func(item.index);
+      }
+      else
+        stack.append(std::make_pair(childLevel, i));
+    }
+  }
+}
+
+bool AirspaceIndex::containsPoint(const AirspaceIndexEntry& entry, float x, float y) const
+{
+  // Ray casting using the precomputed slopes
+  bool inside = false;
+  const Edge *edge = edges.constData() + entry.edgeOffset, *end = edge + entry.edgeCount;
+  for(; edge < end; ++edge)
+  {
+    if((edge->y1 > y) != (edge->y2 > y) && x < edge->x1 + (y - edge->y1) * edge->slope)
+      inside = !inside;
+  }
+  return inside;
+}
+
+bool AirspaceIndex::crossesSegment(const AirspaceIndexEntry& entry, float x1, float y1, float x2, float y2) const
+{
+  if(containsPoint(entry, x1, y1) || containsPoint(entry, x2, y2))
+    return true;
+
+  float minX = std::min(x1, x2), maxX = std::max(x1, x2), minY = std::min(y1, y2), maxY = std::max(y1, y2);
+  float dx = x2 - x1, dy = y2 - y1;
+
+  const Edge *edge = edges.constData() + entry.edgeOffset, *end = edge + entry.edgeCount;
+  for(; edge < end; ++edge)
+  {
+    // Quick rejection using bounding boxes
+    if(std::max(edge->x1, edge->x2) < minX || std::min(edge->x1, edge->x2) > maxX ||
+       std::max(edge->y1, edge->y2) < minY || std::min(edge->y1, edge->y2) > maxY)
+      continue;
+
+    // Check if edge end points are on different sides of the segment and vice versa
+    float ex = edge->x2 - edge->x1, ey = edge->y2 - edge->y1;
+    float d1 = dx * (edge->y1 - y1) - dy * (edge->x1 - x1);
+    float d2 = dx * (edge->y2 - y1) - dy * (edge->x2 - x1);
+    float d3 = ex * (y1 - edge->y1) - ey * (x1 - edge->x1);
+    float d4 = ex * (y2 - edge->y1) - ey * (x2 - edge->x1);
+    if(((d1 <= 0.f && d2 >= 0.f) || (d1 >= 0.f && d2 <= 0.f)) && ((d3 <= 0.f && d4 >= 0.f) || (d3 >= 0.f && d4 <= 0.f)))
+      return true;
+  }
+  return false;
+}
+
+QVector<int> AirspaceIndex::getAirspacesAt(const geo::Pos& pos) const
+{
+  return getAirspacesAt(pos, std::numeric_limits<float>::quiet_NaN());
+}
+
+QVector<int> AirspaceIndex::getAirspacesAt(const geo::Pos& pos, float altitudeFt) const
+{
+  QVector<int> result;
+  if(!pos.isValid())
+    return result;
+
+  bool checkAltitude = !std::isnan(altitudeFt);
+  float x = pos.getLonX(), y = pos.getLatY();
+  searchBox(x, y, x, y, [&](int index) {
+          const AirspaceIndexEntry& entry = entries.at(index);
+          if(checkAltitude && (altitudeFt < entry.minAltitude || altitudeFt > entry.maxAltitude))
+            return;
+
+          if(containsPoint(entry, entry.shifted && x < 0.f ? x + 360.f : x, y))
+            result.append(index);
+        });
+
+  // Position on the anti-meridian can hit both items of an entry
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+QVector<int> AirspaceIndex::getAirspacesCrossing(const geo::Line& line, float minAltitudeFt, float maxAltitudeFt) const
+{
+  QVector<int> result;
+  collectCrossing(result, line, minAltitudeFt, maxAltitudeFt);
+  return result;
+}
+
+QVector<AirspaceLegHit> AirspaceIndex::getAirspacesForProfile(const geo::LineString& route,
+                                                              const QVector<float>& altitudesFt) const
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  bool checkAltitude = altitudesFt.size() == route.size();
+  if(!checkAltitude && !altitudesFt.isEmpty())
+    qWarning() << Q_FUNC_INFO << "Altitude and route size differ" << altitudesFt.size() << route.size();
+
+  QVector<AirspaceLegHit> hits;
+  QVector<int> legResult;
+  for(int i = 0; i < route.size() - 1; i++)
+  {
+    float minAlt = 0.f, maxAlt = std::numeric_limits<float>::max();
+    if(checkAltitude)
+    {
+      minAlt = std::min(altitudesFt.at(i), altitudesFt.at(i + 1));
+      maxAlt = std::max(altitudesFt.at(i), altitudesFt.at(i + 1));
+    }
+
+    legResult.clear();
+    collectCrossing(legResult, Line(route.at(i), route.at(i + 1)), minAlt, maxAlt);
+    for(int index : qAsConst(legResult))
+      hits.append({i, index});
+  }
+
+  qDebug() << Q_FUNC_INFO << route.size() << "positions" << hits.size() << "hits in" << timer.elapsed() << "ms";
+  return hits;
+}
+
+void AirspaceIndex::planarSegments(QVector<geo::Line>& segments, const geo::Line& line) const
+{
+  if(!line.isValid())
+    return;
+
+  // Follow the great circle for long legs
+  LineString positions;
+  float length = line.lengthMeter();
+  if(length > maxSegmentLengthMeter)
+  {
+    int numPoints = static_cast<int>(std::ceil(length / maxSegmentLengthMeter));
+    line.getPos1().interpolatePoints(line.getPos2(), length, numPoints, positions);
+  }
+  else
+    positions.append(line.getPos1());
+  positions.append(line.getPos2());
+
+  for(int i = 0; i < positions.size() - 1; i++)
+  {
+    const QList<Line> split = Line(positions.at(i), positions.at(i + 1)).splitAtAntiMeridian();
+    for(const Line& l : split)
+      segments.append(l);
+  }
+}
+
+void AirspaceIndex::collectCrossing(QVector<int>& result, const geo::Line& line, float minAltitudeFt,
+                                    float maxAltitudeFt) const
+{
+  QVector<Line> segments;
+  planarSegments(segments, line);
+
+  int start = result.size();
+  for(const Line& segment : qAsConst(segments))
+  {
+    float x1 = segment.getPos1().getLonX(), y1 = segment.getPos1().getLatY(),
+          x2 = segment.getPos2().getLonX(), y2 = segment.getPos2().getLatY();
+
+    searchBox(std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2), [&](int index) {
+            const AirspaceIndexEntry& entry = entries.at(index);
+            if(maxAltitudeFt < entry.minAltitude || minAltitudeFt > entry.maxAltitude)
+              return;
+
+            // Segments are split at the anti-meridian and are therefore entirely west or east
+            bool shift = entry.shifted && x1 <= 0.f && x2 <= 0.f;
+            if(crossesSegment(entry, shift ? x1 + 360.f : x1, y1, shift ? x2 + 360.f : x2, y2))
+              result.append(index);
+          });
+  }
+
+  // Remove duplicates from several segments or anti-meridian items
+  std::sort(result.begin() + start, result.end());
+  result.erase(std::unique(result.begin() + start, result.end()), result.end());
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,195 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_AIRSPACEINDEX_H
+#define ATOOLS_AIRSPACEINDEX_H
+
+#include "geo/rect.h"
+
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class LineString;
+class Line;
+}
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace common {
+
+/* Airspace stored in the index. Source is a caller defined value to separate
+ * sim, navdata, user and online airspaces which can have overlapping ids. */
+struct AirspaceIndexEntry
+{
+  int id, source;
+  QString type, name;
+
+  /* Altitude band in feet. Unknown lower limit is ground and unknown upper limit is unlimited. */
+  int minAltitude, maxAltitude;
+
+  /* Bounding rectangle in original coordinates */
+  atools::geo::Rect bounding;
+
+  /* Polygon crosses the anti-meridian. Western longitudes are shifted by 360 degrees for all calculations then. */
+  bool shifted;
+
+  /* Range of this airspace polygon in AirspaceIndex::edges */
+  int edgeOffset, edgeCount;
+};
+
+/* Result of a batch route profile query */
+struct AirspaceLegHit
+{
+  /* Index of leg from position legIndex to legIndex + 1 in the route */
+  int legIndex;
+
+  /* Index into the entries of AirspaceIndex. Use AirspaceIndex::at() to get the airspace. */
+  int entryIndex;
+};
+
+/*
+ * In-memory index for airspace polygons answering which airspaces contain a position at an altitude or
+ * which airspaces are crossed by a route leg.
+ *
+ * Uses a packed R-tree (sort tile recursive) over the bounding rectangles and a flat edge list
+ * with precomputed slopes for polygon tests. Polygons crossing the anti-meridian are unwrapped.
+ *
+ * Coordinates are treated as planar longitude/latitude as done for map display.
+ * Long legs are densified along the great circle before testing.
+ *
+ * Add airspaces with addAirspace() or loadAirspaces() and call updateIndex() before querying.
+ * Not thread safe while loading. Queries on a built index can be run in parallel.
+ */
+class AirspaceIndex
+{
+public:
+  AirspaceIndex();
+
+  /* Loads all airspaces from the given table which must have the columns of the boundary table.
+   * Missing altitude, type or name columns as in the online atc table are accepted.
+   * Returns number of airspaces added. */
+  int loadAirspaces(atools::sql::SqlDatabase *db, int source, const QString& table = "boundary",
+                    const QString& idColumn = "boundary_id");
+
+  /* Add a single airspace. Returns false if geometry is not a valid polygon. Use INT_MAX for unlimited. */
+  bool addAirspace(int id, int source, const QString& type, const QString& name, int minAltitude, int maxAltitude,
+                   const atools::geo::LineString& polygon);
+
+  /* Build the R-tree. Call this after adding airspaces. */
+  void updateIndex();
+
+  void clear();
+
+  /* Indexes of all airspaces containing pos at the given altitude in feet */
+  QVector<int> getAirspacesAt(const atools::geo::Pos& pos, float altitudeFt) const;
+
+  /* As above but ignore altitude */
+  QVector<int> getAirspacesAt(const atools::geo::Pos& pos) const;
+
+  /* Indexes of all airspaces touched by the great circle line where the altitude band overlaps
+   * the range from minAltitudeFt to maxAltitudeFt. */
+  QVector<int> getAirspacesCrossing(const atools::geo::Line& line, float minAltitudeFt, float maxAltitudeFt) const;
+
+  /* Batch query for a full route profile. Altitudes has the altitude in feet for each position in route.
+   * Each leg is checked against the altitude range covered by its start and end altitude.
+   * Results are ordered by leg. */
+  QVector<AirspaceLegHit> getAirspacesForProfile(const atools::geo::LineString& route,
+                                                 const QVector<float>& altitudesFt) const;
+
+  const AirspaceIndexEntry& at(int index) const
+  {
+    return entries.at(index);
+  }
+
+  int size() const
+  {
+    return entries.size();
+  }
+
+  bool isEmpty() const
+  {
+    return entries.isEmpty();
+  }
+
+  /* Maximum segment length before a leg is split into great circle sections */
+  void setMaxSegmentLengthMeter(float value)
+  {
+    maxSegmentLengthMeter = value;
+  }
+
+private:
+  /* Precomputed edge with slope dx/dy for crossing test */
+  struct Edge
+  {
+    float x1, y1, x2, y2, slope;
+  };
+
+  /* Box in unwrapped coordinates. Either an R-tree node or a leaf item. */
+  struct Box
+  {
+    float minX, minY, maxX, maxY;
+
+    /* Leaf: entry index. Inner node: first child index in next level nodes. */
+    int index;
+
+    /* Number of children for inner nodes. 0 for leaf items. */
+    int count;
+
+    bool overlaps(float x1, float y1, float x2, float y2) const
+    {
+      return minX <= x2 && maxX >= x1 && minY <= y2 && maxY >= y1;
+    }
+  };
+
+  /* Adds polygon from any container of positions like LineString or BinaryGeometryView */
+  template<typename CONTAINER>
+  bool addPolygon(int id, int source, const QString& type, const QString& name, int minAltitude, int maxAltitude,
+                  const CONTAINER& polygon, const atools::geo::Rect& rect);
+
+  /* Call func with entry index for all items overlapping the box */
+  template<typename FUNC>
+  void searchBox(float minX, float minY, float maxX, float maxY, FUNC func) const;
+
+  bool containsPoint(const AirspaceIndexEntry& entry, float x, float y) const;
+  bool crossesSegment(const AirspaceIndexEntry& entry, float x1, float y1, float x2, float y2) const;
+
+  /* Splits line into short planar segments not crossing the anti-meridian */
+  void planarSegments(QVector<atools::geo::Line>& segments, const atools::geo::Line& line) const;
+
+  void collectCrossing(QVector<int>& result, const atools::geo::Line& line, float minAltitudeFt,
+                       float maxAltitudeFt) const;
+
+  QVector<AirspaceIndexEntry> entries;
+  QVector<Edge> edges;
+
+  /* Leaf items - one or two per entry */
+  QVector<Box> items;
+
+  /* Node levels from root (index 0) down to the level above the leaf items */
+  QVector<QVector<Box> > levels;
+
+  float maxSegmentLengthMeter = 100000.f;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_AIRSPACEINDEX_H
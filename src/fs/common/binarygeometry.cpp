@@ -17,12 +17,67 @@
 
 #include "fs/common/binarygeometry.h"
 
-#include <QDataStream>
+#include "util/varint.h"
+
+#include <QDebug>
+#include <QtEndian>
+#include <cstring>
 
 namespace atools {
 namespace fs {
 namespace common {
 
+namespace {
+
+/* Header for the compact format. First byte can never appear in the legacy format
+ * since it would mean more than four billion points in the big endian count. */
+const quint8 MAGIC[] = {0xff, 'G', 'B'};
+const quint8 VERSION = 2;
+const quint8 FLAG_RECT = 1;
+
+/* Size of magic, version and flags */
+const int HEADER_SIZE = sizeof(MAGIC) + 2;
+
+/* Four floats for west, north, east and south */
+const int RECT_SIZE = 4 * sizeof(float);
+
+/* Quantization to micro degrees - about ten centimeters */
+const double COORD_FACTOR = 1.e6;
+
+/* Legacy format has big endian quint32 count and two big endian floats per point */
+const int LEGACY_POINT_SIZE = 2 * sizeof(float);
+
+void writeFloat(QByteArray& bytes, float value)
+{
+  quint32 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  bits = qToLittleEndian(bits);
+  bytes.append(reinterpret_cast<const char *>(&bits), sizeof(bits));
+}
+
+float readFloatLittleEndian(const quint8 *ptr)
+{
+  quint32 bits = qFromLittleEndian<quint32>(ptr);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+float readFloatBigEndian(const quint8 *ptr)
+{
+  quint32 bits = qFromBigEndian<quint32>(ptr);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+bool isCompactFormat(const quint8 *ptr, int size)
+{
+  return size >= HEADER_SIZE && std::memcmp(ptr, MAGIC, sizeof(MAGIC)) == 0 && ptr[sizeof(MAGIC)] == VERSION;
+}
+
+} // namespace
+
 BinaryGeometry::BinaryGeometry(const geo::LineString& value)
   : geometry(value)
 {
@@ -41,35 +96,144 @@ BinaryGeometry::BinaryGeometry()
 
 void BinaryGeometry::readFromByteArray(const QByteArray& bytes)
 {
-  geometry.clear();
-
-  QDataStream in(bytes);
-  in.setVersion(QDataStream::Qt_5_5);
-  in.setFloatingPointPrecision(QDataStream::SinglePrecision);
-
-  quint32 size;
-  float lonx, laty;
-  in >> size;
-  for(unsigned int i = 0; i < size; i++)
-  {
-    in >> lonx >> laty;
-    geometry.append(lonx, laty);
-  }
+  geometry = BinaryGeometryView(bytes).toLineString();
 }
 
 QByteArray BinaryGeometry::writeToByteArray() const
 {
   QByteArray bytes;
-  QDataStream out(&bytes, QIODevice::WriteOnly);
-  out.setVersion(QDataStream::Qt_5_5);
-  out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  // Header, rectangle and a few bytes per point
+  bytes.reserve(HEADER_SIZE + RECT_SIZE + 5 + geometry.size() * 6);
 
-  out << static_cast<quint32>(geometry.size());
+  bytes.append(reinterpret_cast<const char *>(MAGIC), sizeof(MAGIC));
+  bytes.append(static_cast<char>(VERSION));
+
+  // Calculate once here since the anti-meridian aware calculation needs all points
+  atools::geo::Rect rect = geometry.boundingRect();
+  bytes.append(static_cast<char>(rect.isValid() ? FLAG_RECT : 0));
+  if(rect.isValid())
+  {
+    writeFloat(bytes, rect.getWest());
+    writeFloat(bytes, rect.getNorth());
+    writeFloat(bytes, rect.getEast());
+    writeFloat(bytes, rect.getSouth());
+  }
+
+  atools::util::varint::write(bytes, static_cast<quint64>(geometry.size()));
+  qint64 lastLon = 0, lastLat = 0;
   for(const atools::geo::Pos& pos : qAsConst(geometry))
-    out << pos.getLonX() << pos.getLatY();
+  {
+    qint64 lon = qRound64(pos.getLonX() * COORD_FACTOR), lat = qRound64(pos.getLatY() * COORD_FACTOR);
+    atools::util::varint::writeSigned(bytes, lon - lastLon);
+    atools::util::varint::writeSigned(bytes, lat - lastLat);
+    lastLon = lon;
+    lastLat = lat;
+  }
   return bytes;
 }
 
+// ===========================================================================
+BinaryGeometryView::BinaryGeometryView(const QByteArray& bytes)
+  : data(bytes)
+{
+  const quint8 *ptr = reinterpret_cast<const quint8 *>(data.constData());
+  dataEnd = ptr + data.size();
+
+  if(isCompactFormat(ptr, data.size()))
+  {
+    compact = true;
+    quint8 flags = ptr[HEADER_SIZE - 1];
+    ptr += HEADER_SIZE;
+
+    if(flags & FLAG_RECT)
+    {
+      if(dataEnd - ptr < RECT_SIZE)
+        return;
+
+      rect = atools::geo::Rect(readFloatLittleEndian(ptr), readFloatLittleEndian(ptr + 4),
+                               readFloatLittleEndian(ptr + 8), readFloatLittleEndian(ptr + 12));
+      ptr += RECT_SIZE;
+    }
+
+    bool ok = true;
+    quint64 num = atools::util::varint::read(ptr, dataEnd, ok);
+
+    // Each point needs at least two bytes
+    if(ok && num <= static_cast<quint64>(dataEnd - ptr) / 2)
+    {
+      numPoints = static_cast<int>(num);
+      pointsStart = ptr;
+      valid = true;
+    }
+  }
+  else if(data.size() >= static_cast<int>(sizeof(quint32)))
+  {
+    quint32 num = qFromBigEndian<quint32>(ptr);
+    ptr += sizeof(quint32);
+
+    if(num <= static_cast<quint64>(dataEnd - ptr) / LEGACY_POINT_SIZE)
+    {
+      numPoints = static_cast<int>(num);
+      pointsStart = ptr;
+      valid = true;
+    }
+  }
+
+  if(!valid)
+    qWarning() << Q_FUNC_INFO << "Invalid geometry data of size" << data.size();
+}
+
+atools::geo::Rect BinaryGeometryView::boundingRect() const
+{
+  if(compact)
+    return rect;
+  else
+    return toLineString().boundingRect();
+}
+
+atools::geo::LineString BinaryGeometryView::toLineString() const
+{
+  atools::geo::LineString line;
+  line.reserve(numPoints);
+  for(const atools::geo::Pos& pos : *this)
+    line.append(pos);
+  return line;
+}
+
+BinaryGeometryView::const_iterator::const_iterator(const BinaryGeometryView *viewParam, int indexParam)
+  : view(viewParam), ptr(viewParam->pointsStart), index(indexParam)
+{
+  if(index == 0)
+    decode();
+}
+
+void BinaryGeometryView::const_iterator::decode()
+{
+  if(index >= view->numPoints)
+    return;
+
+  if(view->compact)
+  {
+    bool ok = true;
+    lon += atools::util::varint::readSigned(ptr, view->dataEnd, ok);
+    lat += atools::util::varint::readSigned(ptr, view->dataEnd, ok);
+
+    if(ok)
+      pos = atools::geo::Pos(static_cast<double>(lon) / COORD_FACTOR, static_cast<double>(lat) / COORD_FACTOR);
+    else
+    {
+      // Truncated data - stop iteration
+      qWarning() << Q_FUNC_INFO << "Truncated geometry data";
+      index = view->numPoints;
+    }
+  }
+  else
+  {
+    pos = atools::geo::Pos(readFloatBigEndian(ptr), readFloatBigEndian(ptr + 4));
+    ptr += LEGACY_POINT_SIZE;
+  }
+}
+
 } // namespace common
 } // namespace fs
 } // namespace atools
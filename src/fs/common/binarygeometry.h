@@ -19,8 +19,9 @@
 #define ATOOLS_BINARYGEOMETRY_H
 
 #include "geo/linestring.h"
+#include "geo/rect.h"
 
-class QByteArray;
+#include <QByteArray>
 
 namespace atools {
 namespace fs {
@@ -29,8 +30,12 @@ namespace common {
 /*
  * FSX/P3D geometry for common use in database and client code.
  *
- * Writes a simple lat/long (not altitude) list in single floating point precision into a byte array which can be used
+ * Writes a simple lat/long (not altitude) list into a byte array which can be used
  * to write and read it into and from a database BLOB.
+ *
+ * Current format (version 2) is a small header with magic, version, flags and the bounding rectangle followed by a
+ * varint point count and zigzag varint delta encoded coordinates in micro degrees.
+ * The legacy format (big endian point count and single precision float pairs) is still read.
  */
 class BinaryGeometry
 {
@@ -65,6 +70,106 @@ private:
   atools::geo::LineString geometry;
 };
 
+/*
+ * Read only view on a geometry BLOB which decodes positions on the fly while iterating without
+ * building a line string. Keeps an implicitly shared copy of the byte array.
+ * Bounding rectangle is available without decoding points for the version 2 format.
+ */
+class BinaryGeometryView
+{
+public:
+  explicit BinaryGeometryView(const QByteArray& bytes);
+
+  /* Forward iterator decoding one position per step */
+  class const_iterator
+  {
+public:
+    const atools::geo::Pos& operator*() const
+    {
+      return pos;
+    }
+
+    const atools::geo::Pos *operator->() const
+    {
+      return &pos;
+    }
+
+    const_iterator& operator++()
+    {
+      index++;
+      decode();
+      return *this;
+    }
+
+    bool operator==(const const_iterator& other) const
+    {
+      return index == other.index;
+    }
+
+    bool operator!=(const const_iterator& other) const
+    {
+      return index != other.index;
+    }
+
+private:
+    friend class BinaryGeometryView;
+    const_iterator(const BinaryGeometryView *viewParam, int indexParam);
+
+    void decode();
+
+    const BinaryGeometryView *view;
+    const quint8 *ptr = nullptr;
+    int index;
+    qint64 lon = 0, lat = 0;
+    atools::geo::Pos pos;
+  };
+
+  const_iterator begin() const
+  {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(this, numPoints);
+  }
+
+  /* false if data is truncated or otherwise invalid */
+  bool isValid() const
+  {
+    return valid;
+  }
+
+  int size() const
+  {
+    return numPoints;
+  }
+
+  bool isEmpty() const
+  {
+    return numPoints == 0;
+  }
+
+  /* true if data uses the compact version 2 format */
+  bool isCompact() const
+  {
+    return compact;
+  }
+
+  /* Stored rectangle for version 2 or calculated one for legacy format */
+  atools::geo::Rect boundingRect() const;
+
+  /* Decode all positions */
+  atools::geo::LineString toLineString() const;
+
+private:
+  QByteArray data;
+  const quint8 *pointsStart = nullptr, *dataEnd = nullptr;
+  int numPoints = 0;
+  bool valid = false, compact = false;
+  atools::geo::Rect rect;
+};
+
 } // namespace common
 } // namespace fs
 } // namespace atools
@@ -0,0 +1,286 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/binarytrail.h"
+
+#include "util/varint.h"
+
+#include <QByteArray>
+#include <QDebug>
+
+#include <cstring>
+
+namespace atools {
+namespace fs {
+namespace common {
+
+/* Format identifier and version */
+static const char MAGIC[] = {'A', 'T', 'R', 'L'};
+static const quint8 VERSION = 1;
+
+/* Flags in header */
+static const quint8 FLAG_ALTITUDE = 0x01, FLAG_TIMESTAMPS = 0x02, FLAG_ROUTE_NAMES = 0x04;
+
+/* Degree to stored integer */
+static const double COORD_FACTOR = 100000.;
+
+/* Header is magic, version and flags */
+static const int HEADER_SIZE = sizeof(MAGIC) + 2;
+
+// Writing ===========================================================================
+namespace {
+
+using atools::util::varint::write;
+using atools::util::varint::writeSigned;
+
+/* Writes number of points and delta encoded coordinates and altitude */
+void writeLine(QByteArray& bytes, const atools::geo::LineString& line, bool altitude)
+{
+  write(bytes, static_cast<quint64>(line.size()));
+
+  qint64 lastLon = 0, lastLat = 0, lastAlt = 0;
+  for(const atools::geo::Pos& pos : line)
+  {
+    qint64 lon = qRound64(pos.getLonX() * COORD_FACTOR), lat = qRound64(pos.getLatY() * COORD_FACTOR);
+    writeSigned(bytes, lon - lastLon);
+    writeSigned(bytes, lat - lastLat);
+    lastLon = lon;
+    lastLat = lat;
+
+    if(altitude)
+    {
+      qint64 alt = qRound64(pos.getAltitude());
+      writeSigned(bytes, alt - lastAlt);
+      lastAlt = alt;
+    }
+  }
+}
+
+// Reading ===========================================================================
+/* Simple bounds checked reader for varints */
+class Reader
+{
+public:
+  Reader(const QByteArray& bytes, int offset)
+    : pos(reinterpret_cast<const quint8 *>(bytes.constData()) + offset),
+    end(reinterpret_cast<const quint8 *>(bytes.constData()) + bytes.size())
+  {
+  }
+
+  quint64 readVarint()
+  {
+    return atools::util::varint::read(pos, end, ok);
+  }
+
+  qint64 readSigned()
+  {
+    return atools::util::varint::readSigned(pos, end, ok);
+  }
+
+  /* Read a size value and check it against the remaining bytes to avoid huge allocations for broken data */
+  int readSize()
+  {
+    quint64 value = readVarint();
+    if(value > static_cast<quint64>(end - pos))
+    {
+      ok = false;
+      return 0;
+    }
+    return static_cast<int>(value);
+  }
+
+  QString readString()
+  {
+    int len = readSize();
+    if(!ok)
+      return QString();
+
+    QString str = QString::fromUtf8(reinterpret_cast<const char *>(pos), len);
+    pos += len;
+    return str;
+  }
+
+  void readLine(atools::geo::LineString& line, bool altitude)
+  {
+    int num = readSize();
+    line.reserve(num);
+
+    qint64 lon = 0, lat = 0, alt = 0;
+    for(int i = 0; i < num && ok; i++)
+    {
+      lon += readSigned();
+      lat += readSigned();
+      if(altitude)
+        alt += readSigned();
+
+      line.append(atools::geo::Pos(static_cast<double>(lon) / COORD_FACTOR, static_cast<double>(lat) / COORD_FACTOR,
+                                   static_cast<double>(alt)));
+    }
+  }
+
+  bool ok = true;
+
+private:
+  const quint8 *pos, *end;
+};
+
+} // namespace
+
+// ===========================================================================
+BinaryTrail::BinaryTrail()
+{
+
+}
+
+BinaryTrail::BinaryTrail(const QByteArray& bytes, bool loadTimestamps)
+{
+  readFromByteArray(bytes, loadTimestamps);
+}
+
+void BinaryTrail::clear()
+{
+  route.clear();
+  routeNames.clear();
+  tracks.clear();
+  timestampsMs.clear();
+  valid = false;
+}
+
+bool BinaryTrail::isBinaryTrail(const QByteArray& bytes)
+{
+  return bytes.size() >= HEADER_SIZE && memcmp(bytes.constData(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool BinaryTrail::readFromByteArray(const QByteArray& bytes, bool loadTimestamps)
+{
+  clear();
+
+  if(!isBinaryTrail(bytes))
+    return false;
+
+  quint8 version = static_cast<quint8>(bytes.at(sizeof(MAGIC)));
+  quint8 flags = static_cast<quint8>(bytes.at(sizeof(MAGIC) + 1));
+
+  if(version > VERSION)
+  {
+    qWarning() << Q_FUNC_INFO << "Unsupported version" << version;
+    return false;
+  }
+
+  bool altitude = flags & FLAG_ALTITUDE, timestamps = flags & FLAG_TIMESTAMPS;
+  Reader reader(bytes, HEADER_SIZE);
+
+  // Route and names ===================
+  reader.readLine(route, altitude);
+  if(flags & FLAG_ROUTE_NAMES)
+  {
+    for(int i = 0; i < route.size() && reader.ok; i++)
+      routeNames.append(reader.readString());
+  }
+
+  // Tracks and optional timestamps ===================
+  int numTracks = reader.readSize();
+  tracks.reserve(numTracks);
+  for(int i = 0; i < numTracks && reader.ok; i++)
+  {
+    tracks.append(atools::geo::LineString());
+    atools::geo::LineString& track = tracks.last();
+    reader.readLine(track, altitude);
+
+    if(timestamps)
+    {
+      QVector<qint64> times;
+      if(loadTimestamps)
+        times.reserve(track.size());
+
+      qint64 time = 0;
+      for(int j = 0; j < track.size() && reader.ok; j++)
+      {
+        time += reader.readSigned();
+        if(loadTimestamps)
+          times.append(time);
+      }
+
+      if(loadTimestamps)
+        timestampsMs.append(times);
+    }
+  }
+
+  if(!reader.ok)
+  {
+    qWarning() << Q_FUNC_INFO << "Binary trail is truncated or broken";
+    clear();
+    return false;
+  }
+
+  valid = true;
+  return true;
+}
+
+QByteArray BinaryTrail::writeToByteArray(bool saveAltitude, bool saveTimestamps) const
+{
+  // Timestamps have to match all tracks
+  if(saveTimestamps)
+  {
+    saveTimestamps = !timestampsMs.isEmpty() && timestampsMs.size() == tracks.size();
+    for(int i = 0; i < tracks.size() && saveTimestamps; i++)
+      saveTimestamps = timestampsMs.at(i).size() == tracks.at(i).size();
+  }
+
+  bool saveNames = !routeNames.isEmpty() && routeNames.size() == route.size();
+
+  QByteArray bytes;
+  bytes.append(MAGIC, sizeof(MAGIC));
+  bytes.append(static_cast<char>(VERSION));
+  bytes.append(static_cast<char>((saveAltitude ? FLAG_ALTITUDE : 0) | (saveTimestamps ? FLAG_TIMESTAMPS : 0) |
+                                 (saveNames ? FLAG_ROUTE_NAMES : 0)));
+
+  // Route and names ===================
+  writeLine(bytes, route, saveAltitude);
+  if(saveNames)
+  {
+    for(const QString& name : routeNames)
+    {
+      QByteArray utf8 = name.toUtf8();
+      write(bytes, static_cast<quint64>(utf8.size()));
+      bytes.append(utf8);
+    }
+  }
+
+  // Tracks and optional timestamps ===================
+  write(bytes, static_cast<quint64>(tracks.size()));
+  for(int i = 0; i < tracks.size(); i++)
+  {
+    writeLine(bytes, tracks.at(i), saveAltitude);
+
+    if(saveTimestamps)
+    {
+      qint64 lastTime = 0;
+      for(qint64 time : timestampsMs.at(i))
+      {
+        writeSigned(bytes, time - lastTime);
+        lastTime = time;
+      }
+    }
+  }
+
+  return bytes;
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
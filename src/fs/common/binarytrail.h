@@ -0,0 +1,121 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_BINARYTRAIL_H
+#define ATOOLS_BINARYTRAIL_H
+
+#include "geo/linestring.h"
+
+#include <QStringList>
+
+class QByteArray;
+
+namespace atools {
+namespace fs {
+namespace common {
+
+/*
+ * Compact binary encoding for a flight plan route with waypoint names and aircraft trail tracks as used by the logbook.
+ *
+ * Coordinates are stored with a resolution of 0.00001 degree as zigzag varints containing the delta to the previous
+ * point. Altitude is stored the same way in feet. Timestamps in milliseconds since epoch are optional.
+ *
+ * Can be decoded quickly without decompression or XML parsing.
+ */
+class BinaryTrail
+{
+public:
+  BinaryTrail();
+
+  /* Reads from byte array. Check isValid() for errors. */
+  BinaryTrail(const QByteArray& bytes, bool loadTimestamps = true);
+
+  /* Returns false if the byte array is not valid. Timestamps are skipped if loadTimestamps is false. */
+  bool readFromByteArray(const QByteArray& bytes, bool loadTimestamps = true);
+
+  /* Timestamps are only written if they match the tracks */
+  QByteArray writeToByteArray(bool saveAltitude = true, bool saveTimestamps = true) const;
+
+  /* true if byte array starts with the format identifier */
+  static bool isBinaryTrail(const QByteArray& bytes);
+
+  /* true if reading was successful */
+  bool isValid() const
+  {
+    return valid;
+  }
+
+  /* Flight plan waypoints */
+  const atools::geo::LineString& getRoute() const
+  {
+    return route;
+  }
+
+  /* Flight plan waypoint names. Either empty or same size as route. */
+  const QStringList& getRouteNames() const
+  {
+    return routeNames;
+  }
+
+  /* Trail segments */
+  const QVector<atools::geo::LineString>& getTracks() const
+  {
+    return tracks;
+  }
+
+  /* Milliseconds since epoch for each track point. Empty if not loaded or not available. */
+  const QVector<QVector<qint64> >& getTimestampsMs() const
+  {
+    return timestampsMs;
+  }
+
+  /* Direct access for readers like FlightplanIO::loadGpxGz() */
+  atools::geo::LineString *getRoutePtr()
+  {
+    return &route;
+  }
+
+  QStringList *getRouteNamesPtr()
+  {
+    return &routeNames;
+  }
+
+  QVector<atools::geo::LineString> *getTracksPtr()
+  {
+    return &tracks;
+  }
+
+  QVector<QVector<qint64> > *getTimestampsMsPtr()
+  {
+    return &timestampsMs;
+  }
+
+  void clear();
+
+private:
+  atools::geo::LineString route;
+  QStringList routeNames;
+  QVector<atools::geo::LineString> tracks;
+  QVector<QVector<qint64> > timestampsMs;
+  bool valid = false;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_BINARYTRAIL_H
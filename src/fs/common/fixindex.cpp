@@ -0,0 +1,140 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/common/fixindex.h"
+
+#include "geo/pos.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+
+#include <QDebug>
+
+#include <cmath>
+
+using atools::sql::SqlQuery;
+
+namespace atools {
+namespace fs {
+namespace common {
+
+void FixIndex::loadFromDatabase(sql::SqlDatabase& db)
+{
+  clear();
+
+  load(waypointIndex, db, "waypoint", true /* loadType */);
+  load(ilsIndex, db, "ils", false /* loadType */);
+
+  for(const QVector<Entry>& entries : qAsConst(waypointIndex))
+    numWaypoints += entries.size();
+
+  for(const QVector<Entry>& entries : qAsConst(ilsIndex))
+    numIls += entries.size();
+
+  qDebug() << Q_FUNC_INFO << "Loaded" << numWaypoints << "waypoints and" << numIls << "ILS";
+}
+
+void FixIndex::load(QHash<QString, QVector<Entry> >& index, sql::SqlDatabase& db, const QString& table, bool loadType)
+{
+  SqlQuery query(db);
+  query.exec(QString("select %1 from %2").
+             arg(loadType ? "ident, region, type, lonx, laty" : "ident, region, lonx, laty").arg(table));
+
+  while(query.next())
+  {
+    // Null values never match the like and equal operators of the lookup queries
+    if(query.isNull("region") || query.isNull("lonx") || query.isNull("laty"))
+      continue;
+
+    Entry entry;
+    if(loadType)
+      entry.type = query.valueStr("type");
+    entry.region = query.valueStr("region");
+    entry.lonX = query.valueDouble("lonx");
+    entry.latY = query.valueDouble("laty");
+    index[query.valueStr("ident")].append(entry);
+  }
+}
+
+bool FixIndex::findWaypoint(QString& type, QString& foundRegion, const QString& ident, const QString& region,
+                            const geo::PosD& pos, bool exact) const
+{
+  const Entry *entry = find(waypointIndex, ident, region, pos, exact);
+  if(entry != nullptr)
+  {
+    type = entry->type;
+    foundRegion = entry->region;
+    return true;
+  }
+  return false;
+}
+
+bool FixIndex::findIls(QString& foundRegion, const QString& ident, const QString& region,
+                       const geo::PosD& pos, bool exact) const
+{
+  const Entry *entry = find(ilsIndex, ident, region, pos, exact);
+  if(entry != nullptr)
+  {
+    foundRegion = entry->region;
+    return true;
+  }
+  return false;
+}
+
+const FixIndex::Entry *FixIndex::find(const QHash<QString, QVector<Entry> >& index, const QString& ident,
+                                      const QString& region, const geo::PosD& pos, bool exact) const
+{
+  auto it = index.constFind(ident);
+  if(it == index.constEnd())
+    return nullptr;
+
+  const Entry *found = nullptr;
+  double foundDist = 0.1;
+  for(const Entry& entry : it.value())
+  {
+    // Empty region matches all - otherwise compare case insensitive like the SQL "like" operator
+    if(!region.isEmpty() && entry.region.compare(region, Qt::CaseInsensitive) != 0)
+      continue;
+
+    if(exact)
+    {
+      if(entry.lonX == pos.getLonX() && entry.latY == pos.getLatY())
+        return &entry;
+    }
+    else
+    {
+      // Use the first and nearest one below the maximum distance
+      double dist = std::abs(entry.lonX - pos.getLonX()) + std::abs(entry.latY - pos.getLatY());
+      if(dist < foundDist)
+      {
+        found = &entry;
+        foundDist = dist;
+      }
+    }
+  }
+  return found;
+}
+
+void FixIndex::clear()
+{
+  waypointIndex.clear();
+  ilsIndex.clear();
+  numWaypoints = numIls = 0;
+}
+
+} // namespace common
+} // namespace fs
+} // namespace atools
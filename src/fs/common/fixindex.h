@@ -0,0 +1,93 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_COMMON_FIXINDEX_H
+#define ATOOLS_FS_COMMON_FIXINDEX_H
+
+#include <QHash>
+#include <QVector>
+
+namespace atools {
+namespace geo {
+class PosD;
+}
+namespace sql {
+class SqlDatabase;
+}
+
+namespace fs {
+namespace common {
+
+/*
+ * In-memory copy of the waypoint and ils tables for resolving procedure fixes by ident, region and position.
+ * Mirrors the lookup queries of the ProcedureWriter and allows to resolve fixes from several threads at once
+ * since it is read-only after loading.
+ */
+class FixIndex
+{
+public:
+  FixIndex() = default;
+
+  /* Load ident, region, type and coordinates from tables waypoint and ils. Clears index before. */
+  void loadFromDatabase(atools::sql::SqlDatabase& db);
+
+  /* Find a waypoint by ident and region. An empty region matches all.
+   * exact = true: Position has to match exactly.
+   * exact = false: Nearest waypoint in the vicinity of 0.1 degree (sum of latitude and longitude difference).
+   * Returns true and fills type and foundRegion if found. */
+  bool findWaypoint(QString& type, QString& foundRegion, const QString& ident, const QString& region,
+                    const atools::geo::PosD& pos, bool exact) const;
+
+  /* As above for ILS. Fills only foundRegion. */
+  bool findIls(QString& foundRegion, const QString& ident, const QString& region,
+               const atools::geo::PosD& pos, bool exact) const;
+
+  void clear();
+
+  int sizeWaypoints() const
+  {
+    return numWaypoints;
+  }
+
+  int sizeIls() const
+  {
+    return numIls;
+  }
+
+private:
+  struct Entry
+  {
+    QString type, region;
+    double lonX, latY;
+  };
+
+  const Entry *find(const QHash<QString, QVector<Entry> >& index, const QString& ident, const QString& region,
+                    const atools::geo::PosD& pos, bool exact) const;
+
+  void load(QHash<QString, QVector<Entry> >& index, atools::sql::SqlDatabase& db, const QString& table,
+            bool loadType);
+
+  /* Ident to all fixes with this ident in table order */
+  QHash<QString, QVector<Entry> > waypointIndex, ilsIndex;
+  int numWaypoints = 0, numIls = 0;
+};
+
+} // namespace common
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_COMMON_FIXINDEX_H
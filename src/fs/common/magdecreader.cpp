@@ -24,6 +24,7 @@
 #include "wmm/magdectool.h"
 #include "exception.h"
 #include "sql/sqlquery.h"
+#include "sql/sqlcursor.h"
 
 #include <QFile>
 #include <QDebug>
@@ -54,28 +55,31 @@ void MagDecReader::readFromWmm()
   readFromWmm(QDate::currentDate());
 }
 
-void MagDecReader::readFromWmm(const QDate& date)
+void MagDecReader::readFromWmm(const QDate& date, int cellsPerDegreeParam)
 {
-  readFromWmm(date.year(), date.month());
+  readFromWmm(date.year(), date.month(), cellsPerDegreeParam);
 }
 
-void MagDecReader::readFromWmm(int year, int month)
+void MagDecReader::readFromWmm(int year, int month, int cellsPerDegreeParam)
 {
   clear();
 
   // Create WMM model data
   atools::wmm::MagDecTool magDecTool;
-  magDecTool.init(year, month);
+  magDecTool.init(year, month, cellsPerDegreeParam);
 
   referenceDate = magDecTool.getReferenceDate();
-  numValues = 360 * 181;
+  cellsPerDegree = magDecTool.getCellsPerDegree();
+  numValues = static_cast<quint32>(magDecTool.getNumColumns() * magDecTool.getNumRows());
 
   // Copy to internal representation that allows saving and loading
+  int minLonIndex = -180 * cellsPerDegree, minLatIndex = -90 * cellsPerDegree;
   magDecValues = new float[numValues];
-  for(int latY = -90; latY <= 90; latY++)
+  for(int latIndex = 0; latIndex < magDecTool.getNumRows(); latIndex++)
   {
-    for(int lonX = -180; lonX < 180; lonX++)
-      magDecValues[offset(lonX, latY)] = magDecTool.getMagVar(lonX, latY);
+    for(int lonIndex = 0; lonIndex < magDecTool.getNumColumns(); lonIndex++)
+      magDecValues[offset(minLonIndex + lonIndex, minLatIndex + latIndex)] =
+        magDecTool.getGridValue(lonIndex, latIndex);
   }
 }
 
@@ -130,6 +134,7 @@ void MagDecReader::readFromBgl(const QString& filename)
     }
 
     numValues = numLongValues * numLatValues;
+    cellsPerDegree = 1;
 
     magDecValues = new float[numValues];
 
@@ -157,6 +162,22 @@ void MagDecReader::readFromBytes(const QByteArray& bytes)
   in.setFloatingPointPrecision(QDataStream::SinglePrecision);
 
   in >> numValues;
+
+  // Detect grid resolution from number of values - 360 * 181 for the default one degree grid
+  cellsPerDegree = 0;
+  for(int cells = 1; cells <= atools::wmm::MagDecTool::MAX_CELLS_PER_DEGREE && cellsPerDegree == 0; cells++)
+  {
+    if(numValues == static_cast<quint32>(360 * cells * (180 * cells + 1)))
+      cellsPerDegree = cells;
+  }
+
+  if(cellsPerDegree == 0)
+  {
+    quint32 invalidNumValues = numValues;
+    clear();
+    throw atools::Exception(tr("Invalid number of magnetic declination values %1.").arg(invalidNumValues));
+  }
+
   magDecValues = new float[numValues];
 
   for(unsigned int i = 0; i < numValues; i++)
@@ -183,16 +204,17 @@ bool MagDecReader::readFromTable(sql::SqlDatabase& db)
 {
   if(atools::sql::SqlUtil(db).hasTable("magdecl"))
   {
-    atools::sql::SqlQuery query(db);
+    atools::sql::SqlQuery magQuery(db);
+    atools::sql::SqlCursor query(magQuery);
     query.exec("select magdecl_id, reference_time, mag_var from magdecl");
 
     if(query.next())
     {
-      QByteArray bytes = query.value("mag_var").toByteArray();
-      readFromBytes(bytes);
+      // Blob is shared with the driver and not copied
+      readFromBytes(query.valueBytes(query.index("mag_var")));
 
       QDateTime timestamp;
-      timestamp.setTime_t(query.value("reference_time").toUInt());
+      timestamp.setTime_t(static_cast<uint>(query.valueLongLong(query.index("reference_time"))));
       referenceDate = timestamp.date();
 
       qInfo() << Q_FUNC_INFO << db.databaseName() << "Reference date" << referenceDate;
@@ -211,6 +233,8 @@ void MagDecReader::clear()
   magDecValues = nullptr;
   referenceDate = QDate();
   wmmVersion.clear();
+  numValues = 0;
+  cellsPerDegree = 1;
 }
 
 bool MagDecReader::isValid() const
@@ -244,44 +268,29 @@ float MagDecReader::getMagVar(const geo::Pos& pos) const
     return 0.f;
 
   Pos posNorm(pos.normalized());
-  float lonX = posNorm.getLonX();
-  float latY = posNorm.getLatY();
 
-  int minLonX1 = static_cast<int>(std::floor(lonX)), maxLonX2 = static_cast<int>(std::ceil(lonX)),
-      minLatY1 = static_cast<int>(std::floor(latY)), maxLatY2 = static_cast<int>(std::ceil(latY));
-
-  if(pos.nearGrid(1.f, atools::geo::Pos::POS_EPSILON_500M))
-    // Exact or near degree - nothing to interpolate
-    return magvar(offset(atools::roundToInt(pos.getLonX()), atools::roundToInt(pos.getLatY())));
+  if(posNorm.nearGrid(1.f / cellsPerDegree, atools::geo::Pos::POS_EPSILON_500M))
+    // Exact or near grid point - nothing to interpolate
+    return magvar(offset(atools::roundToInt(posNorm.getLonX() * cellsPerDegree),
+                         atools::roundToInt(posNorm.getLatY() * cellsPerDegree)));
   else
   {
-    // Get four exact degree points around the coordinate
-    int topRightOffsetQ12 = offset(minLonX1, maxLatY2), topLeftOffsetQ22 = offset(maxLonX2, maxLatY2),
-        bottomRightOffsetQ11 = offset(maxLonX2, minLatY1), bottomLeftOffsetQ21 = offset(minLonX1, minLatY1);
+    // Position in grid units
+    float lonX = posNorm.getLonX() * cellsPerDegree;
+    float latY = posNorm.getLatY() * cellsPerDegree;
 
-    // Calculate magvar values for the four points
-    float fQ12 = magvar(topRightOffsetQ12), fQ22 = magvar(topLeftOffsetQ22),
-          fQ11 = magvar(bottomRightOffsetQ11), fQ21 = magvar(bottomLeftOffsetQ21);
+    // Get four grid points around the coordinate - offset() wraps around at the anti-meridian
+    int leftX = static_cast<int>(std::floor(lonX)), bottomY = static_cast<int>(std::floor(latY));
+    int rightX = leftX + 1, topY = std::min(bottomY + 1, 90 * cellsPerDegree);
+    float fracX = lonX - leftX, fracY = latY - bottomY;
 
-    // Do a bilinear interpolation between the four points
-    float fR1, fR2;
-    float diffX = maxLonX2 - minLonX1;
-    if(std::abs(diffX) > 0.f)
-    {
-      fR1 = (maxLonX2 - lonX) / diffX * fQ11 + (lonX - minLonX1) / diffX * fQ21;
-      fR2 = (maxLonX2 - lonX) / diffX * fQ12 + (lonX - minLonX1) / diffX * fQ22;
-    }
-    else
-    {
-      fR1 = (fQ11 + fQ21) / 2.f;
-      fR2 = (fQ12 + fQ22) / 2.f;
-    }
+    float bottomLeft = magvar(offset(leftX, bottomY)), bottomRight = magvar(offset(rightX, bottomY)),
+          topLeft = magvar(offset(leftX, topY)), topRight = magvar(offset(rightX, topY));
 
-    float diffY = maxLatY2 - minLatY1;
-    if(std::abs(diffY) > 0.f)
-      return (maxLatY2 - latY) / diffY * fR1 + (latY - minLatY1) / diffY * fR2;
-    else
-      return (fR1 + fR2) / 2.f;
+    // Do a bilinear interpolation between the four points
+    float bottom = bottomLeft + (bottomRight - bottomLeft) * fracX;
+    float top = topLeft + (topRight - topLeft) * fracX;
+    return bottom + (top - bottom) * fracY;
   }
 }
 
@@ -312,22 +321,27 @@ float MagDecReader::magvar(int offset) const
 // For negative (West) longitudes (from -1 to -179):
 // Offset =((Long+360)*362)+(Lat*2)+316
 // Note that North latitudes should be entered as positive values (0 to 90) and South latitudes as negative values (-1 to -90)
-int MagDecReader::offset(int lonX, int latY) const
+// Finer grids use the same layout where each degree is divided into cellsPerDegree values
+int MagDecReader::offset(int lonIndex, int latIndex) const
 {
-  if(lonX == -180)
+  const int maxLonIndex = 180 * cellsPerDegree, numLatValues = 180 * cellsPerDegree + 1;
+
+  if(lonIndex <= -maxLonIndex)
     // Wrap around - other values should not appear on normalized coordinates
-    lonX = 180;
+    lonIndex += 2 * maxLonIndex;
+  else if(lonIndex > maxLonIndex)
+    lonIndex -= 2 * maxLonIndex;
 
-  if(lonX >= 0 && lonX <= 180)
+  if(lonIndex >= 0 && lonIndex <= maxLonIndex)
     // For positive (East) longitudes (from 0 to 180):
     // East: Offset = (Long*362)+(Lat*2)+180
-    return ((lonX * 362) + (latY * 2) + 180) / 2;
-  else if(lonX <= -1 && lonX >= -179)
+    return lonIndex * numLatValues + latIndex + 90 * cellsPerDegree;
+  else if(lonIndex < 0 && lonIndex > -maxLonIndex)
     // For negative (West) longitudes (from -1 to -179):
     // West: Offset =((Long+360)*362)+(Lat*2)+180
-    return (((lonX + 360) * 362) + (latY * 2) + 180) / 2;
+    return (lonIndex + 2 * maxLonIndex) * numLatValues + latIndex + 90 * cellsPerDegree;
   else
-    qWarning() << "MagDecReader invalid coordinates in offset calculation" << lonX << latY;
+    qWarning() << "MagDecReader invalid coordinates in offset calculation" << lonIndex << latIndex;
   return 0;
 }
 
@@ -49,9 +49,11 @@ public:
 
   /* Calculate values from world magnetic model based on current year and month or current date if not given.
    * Values can be saved to database. Result is always valid.
+   * cellsPerDegree defines the grid resolution. 1 is the default one degree grid which is compatible
+   * to all versions. 4 results in a 0.25 degree grid.
    *  January = 1 */
-  void readFromWmm(int year, int month = 1);
-  void readFromWmm(const QDate& date);
+  void readFromWmm(int year, int month = 1, int cellsPerDegree = 1);
+  void readFromWmm(const QDate& date, int cellsPerDegree = 1);
   void readFromWmm();
 
   /* Read values from magdec.bgl file */
@@ -70,6 +72,7 @@ public:
   bool isValid() const;
 
   /* East values are positive while West values are negative.
+   * Values are interpolated bilinear between the four surrounding grid points.
    * Throws exception if object is not valid.
    */
   float getMagVar(const atools::geo::Pos& pos) const;
@@ -79,6 +82,12 @@ public:
     return referenceDate;
   }
 
+  /* Grid resolution. 1 for a one degree grid */
+  int getCellsPerDegree() const
+  {
+    return cellsPerDegree;
+  }
+
   /* Version information for world magnetic model if one of the readFromWmm methods was used */
   QString getWmmVersion() const
   {
@@ -89,11 +98,14 @@ private:
   QByteArray writeToBytes() const;
   void readFromBytes(const QByteArray& bytes);
 
-  int offset(int lonX, int latY) const;
+  /* Offset into array for grid indexes. lonIndex -180 * cellsPerDegree to 180 * cellsPerDegree and
+   * latIndex -90 * cellsPerDegree to 90 * cellsPerDegree */
+  int offset(int lonIndex, int latIndex) const;
   float magvar(int offset) const;
 
   QDate referenceDate;
   quint32 numValues = 0;
+  int cellsPerDegree = 1;
 
   /* https://www.fsdeveloper.com/wiki/index.php?title=Magdec_BGL_File */
   float *magDecValues = nullptr;
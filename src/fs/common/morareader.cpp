@@ -17,6 +17,7 @@
 
 #include "fs/common/morareader.h"
 #include "sql/sqlquery.h"
+#include "sql/sqlcursor.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlutil.h"
 #include "geo/pos.h"
@@ -140,19 +141,28 @@ void MoraReader::fillDbFromQuery(sql::SqlQuery *moraQuery, int fileId)
   // mora30             text (3) );
 
   QVector<QStringList> lines;
-  moraQuery->exec();
+  atools::sql::SqlCursor cursor(moraQuery);
+  cursor.exec();
+
+  // Resolve column indexes once
+  int startLatIdx = cursor.index("starting_latitude");
+  int startLonIdx = cursor.index("starting_longitude");
+  int moraIdx[30];
+  for(int i = 0; i < 30; i++)
+    moraIdx[i] = cursor.index(MORA_FIELD_NAME.arg(i + 1, 2, 10, QChar('0')));
 
   // The Grid MORA Table will contain records describing the MORA for each Latitude and Longitude block.
   // Each record will contain thirty blocks and the “Starting Latitude” field defines the
   // lower left corner for the first block of each record.
-  while(moraQuery->next())
+  while(cursor.next())
   {
     QStringList line;
-    line.append(moraQuery->valueStr("starting_latitude")); // 89 to -90
-    line.append(moraQuery->valueStr("starting_longitude")); // -180 to -150
+    line.reserve(32);
+    line.append(cursor.valueStr(startLatIdx)); // 89 to -90
+    line.append(cursor.valueStr(startLonIdx)); // -180 to -150
 
     for(int i = 0; i < 30; i++)
-      line.append(moraQuery->valueStr(MORA_FIELD_NAME.arg(i + 1, 2, 10, QChar('0'))));
+      line.append(cursor.valueStr(moraIdx[i]));
     lines.append(line);
   }
 
@@ -19,6 +19,7 @@
 
 #include "atools.h"
 #include "fs/common/airportindex.h"
+#include "fs/common/fixindex.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
@@ -267,6 +268,16 @@ enum WaypointDescriptionCode4
 
 }
 
+QString ProcedureInput::getContext() const
+{
+  if(!context.isEmpty())
+    return context;
+  else
+    return QString("File %1, airport %2, procedure %3, transition %4").
+           arg(contextFile).arg(airportIdent).arg(sidStarAppIdent).arg(transIdent);
+}
+
+// ==========================================================================
 ProcedureWriter::ProcedureWriter(atools::sql::SqlDatabase& sqlDb, atools::fs::common::AirportIndex *airportIndexParam)
   : db(sqlDb), airportIndex(airportIndexParam),
   // Create SqlRecords for tables that can be cloned before filling with data
@@ -369,30 +380,66 @@ void ProcedureWriter::writeProcedureLeg(const ProcedureInput& line)
   }
 }
 
-void ProcedureWriter::assignApproachIds(ProcedureWriter::Procedure& proc)
+void ProcedureWriter::addRecord(RecordType type, const SqlRecord& record)
 {
-  proc.record.setValue(":approach_id", ++curApproachId);
+  if(buffered)
+    records.append({type, record});
+  else
+    writeRecord(type, record);
 }
 
-void ProcedureWriter::assignApproachLegIds(sql::SqlRecordList& records)
+void ProcedureWriter::addRecords(RecordType type, const SqlRecordList& recordList)
 {
-  for(SqlRecord& rec : records)
+  for(const SqlRecord& record : recordList)
+    addRecord(type, record);
+}
+
+void ProcedureWriter::writeRecord(RecordType type, SqlRecord record)
+{
+  // Assign new ids to the approaches, transitions and legs in insert order
+  switch(type)
   {
-    rec.setValue(":approach_leg_id", ++curApproachLegId);
-    rec.setValue(":approach_id", curApproachId);
+    case APPROACH_RECORD_TYPE:
+      record.setValue(":approach_id", ++curApproachId);
+      insertApproachQuery->bindAndExecRecord(record);
+      break;
+
+    case APPROACH_LEG_RECORD_TYPE:
+      record.setValue(":approach_leg_id", ++curApproachLegId);
+      record.setValue(":approach_id", curApproachId);
+      insertApproachLegQuery->bindAndExecRecord(record);
+      break;
+
+    case TRANSITION_RECORD_TYPE:
+      record.setValue(":transition_id", ++curTransitionId);
+      record.setValue(":approach_id", curApproachId);
+      insertTransitionQuery->bindAndExecRecord(record);
+      break;
+
+    case TRANSITION_LEG_RECORD_TYPE:
+      record.setValue(":transition_leg_id", ++curTransitionLegId);
+      record.setValue(":transition_id", curTransitionId);
+      insertTransitionLegQuery->bindAndExecRecord(record);
+      break;
+
+    case AIRPORT_RECORD_TYPE:
+      updateAirportQuery->bindRecord(record);
+      updateAirportQuery->exec();
+      break;
   }
 }
 
-void ProcedureWriter::assignTransitionIds(ProcedureWriter::Procedure& proc)
+ProcedureWriter::RecordList ProcedureWriter::takeRecords()
 {
-  proc.record.setValue(":transition_id", ++curTransitionId);
-  proc.record.setValue(":approach_id", curApproachId);
+  RecordList retval;
+  retval.swap(records);
+  return retval;
+}
 
-  for(SqlRecord& rec : proc.legRecords)
-  {
-    rec.setValue(":transition_leg_id", ++curTransitionLegId);
-    rec.setValue(":transition_id", curTransitionId);
-  }
+void ProcedureWriter::writeRecords(const RecordList& recordList)
+{
+  for(const Record& record : recordList)
+    writeRecord(record.type, record.record);
 }
 
 void ProcedureWriter::finishProcedure(const ProcedureInput& line)
@@ -401,10 +448,10 @@ void ProcedureWriter::finishProcedure(const ProcedureInput& line)
   {
     numProcedures += approaches.size() + transitions.size();
     if(approaches.size() > 1)
-      qWarning() << line.context << "Found more than one approach" << approaches.size();
+      qWarning() << line.getContext() << "Found more than one approach" << approaches.size();
 
     if(approaches.isEmpty())
-      qWarning() << line.context << "No approaches found. Invalid state.";
+      qWarning() << line.getContext() << "No approaches found. Invalid state.";
     else
     {
       // Write approach
@@ -419,17 +466,14 @@ void ProcedureWriter::finishProcedure(const ProcedureInput& line)
           appr.record.setValue(":has_rnp", 1);
       }
 
-      assignApproachIds(appr);
-      assignApproachLegIds(appr.legRecords);
-      insertApproachQuery->bindAndExecRecord(appr.record);
-      insertApproachLegQuery->bindAndExecRecords(appr.legRecords);
+      addRecord(APPROACH_RECORD_TYPE, appr.record);
+      addRecords(APPROACH_LEG_RECORD_TYPE, appr.legRecords);
 
       // Write transitions for one approach
-      for(Procedure& trans : transitions)
+      for(const Procedure& trans : qAsConst(transitions))
       {
-        assignTransitionIds(trans);
-        insertTransitionQuery->bindAndExecRecord(trans.record);
-        insertTransitionLegQuery->bindAndExecRecords(trans.legRecords);
+        addRecord(TRANSITION_RECORD_TYPE, trans.record);
+        addRecords(TRANSITION_LEG_RECORD_TYPE, trans.legRecords);
       }
     }
   }
@@ -452,7 +496,7 @@ void ProcedureWriter::finishProcedure(const ProcedureInput& line)
     numProcedures += approaches.size() + transitions.size();
 
     if(approaches.isEmpty())
-      qWarning() << line.context << "No SID/STAR found. Invalid state.";
+      qWarning() << line.getContext() << "No SID/STAR found. Invalid state.";
     else
     {
       int numCommon = 0;
@@ -463,7 +507,7 @@ void ProcedureWriter::finishProcedure(const ProcedureInput& line)
       }
 
       if(numCommon > 1)
-        qWarning() << line.context << "Found more than one common route for SID/STAR.";
+        qWarning() << line.getContext() << "Found more than one common route for SID/STAR.";
 
       Procedure sidCommon, starCommon;
       if(curRowCode == rc::SID &&
@@ -503,15 +547,13 @@ void ProcedureWriter::finishProcedure(const ProcedureInput& line)
       // Write all procedures - get a copy of the object since it is modified
       for(Procedure appr : qAsConst(approaches))
       {
-        assignApproachIds(appr);
         // qDebug() << appr.legRecords;
-        insertApproachQuery->bindAndExecRecord(appr.record);
+        addRecord(APPROACH_RECORD_TYPE, appr.record);
 
         if(starCommon.isValid())
         {
           // Prefix the common route legs to the STAR
-          assignApproachLegIds(starCommon.legRecords);
-          insertApproachLegQuery->bindAndExecRecords(starCommon.legRecords);
+          addRecords(APPROACH_LEG_RECORD_TYPE, starCommon.legRecords);
 
           // Remove the IF of the STAR which will be replaced by the TF of the common route
           if(appr.legRecords.constFirst().value(":type") == "IF")
@@ -519,23 +561,18 @@ void ProcedureWriter::finishProcedure(const ProcedureInput& line)
         }
 
         // Write SID or STAR legs
-        assignApproachLegIds(appr.legRecords);
-        insertApproachLegQuery->bindAndExecRecords(appr.legRecords);
+        addRecords(APPROACH_LEG_RECORD_TYPE, appr.legRecords);
 
         if(sidCommon.isValid())
-        {
           // Append the common route legs to the SID
-          assignApproachLegIds(sidCommon.legRecords);
-          insertApproachLegQuery->bindAndExecRecords(sidCommon.legRecords);
-        }
+          addRecords(APPROACH_LEG_RECORD_TYPE, sidCommon.legRecords);
 
-        // Assign a new set of ids and write a duplicate of all transitions for the current approach
-        for(Procedure& trans : transitions)
+        // Write a duplicate of all transitions for the current approach - new ids are assigned when writing
+        for(const Procedure& trans : qAsConst(transitions))
         {
-          assignTransitionIds(trans);
           // qDebug() << trans.legRecords;
-          insertTransitionQuery->bindAndExecRecord(trans.record);
-          insertTransitionLegQuery->bindAndExecRecords(trans.legRecords);
+          addRecord(TRANSITION_RECORD_TYPE, trans.record);
+          addRecords(TRANSITION_LEG_RECORD_TYPE, trans.legRecords);
         }
       }
     }
@@ -729,7 +766,7 @@ void ProcedureWriter::writeTransitionLeg(const ProcedureInput& line)
       lastRec.setValue(":dme_region", line.recdRegion.trimmed());
     }
     else
-      qWarning() << line.context << "No recommended navaid for AF leg";
+      qWarning() << line.getContext() << "No recommended navaid for AF leg";
   }
 
   bindLeg(line, rec);
@@ -794,7 +831,7 @@ void ProcedureWriter::bindLeg(const ProcedureInput& line, atools::sql::SqlRecord
   else
   {
     altDescrValid = false;
-    qWarning() << line.context << "Unexpected alt descriptor" << altDescr;
+    qWarning() << line.getContext() << "Unexpected alt descriptor" << altDescr;
   }
 
   QString turnDir = line.turnDir.trimmed();
@@ -827,7 +864,7 @@ void ProcedureWriter::bindLeg(const ProcedureInput& line, atools::sql::SqlRecord
   {
     if(!line.centerFixOrTaaPt.isEmpty())
     {
-      NavIdInfo centerNavInfo = navaidType(line.context + ". RF recommended",
+      NavIdInfo centerNavInfo = navaidType(line, QStringLiteral(". RF recommended"),
                                            QString(), line.centerSecCode, line.centerSubCode,
                                            line.centerFixOrTaaPt, line.centerIcaoCode, line.centerPos, line.airportPos);
 
@@ -850,11 +887,11 @@ void ProcedureWriter::bindLeg(const ProcedureInput& line, atools::sql::SqlRecord
 
     }
     else
-      qWarning() << line.context << "No center fix for RF leg";
+      qWarning() << line.getContext() << "No center fix for RF leg";
   }
   else if(!line.recdNavaid.isEmpty())
   {
-    NavIdInfo recdNavInfo = navaidType(line.context + ". recommended",
+    NavIdInfo recdNavInfo = navaidType(line, QStringLiteral(". recommended"),
                                        QString(), line.recdSecCode, line.recdSubCode, line.recdNavaid, line.recdRegion,
                                        line.recdWaypointPos, line.airportPos);
 
@@ -876,7 +913,7 @@ void ProcedureWriter::bindLeg(const ProcedureInput& line, atools::sql::SqlRecord
   // else null
 
   if(line.pathTerm == "AF" && line.recdNavaid.trimmed().isEmpty())
-    qWarning() << line.context << "No recommended fix for AF leg";
+    qWarning() << line.getContext() << "No recommended fix for AF leg";
 
   rec.setValue(":is_flyover", overfly);
   rec.setValue(":is_true_course", 0); // Not used
@@ -920,7 +957,7 @@ void ProcedureWriter::bindLeg(const ProcedureInput& line, atools::sql::SqlRecord
     // else null means speed at
 
     if(!atools::contains(spdDescr, {QString(), " ", "+", "-"}))
-      qWarning() << line.context << "Invalid speed limit" << spdDescr;
+      qWarning() << line.getContext() << "Invalid speed limit" << spdDescr;
   }
   // else null
 
@@ -946,9 +983,9 @@ void ProcedureWriter::finish(const ProcedureInput& line)
 {
   finishProcedure(line);
 
-  updateAirportQuery->bindValue(":num", numProcedures);
-  updateAirportQuery->bindValue(":id", line.airportId);
-  updateAirportQuery->exec();
+  SqlRecord airportRec;
+  airportRec.appendFieldAndValue(":num", numProcedures).appendFieldAndValue(":id", line.airportId);
+  addRecord(AIRPORT_RECORD_TYPE, airportRec);
   numProcedures = 0;
 }
 
@@ -980,7 +1017,7 @@ atools::fs::common::rc::RowCode ProcedureWriter::toRowCode(const ProcedureInput&
     return rc::PRDAT;
   else
   {
-    qWarning() << line.context << "Unexpexted row code" << code;
+    qWarning() << line.getContext() << "Unexpexted row code" << code;
     return rc::NONE;
   }
 }
@@ -1056,7 +1093,7 @@ QString ProcedureWriter::procedureType(const ProcedureInput& line)
       // case rt::PRIMARY_MISSED_APPROACH:
       // case rt::ENGINE_OUT_MISSED_APPROACH:
       default:
-        qWarning() << line.context << "Unexpected approach route type" << curRouteType;
+        qWarning() << line.getContext() << "Unexpected approach route type" << curRouteType;
 
         if(curRouteType == ' ' || curRouteType == '\0')
           // No way to get a type
@@ -1075,13 +1112,13 @@ QString ProcedureWriter::procedureType(const ProcedureInput& line)
 
 ProcedureWriter::NavIdInfo ProcedureWriter::navaidTypeFix(const ProcedureInput& line)
 {
-  return navaidType(line.context + ". fix_type", line.descCode, line.secCode, line.subCode, line.fixIdent,
+  return navaidType(line, QStringLiteral(". fix_type"), line.descCode, line.secCode, line.subCode, line.fixIdent,
                     line.region, line.waypointPos, line.airportPos);
 
 }
 
-ProcedureWriter::NavIdInfo ProcedureWriter::navaidType(const QString& context, const QString& descCode,
-                                                       const QString& sectionCode,
+ProcedureWriter::NavIdInfo ProcedureWriter::navaidType(const ProcedureInput& line, const QString& contextSuffix,
+                                                       const QString& descCode, const QString& sectionCode,
                                                        const QString& subSectionCode, const QString& ident,
                                                        const QString& region,
                                                        const atools::geo::PosD& pos,
@@ -1130,39 +1167,14 @@ ProcedureWriter::NavIdInfo ProcedureWriter::navaidType(const QString& context, c
     {
       NavIdInfo inf;
 
-      // Try an exact and faster coordinate search first
-      // For that we need double coordinate values
-      findFix(findWaypointExactQuery, ident, region, searchPos);
-      if(findWaypointExactQuery->next())
+      // Try an exact and faster coordinate search first. For that we need double coordinate values
+      // Look in vicinity for waypoints if nothing was found at position
+      if(!findWaypoint(inf, ident, region, searchPos, true /* exact */) &&
+         !findWaypoint(inf, ident, region, searchPos, false /* exact */))
       {
-        inf.type = findWaypointExactQuery->valueStr("type");
-        inf.region = findWaypointExactQuery->valueStr("region");
-      }
-      else
-      {
-        // Nothing found at position - look in vicinity for waypoints
-        findFix(findWaypointQuery, ident, region, searchPos);
-        if(findWaypointQuery->next())
-        {
-          inf.type = findWaypointQuery->valueStr("type");
-          inf.region = findWaypointQuery->valueStr("region");
-        }
-        else
-        {
-          // Nothing found at position - look at position for ILS
-          findFix(findIlsExactQuery, ident, region, searchPos);
-          if(findIlsExactQuery->next())
-            // Do not set type for ILS
-            inf.region = findIlsExactQuery->valueStr("region");
-          else
-          {
-            // Nothing found at position - look in vicinity for ILS
-            findFix(findIlsQuery, ident, region, searchPos);
-            if(findIlsQuery->next())
-              // Do not set type for ILS
-              inf.region = findIlsQuery->valueStr("region");
-          }
-        }
+        // Nothing found at position - look at position and then in vicinity for ILS
+        if(!findIls(inf, ident, region, searchPos, true /* exact */))
+          findIls(inf, ident, region, searchPos, false /* exact */);
       }
 
       if(!inf.type.isEmpty())
@@ -1178,7 +1190,7 @@ ProcedureWriter::NavIdInfo ProcedureWriter::navaidType(const QString& context, c
       }
     }
     else if(!pos.isNull())
-      qWarning() << context << "Cannot find navaid type for" << ident << "/" << region << pos;
+      qWarning() << line.getContext() + contextSuffix << "Cannot find navaid type for" << ident << "/" << region << pos;
 
     return NavIdInfo();
   }
@@ -1234,7 +1246,8 @@ ProcedureWriter::NavIdInfo ProcedureWriter::navaidType(const QString& context, c
         break;
 
     }
-    qWarning() << context << "Unexpected airport section" << sectionCode << "sub" << subSectionCode;
+    qWarning() << line.getContext() + contextSuffix << "Unexpected airport section" << sectionCode
+               << "sub" << subSectionCode;
   }
   else if(sc == sc::ENROUTE)
   {
@@ -1256,7 +1269,8 @@ ProcedureWriter::NavIdInfo ProcedureWriter::navaidType(const QString& context, c
       case atools::fs::common::sc::ER_COMMUNICATIONS:
         break;
     }
-    qWarning() << context << "Unexpected enroute section" << sectionCode << "sub" << subSectionCode;
+    qWarning() << line.getContext() + contextSuffix << "Unexpected enroute section" << sectionCode
+               << "sub" << subSectionCode;
   }
   else if(sc == sc::NAVAID)
   {
@@ -1270,10 +1284,11 @@ ProcedureWriter::NavIdInfo ProcedureWriter::navaidType(const QString& context, c
       case atools::fs::common::sc::NDB:
         return NavIdInfo("N", region);
     }
-    qWarning() << context << "Unexpected navaid section" << sectionCode << "sub" << subSectionCode;
+    qWarning() << line.getContext() + contextSuffix << "Unexpected navaid section" << sectionCode
+               << "sub" << subSectionCode;
   }
   else
-    qWarning() << context << "Unexpected section" << sectionCode;
+    qWarning() << line.getContext() + contextSuffix << "Unexpected section" << sectionCode;
 
   return NavIdInfo();
 }
@@ -1288,6 +1303,40 @@ void ProcedureWriter::findFix(atools::sql::SqlQuery *query, const QString& ident
   query->exec();
 }
 
+bool ProcedureWriter::findWaypoint(NavIdInfo& inf, const QString& ident, const QString& region,
+                                   const atools::geo::PosD& pos, bool exact)
+{
+  if(fixIndex != nullptr)
+    return fixIndex->findWaypoint(inf.type, inf.region, ident, region, pos, exact);
+
+  SqlQuery *query = exact ? findWaypointExactQuery : findWaypointQuery;
+  findFix(query, ident, region, pos);
+  bool found = query->next();
+  if(found)
+  {
+    inf.type = query->valueStr("type");
+    inf.region = query->valueStr("region");
+  }
+  query->finish();
+  return found;
+}
+
+bool ProcedureWriter::findIls(NavIdInfo& inf, const QString& ident, const QString& region,
+                              const atools::geo::PosD& pos, bool exact)
+{
+  // Do not set type for ILS
+  if(fixIndex != nullptr)
+    return fixIndex->findIls(inf.region, ident, region, pos, exact);
+
+  SqlQuery *query = exact ? findIlsExactQuery : findIlsQuery;
+  findFix(query, ident, region, pos);
+  bool found = query->next();
+  if(found)
+    inf.region = query->valueStr("region");
+  query->finish();
+  return found;
+}
+
 QString ProcedureWriter::sidStarRunwayNameAndSuffix(const ProcedureInput& line)
 {
   QString ident = line.transIdent;
@@ -1297,7 +1346,7 @@ QString ProcedureWriter::sidStarRunwayNameAndSuffix(const ProcedureInput& line)
     QString desig = ident.size() > 4 ? ident.at(4) : QString();
 
     if(ident.at(2).isDigit() && ident.at(3).isDigit() && !atools::contains(desig, {QString(), "L", "R", "C", "-", "B", "T"}))
-      qWarning() << line.context << "Invalid designator" << desig;
+      qWarning() << line.getContext() << "Invalid designator" << desig;
 
     if(desig != "B") // B = multiple runways with same number but different designator
     {
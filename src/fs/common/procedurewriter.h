@@ -36,6 +36,7 @@ class ProgressHandler;
 
 namespace common {
 class AirportIndex;
+class FixIndex;
 
 namespace rc {
 
@@ -56,8 +57,11 @@ enum RowCode
  *  Comments denote column in ARINC text file and chapters explaining value */
 struct ProcedureInput
 {
-  /* Context to be used to prefix warning messages */
+  /* Context to be used to prefix warning messages. Use getContext() to get the message prefix. */
   QString context;
+
+  /* Used to build the context lazily from file, airport, procedure and transition if context is empty */
+  QString contextFile;
   QString airportIdent;
   int airportId;
   atools::geo::PosD airportPos;
@@ -109,6 +113,9 @@ struct ProcedureInput
 
   QString gnssFmsIndicator; // 117     5.222
   QString aircraftCategory; // 5.221
+
+  /* Prefix for warning messages. Formatted only when needed */
+  QString getContext() const;
 };
 
 const float INVALID_FLOAT = std::numeric_limits<float>::max();
@@ -138,6 +145,46 @@ public:
   /* Reset after writing procedures for one airport */
   void reset();
 
+  /* Type of a row collected when buffering */
+  enum RecordType
+  {
+    APPROACH_RECORD_TYPE,
+    APPROACH_LEG_RECORD_TYPE,
+    TRANSITION_RECORD_TYPE,
+    TRANSITION_LEG_RECORD_TYPE,
+    AIRPORT_RECORD_TYPE /* Update for airport.num_approach */
+  };
+
+  /* Row for one of the tables or an airport update in insert order. Ids are assigned by writeRecords(). */
+  struct Record
+  {
+    RecordType type;
+    atools::sql::SqlRecord record;
+  };
+
+  typedef QVector<Record> RecordList;
+
+  /* Collect all rows instead of inserting them into the database. Buffered writers do not access
+   * the database except when using writeRecords() and can be used in worker threads if a fix index is set.
+   * Call takeRecords() after finish() to get the rows for one airport. */
+  void setBuffered(bool value)
+  {
+    buffered = value;
+  }
+
+  /* Get and remove all rows collected in buffered mode */
+  RecordList takeRecords();
+
+  /* Assign ids and insert the rows collected by a buffered writer. */
+  void writeRecords(const RecordList& records);
+
+  /* Use an in-memory index instead of database queries to resolve fix types and regions.
+   * Index is not owned and has to be valid until the writer is deleted. */
+  void setFixIndex(const atools::fs::common::FixIndex *value)
+  {
+    fixIndex = value;
+  }
+
 private:
   /* Used to store a procedure before writing to the database */
   struct Procedure
@@ -204,21 +251,21 @@ private:
   atools::fs::common::rc::RowCode toRowCode(const ProcedureInput& line);
 
   /* Calculate a navaid type based on section and subsection code or waypoint description.
-   *  If not valid query the database for navaids */
-  NavIdInfo navaidType(const QString& context, const QString& descCode, const QString& sectionCode,
-                       const QString& subSectionCode, const QString& ident, const QString& region,
-                       const geo::PosD& pos, const atools::geo::PosD& airportPos);
+   *  If not valid query the database for navaids. contextSuffix is appended to the context of line in messages. */
+  NavIdInfo navaidType(const ProcedureInput& line, const QString& contextSuffix, const QString& descCode,
+                       const QString& sectionCode, const QString& subSectionCode, const QString& ident,
+                       const QString& region, const geo::PosD& pos, const atools::geo::PosD& airportPos);
   NavIdInfo navaidTypeFix(const ProcedureInput& line);
 
   /* Calculate a database procedure type based on route type */
   QString procedureType(const ProcedureInput& line);
 
-  /* Assigns new ids to the currently stored approaches */
-  void assignApproachIds(ProcedureWriter::Procedure& proc);
-  void assignApproachLegIds(atools::sql::SqlRecordList& records);
+  /* Insert row immediately or append to list if buffered */
+  void addRecord(RecordType type, const atools::sql::SqlRecord& record);
+  void addRecords(RecordType type, const atools::sql::SqlRecordList& records);
 
-  /* Assigns new ids to the currently stored transitions */
-  void assignTransitionIds(ProcedureWriter::Procedure& proc);
+  /* Assign new ids and insert row */
+  void writeRecord(RecordType type, atools::sql::SqlRecord record);
 
   /* Extract runway names */
   void apprRunwayNameAndSuffix(const ProcedureInput& line, QString& runway, QString& suffix);
@@ -230,6 +277,12 @@ private:
   void findFix(atools::sql::SqlQuery *query, const QString& ident, const QString& region,
                const atools::geo::PosD& pos) const;
 
+  /* Find waypoint or ILS using the fix index if set or database queries otherwise */
+  bool findWaypoint(NavIdInfo& inf, const QString& ident, const QString& region, const atools::geo::PosD& pos,
+                    bool exact);
+  bool findIls(NavIdInfo& inf, const QString& ident, const QString& region, const atools::geo::PosD& pos,
+               bool exact);
+
   /* Database ids */
   int curApproachId = 0, curTransitionId = 0, curApproachLegId = 0, curTransitionLegId = 0;
 
@@ -245,6 +298,13 @@ private:
 
   /* Index to look up airport and runway ids */
   atools::fs::common::AirportIndex *airportIndex;
+
+  /* Optional index to look up fixes */
+  const atools::fs::common::FixIndex *fixIndex = nullptr;
+
+  /* Collect rows in records instead of inserting */
+  bool buffered = false;
+  RecordList records;
   const atools::sql::SqlRecord APPROACH_RECORD, APPROACH_LEG_RECORD, TRANSITION_RECORD, TRANSITION_LEG_RECORD;
 
   /* Temporary storage before writing to database keeps one approach/SID/STAR and respective transitions
@@ -281,8 +281,10 @@ private:
    * 25 Fixed issue where airport frequencies were written as 0 instead of null for MSFS resulting in wrong search results.
    * 26 Added parking suffix for MSFS.
    * 27 Columns "metadata.properties" added.
+   * 28 Geometry BLOBs in boundary and apron use the compact BinaryGeometry layout with magic number and header.
+   *    The legacy layout is still read, so databases with older minor versions stay usable.
    */
-  static const int DB_VERSION_MINOR = 27;
+  static const int DB_VERSION_MINOR = 28;
 
   /* Version of included AIRAC cycle.
    * VERSION_NUMBER=
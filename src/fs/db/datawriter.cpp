@@ -430,7 +430,7 @@ void DataWriter::readMagDeclBgl(const QString& fileScenery)
 
   if(!loaded)
   {
-    magDecReader->readFromWmm();
+    magDecReader->readFromWmm(QDate::currentDate(), options.getMagDecCellsPerDegree());
     magDecReader->writeToTable(db);
     db.commit();
   }
@@ -21,6 +21,7 @@
 #include "fs/common/airportindex.h"
 #include "fs/common/binarygeometry.h"
 #include "fs/common/binarymsageometry.h"
+#include "fs/common/fixindex.h"
 #include "fs/common/magdecreader.h"
 #include "fs/common/metadatawriter.h"
 #include "fs/common/morareader.h"
@@ -34,11 +35,13 @@
 #include "sql/sqlquery.h"
 #include "sql/sqlscript.h"
 #include "sql/sqlutil.h"
+#include "util/parallel.h"
 
 #include <QCoreApplication>
 #include <QDataStream>
 #include <QDebug>
 #include <QFileInfo>
+#include <QThread>
 
 using atools::fs::common::MagDecReader;
 using atools::fs::common::MetadataWriter;
@@ -60,6 +63,9 @@ namespace ng {
 
 static const float RNV_FEATHER_WIDTH_DEG = 8.f;
 
+/* Number of airports collected before procedures are built in parallel and written */
+static const int PROCEDURE_BATCH_AIRPORTS = 500;
+
 DfdCompiler::DfdCompiler(sql::SqlDatabase& sqlDb, const NavDatabaseOptions& opts,
                          ProgressHandler *progressHandler)
   : options(opts), db(sqlDb), progress(progressHandler)
@@ -1224,14 +1230,19 @@ void DfdCompiler::writeAirways()
 
 void DfdCompiler::writeProcedures()
 {
+  // Resolving fix types from memory allows to build procedures in worker threads which cannot use the database
+  progress->reportOther("Loading fixes for procedures");
+  atools::fs::common::FixIndex fixIndex;
+  fixIndex.loadFromDatabase(db);
+
   progress->reportOther("Writing approaches and transitions");
-  writeProcedure("src.tbl_iaps", "APPCH");
+  writeProcedure("src.tbl_iaps", "APPCH", fixIndex);
 
   progress->reportOther("Writing SIDs");
-  writeProcedure("src.tbl_sids", "SID");
+  writeProcedure("src.tbl_sids", "SID", fixIndex);
 
   progress->reportOther("Writing STARs");
-  writeProcedure("src.tbl_stars", "STAR");
+  writeProcedure("src.tbl_stars", "STAR", fixIndex);
 }
 
 void DfdCompiler::writeMora()
@@ -1245,63 +1256,116 @@ void DfdCompiler::writeMora()
   db.commit();
 }
 
-void DfdCompiler::writeProcedure(const QString& table, const QString& rowCode)
+void DfdCompiler::writeProcedure(const QString& table, const QString& rowCode,
+                                 const atools::fs::common::FixIndex& fixIndex)
 {
+  using atools::fs::common::ProcedureInput;
+  using atools::fs::common::ProcedureWriter;
+
   // Get procedures ordered from the table
   SqlQuery query(SqlUtil(db).buildSelectStatement(table) +
                  // " where airport_identifier in ('CYBK') "
                  // "and procedure_identifier = 'R34'"
                  " order by airport_identifier, procedure_identifier, route_type, transition_identifier, seqno ", db);
   query.exec();
-  atools::fs::common::ProcedureInput procInput;
 
-  QString curAirport;
-  procInput.rowCode = rowCode;
+  // Buffered writers for worker threads which do not access the database - created in this thread
+  QVector<ProcedureWriter *> writers;
+  for(int i = 0; i < std::max(QThread::idealThreadCount(), 1); i++)
+  {
+    writers.append(new ProcedureWriter(db, airportIndex));
+    writers.last()->setBuffered(true);
+    writers.last()->setFixIndex(&fixIndex);
+  }
+
+  // Procedure rows for each airport
+  QVector<QVector<ProcedureInput> > airports;
+
+  QString curAirport, databaseName = db.databaseName();
   int num = 0;
-  while(query.next())
+  try
   {
-    QString airportIdent = query.valueStr("airport_identifier");
-    if(query.valueStr("area_code") == "CTL")
-      // Ignore artificial circle-to-land duplicates
-      continue;
+    while(query.next())
+    {
+      QString airportIdent = query.valueStr("airport_identifier");
+      if(query.valueStr("area_code") == "CTL")
+        // Ignore artificial circle-to-land duplicates
+        continue;
 
-    // if(airportIdent != "EKAH")
-    // continue;
-    // qDebug() << query.record();
+      // if(airportIdent != "EKAH")
+      // continue;
+      // qDebug() << query.record();
 
-    // Give some feedback for long process
-    if((++num % 10000) == 0)
-      qDebug() << num << airportIdent << "...";
+      // Give some feedback for long process
+      if((++num % 10000) == 0)
+        qDebug() << num << airportIdent << "...";
 
-    if(!curAirport.isEmpty() && airportIdent != curAirport)
-    {
-      // Write all procedures of this airport
-      procWriter->finish(procInput);
-      procWriter->reset();
-    }
+      if(airportIdent != curAirport)
+      {
+        // Write procedures for a full batch of airports before starting the next one
+        if(airports.size() >= PROCEDURE_BATCH_AIRPORTS)
+        {
+          writeProcedureBatch(airports, writers);
+          airports.clear();
+        }
+        airports.append(QVector<ProcedureInput>());
+      }
 
-    // qDebug() << query.record();
-    // Fill context for error reporting
-    procInput.context = QString("File %1, airport %2, procedure %3, transition %4").
-                        arg(db.databaseName()).
-                        arg(query.valueStr("airport_identifier")).
-                        arg(query.valueStr("procedure_identifier")).
-                        arg(query.valueStr("transition_identifier"));
+      ProcedureInput procInput;
 
-    procInput.airportIdent = airportIdent;
-    procInput.airportId = airportIndex->getAirportId(airportIdent);
-    procInput.airportPos = ageo::PosD(airportIndex->getAirportPos(airportIdent));
+      // Context for error reporting is formatted only when needed
+      procInput.contextFile = databaseName;
+      procInput.rowCode = rowCode;
+      procInput.airportIdent = airportIdent;
+      procInput.airportId = airportIndex->getAirportId(airportIdent);
+      procInput.airportPos = ageo::PosD(airportIndex->getAirportPos(airportIdent));
 
-    // Fill data for procedure writer
-    fillProcedureInput(procInput, query);
+      // Fill data for procedure writer
+      fillProcedureInput(procInput, query);
+      airports.last().append(procInput);
 
-    // Leave the complicated states to the procedure writer
-    procWriter->write(procInput);
+      curAirport = airportIdent;
+    }
 
-    curAirport = procInput.airportIdent;
+    writeProcedureBatch(airports, writers);
   }
-  procWriter->finish(procInput);
-  procWriter->reset();
+  catch(...)
+  {
+    qDeleteAll(writers);
+    throw;
+  }
+  qDeleteAll(writers);
+}
+
+void DfdCompiler::writeProcedureBatch(const QVector<QVector<common::ProcedureInput> >& airports,
+                                      const QVector<common::ProcedureWriter *>& writers)
+{
+  using atools::fs::common::ProcedureInput;
+  using atools::fs::common::ProcedureWriter;
+
+  // Records in insert order for each airport
+  QVector<ProcedureWriter::RecordList> airportRecords(airports.size());
+
+  ProcedureWriter::RecordList *recordsData = airportRecords.data();
+
+  // Each thread uses its own writer and takes the next airport until all are done
+  atools::util::runParallel(airports.size(), 1, [&airports, recordsData, &writers](int i, int, int thread) -> void {
+    ProcedureWriter *writer = writers.at(thread);
+
+    // Leave the complicated states to the procedure writer
+    const QVector<ProcedureInput>& inputs = airports.at(i);
+    for(const ProcedureInput& procInput : inputs)
+      writer->write(procInput);
+
+    // Write all procedures of this airport
+    writer->finish(inputs.constLast());
+    recordsData[i] = writer->takeRecords();
+    writer->reset();
+  }, writers.size());
+
+  // Assign ids and insert in order of airports
+  for(const ProcedureWriter::RecordList& records : qAsConst(airportRecords))
+    procWriter->writeRecords(records);
 }
 
 void DfdCompiler::fillProcedureInput(atools::fs::common::ProcedureInput& procInput, const atools::sql::SqlQuery& query)
@@ -1425,7 +1489,7 @@ void DfdCompiler::readHeader()
 
 void DfdCompiler::compileMagDeclBgl()
 {
-  magDecReader->readFromWmm();
+  magDecReader->readFromWmm(QDate::currentDate(), options.getMagDecCellsPerDegree());
   magDecReader->writeToTable(db);
   db.commit();
 }
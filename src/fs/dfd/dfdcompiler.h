@@ -36,6 +36,7 @@ namespace common {
 class MagDecReader;
 class MetadataWriter;
 class AirportIndex;
+class FixIndex;
 class ProcedureWriter;
 struct ProcedureInput;
 
@@ -151,8 +152,14 @@ private:
   /* Fill input structure for ProcedureWriter */
   void fillProcedureInput(atools::fs::common::ProcedureInput& procInput, const atools::sql::SqlQuery& query);
 
-  /* Write on procedure type - SID, STAR, approaches */
-  void writeProcedure(const QString& table, const QString& rowCode);
+  /* Write on procedure type - SID, STAR, approaches. Airports are processed in parallel batches and
+   * written in order of the source table. */
+  void writeProcedure(const QString& table, const QString& rowCode, const atools::fs::common::FixIndex& fixIndex);
+
+  /* Build procedures for a batch of airports in worker threads using the buffered writers and insert
+   * them afterwards in the calling thread */
+  void writeProcedureBatch(const QVector<QVector<atools::fs::common::ProcedureInput> >& airports,
+                           const QVector<atools::fs::common::ProcedureWriter *>& writers);
 
   /* Start airspace and fill insert query with general airspace data like limits and name from the first source column */
   void beginAirspace(const sql::SqlQuery& query);
@@ -38,6 +38,7 @@
 #include "fs/scenery/languagejson.h"
 #include "fs/scenery/materiallib.h"
 #include "fs/scenery/contentxml.h"
+#include "util/parallel.h"
 
 #include <QDir>
 #include <QElapsedTimer>
@@ -45,6 +46,7 @@
 #include <QQueue>
 #include <QStandardPaths>
 #include <QStringBuilder>
+#include <QThread>
 
 namespace atools {
 namespace fs {
@@ -68,6 +70,9 @@ static const int PROGRESS_NUM_RESOLVE_AIRWAY_STEPS = 1000;
 // createSchemaInternal()
 static const int PROGRESS_NUM_SCHEMA_STEPS = 8;
 
+// Maximum number of SQLite sorter helper threads - SQLITE_MAX_WORKER_THREADS is 8 by default
+static const int MAX_SQLITE_SORTER_THREADS = 8;
+
 using atools::sql::SqlScript;
 using atools::sql::SqlQuery;
 using atools::sql::SqlUtil;
@@ -568,18 +573,32 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
 
   // ==============================================================================
   // Calculate the total number of progress steps
+  // Remember times of the discovery phase since the progress handler is reset afterwards
+  QVector<std::pair<QString, qint64> > discoveryTimes;
+  QElapsedTimer discoveryTimer;
+  discoveryTimer.start();
+  auto discoveryStepDone = [&discoveryTimes, &discoveryTimer](const QString& step) -> void {
+                             discoveryTimes.append(std::make_pair(step, discoveryTimer.restart()));
+                           };
+
   FsPaths::SimulatorType sim = options->getSimulatorType();
   int total = 0;
   if(FsPaths::isAnyXplane(sim))
+  {
     total = countXplaneSteps(&progress);
+    discoveryStepDone("Discovery: X-Plane files");
+  }
   else if(sim == FsPaths::NAVIGRAPH)
     total = countDfdSteps();
   else if(sim == FsPaths::MSFS)
   {
     // Fill with default required entries but does not read a file
     readSceneryConfigMsfs(sceneryCfg);
+    discoveryStepDone("Discovery: MSFS packages");
     readSceneryConfigIncludePathsFsxP3dMsfs(sceneryCfg);
+    discoveryStepDone("Discovery: include paths");
     total = countMsfsSteps(&progress, sceneryCfg);
+    discoveryStepDone("Discovery: BGL files");
 
     // Check for Navigraph packages to report back to caller
     for(const SceneryArea& area : qAsConst(sceneryCfg.getAreas()))
@@ -598,8 +617,11 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
   {
     // Read scenery.cfg
     readSceneryConfigFsxP3d(sceneryCfg);
+    discoveryStepDone("Discovery: scenery.cfg and add-ons");
     readSceneryConfigIncludePathsFsxP3dMsfs(sceneryCfg);
+    discoveryStepDone("Discovery: include paths");
     total = countFsxP3dSteps(&progress, sceneryCfg);
+    discoveryStepDone("Discovery: BGL files");
   }
 
   if(aborted)
@@ -610,10 +632,19 @@ atools::fs::ResultFlags NavDatabase::createInternal(const QString& sceneryConfig
   progress.reset();
   progress.setTotal(total);
 
+  for(const std::pair<QString, qint64>& discoveryTime : qAsConst(discoveryTimes))
+    progress.reportStepTime(discoveryTime.first, discoveryTime.second);
+
   createSchemaInternal(&progress);
   if(aborted)
     return result;
 
+  // Scripts like "create_indexes_post_load.sql" or "finish_schema.sql" are dominated by sorting in "create index".
+  // SQLite allows only one writer per database file which means that scripts cannot run concurrently on separate
+  // connections. Instead let SQLite use helper threads for sorting within each statement.
+  SqlQuery(db).exec(QString("pragma threads = %1").
+                    arg(std::min(std::max(QThread::idealThreadCount() - 1, 0), MAX_SQLITE_SORTER_THREADS)));
+
   // -----------------------------------------------------------------------
   // Create empty data writer pointers which will read all files and fill the database
   // Pointers will be initialized on demand/compilation type and be delete on exit (like thrown exception)
@@ -1443,8 +1474,14 @@ bool NavDatabase::runScript(ProgressHandler *progress, const QString& scriptFile
     if((aborted = progress->reportOtherInc(message, PROGRESS_NUM_SCRIPT_STEPS)))
       return true;
 
+  QElapsedTimer timer;
+  timer.start();
+
   script.executeScript(":/atools/resources/sql/" % scriptFile);
   db->commit();
+
+  if(progress != nullptr)
+    progress->reportStepTime(scriptFile, timer.elapsed());
   return false;
 }
 
@@ -1523,52 +1560,31 @@ void NavDatabase::readSceneryConfigMsfs(atools::fs::scenery::SceneryCfg& cfg)
   areaNav.setNavdata(); // Set flag to allow dummy airport handling
   cfg.appendArea(areaNav);
 
-  scenery::LayoutJson layout;
-
   // Read add-on packages in official ===============================
   const QDir dirOfficial(options->getMsfsOfficialPath(), QString(),
                          QDir::Name | QDir::IgnoreCase, QDir::Dirs | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
   QString baseName = dirOfficial.dirName();
-  const QFileInfoList entriesOfficial = dirOfficial.entryInfoList();
-  for(QFileInfo fileinfo : entriesOfficial)
-  {
-    QString name = fileinfo.fileName();
-    fileinfo.setFile(atools::canonicalFilePath(fileinfo));
 
-    if(contentXml.isDisabled(name))
-    {
-      // Entry is present in Content.xml and has has active="false"
-      qDebug() << Q_FUNC_INFO << "Skipping disabled" << name;
-      continue;
-    }
-
-    if(name == "fs-base-nav" || name == "fs-base" || name == "fs-base-genericairports")
-      // Already read before - do not touch name or priority
-      continue;
-
-    // Read manifest to check type
-    manifest.clear();
-    manifest.read(fileinfo.filePath() % SEP % "manifest.json");
-
-    if(manifest.isAnyScenery())
+  // Already read before - do not touch name or priority
+  const QVector<MsfsPackage> packagesOfficial = readMsfsPackages(dirOfficial.entryInfoList(), contentXml,
+                                                                 {"fs-base-nav", "fs-base", "fs-base-genericairports"});
+  for(const MsfsPackage& package : packagesOfficial)
+  {
+    if(package.anyScenery)
     {
-      // Read BGL and material file locations from layout file
-      layout.clear();
-      layout.read(fileinfo.filePath() % SEP % "layout.json");
-
-      SceneryArea addonArea(contentXml.getPriority(name, LAYER_NUM_DEFAULT), baseName, atools::canonicalFilePath(fileinfo));
-      if(manifest.isScenery() && layout.hasFsArchive() && errors != nullptr)
+      SceneryArea addonArea(contentXml.getPriority(package.name, LAYER_NUM_DEFAULT), baseName, package.path);
+      if(package.scenery && package.fsArchive && errors != nullptr)
         errors->sceneryErrors.append(
-          NavDatabaseErrors::SceneryErrors(addonArea, tr("Encrypted add-on \"%1\" found. Add-on might not show up correctly.").arg(name),
+          NavDatabaseErrors::SceneryErrors(addonArea, tr("Encrypted add-on \"%1\" found. Add-on might not show up correctly.").arg(package.name),
                                            true /* isWarning */));
 
-      if(!layout.getBglPaths().isEmpty())
+      if(package.bglFiles)
       {
         // Indicate add-on in official path
         addonArea.setAddOn(true);
 
         // Detect Navigraph navdata update packages for special handling
-        addonArea.setNavigraphNavdata(isNavigraphNavdata(manifest));
+        addonArea.setNavigraphNavdata(package.navigraph);
 
         cfg.getAreas().append(addonArea);
       }
@@ -1580,39 +1596,22 @@ void NavDatabase::readSceneryConfigMsfs(atools::fs::scenery::SceneryCfg& cfg)
   const QDir dirCommunity(options->getMsfsCommunityPath(), QString(),
                           QDir::Name | QDir::IgnoreCase, QDir::Dirs | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
 
-  const QFileInfoList entriesCommunity = dirCommunity.entryInfoList();
-  for(QFileInfo fileinfo : entriesCommunity)
+  const QVector<MsfsPackage> packagesCommunity = readMsfsPackages(dirCommunity.entryInfoList(), contentXml, QStringList());
+  for(const MsfsPackage& package : packagesCommunity)
   {
-    QString name = fileinfo.fileName();
-    fileinfo.setFile(atools::canonicalFilePath(fileinfo));
-
-    if(contentXml.isDisabled(name))
-    {
-      // Entry is present in Content.xml and has has active="false"
-      qDebug() << Q_FUNC_INFO << "Skipping disabled" << name;
-      continue;
-    }
-
-    manifest.clear();
-    manifest.read(fileinfo.filePath() % SEP % "manifest.json");
-
-    if(manifest.isAnyScenery())
+    if(package.anyScenery)
     {
-      // Read BGL and material file locations from layout file
-      layout.clear();
-      layout.read(fileinfo.filePath() % SEP % "layout.json");
-
-      SceneryArea addonArea(contentXml.getPriority(name, LAYER_NUM_DEFAULT), tr("Community"), atools::canonicalFilePath(fileinfo));
+      SceneryArea addonArea(contentXml.getPriority(package.name, LAYER_NUM_DEFAULT), tr("Community"), package.path);
       addonArea.setCommunity(true);
-      if(manifest.isScenery() && layout.hasFsArchive() && errors != nullptr)
+      if(package.scenery && package.fsArchive && errors != nullptr)
         errors->sceneryErrors.append(
-          NavDatabaseErrors::SceneryErrors(addonArea, tr("Encrypted add-on \"%1\" found. Add-on might not show up correctly.").arg(name),
+          NavDatabaseErrors::SceneryErrors(addonArea, tr("Encrypted add-on \"%1\" found. Add-on might not show up correctly.").arg(package.name),
                                            true /* isWarning */));
 
-      if(!layout.getBglPaths().isEmpty())
+      if(package.bglFiles)
       {
         // Detect Navigraph navdata update packages for special handling
-        addonArea.setNavigraphNavdata(isNavigraphNavdata(manifest));
+        addonArea.setNavigraphNavdata(package.navigraph);
 
         cfg.getAreas().append(addonArea);
       }
@@ -1623,6 +1622,61 @@ void NavDatabase::readSceneryConfigMsfs(atools::fs::scenery::SceneryCfg& cfg)
   cfg.sortAreas();
 }
 
+QVector<NavDatabase::MsfsPackage> NavDatabase::readMsfsPackages(const QFileInfoList& entries,
+                                                                const scenery::ContentXml& contentXml,
+                                                                const QStringList& skipNames)
+{
+  // Filter names first in this thread
+  QVector<MsfsPackage> packages;
+  QFileInfoList packageDirs;
+  for(const QFileInfo& fileinfo : entries)
+  {
+    QString name = fileinfo.fileName();
+    if(contentXml.isDisabled(name))
+    {
+      // Entry is present in Content.xml and has has active="false"
+      qDebug() << Q_FUNC_INFO << "Skipping disabled" << name;
+      continue;
+    }
+
+    if(skipNames.contains(name))
+      continue;
+
+    MsfsPackage package;
+    package.name = name;
+    packages.append(package);
+    packageDirs.append(fileinfo);
+  }
+
+  // Resolve paths and parse the JSON files which can be large in parallel =================
+  // Work directly on raw arrays to avoid detaching in the threads
+  MsfsPackage *packageData = packages.data();
+  const QFileInfo *dirData = packageDirs.constData();
+  atools::util::runParallel(packages.size(), 1, [this, packageData, dirData](int i, int, int) -> void {
+    MsfsPackage& package = packageData[i];
+    package.path = atools::canonicalFilePath(dirData[i]);
+
+    // Read manifest to check type
+    scenery::ManifestJson manifest;
+    manifest.read(package.path % SEP % "manifest.json");
+
+    package.anyScenery = manifest.isAnyScenery();
+    if(package.anyScenery)
+    {
+      // Read BGL and material file locations from layout file
+      scenery::LayoutJson layout;
+      layout.read(package.path % SEP % "layout.json");
+
+      package.scenery = manifest.isScenery();
+      package.fsArchive = layout.hasFsArchive();
+      package.bglFiles = !layout.getBglPaths().isEmpty();
+      package.navigraph = isNavigraphNavdata(manifest);
+    }
+  });
+
+  return packages;
+}
+
 bool NavDatabase::isNavigraphNavdata(atools::fs::scenery::ManifestJson& manifest)
 {
   // navigraph-navdata
@@ -2018,15 +2072,39 @@ void NavDatabase::countFiles(ProgressHandler *progress, const QList<atools::fs::
                              int& numFiles, int& numSceneryAreas)
 {
   qDebug() << Q_FUNC_INFO << "Entry";
-  atools::fs::scenery::FileResolver resolver(*options, true);
 
-  for(const SceneryArea& area : areas)
+  // Directories are walked in parallel in batches to allow progress reports and cancellation in between
+  const int size = static_cast<int>(areas.size());
+  const int batchSize = std::max(QThread::idealThreadCount(), 1) * 4;
+  QVector<int> counts(size, 0);
+  int *countData = counts.data();
+
+  // Options use QRegExp for filters which cannot be shared between threads
+  // Each worker thread gets its own copy with rebuilt filters and the calling thread uses the original
+  const int numThreads = atools::util::parallelThreadCount(std::min(batchSize, size));
+  std::vector<NavDatabaseOptions> optionsCopies(static_cast<size_t>(numThreads - 1), *options);
+  QVector<const NavDatabaseOptions *> threadOptions({options});
+  for(NavDatabaseOptions& opts : optionsCopies)
+  {
+    opts.detachFilters();
+    threadOptions.append(&opts);
+  }
+  const NavDatabaseOptions *const *optionsData = threadOptions.constData();
+
+  for(int start = 0; start < size; start += batchSize)
   {
-    if((aborted = progress->reportOtherMsg(tr("Counting files for %1 ...").arg(area.getTitle()))))
+    if((aborted = progress->reportOtherMsg(tr("Counting files for %1 ...").arg(areas.at(start).getTitle()))))
       return;
 
-    int num = resolver.getFiles(area);
+    atools::util::runParallel(std::min(batchSize, size - start), 1,
+                              [&areas, countData, optionsData, start](int i, int, int thread) -> void {
+      atools::fs::scenery::FileResolver resolver(*optionsData[thread], true);
+      countData[start + i] = resolver.getFiles(areas.at(start + i));
+    }, numThreads);
+  }
 
+  for(int num : qAsConst(counts))
+  {
     if(num > 0)
     {
       numFiles += num;
@@ -24,6 +24,7 @@
 #include <QDebug>
 #include <QCoreApplication>
 #include <QFileInfo>
+#include <QVector>
 
 namespace atools {
 namespace sql {
@@ -40,6 +41,7 @@ class SceneryCfg;
 class AddOnComponent;
 class SceneryArea;
 class ManifestJson;
+class ContentXml;
 }
 
 namespace db {
@@ -190,6 +192,18 @@ private:
   /* Detect Navigraph navdata update packages for special handling. */
   bool isNavigraphNavdata(atools::fs::scenery::ManifestJson& manifest);
 
+  /* Manifest and layout information of a MSFS package directory */
+  struct MsfsPackage
+  {
+    QString name, path; /* Directory name and canonical path */
+    bool anyScenery = false, scenery = false, fsArchive = false, bglFiles = false, navigraph = false;
+  };
+
+  /* Reads manifest.json and layout.json for all package directories in parallel.
+   * Skips packages disabled in Content.xml and names in skipNames. Result has the same order as entries. */
+  QVector<MsfsPackage> readMsfsPackages(const QFileInfoList& entries, const atools::fs::scenery::ContentXml& contentXml,
+                                        const QStringList& skipNames);
+
   atools::sql::SqlDatabase *db;
   atools::fs::NavDatabaseErrors *errors = nullptr;
   const atools::fs::NavDatabaseOptions *options = nullptr;
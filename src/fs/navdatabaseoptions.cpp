@@ -235,6 +235,7 @@ void NavDatabaseOptions::loadFromSettings(QSettings& settings)
   setVerbose(settings.value("Options/Verbose", false).toBool());
   setResolveAirways(settings.value("Options/ResolveRoutes", true).toBool());
   setLanguage(settings.value("Options/MsfsAirportLanguage", "en-US").toString());
+  setMagDecCellsPerDegree(settings.value("Options/MagDecCellsPerDegree", 1).toInt());
   setCreateRouteTables(settings.value("Options/CreateRouteTables", false).toBool());
   setCreateAirportTables(settings.value("Options/CreateAirportTables", false).toBool());
   setDatabaseReport(settings.value("Options/DatabaseReport", true).toBool());
@@ -322,6 +323,24 @@ void NavDatabaseOptions::addToFilterList(const QStringList& filters, QList<QRegE
     addToFilter(filter, filterList);
 }
 
+void NavDatabaseOptions::detachFilters()
+{
+  for(QList<QRegExp> *filterList : {&fileFiltersInc, &pathFiltersInc, &addonFiltersInc, &airportIcaoFiltersInc,
+                                    &fileFiltersExcl, &pathFiltersExcl, &addonFiltersExcl, &airportIcaoFiltersExcl,
+                                    &highPriorityFiltersInc, &dirExcludesGui, &fileExcludesGui, &dirAddonExcludesGui,
+                                    &fileAddonExcludesGui})
+    detachFilterList(*filterList);
+}
+
+void NavDatabaseOptions::detachFilterList(QList<QRegExp>& filterList)
+{
+  QList<QRegExp> detached;
+  detached.reserve(filterList.size());
+  for(const QRegExp& regexp : qAsConst(filterList))
+    detached.append(QRegExp(regexp.pattern(), regexp.caseSensitivity(), regexp.patternSyntax()));
+  filterList = detached;
+}
+
 void NavDatabaseOptions::addToFilter(const QString& filter, QList<QRegExp>& filterList)
 {
   if(!filter.isEmpty())
@@ -358,6 +377,7 @@ QDebug operator<<(QDebug out, const NavDatabaseOptions& opts)
 {
   QDebugStateSaver saver(out);
   out.nospace().noquote() << "NavDatabaseOptions[flags " << opts.flags;
+  out << ", magDecCellsPerDegree " << opts.magDecCellsPerDegree;
 
   out << ", fileFiltersInc [" << patternStr(opts.fileFiltersInc) << "]";
   out << ", fileFiltersExcl [" << patternStr(opts.fileFiltersExcl) << "]";
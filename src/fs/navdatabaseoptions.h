@@ -504,6 +504,24 @@ public:
 
   void setLanguage(const QString& value);
 
+  /* Resolution of the magnetic declination grid calculated from the world magnetic model for X-Plane,
+   * DFD and MSFS. 1 is the default one degree grid which can be read by all versions. 4 results in a
+   * 0.25 degree grid. Has no effect if the grid is read from a magdec.bgl file. */
+  int getMagDecCellsPerDegree() const
+  {
+    return magDecCellsPerDegree;
+  }
+
+  void setMagDecCellsPerDegree(int value)
+  {
+    magDecCellsPerDegree = value;
+  }
+
+  /* Rebuilds all filter regular expressions so that a copy of the options does not share them with the original.
+   * Copies of QList<QRegExp> share the same QRegExp objects and QRegExp::exactMatch() changes the match state.
+   * Call on a copy before using it in another thread. */
+  void detachFilters();
+
 private:
   friend QDebug operator<<(QDebug out, const atools::fs::NavDatabaseOptions& opts);
 
@@ -522,6 +540,7 @@ private:
 
   void addToFilterList(const QStringList& filters, QList<QRegExp>& filterList);
   void addToFilter(const QString& filter, QList<QRegExp>& filterList);
+  static void detachFilterList(QList<QRegExp>& filterList);
   bool includeObject(const QString& string, const QList<QRegExp>& filterListInc, const QList<QRegExp>& filterListExcl) const;
 
   void addToBglObjectFilter(const QStringList& filters, QSet<atools::fs::type::NavDbObjectType>& filterList);
@@ -552,6 +571,7 @@ private:
   bool callDefaultCallback = true;
 
   atools::fs::FsPaths::SimulatorType simulatorType = atools::fs::FsPaths::FSX;
+  int magDecCellsPerDegree = 1;
 };
 
 } // namespace fs
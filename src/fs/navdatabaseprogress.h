@@ -19,6 +19,7 @@
 #define ATOOLS_FS_NAVDATABASEPROGRESS_H
 
 #include <QString>
+#include <QVector>
 
 namespace atools {
 namespace fs {
@@ -217,6 +218,14 @@ public:
     return numErrors;
   }
 
+  /*
+   * @return name and execution time in milliseconds of each finished step like SQL scripts in order of execution
+   */
+  const QVector<std::pair<QString, qint64> >& getStepTimes() const
+  {
+    return stepTimes;
+  }
+
 private:
   friend atools::fs::ProgressHandler;
 
@@ -227,6 +236,7 @@ private:
   bool newFile = false, newSceneryArea = false, newOther = false, firstCall = true, lastCall = false;
   QString filepath, otherAction;
   const atools::fs::scenery::SceneryArea *sceneryArea = nullptr;
+  QVector<std::pair<QString, qint64> > stepTimes;
 
 };
 
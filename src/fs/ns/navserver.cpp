@@ -20,6 +20,7 @@
 #include "fs/ns/navservercommon.h"
 #include "fs/ns/navserverworker.h"
 #include "fs/sc/datareaderthread.h"
+#include "fs/sc/simconnectdata.h"
 #include "util/htmlbuilder.h"
 
 #include <QNetworkInterface>
@@ -30,9 +31,10 @@ namespace fs {
 namespace ns {
 
 NavServer::NavServer(QObject *parent, atools::fs::ns::NavServerOptions optionFlags, int inetPort)
-  : QTcpServer(parent), options(optionFlags), port(inetPort)
+  : QTcpServer(parent), options(optionFlags), numDeltaClients(0), port(inetPort)
 {
   qDebug("NavServer created");
+  qRegisterMetaType<atools::fs::ns::NavServerPacket>();
 }
 
 NavServer::~NavServer()
@@ -48,6 +50,10 @@ void NavServer::stopServer()
   if(isListening())
     close();
 
+  if(dataReader != nullptr)
+    disconnect(dataReader, &atools::fs::sc::DataReaderThread::postSimConnectData, this,
+               &NavServer::postSimConnectData);
+
   // Stop all worker threads
   QSet<NavServerWorker *> workersCopy(workers);
   for(NavServerWorker *worker : workersCopy)
@@ -64,6 +70,10 @@ bool NavServer::startServer(atools::fs::sc::DataReaderThread *dataReaderThread)
   dataReader = dataReaderThread;
   qDebug() << "Navserver starting";
 
+  // Serialize data in the reader thread once and pass the bytes on to all workers
+  connect(dataReader, &atools::fs::sc::DataReaderThread::postSimConnectData, this,
+          &NavServer::postSimConnectData, Qt::DirectConnection);
+
   // hostname/ip/v6
   struct Host
   {
@@ -182,7 +192,7 @@ void NavServer::incomingConnection(qintptr socketDescriptor)
   qDebug() << "Incoming connection";
 
   // Create a worker and set name
-  NavServerWorker *worker = new NavServerWorker(socketDescriptor, nullptr, options);
+  NavServerWorker *worker = new NavServerWorker(socketDescriptor, this, options);
   worker->setObjectName("SocketWorker-" + QString::number(socketDescriptor));
 
   // Create new thread and move the worker into the thread context
@@ -197,15 +207,15 @@ void NavServer::incomingConnection(qintptr socketDescriptor)
           threadFinished(worker);
         });
 
-  // Data reader will send simconnect packages through this connection
-  connect(dataReader, &atools::fs::sc::DataReaderThread::postSimConnectData, worker,
-          &NavServerWorker::postSimConnectData);
+  // Serialized simconnect packages are sent through this connection
+  connect(this, &NavServer::postPacket, worker, &NavServerWorker::postPacket);
   connect(worker, &NavServerWorker::postWeatherRequest,
           dataReader, &atools::fs::sc::DataReaderThread::setWeatherRequest);
 
   qDebug() << "Thread" << worker->objectName();
   workerThread->start();
 
+  QMutexLocker locker(&threadsMutex);
   workers.insert(worker);
 }
 
@@ -216,8 +226,7 @@ void NavServer::threadFinished(NavServerWorker *worker)
   // A thread has finished - lock the list so the thread can be removed from the list
   QMutexLocker locker(&threadsMutex);
 
-  disconnect(dataReader, &atools::fs::sc::DataReaderThread::postSimConnectData, worker,
-             &NavServerWorker::postSimConnectData);
+  disconnect(this, &NavServer::postPacket, worker, &NavServerWorker::postPacket);
 
   // TODO crashes when connected
   // disconnect(worker, &NavServerWorker::postCommand,
@@ -230,6 +239,54 @@ void NavServer::threadFinished(NavServerWorker *worker)
   worker->thread()->deleteLater();
 }
 
+void NavServer::postSimConnectData(const sc::SimConnectData& data)
+{
+  int numWorkers;
+  {
+    QMutexLocker locker(&threadsMutex);
+    numWorkers = workers.size();
+  }
+
+  // Avoid serialization if nobody is connected
+  if(numWorkers == 0)
+    return;
+
+  // Serialize only the formats which are needed by connected clients
+  int numDelta = numDeltaClients.load();
+  NavServerPacket packet;
+  if(numWorkers > numDelta)
+    packet.bytes = data.writeToByteArray();
+
+  if(numDelta > 0)
+  {
+    packet.deltaBytes = data.writeDeltaToByteArray(deltaEncoder);
+    packet.keyframeId = deltaEncoder.getLastPacketKeyframeId();
+    packet.keyframe = deltaEncoder.isLastKeyframe();
+  }
+
+  packet.packetId = data.getPacketId();
+  packet.numMetars = data.getMetars().size();
+  packet.userAircraftValid = data.getUserAircraftConst().isValid();
+
+  if(options & VERBOSE)
+    qDebug() << Q_FUNC_INFO << "packet id" << packet.packetId << "size" << packet.bytes.size()
+             << "delta size" << packet.deltaBytes.size() << "keyframe" << packet.keyframe << packet.keyframeId;
+
+  emit postPacket(packet);
+}
+
+void NavServer::deltaClientAdded()
+{
+  // New client needs a keyframe
+  numDeltaClients++;
+  deltaEncoder.requestKeyframe();
+}
+
+void NavServer::deltaClientRemoved()
+{
+  numDeltaClients--;
+}
+
 bool NavServer::hasConnections() const
 {
   QMutexLocker locker(&threadsMutex);
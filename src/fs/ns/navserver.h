@@ -19,6 +19,7 @@
 #define LITTLENAVCONNECT_NAVSERVER_H
 
 #include "fs/ns/navservercommon.h"
+#include "fs/sc/simconnectdelta.h"
 
 #include <QMutex>
 #include <QTcpServer>
@@ -55,23 +56,44 @@ public:
   /* true if any workers are in the list */
   bool hasConnections() const;
 
+  /* Called by workers from their thread when client switches to the delta protocol or disconnects. */
+  void deltaClientAdded();
+  void deltaClientRemoved();
+
+  /* Called by workers if their client has not received the current keyframe. */
+  void requestKeyframe()
+  {
+    deltaEncoder.requestKeyframe();
+  }
+
   /* Need a stop/start to use new port */
   void setPort(int value)
   {
     port = value;
   }
 
+signals:
+  /* Sent to all workers once per data packet */
+  void postPacket(atools::fs::ns::NavServerPacket packet);
+
 private:
   void incomingConnection(qintptr socketDescriptor) override;
   void threadFinished(NavServerWorker *worker);
 
+  /* Called in the data reader thread context. Serializes data once for all workers and sends it. */
+  void postSimConnectData(const atools::fs::sc::SimConnectData& data);
+
   atools::fs::ns::NavServerOptions options = NONE;
-  atools::fs::sc::DataReaderThread *dataReader;
+  atools::fs::sc::DataReaderThread *dataReader = nullptr;
 
   QSet<NavServerWorker *> workers;
   // Needed to lock for any modifications of the workers set
   mutable QMutex threadsMutex;
 
+  /* Keyframe and delta state used in data reader thread */
+  atools::fs::sc::SimConnectDeltaEncoder deltaEncoder;
+  std::atomic_int numDeltaClients;
+
   int port = 51968;
 };
 
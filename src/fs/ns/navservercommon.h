@@ -18,6 +18,7 @@
 #ifndef ATOOLS_NS_COMMON_H
 #define ATOOLS_NS_COMMON_H
 
+#include <QByteArray>
 #include <QLoggingCategory>
 
 namespace atools {
@@ -34,6 +35,23 @@ enum NavServerOption
 Q_DECLARE_FLAGS(NavServerOptions, NavServerOption);
 Q_DECLARE_OPERATORS_FOR_FLAGS(atools::fs::ns::NavServerOptions);
 
+/* SimConnectData serialized once per update and sent to all workers.
+ * Bytes are implicitly shared and not copied per client. */
+struct NavServerPacket
+{
+  /* Full packet for clients using the legacy protocol. Empty if no such client is connected. */
+  QByteArray bytes;
+
+  /* Delta protocol packet. Empty if no delta client is connected. */
+  QByteArray deltaBytes;
+  quint32 keyframeId = 0;
+  bool keyframe = false;
+
+  int packetId = 0;
+  int numMetars = 0;
+  bool userAircraftValid = false;
+};
+
 /* Declare a own logging category to append in the text edit */
 Q_DECLARE_LOGGING_CATEGORY(gui);
 
@@ -41,4 +59,6 @@ Q_DECLARE_LOGGING_CATEGORY(gui);
 } // namespace fs
 } // namespace atools
 
+Q_DECLARE_METATYPE(atools::fs::ns::NavServerPacket);
+
 #endif // ATOOLS_NS_COMMON_H
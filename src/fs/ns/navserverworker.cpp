@@ -20,6 +20,7 @@
 #include "fs/ns/navserverworker.h"
 #include "fs/ns/navservercommon.h"
 #include "fs/sc/simconnectreply.h"
+#include "fs/sc/simconnectdatabase.h"
 
 #include <QThread>
 #include <QTcpSocket>
@@ -28,9 +29,9 @@ namespace atools {
 namespace fs {
 namespace ns {
 
-NavServerWorker::NavServerWorker(qintptr socketDescriptor, NavServer *parent,
+NavServerWorker::NavServerWorker(qintptr socketDescriptor, NavServer *navServerParam,
                                  atools::fs::ns::NavServerOptions optionFlags)
-  : QObject(parent), socketDescr(socketDescriptor), options(optionFlags)
+  : QObject(nullptr), socketDescr(socketDescriptor), navServer(navServerParam), options(optionFlags)
 {
   qDebug() << "NavServerWorker created" << QThread::currentThread()->objectName();
 }
@@ -71,6 +72,10 @@ void NavServerWorker::socketDisconnected()
   qInfo(gui).noquote().nospace() << tr("Connection from %1 (%2) closed.").
     arg(hostInfo.hostName()).arg(peerAddr);
 
+  if(deltaProtocol)
+    navServer->deltaClientRemoved();
+  deltaProtocol = false;
+
   socket->deleteLater();
   socket = nullptr;
   thread()->exit();
@@ -104,7 +109,15 @@ void NavServerWorker::readyReadReplyFromSocket()
     if(options & VERBOSE)
       qDebug() << "NavServerWorker readyReadReply packet id" << reply.getPacketId();
 
-    if(reply.getCommand() == atools::fs::sc::CMD_WEATHER_REQUEST)
+    if(reply.getCommand().testFlag(atools::fs::sc::CMD_DELTA_DATA) && !deltaProtocol)
+    {
+      // Client can read delta packets - switch over and get a keyframe with the next packet
+      qDebug() << "NavServerWorker client" << peerAddr << "uses delta protocol";
+      deltaProtocol = true;
+      navServer->deltaClientAdded();
+    }
+
+    if(reply.getCommand().testFlag(atools::fs::sc::CMD_WEATHER_REQUEST))
     {
       if(options & VERBOSE)
         qDebug() << "NavServerWorker::readyReadReply got weather request";
@@ -126,22 +139,22 @@ void NavServerWorker::readyReadReplyFromSocket()
     qDebug() << "NavServerWorker::readyReadReply leave";
 }
 
-void NavServerWorker::postSimConnectData(atools::fs::sc::SimConnectData dataPacket)
+void NavServerWorker::postPacket(atools::fs::ns::NavServerPacket packet)
 {
   if(options & VERBOSE)
-    qDebug() << "NavServerWorker postSimConnectData" << QThread::currentThread()->objectName()
+    qDebug() << "NavServerWorker postPacket" << QThread::currentThread()->objectName()
              << "last ids" << lastPacketIds;
 
-  if(!dataPacket.getMetars().isEmpty())
+  if(packet.numMetars > 0)
   {
     if(options & VERBOSE)
-      qDebug() << "NavServerWorker::postSimConnectData metars num " << dataPacket.getMetars().size();
+      qDebug() << "NavServerWorker::postPacket metars num " << packet.numMetars;
 
-    if(dataPacket.getUserAircraftConst().isValid())
+    if(packet.userAircraftValid)
       qWarning() << "Aircraft and metar mixed";
   }
 
-  if(lastPacketIds.size() > 1 && dataPacket.getPacketId() > 0)
+  if(lastPacketIds.size() > 1 && packet.packetId > 0)
   {
     // No reply received in the meantime - count it as dropped package and do not send a new package
     handleDroppedPackages(tr("Missing reply"));
@@ -152,22 +165,47 @@ void NavServerWorker::postSimConnectData(atools::fs::sc::SimConnectData dataPack
     // We're already posting
     qCritical() << "Nested post";
 
-  if(dataPacket.getPacketId() > 0)
+  // Bytes were serialized once by the server for all clients
+  const QByteArray *bytes = &packet.bytes;
+  if(deltaProtocol && !packet.deltaBytes.isEmpty())
+  {
+    if(packet.keyframe || packet.keyframeId == sentKeyframeId)
+    {
+      bytes = &packet.deltaBytes;
+      sentKeyframeId = packet.keyframeId;
+    }
+    else if(packet.keyframeId == 0)
+      // Does not depend on a keyframe like weather replies - send even if client has no keyframe yet
+      bytes = &packet.deltaBytes;
+    else
+      // Client does not know this keyframe - request one and use full packet meanwhile if available
+      navServer->requestKeyframe();
+  }
+
+  if(bytes->isEmpty())
+  {
+    if(options & VERBOSE)
+      qDebug() << "NavServerWorker no matching packet format for id" << packet.packetId;
+    return;
+  }
+
+  if(packet.packetId > 0)
     // Insert packet id in sent list if this is not a weather request
-    lastPacketIds.insert(dataPacket.getPacketId());
+    lastPacketIds.insert(packet.packetId);
 
   inPost = true;
 
-  int written;
-  written = dataPacket.write(socket);
-  if(dataPacket.getStatus() != atools::fs::sc::OK)
-    qWarning(gui).noquote().nospace() << tr("Error writing data: %1.").arg(dataPacket.getStatusText());
+  atools::fs::sc::SimConnectStatus status = atools::fs::sc::OK;
+  int written = atools::fs::sc::SimConnectDataBase::writeBlock(socket, *bytes, status);
+  if(status != atools::fs::sc::OK)
+    qWarning(gui).noquote().nospace() << tr("Error writing data: %1.").
+      arg(atools::fs::sc::SimConnectDataBase::getStatusText(status));
 
   if(!socket->flush())
     qWarning() << "NavServerWorker Reply to client not flushed";
 
   if(options & VERBOSE)
-    qDebug() << "NavServerWorker written" << written << "flush" << flush << "id" << dataPacket.getPacketId();
+    qDebug() << "NavServerWorker written" << written << "id" << packet.packetId;
 
   inPost = false;
 }
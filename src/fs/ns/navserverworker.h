@@ -18,8 +18,6 @@
 #ifndef ATOOLS_NS_NAVSERVERTHREAD_H
 #define ATOOLS_NS_NAVSERVERTHREAD_H
 
-#include "fs/sc/simconnectdata.h"
-
 #include "fs/sc/simconnectreply.h"
 #include "fs/ns/navservercommon.h"
 
@@ -42,14 +40,16 @@ class NavServerWorker :
   Q_OBJECT
 
 public:
-  explicit NavServerWorker(qintptr socketDescriptor, NavServer *parent, atools::fs::ns::NavServerOptions optionFlags);
+  /* Worker has no parent since it is moved to its own thread. navServerParam is used for the delta protocol. */
+  explicit NavServerWorker(qintptr socketDescriptor, NavServer *navServerParam,
+                           atools::fs::ns::NavServerOptions optionFlags);
   virtual ~NavServerWorker() override;
 
   NavServerWorker(const NavServerWorker& other) = delete;
   NavServerWorker& operator=(const NavServerWorker& other) = delete;
 
-  /* Receives sim connect data from DataReader thread and writes to socket. */
-  void postSimConnectData(atools::fs::sc::SimConnectData dataPacket);
+  /* Receives serialized sim connect data from NavServer and writes the bytes to socket. */
+  void postPacket(atools::fs::ns::NavServerPacket packet);
 
   /* Signal posted by thread to indicate it has started . */
   void threadStarted();
@@ -71,7 +71,7 @@ private:
   const int MAX_DROPPED_PACKAGES = 50;
 
   qintptr socketDescr;
-  atools::fs::sc::SimConnectData data;
+  NavServer *navServer;
   QTcpSocket *socket = nullptr;
 
   atools::fs::ns::NavServerOptions options = NONE;
@@ -80,6 +80,10 @@ private:
   int droppedPackages = 0;
   bool inPost = false;
 
+  /* Client requested delta encoded packets. Keyframe id last sent to the client. */
+  bool deltaProtocol = false;
+  quint32 sentKeyframeId = 0;
+
   /* Add packet id on send and remove when reply is received */
   QSet<int> lastPacketIds;
   QString peerAddr;
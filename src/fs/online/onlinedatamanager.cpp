@@ -114,6 +114,11 @@ int OnlinedataManager::getReloadMinutesFromWhazzup() const
   return whazzup->getReloadMinutes();
 }
 
+const OnlineChanges& OnlinedataManager::getChangesFromWhazzup() const
+{
+  return whazzup->getChanges();
+}
+
 bool OnlinedataManager::hasSchema()
 {
   return SqlUtil(db).hasTable("client");
@@ -133,6 +138,10 @@ void OnlinedataManager::createSchema()
 
   script.executeScript(":/atools/resources/sql/fs/online/create_online_schema.sql");
   transaction.commit();
+
+  // Tables are empty now - insert all rows again on next update
+  whazzup->resetChangeTracking();
+  whazzupServers->resetChangeTracking();
 }
 
 void OnlinedataManager::clearData()
@@ -142,6 +151,9 @@ void OnlinedataManager::clearData()
   for(const QString& table : tables)
     db->exec("delete from " + table);
   transaction.commit();
+
+  whazzup->resetChangeTracking();
+  whazzupServers->resetChangeTracking();
 }
 
 void OnlinedataManager::dropSchema()
@@ -153,6 +165,9 @@ void OnlinedataManager::dropSchema()
 
   script.executeScript(":/atools/resources/sql/fs/online/drop_online_schema.sql");
   transaction.commit();
+
+  whazzup->resetChangeTracking();
+  whazzupServers->resetChangeTracking();
 }
 
 void OnlinedataManager::reset()
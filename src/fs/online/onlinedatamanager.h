@@ -92,6 +92,10 @@ public:
   /* Time in minutes this file will be updated */
   int getReloadMinutesFromWhazzup() const;
 
+  /* Ids of rows in tables client and atc which were inserted, updated, moved or deleted by the last
+   * successful call of readFromWhazzup(). */
+  const atools::fs::online::OnlineChanges& getChangesFromWhazzup() const;
+
   /* True if table clients is present in database */
   bool hasSchema();
 
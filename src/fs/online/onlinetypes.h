@@ -68,6 +68,43 @@ struct OnlineAircraft
 
 };
 
+/*
+ * Database ids of rows in tables "client" and "atc" which were changed by the last whazzup update.
+ * Allows consumers like map layers to update incrementally instead of reloading all rows.
+ */
+struct OnlineChanges
+{
+  /* New rows */
+  QVector<int> clientsInserted, atcInserted;
+
+  /* Rows where any non position value changed and which were replaced completely */
+  QVector<int> clientsUpdated, atcUpdated;
+
+  /* Client rows where only position, altitude, speed, heading or state changed */
+  QVector<int> clientsMoved;
+
+  /* Rows which were not contained in the update anymore and were deleted */
+  QVector<int> clientsDeleted, atcDeleted;
+
+  bool isEmpty() const
+  {
+    return clientsInserted.isEmpty() && atcInserted.isEmpty() && clientsUpdated.isEmpty() && atcUpdated.isEmpty() &&
+           clientsMoved.isEmpty() && clientsDeleted.isEmpty() && atcDeleted.isEmpty();
+  }
+
+  void clear()
+  {
+    clientsInserted.clear();
+    atcInserted.clear();
+    clientsUpdated.clear();
+    atcUpdated.clear();
+    clientsMoved.clear();
+    clientsDeleted.clear();
+    atcDeleted.clear();
+  }
+
+};
+
 /* Online data format which is to be downloaded. */
 enum Format
 {
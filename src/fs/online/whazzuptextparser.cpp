@@ -24,10 +24,14 @@
 #include "geo/linestring.h"
 #include "fs/common/binarygeometry.h"
 
+#include "json/nlohmann/json.hpp"
+
+#include <QElapsedTimer>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QTextCodec>
+#include <QStringBuilder>
 
 using atools::sql::SqlDatabase;
 using atools::sql::SqlQuery;
@@ -132,6 +136,418 @@ static int NUM_IVAOCOLUMNS = STATE + 1;
 
 /* *INDENT-ON* */
 
+/* Client columns which change on every update for moving aircraft. These are updated separately if nothing else changed. */
+static const QStringList CLIENT_POS_PLACEHOLDERS({":lonx", ":laty", ":altitude", ":groundspeed", ":heading", ":on_ground",
+                                                  ":state"});
+
+namespace {
+
+typedef nlohmann::json Json;
+
+/* Value slots for the VATSIM JSON feed. Keys of all sections are mapped to these. */
+namespace js {
+enum Slots
+{
+  CID, NAME, CALLSIGN, LATITUDE, LONGITUDE, ALTITUDE, GROUNDSPEED, SERVER, TRANSPONDER, HEADING, LOGON_TIME,
+  LAST_UPDATED, FACILITY, VISUAL_RANGE, FREQUENCY, TEXT_ATIS,
+  FP_FLIGHT_RULES, FP_AIRCRAFT, FP_DEPARTURE, FP_ARRIVAL, FP_ALTERNATE, FP_CRUISE_TAS, FP_ALTITUDE, FP_DEPTIME,
+  FP_ENROUTE_TIME, FP_FUEL_TIME, FP_REMARKS, FP_ROUTE,
+  VERSION, RELOAD, UPDATE_TIMESTAMP,
+  IDENT, HOSTNAME_OR_IP, LOCATION,
+  NUM_SLOTS
+};
+
+}
+
+/* Map from key to slot. Keys in nested objects are prefixed with the object key and a dot like "flight_plan.route". */
+typedef QHash<QByteArray, int> SlotMap;
+
+/* Streaming SAX handler for the VATSIM JSON data feed which avoids building a full document in memory.
+ * Collects values of known keys into slots for each object in the top level arrays or for each top level object.
+ * Values of unknown keys are skipped. Calls rowFunc for each completed row. Returning false from rowFunc stops parsing. */
+class VatsimJsonHandler :
+  public nlohmann::json_sax<Json>
+{
+public:
+  typedef std::function<bool (const QByteArray& section, const QVector<QString>& values)> RowFuncType;
+
+  VatsimJsonHandler(const QHash<QByteArray, SlotMap>& sectionSlotsParam, RowFuncType rowFuncParam)
+    : sectionSlots(sectionSlotsParam), rowFunc(rowFuncParam)
+  {
+    values.resize(js::NUM_SLOTS);
+  }
+
+  virtual bool null() override
+  {
+    return assign(QString());
+  }
+
+  virtual bool boolean(bool val) override
+  {
+    return assign(val ? QStringLiteral("true") : QStringLiteral("false"));
+  }
+
+  virtual bool number_integer(number_integer_t val) override
+  {
+    return slot >= 0 ? assign(QString::number(val)) : true;
+  }
+
+  virtual bool number_unsigned(number_unsigned_t val) override
+  {
+    return slot >= 0 ? assign(QString::number(val)) : true;
+  }
+
+  virtual bool number_float(number_float_t, const string_t& str) override
+  {
+    // Use number as given in the file to avoid round trip conversion
+    return slot >= 0 ? assign(QString::fromLatin1(str.data(), static_cast<int>(str.size()))) : true;
+  }
+
+  virtual bool string(string_t& val) override
+  {
+    return slot >= 0 ? assign(QString::fromUtf8(val.data(), static_cast<int>(val.size()))) : true;
+  }
+
+  virtual bool binary(binary_t&) override
+  {
+    return true;
+  }
+
+  virtual bool start_object(std::size_t) override
+  {
+    depth++;
+
+    if(rowDepth == -1)
+    {
+      // Either object in a top level array or a top level object
+      if(slotMap != nullptr && ((sectionIsArray && depth == 3) || (!sectionIsArray && depth == 2)))
+      {
+        rowDepth = depth;
+        for(QString& str : values)
+          str.clear();
+      }
+    }
+    else
+      // Nested object in row - prefix keys with object key
+      prefixStack.append((prefixStack.isEmpty() ? QByteArray() : prefixStack.constLast()) +
+                         QByteArray::fromStdString(lastKey) + '.');
+
+    slot = -1;
+    return true;
+  }
+
+  virtual bool key(string_t& val) override
+  {
+    if(depth == 1)
+    {
+      // New top level section
+      section = QByteArray(val.data(), static_cast<int>(val.size()));
+      auto it = sectionSlots.constFind(section);
+      slotMap = it != sectionSlots.constEnd() ? &it.value() : nullptr;
+      sectionIsArray = false;
+      slot = -1;
+    }
+    else if(rowDepth != -1)
+    {
+      if(prefixStack.isEmpty())
+        // Use raw data to avoid allocation for the lookup
+        slot = slotMap->value(QByteArray::fromRawData(val.data(), static_cast<int>(val.size())), -1);
+      else
+        slot = slotMap->value(prefixStack.constLast() + QByteArray(val.data(), static_cast<int>(val.size())), -1);
+
+      // Remember key for nested objects - reuses buffer
+      lastKey = val;
+    }
+    return true;
+  }
+
+  virtual bool end_object() override
+  {
+    bool retval = true;
+    if(depth == rowDepth)
+    {
+      // Row is complete
+      rowDepth = -1;
+      retval = rowFunc(section, values);
+    }
+    else if(rowDepth != -1 && depth > rowDepth && !prefixStack.isEmpty())
+      prefixStack.removeLast();
+
+    depth--;
+    slot = -1;
+    return retval;
+  }
+
+  virtual bool start_array(std::size_t) override
+  {
+    depth++;
+
+    if(depth == 2)
+      sectionIsArray = true;
+    else if(rowDepth != -1 && valueArrayDepth == -1)
+      // Array of values in a row - joined with linefeed
+      valueArrayDepth = depth;
+
+    return true;
+  }
+
+  virtual bool end_array() override
+  {
+    if(depth == valueArrayDepth)
+    {
+      valueArrayDepth = -1;
+      slot = -1;
+    }
+
+    depth--;
+    return true;
+  }
+
+  virtual bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override
+  {
+    qWarning() << Q_FUNC_INFO << "Error reading data" << ex.what() << "at offset" << position;
+    return false;
+  }
+
+private:
+  bool assign(const QString& val)
+  {
+    if(rowDepth != -1 && slot >= 0)
+    {
+      if(valueArrayDepth != -1)
+      {
+        // Join non-empty array values
+        if(!val.isEmpty())
+        {
+          if(!values[slot].isEmpty())
+            values[slot].append('\n');
+          values[slot].append(val);
+        }
+      }
+      else
+      {
+        values[slot] = val;
+        slot = -1;
+      }
+    }
+    return true;
+  }
+
+  const QHash<QByteArray, SlotMap>& sectionSlots;
+  RowFuncType rowFunc;
+
+  const SlotMap *slotMap = nullptr; /* Slots for current section or null if section is ignored */
+  QByteArray section;
+  std::string lastKey;
+  QVector<QByteArray> prefixStack;
+  QVector<QString> values;
+
+  int depth = 0, /* Nesting level of objects and arrays. Top level object is 1. */
+      rowDepth = -1, /* Depth of current row object or -1 if not in row */
+      valueArrayDepth = -1, /* Depth of value array in row or -1 */
+      slot = -1; /* Slot for the next value or -1 if value is ignored */
+  bool sectionIsArray = false;
+};
+
+/* Keys for all sections read from the VATSIM JSON feed */
+static const QHash<QByteArray, SlotMap> VATSIM_SECTION_SLOTS = []() -> QHash<QByteArray, SlotMap>
+{
+  SlotMap flightplan({
+    {"flight_plan.flight_rules", js::FP_FLIGHT_RULES}, {"flight_plan.aircraft", js::FP_AIRCRAFT},
+    {"flight_plan.departure", js::FP_DEPARTURE}, {"flight_plan.arrival", js::FP_ARRIVAL},
+    {"flight_plan.alternate", js::FP_ALTERNATE}, {"flight_plan.cruise_tas", js::FP_CRUISE_TAS},
+    {"flight_plan.altitude", js::FP_ALTITUDE}, {"flight_plan.deptime", js::FP_DEPTIME},
+    {"flight_plan.enroute_time", js::FP_ENROUTE_TIME}, {"flight_plan.fuel_time", js::FP_FUEL_TIME},
+    {"flight_plan.remarks", js::FP_REMARKS}, {"flight_plan.route", js::FP_ROUTE}
+  });
+
+  SlotMap pilots({
+    {"cid", js::CID}, {"name", js::NAME}, {"callsign", js::CALLSIGN}, {"latitude", js::LATITUDE},
+    {"longitude", js::LONGITUDE}, {"altitude", js::ALTITUDE}, {"groundspeed", js::GROUNDSPEED}, {"server", js::SERVER},
+    {"transponder", js::TRANSPONDER}, {"heading", js::HEADING}, {"logon_time", js::LOGON_TIME}
+  });
+
+  SlotMap prefiles({
+    {"cid", js::CID}, {"name", js::NAME}, {"callsign", js::CALLSIGN}
+  });
+
+  for(auto it = flightplan.constBegin(); it != flightplan.constEnd(); ++it)
+  {
+    pilots.insert(it.key(), it.value());
+    prefiles.insert(it.key(), it.value());
+  }
+
+  return QHash<QByteArray, SlotMap>({
+    {"general", SlotMap({
+       {"version", js::VERSION}, {"reload", js::RELOAD}, {"update_timestamp", js::UPDATE_TIMESTAMP}
+     })},
+    {"pilots", pilots},
+    {"controllers", SlotMap({
+       {"cid", js::CID}, {"name", js::NAME}, {"callsign", js::CALLSIGN}, {"frequency", js::FREQUENCY},
+       {"facility", js::FACILITY}, {"server", js::SERVER}, {"visual_range", js::VISUAL_RANGE},
+       {"text_atis", js::TEXT_ATIS}, {"last_updated", js::LAST_UPDATED}, {"logon_time", js::LOGON_TIME},
+       {"latitude", js::LATITUDE}, {"longitude", js::LONGITUDE}
+     })},
+    {"servers", SlotMap({
+       {"ident", js::IDENT}, {"hostname_or_ip", js::HOSTNAME_OR_IP}, {"location", js::LOCATION}, {"name", js::NAME}
+     })},
+    {"prefiles", prefiles}
+  });
+}();
+
+/* Streaming SAX handler for the VATSIM transceivers file. Calls transceiverFunc for each transceiver
+ * having callsign, frequency in Hz and position. */
+class TransceiverJsonHandler :
+  public nlohmann::json_sax<Json>
+{
+public:
+  typedef std::function<void (const QString& callsign, double frequency, const Pos& pos)> TransceiverFuncType;
+
+  TransceiverJsonHandler(TransceiverFuncType transceiverFuncParam)
+    : transceiverFunc(transceiverFuncParam)
+  {
+  }
+
+  virtual bool null() override
+  {
+    return true;
+  }
+
+  virtual bool boolean(bool) override
+  {
+    return true;
+  }
+
+  virtual bool number_integer(number_integer_t val) override
+  {
+    return assign(static_cast<double>(val));
+  }
+
+  virtual bool number_unsigned(number_unsigned_t val) override
+  {
+    return assign(static_cast<double>(val));
+  }
+
+  virtual bool number_float(number_float_t val, const string_t&) override
+  {
+    return assign(val);
+  }
+
+  virtual bool string(string_t& val) override
+  {
+    // Callsign of station object
+    if(depth == 2 && field == CALLSIGN)
+      callsign = QString::fromUtf8(val.data(), static_cast<int>(val.size()));
+    field = NONE;
+    return true;
+  }
+
+  virtual bool binary(binary_t&) override
+  {
+    return true;
+  }
+
+  virtual bool start_object(std::size_t) override
+  {
+    depth++;
+    if(depth == 2)
+    {
+      // Station object
+      callsign.clear();
+      transceivers.clear();
+    }
+    else if(depth == 4)
+      // Transceiver object in array
+      transceivers.append(Values());
+
+    field = NONE;
+    return true;
+  }
+
+  virtual bool key(string_t& val) override
+  {
+    field = NONE;
+    if(depth == 2 && val == "callsign")
+      field = CALLSIGN;
+    else if(depth == 4)
+    {
+      if(val == "frequency")
+        field = FREQUENCY;
+      else if(val == "latDeg")
+        field = LAT;
+      else if(val == "lonDeg")
+        field = LON;
+    }
+    return true;
+  }
+
+  virtual bool end_object() override
+  {
+    if(depth == 2)
+    {
+      // Station complete - callsign is known now regardless of key order
+      for(const Values& transceiver : qAsConst(transceivers))
+        transceiverFunc(callsign, transceiver.frequency, Pos(transceiver.lonX, transceiver.latY));
+    }
+
+    depth--;
+    field = NONE;
+    return true;
+  }
+
+  virtual bool start_array(std::size_t) override
+  {
+    depth++;
+    return true;
+  }
+
+  virtual bool end_array() override
+  {
+    depth--;
+    return true;
+  }
+
+  virtual bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override
+  {
+    qWarning() << Q_FUNC_INFO << "Error reading data" << ex.what() << "at offset" << position;
+    return false;
+  }
+
+private:
+  enum Field
+  {
+    NONE, CALLSIGN, FREQUENCY, LAT, LON
+  };
+
+  struct Values
+  {
+    double frequency = 0., lonX = 0., latY = 0.;
+  };
+
+  bool assign(double val)
+  {
+    if(depth == 4 && !transceivers.isEmpty())
+    {
+      if(field == FREQUENCY)
+        transceivers.last().frequency = val;
+      else if(field == LAT)
+        transceivers.last().latY = val;
+      else if(field == LON)
+        transceivers.last().lonX = val;
+    }
+    field = NONE;
+    return true;
+  }
+
+  TransceiverFuncType transceiverFunc;
+  QString callsign;
+  QVector<Values> transceivers;
+  Field field = NONE;
+  int depth = 0; /* Top level array is 1 */
+};
+
+} // namespace
+
 WhazzupTextParser::WhazzupTextParser(sql::SqlDatabase *sqlDb, bool verboseErrorReporting)
   : db(sqlDb), error(verboseErrorReporting)
 {
@@ -148,10 +564,13 @@ WhazzupTextParser::~WhazzupTextParser()
 bool WhazzupTextParser::read(QString file, Format streamFormat, const QDateTime& lastUpdate)
 {
   reset(); // Also resets format
+  beginChanges();
 
   format = streamFormat;
 
-  if(streamFormat == VATSIM_JSON3 || streamFormat == IVAO_JSON2)
+  if(streamFormat == VATSIM_JSON3)
+    return readInternalJsonVatsim(file, lastUpdate);
+  else if(streamFormat == IVAO_JSON2)
     return readInternalJson(file, lastUpdate);
   else
   {
@@ -179,40 +598,159 @@ void WhazzupTextParser::readTransceivers(const QString& file)
   // ]
   // },
 
-  // Open and check for errors
-  QJsonParseError jsonErr;
-  QJsonDocument doc = QJsonDocument::fromJson(file.toUtf8(), &jsonErr);
-  if(jsonErr.error != QJsonParseError::NoError)
-    qWarning() << Q_FUNC_INFO << "Error reading data" << jsonErr.errorString() << "at offset" << jsonErr.offset;
+  QElapsedTimer timer;
+  timer.start();
 
-  // Top level is an array or unnamed objects
-  const QJsonArray transValues = doc.array();
-  for(const QJsonValue& transVal : transValues)
-  {
-    QJsonObject transObj = transVal.toObject();
-    QString callsign = transObj.value("callsign").toString();
+  // Stream through the file and add objects to multi hash with callsign as key
+  TransceiverJsonHandler handler([this](const QString& callsign, double frequencyHz, const Pos& pos) -> void {
+    Transceiver transceiver;
+
+    // frequency in kHz
+    int frequency = atools::roundToInt(frequencyHz / 1000.);
+    if(frequency < 100 && error)
+      qWarning() << Q_FUNC_INFO << "Invalid frequency" << frequencyHz << "for" << callsign;
+    else
+      transceiver.frequency.insert(frequency);
+    transceiver.pos = pos;
+    transceiverMap.insertMulti(callsign, transceiver);
+  });
+
+  QByteArray utf8 = file.toUtf8();
+  Json::sax_parse(utf8.constData(), utf8.constData() + utf8.size(), &handler);
+
+  qDebug() << Q_FUNC_INFO << "Read" << transceiverMap.size() << "transceivers in" << timer.elapsed() << "ms";
+}
+
+bool WhazzupTextParser::readInternalJsonVatsim(const QString& file, const QDateTime& lastUpdate)
+{
+  QElapsedTimer timer;
+  timer.start();
 
-    // Get all transceivers with coordinates and frequency for this callsign
-    const QJsonArray transceiverValues = transObj.value("transceivers").toArray();
-    for(const QJsonValue& transceiverVal : transceiverValues)
+  bool clientsPresent = false, atcPresent = false, serversDeleted = false, outdated = false;
+  int numRows = 0;
+
+  // Called for the general object and each object in the pilots, controllers, servers and prefiles arrays
+  // Rows are not deleted but updated incrementally - stale rows are deleted in finishChanges()
+  VatsimJsonHandler handler(VATSIM_SECTION_SLOTS, [&](const QByteArray& section, const QVector<QString>& values) -> bool {
+    numRows++;
+    if(section == "general")
     {
-      QJsonObject transceiverObj = transceiverVal.toObject();
-      Pos pos(transceiverObj.value("lonDeg"), transceiverObj.value("latDeg"));
+      // "general": {
+      // "version": 3,
+      // "reload": 1,
+      // "update": "20210314160704",
+      // "update_timestamp": "2021-03-14T16:07:04.9418979Z",
+      // "connected_clients": 1857,
+      // "unique_users": 1777
+      // },
+      // Version and reload time in minutes
+      version = values.at(js::VERSION).toInt();
+      reload = values.at(js::RELOAD).toInt();
 
-      // Build and add object to multi hash with callsign as key
-      Transceiver transceiver;
+      QDateTime update = QDateTime::fromString(values.at(js::UPDATE_TIMESTAMP), Qt::ISODate);
+      if(update.isValid())
+      {
+        if(update <= lastUpdate)
+        {
+          // This is older than the last update - stop parsing and bail out
+          outdated = true;
+          return false;
+        }
 
-      // frequency in kHz
-      int frequency = atools::roundToInt(transceiverObj.value("frequency").toDouble() / 1000.f);
-      if(frequency < 100 && error)
-        qWarning() << Q_FUNC_INFO << "Invalid frequency" << transceiverObj.value("frequency").toInt()
-                   << "for" << callsign;
-      else
-        transceiver.frequency.insert(frequency);
-      transceiver.pos = Pos(transceiverObj.value("lonDeg"), transceiverObj.value("latDeg"));
-      transceiverMap.insertMulti(callsign, transceiver);
-    } // for(QJsonValue transceiverVal : transObj.value("transceivers").toArray())
-  } // for(QJsonValue transVal : doc.array())
+        update.setTimeSpec(Qt::UTC);
+        updateTimestamp = update;
+      }
+    }
+    else if(section == "pilots")
+    {
+      clientsPresent = true;
+      QStringList columns(defaultColumns);
+      columns[c::CALLSIGN] = values.at(js::CALLSIGN);
+      columns[c::CLIENTTYPE] = "PILOT";
+      columns[c::CID] = values.at(js::CID);
+      columns[c::REALNAME] = values.at(js::NAME);
+      columns[c::LATITUDE] = values.at(js::LATITUDE);
+      columns[c::LONGITUDE] = values.at(js::LONGITUDE);
+      columns[c::ALTITUDE] = values.at(js::ALTITUDE);
+      columns[c::GROUNDSPEED] = values.at(js::GROUNDSPEED);
+      columns[c::SERVER] = values.at(js::SERVER);
+      columns[c::TRANSPONDER] = values.at(js::TRANSPONDER);
+      assignFlightplanVatsim(columns, values);
+      columns[v::TIME_LOGON] = values.at(js::LOGON_TIME);
+      columns[v::HEADING] = values.at(js::HEADING);
+
+      parseSection(columns, false /* isAtc */, false /* isPrefile */, true /* isJson */);
+    }
+    else if(section == "controllers")
+    {
+      atcPresent = true;
+      QStringList columns(defaultColumns);
+      columns[c::CALLSIGN] = values.at(js::CALLSIGN);
+      columns[c::CLIENTTYPE] = "ATC";
+      columns[c::CID] = values.at(js::CID);
+      columns[c::REALNAME] = values.at(js::NAME);
+      columns[c::FACILITYTYPE] = values.at(js::FACILITY);
+      columns[c::SERVER] = values.at(js::SERVER);
+      columns[c::VISUALRANGE] = values.at(js::VISUAL_RANGE);
+      columns[v::ATIS_MESSAGE] = values.at(js::TEXT_ATIS); // Already joined with linefeed
+      columns[v::TIME_LAST_ATIS_RECEIVED] = values.at(js::LAST_UPDATED);
+      columns[v::TIME_LOGON] = values.at(js::LOGON_TIME);
+      assignAtcFrequency(columns, values.at(js::CALLSIGN), values.at(js::FREQUENCY).toDouble(),
+                         values.at(js::LATITUDE), values.at(js::LONGITUDE));
+
+      parseSection(columns, true /* isAtc */, false /* isPrefile */, true /* isJson */);
+    }
+    else if(section == "servers")
+    {
+      if(!serversDeleted)
+      {
+        db->exec("delete from server");
+        serversDeleted = true;
+      }
+
+      // Build a column list like the one fetched from the whazzup.txt
+      parseServersSection(QStringList({values.at(js::IDENT), values.at(js::HOSTNAME_OR_IP), values.at(js::LOCATION),
+                                       values.at(js::NAME),
+                                       QString() /* client_connections_allowed */,
+                                       QString() /* allowed_connections */,
+                                       QString() /* voice_type */}));
+    }
+    else if(section == "prefiles")
+    {
+      QStringList columns(defaultColumns);
+      columns[c::CALLSIGN] = values.at(js::CALLSIGN);
+      columns[c::CID] = values.at(js::CID);
+      columns[c::REALNAME] = values.at(js::NAME);
+      columns[c::CLIENTTYPE] = "PILOT";
+      assignFlightplanVatsim(columns, values);
+
+      parseSection(columns, false /*ATC*/, true /* prefile */, true /* isJson */);
+    }
+    return true;
+  });
+
+  QByteArray utf8 = file.toUtf8();
+  bool parsed = Json::sax_parse(utf8.constData(), utf8.constData() + utf8.size(), &handler);
+
+  if(outdated)
+    return false;
+
+  if(!parsed)
+  {
+    // Truncated or malformed feed - the caller rolls back and stale rows must not be deleted since the
+    // missing part of the lists was never seen
+    qWarning() << Q_FUNC_INFO << "Parsing failed after" << numRows << "rows. Keeping last update.";
+    beginChanges();
+    return false;
+  }
+
+  // ATIS - only VATSIM =================================
+  // TODO Currently ignored since missing connection to controllers
+
+  finishChanges(clientsPresent, atcPresent);
+
+  qDebug() << Q_FUNC_INFO << "Read" << numRows << "rows in" << timer.elapsed() << "ms";
+  return true;
 }
 
 bool WhazzupTextParser::readInternalJson(const QString& file, const QDateTime& lastUpdate)
@@ -223,30 +761,10 @@ bool WhazzupTextParser::readInternalJson(const QString& file, const QDateTime& l
   if(jsonErr.error != QJsonParseError::NoError)
     qWarning() << Q_FUNC_INFO << "Error reading data" << jsonErr.errorString() << "at offset" << jsonErr.offset;
 
-  QDateTime update;
   QJsonObject obj = doc.object();
 
-  if(format == VATSIM_JSON3)
-  {
-    // Read time from general section =============
-    // "general": {
-    // "version": 3,
-    // "reload": 1,
-    // "update": "20210314160704",
-    // "update_timestamp": "2021-03-14T16:07:04.9418979Z",
-    // "connected_clients": 1857,
-    // "unique_users": 1777
-    // },
-    QJsonObject generalObj = obj.value("general").toObject();
-    update = generalObj.value("update_timestamp").toVariant().toDateTime();
-
-    // Version and reload time in minutes
-    version = generalObj.value("version").toInt();
-    reload = generalObj.value("reload").toInt();
-  }
-  else if(format == IVAO_JSON2)
-    // "updatedAt": "2021-06-20T21:09:19.642Z",
-    update = obj.value("updatedAt").toVariant().toDateTime();
+  // "updatedAt": "2021-06-20T21:09:19.642Z",
+  QDateTime update = obj.value("updatedAt").toVariant().toDateTime();
 
   if(update.isValid())
   {
@@ -260,40 +778,30 @@ bool WhazzupTextParser::readInternalJson(const QString& file, const QDateTime& l
 
   // Read other object arrays ==================================================================
   // Clients/pilots =================================
-  QJsonObject clients = format == VATSIM_JSON3 ? obj : obj.value("clients").toObject();
+  QJsonObject clients = obj.value("clients").toObject();
+  // Rows are not deleted but updated incrementally - stale rows are deleted in finishChanges()
   QJsonArray pilotsArr = clients.value("pilots").toArray();
-  if(!pilotsArr.isEmpty())
-    db->exec("delete from client");
+  bool clientsPresent = !pilotsArr.isEmpty();
   readPilotsJson(pilotsArr);
 
   // Controllers/atcs and observers =================================
-  QJsonArray controllersArr = format == VATSIM_JSON3 ? obj.value("controllers").toArray() :
-                              obj.value("clients").toObject().value("atcs").toArray();
-  if(!controllersArr.isEmpty())
-    db->exec("delete from atc");
+  QJsonArray controllersArr = clients.value("atcs").toArray();
+  bool atcPresent = !controllersArr.isEmpty();
   readControllersJson(controllersArr, false /* observer */);
-  if(format == IVAO_JSON2)
-    readControllersJson(clients.value("observers").toArray(), true /* observer */);
+  readControllersJson(clients.value("observers").toArray(), true /* observer */);
 
   // Servers =================================
   QJsonArray serversArr = obj.value("servers").toArray();
   if(!serversArr.isEmpty())
     db->exec("delete from server");
   readServersJson(serversArr, false /* voice */);
-  if(format == IVAO_JSON2)
-    readServersJson(obj.value("voiceServers").toArray(), true /* voice */);
+  readServersJson(obj.value("voiceServers").toArray(), true /* voice */);
 
-  // Prefiles - only VATSIM =================================
-  if(format == VATSIM_JSON3)
-    readPrefilesJson(obj);
-
-  // ATIS - only VATSIM =================================
-  // readAtisJson(obj); TODO Currently ignored since missing connection to controllers
+  finishChanges(clientsPresent, atcPresent);
 
   return true;
 }
 
-// Currently ignored
 void WhazzupTextParser::readAtisJson(const QJsonObject& obj)
 {
   // "atis": [
@@ -348,25 +856,7 @@ void WhazzupTextParser::readServersJson(const QJsonArray& serversArr, bool voice
     // CZECH:212.67.73.150:Czech Republic:CenterEast Europe Server - sponsored by VACC-CZ:1:
     QStringList columns;
 
-    if(format == VATSIM_JSON3)
-    {
-      // "servers": [
-      // {
-      // "ident": "CANADA",
-      // "hostname_or_ip": "165.22.239.218",
-      // "location": "Toronto, Canada",
-      // "name": "ANONYM",
-      // "clients_connection_allowed": 1
-      // },
-      columns.append(serverObj.value("ident").toVariant().toString());
-      columns.append(serverObj.value("hostname_or_ip").toVariant().toString());
-      columns.append(serverObj.value("location").toVariant().toString());
-      columns.append(serverObj.value("name").toVariant().toString());
-      columns.append(QString()); // client_connections_allowed
-      columns.append(QString()); // allowed_connections
-      columns.append(QString()); // voice_type
-    }
-    else if(format == IVAO_JSON2)
+    if(format == IVAO_JSON2)
     {
       // "servers": [
       // {
@@ -403,82 +893,7 @@ void WhazzupTextParser::readControllersJson(const QJsonArray& controllersArr, bo
     columns[c::CALLSIGN] = callsign;
     columns[c::CLIENTTYPE] = "ATC";
 
-    if(format == VATSIM_JSON3)
-    {
-      // "controllers": [
-      // {
-      // "cid": 813331,
-      // "name": "ANONYM",
-      // "callsign": "EFIN_D_CTR",
-      // "frequency": "121.300",
-      // "facility": 6,
-      // "rating": 5,
-      // "server": "UK-1",
-      // "visual_range": 300,
-      // "text_atis": [
-      // "HELSINKI CONTROL"
-      // ],
-      // "last_updated": "2021-03-14T16:07:00.8535377Z",
-      // "logon_time": "2021-03-14T08:10:47.665987Z"
-      // },
-      columns[c::CID] = atcObj.value("cid").toVariant().toString();
-      columns[c::REALNAME] = atcObj.value("name").toVariant().toString();
-
-      columns[c::FACILITYTYPE] = atcObj.value("facility").toVariant().toString();
-      columns[c::SERVER] = atcObj.value("server").toVariant().toString();
-      columns[c::VISUALRANGE] = atcObj.value("visual_range").toVariant().toString();
-
-      // Read ATIS message array into linefeed separated string =========
-      QStringList atisStrList;
-      const QJsonArray atisArray = atcObj.value("text_atis").toArray();
-      for(const QJsonValue& value : atisArray)
-        atisStrList.append(value.toString());
-      atisStrList.removeAll(QString());
-      columns[v::ATIS_MESSAGE] = atisStrList.join('\n');
-      columns[v::TIME_LAST_ATIS_RECEIVED] = atcObj.value("last_updated").toVariant().toString();
-
-      columns[v::TIME_LOGON] = atcObj.value("logon_time").toVariant().toString();
-
-      // Get all transceivers with callsign =========
-      if(transceiverMap.contains(callsign))
-      {
-        Rect rect;
-        QSet<int> frequencies; // kHz
-        frequencies.insert(atools::roundToInt(atcObj.value("frequency").toVariant().toDouble() * 1000.f));
-
-        // Read all frequencies and build a bounding rectangle from positions
-        const QList<Transceiver> transceivers = transceiverMap.values(callsign);
-        for(const Transceiver& transceiver : transceivers)
-        {
-          frequencies.unite(transceiver.frequency);
-          rect.extend(transceiver.pos);
-        }
-        frequencies.remove(0);
-
-        // Convert frequencies to mHz
-        QVector<float> frequenciesMhz;
-        for(int f : frequencies)
-          frequenciesMhz.append(f / 1000.f);
-
-        columns[c::FREQUENCY] = atools::floatVectorToStrList(frequenciesMhz).join('&');
-
-        // Use center of bounding rectangle as position
-        columns[c::LONGITUDE] = QString::number(rect.getCenter().getLonX());
-        columns[c::LATITUDE] = QString::number(rect.getCenter().getLatY());
-      }
-      else
-      {
-        // Center has no geometry in the transceiever list ====================
-        columns[c::FREQUENCY] = QString::number(atcObj.value("frequency").toVariant().toDouble());
-
-        if(atcObj.contains("latitude") && atcObj.contains("longitude"))
-        {
-          columns[c::LATITUDE] = atcObj.value("latitude").toVariant().toString();
-          columns[c::LONGITUDE] = atcObj.value("longitude").toVariant().toString();
-        }
-      }
-    }
-    else if(format == IVAO_JSON2)
+    if(format == IVAO_JSON2)
     {
       // "atcs": [
       // {
@@ -560,66 +975,7 @@ void WhazzupTextParser::readPilotsJson(const QJsonArray& pilotsArr)
     columns[c::CALLSIGN] = pilotObj.value("callsign").toString();
     columns[c::CLIENTTYPE] = "PILOT";
 
-    if(format == VATSIM_JSON3)
-    {
-      // "pilots": [
-      // {
-      // "cid": 1474512,
-      // "name": "ANONYM",
-      // "callsign": "ABS9481",
-      // "server": "GERMANY-2",
-      // "pilot_rating": 0,
-      // "latitude": 33.68793,
-      // "longitude": -7.51442,
-      // "altitude": 2501,
-      // "groundspeed": 193,
-      // "transponder": "2000",
-      // "heading": 163,
-      // "qnh_i_hg": 30.13,
-      // "qnh_mb": 1020,
-      //
-      // "flight_plan": {
-      // "flight_rules": "I",
-      // "aircraft": "B77L/H-SDE1E2E3FGHIJ2J3J4J5M1RWXY/LB1D1",
-      // "aircraft_faa": "H/B77L/L",
-      // "aircraft_short": "B77L",
-      // "departure": "OMDB",
-      // "arrival": "SBGR",
-      // "alternate": "SBGL",
-      // "cruise_tas": "492",
-      // "altitude": "32000",
-      // "deptime": "2300",
-      // "enroute_time": "1442",
-      // "fuel_time": "1638",
-      // "remarks": "PBN/A1B1C1D1L1O1S2 DOF/210313 ... /V/",
-      // "route": "NABIX3G NABIX P699 OXARI M430 KIA ... UL327 SIDUR UZ10 ILMIG DCT TBE TBE2B"
-      // },
-      //
-      // "logon_time": "2021-03-13T22:38:09.826199Z",
-      // "last_updated": "2021-03-14T16:07:00.8565953Z"
-      // },
-      columns[c::CID] = pilotObj.value("cid").toVariant().toString();
-      columns[c::REALNAME] = pilotObj.value("name").toString();
-      columns[c::LATITUDE] = pilotObj.value("latitude").toVariant().toString();
-      columns[c::LONGITUDE] = pilotObj.value("longitude").toVariant().toString();
-      columns[c::ALTITUDE] = pilotObj.value("altitude").toVariant().toString();
-      columns[c::GROUNDSPEED] = pilotObj.value("groundspeed").toVariant().toString();
-      columns[c::SERVER] = pilotObj.value("server").toVariant().toString();
-      columns[c::TRANSPONDER] = pilotObj.value("transponder").toVariant().toString();
-
-      // Insert values from flight plan object
-      assignFlightplan(columns, pilotObj.value("flight_plan").toObject());
-
-      // IGNORED planned_depairport_lat
-      // IGNORED planned_depairport_lon
-      // IGNORED planned_destairport_lat
-      // IGNORED planned_destairport_lon
-      // atis_message
-      // time_last_atis_received
-      columns[v::TIME_LOGON] = pilotObj.value("logon_time").toVariant().toString();
-      columns[v::HEADING] = pilotObj.value("heading").toVariant().toString();
-    }
-    else if(format == IVAO_JSON2)
+    if(format == IVAO_JSON2)
     {
       // "pilots": [
       // {
@@ -703,99 +1059,12 @@ void WhazzupTextParser::readPilotsJson(const QJsonArray& pilotsArr)
   }
 }
 
-void WhazzupTextParser::readPrefilesJson(const QJsonObject& obj)
-{
-  // "prefiles": [
-  // {
-  // "cid": 1530915,
-  // "name": "ANONYM",
-  // "callsign": "TAP300",
-  // "flight_plan": {
-  // "flight_rules": "I",
-  // "aircraft": "A320/L",
-  // "aircraft_faa": "A320/L",
-  // "aircraft_short": "A320",
-  // "departure": "LEPA",
-  // "arrival": "LIMC",
-  // "alternate": "LSZH",
-  // "cruise_tas": "449",
-  // "altitude": "36000",
-  // "deptime": "1340",
-  // "enroute_time": "0119",
-  // "fuel_time": "0302",
-  // "remarks": "PBN/A1B1C1D1O1S1 DOF/210314 REG/N320SB EET/LFFF0026 LIMM0050 OPR/TAP PER/C RMK/TCAS SIMBRIEF /V/",
-  // "route": "MEROS UN853 LUMAS UM985 EKSID M985 NOSTA/N0429F300 M985 GEN"
-  // },
-  // "last_updated": "2021-03-14T13:19:23.9417633Z"
-  // },
-  // Prefill with empty strings for pilots/clients delimited format
-  const QJsonArray prefilesArr = obj.value("prefiles").toArray();
-  for(const QJsonValue& prefileVal : prefilesArr)
-  {
-    QStringList columns(defaultColumns);
-    QJsonObject pilotObj = prefileVal.toObject();
-
-    columns[c::CALLSIGN] = pilotObj.value("callsign").toVariant().toString();
-    columns[c::CID] = pilotObj.value("cid").toVariant().toString();
-    columns[c::REALNAME] = pilotObj.value("name").toVariant().toString();
-    columns[c::CLIENTTYPE] = "PILOT";
-
-    // Insert values from flight plan object
-    assignFlightplan(columns, pilotObj.value("flight_plan").toObject());
-
-    // Prefill with empty strings for pilots/clients delimited format
-    parseSection(columns, false /*ATC*/, true /* prefile */, true /* isJson */);
-  }
-}
-
 void WhazzupTextParser::assignFlightplan(QStringList& columns, const QJsonObject& flightplanObj)
 {
   columns[c::PLANNED_REMARKS] = flightplanObj.value("remarks").toVariant().toString();
   columns[c::PLANNED_ROUTE] = flightplanObj.value("route").toVariant().toString();
 
-  if(format == VATSIM_JSON3)
-  {
-    // "flight_plan": {
-    // "flight_rules": "I",
-    // "aircraft": "B744/H-SDE3FGHIJ3J5J6M1M2P2RWXYZ/LB1D1",
-    // "aircraft_faa": "H/B744/L",
-    // "aircraft_short": "B744",
-    // "departure": "SAEZ",
-    // "arrival": "EGLL",
-    // "alternate": "EGSS",
-    // "cruise_tas": "511",
-    // "altitude": "29000",
-    // "deptime": "0010",
-    // "enroute_time": "1251",
-    // "fuel_time": "1433",
-    // "remarks": "PBN/A1B1C1D1L1O1S2 NAV/RNVD1E2A1 RNP2 DAT/CPDLCX 1FANSP2PDC SUR/260B RSP180 DO...",
-    // "route": "N0511F290 LANDA UW64 MCS UB688 ... UN472 BADUR UN585 FEJAC DCT JSY DCT REVTU UP87 ROXOG"
-    // },
-
-    columns[c::PLANNED_AIRCRAFT] = flightplanObj.value("aircraft").toVariant().toString();
-    columns[c::PLANNED_TASCRUISE] = flightplanObj.value("cruise_tas").toVariant().toString();
-    columns[c::PLANNED_DEPAIRPORT] = flightplanObj.value("departure").toVariant().toString();
-    columns[c::PLANNED_ALTITUDE] = flightplanObj.value("altitude").toVariant().toString();
-    columns[c::PLANNED_DESTAIRPORT] = flightplanObj.value("arrival").toVariant().toString();
-
-    columns[c::PLANNED_FLIGHTTYPE] = flightplanObj.value("flight_rules").toVariant().toString();
-    columns[c::PLANNED_DEPTIME] = flightplanObj.value("deptime").toVariant().toString();
-
-    // Split time into hours and minutes as in delimited format
-    QString minEnrouteHours = flightplanObj.value("enroute_time").toVariant().toString();
-    minEnrouteHours.chop(2);
-    columns[c::PLANNED_HRSENROUTE] = minEnrouteHours;
-    columns[c::PLANNED_MINENROUTE] = flightplanObj.value("enroute_time").toVariant().toString().right(2);
-
-    // Split time into hours and minutes as in delimited format
-    QString minFuelHours = flightplanObj.value("fuel_time").toVariant().toString();
-    minFuelHours.chop(2);
-    columns[c::PLANNED_HRSFUEL] = minFuelHours;
-    columns[c::PLANNED_MINFUEL] = flightplanObj.value("fuel_time").toVariant().toString().right(2);
-
-    columns[c::PLANNED_ALTAIRPORT] = flightplanObj.value("alternate").toVariant().toString();
-  }
-  else if(format == IVAO_JSON2)
+  if(format == IVAO_JSON2)
   {
     // "flightPlan": {
     // "revision": 0,
@@ -881,6 +1150,89 @@ void WhazzupTextParser::assignFlightplan(QStringList& columns, const QJsonObject
   }
 }
 
+void WhazzupTextParser::assignFlightplanVatsim(QStringList& columns, const QVector<QString>& values)
+{
+  // "flight_plan": {
+  // "flight_rules": "I",
+  // "aircraft": "B744/H-SDE3FGHIJ3J5J6M1M2P2RWXYZ/LB1D1",
+  // "aircraft_faa": "H/B744/L",
+  // "aircraft_short": "B744",
+  // "departure": "SAEZ",
+  // "arrival": "EGLL",
+  // "alternate": "EGSS",
+  // "cruise_tas": "511",
+  // "altitude": "29000",
+  // "deptime": "0010",
+  // "enroute_time": "1251",
+  // "fuel_time": "1433",
+  // "remarks": "PBN/A1B1C1D1L1O1S2 NAV/RNVD1E2A1 RNP2 DAT/CPDLCX 1FANSP2PDC SUR/260B RSP180 DO...",
+  // "route": "N0511F290 LANDA UW64 MCS UB688 ... UN472 BADUR UN585 FEJAC DCT JSY DCT REVTU UP87 ROXOG"
+  // },
+  columns[c::PLANNED_REMARKS] = values.at(js::FP_REMARKS);
+  columns[c::PLANNED_ROUTE] = values.at(js::FP_ROUTE);
+  columns[c::PLANNED_AIRCRAFT] = values.at(js::FP_AIRCRAFT);
+  columns[c::PLANNED_TASCRUISE] = values.at(js::FP_CRUISE_TAS);
+  columns[c::PLANNED_DEPAIRPORT] = values.at(js::FP_DEPARTURE);
+  columns[c::PLANNED_ALTITUDE] = values.at(js::FP_ALTITUDE);
+  columns[c::PLANNED_DESTAIRPORT] = values.at(js::FP_ARRIVAL);
+  columns[c::PLANNED_FLIGHTTYPE] = values.at(js::FP_FLIGHT_RULES);
+  columns[c::PLANNED_DEPTIME] = values.at(js::FP_DEPTIME);
+
+  // Split time into hours and minutes as in delimited format
+  const QString& enrouteTime = values.at(js::FP_ENROUTE_TIME);
+  columns[c::PLANNED_HRSENROUTE] = enrouteTime.left(std::max(enrouteTime.size() - 2, 0));
+  columns[c::PLANNED_MINENROUTE] = enrouteTime.right(2);
+
+  const QString& fuelTime = values.at(js::FP_FUEL_TIME);
+  columns[c::PLANNED_HRSFUEL] = fuelTime.left(std::max(fuelTime.size() - 2, 0));
+  columns[c::PLANNED_MINFUEL] = fuelTime.right(2);
+
+  columns[c::PLANNED_ALTAIRPORT] = values.at(js::FP_ALTERNATE);
+}
+
+void WhazzupTextParser::assignAtcFrequency(QStringList& columns, const QString& callsign, double frequency,
+                                           const QString& latitude, const QString& longitude)
+{
+  // Get all transceivers with callsign =========
+  if(transceiverMap.contains(callsign))
+  {
+    Rect rect;
+    QSet<int> frequencies; // kHz
+    frequencies.insert(atools::roundToInt(frequency * 1000.));
+
+    // Read all frequencies and build a bounding rectangle from positions
+    const QList<Transceiver> transceivers = transceiverMap.values(callsign);
+    for(const Transceiver& transceiver : transceivers)
+    {
+      frequencies.unite(transceiver.frequency);
+      rect.extend(transceiver.pos);
+    }
+    frequencies.remove(0);
+
+    // Convert frequencies to mHz
+    QVector<float> frequenciesMhz;
+    for(int f : frequencies)
+      frequenciesMhz.append(f / 1000.f);
+
+    columns[c::FREQUENCY] = atools::floatVectorToStrList(frequenciesMhz).join('&');
+
+    // Use center of bounding rectangle as position
+    columns[c::LONGITUDE] = QString::number(rect.getCenter().getLonX());
+    columns[c::LATITUDE] = QString::number(rect.getCenter().getLatY());
+  }
+  else
+  {
+    // Center has no geometry in the transceiever list ====================
+    columns[c::FREQUENCY] = QString::number(frequency);
+
+    if(!latitude.isEmpty() && !longitude.isEmpty())
+    {
+      columns[c::LATITUDE] = latitude;
+      columns[c::LONGITUDE] = longitude;
+    }
+  }
+}
+
 bool WhazzupTextParser::readInternalDelimited(QTextStream& stream, const QDateTime& lastUpdate)
 {
   QSet<QString> sections;
@@ -895,11 +1247,8 @@ bool WhazzupTextParser::readInternalDelimited(QTextStream& stream, const QDateTi
   }
 
   // Delete tables for available sections and keep others
-  if(sections.contains("CLIENTS"))
-  {
-    db->exec("delete from client");
-    db->exec("delete from atc");
-  }
+  // Clients and ATC are updated incrementally - stale rows are deleted in finishChanges()
+  bool clientsPresent = sections.contains("CLIENTS");
 
   if(sections.contains("SERVERS"))
     db->exec("delete from server where voice_type is null");
@@ -954,6 +1303,8 @@ bool WhazzupTextParser::readInternalDelimited(QTextStream& stream, const QDateTi
     }
   }
 
+  finishChanges(clientsPresent, clientsPresent);
+
   return true;
 }
 
@@ -1321,7 +1672,135 @@ void WhazzupTextParser::parseSection(const QStringList& line, bool isAtc, bool p
   // qDebug() << hashKey << id;
   insertQuery->bindValue(isAtc ? ":atc_id" : ":client_id", id);
 
-  insertQuery->exec();
+  writeRow(insertQuery, isAtc, id);
+}
+
+void WhazzupTextParser::writeRow(atools::sql::SqlQuery *insertQuery, bool isAtc, int id)
+{
+  const QString idPlaceholder = isAtc ? ":atc_id" : ":client_id";
+
+  // Calculate hashes for all bound values except id =======================
+  RowHash hash;
+  for(const QString& placeholder : insertQuery->getPlaceholderList())
+  {
+    if(placeholder == idPlaceholder)
+      continue;
+
+    QVariant value = insertQuery->boundValue(placeholder, true /* ignoreInvalid */);
+    uint valueHash = 0;
+    if(!value.isNull())
+      valueHash = value.type() == QVariant::ByteArray ? qHash(value.toByteArray()) : qHash(value.toString());
+
+    if(!isAtc && CLIENT_POS_PLACEHOLDERS.contains(placeholder))
+      hash.pos = hash.pos * 31 + valueHash;
+    else
+      hash.data = hash.data * 31 + valueHash;
+  }
+
+  // Find row from this or last update =======================
+  QHash<int, RowHash>& newRows = isAtc ? newAtcRows : newClientRows;
+  const QHash<int, RowHash>& oldRows = isAtc ? atcRows : clientRows;
+
+  bool existing = true;
+  RowHash lastHash;
+  if(newRows.contains(id))
+    // Duplicate in this update
+    lastHash = newRows.value(id);
+  else if(oldRows.contains(id))
+    lastHash = oldRows.value(id);
+  else
+    existing = false;
+
+  newRows.insert(id, hash);
+
+  if(!existing)
+  {
+    // New row =======================
+    insertQuery->exec();
+    (isAtc ? changes.atcInserted : changes.clientsInserted).append(id);
+  }
+  else if(lastHash.data != hash.data)
+  {
+    // Any value changed - replace whole row =======================
+    insertQuery->exec();
+    (isAtc ? changes.atcUpdated : changes.clientsUpdated).append(id);
+  }
+  else if(lastHash.pos != hash.pos)
+  {
+    // Only position changed - update the few columns instead of replacing the row =======================
+    for(const QString& placeholder : CLIENT_POS_PLACEHOLDERS)
+      clientPosUpdateQuery->bindValue(placeholder, insertQuery->boundValue(placeholder, true /* ignoreInvalid */));
+    clientPosUpdateQuery->bindValue(":client_id", id);
+    clientPosUpdateQuery->exec();
+    changes.clientsMoved.append(id);
+  }
+  // else not changed - nothing to write
+}
+
+void WhazzupTextParser::beginChanges()
+{
+  changes.clear();
+  newClientRows.clear();
+  newAtcRows.clear();
+}
+
+void WhazzupTextParser::finishChanges(bool clientsPresent, bool atcPresent)
+{
+  if(clientsPresent)
+  {
+    // Full client list in update - remove all not found anymore
+    deleteStaleRows(clientDeleteQuery, clientRows, newClientRows, changes.clientsDeleted);
+    clientRows.swap(newClientRows);
+  }
+  else
+  {
+    // Only partial update like prefiles - keep rows from last update
+    for(auto it = newClientRows.constBegin(); it != newClientRows.constEnd(); ++it)
+      clientRows.insert(it.key(), it.value());
+  }
+
+  if(atcPresent)
+  {
+    deleteStaleRows(atcDeleteQuery, atcRows, newAtcRows, changes.atcDeleted);
+    atcRows.swap(newAtcRows);
+  }
+  else
+  {
+    for(auto it = newAtcRows.constBegin(); it != newAtcRows.constEnd(); ++it)
+      atcRows.insert(it.key(), it.value());
+  }
+
+  newClientRows.clear();
+  newAtcRows.clear();
+
+  qDebug() << Q_FUNC_INFO << "clients inserted" << changes.clientsInserted.size()
+           << "updated" << changes.clientsUpdated.size() << "moved" << changes.clientsMoved.size()
+           << "deleted" << changes.clientsDeleted.size()
+           << "atc inserted" << changes.atcInserted.size() << "updated" << changes.atcUpdated.size()
+           << "deleted" << changes.atcDeleted.size();
+}
+
+void WhazzupTextParser::deleteStaleRows(atools::sql::SqlQuery *deleteQuery, const QHash<int, RowHash>& oldRows,
+                                        const QHash<int, RowHash>& newRows, QVector<int>& deletedIds)
+{
+  for(auto it = oldRows.constBegin(); it != oldRows.constEnd(); ++it)
+  {
+    if(!newRows.contains(it.key()))
+    {
+      deleteQuery->bindValue(":id", it.key());
+      deleteQuery->exec();
+      deletedIds.append(it.key());
+    }
+  }
+}
+
+void WhazzupTextParser::resetChangeTracking()
+{
+  clientRows.clear();
+  atcRows.clear();
+  newClientRows.clear();
+  newAtcRows.clear();
+  changes.clear();
 }
 
 int WhazzupTextParser::semiPermanentId(QHash<QString, int>& idMap, int& curId, const QString& key)
@@ -1414,6 +1893,19 @@ void WhazzupTextParser::initQueries()
 
   serverInsertQuery = new SqlQuery(db);
   serverInsertQuery->prepare(util.buildInsertStatement("server", QString(), {"server_id"}));
+
+  // Build "update client set lonx = :lonx, laty = :laty, ... where client_id = :client_id"
+  QStringList posColumns;
+  for(const QString& placeholder : CLIENT_POS_PLACEHOLDERS)
+    posColumns.append(placeholder.mid(1) % " = " % placeholder);
+  clientPosUpdateQuery = new SqlQuery(db);
+  clientPosUpdateQuery->prepare("update client set " % posColumns.join(", ") % " where client_id = :client_id");
+
+  clientDeleteQuery = new SqlQuery(db);
+  clientDeleteQuery->prepare("delete from client where client_id = :id");
+
+  atcDeleteQuery = new SqlQuery(db);
+  atcDeleteQuery->prepare("delete from atc where atc_id = :id");
 }
 
 void WhazzupTextParser::deInitQueries()
@@ -1426,6 +1918,15 @@ void WhazzupTextParser::deInitQueries()
 
   delete serverInsertQuery;
   serverInsertQuery = nullptr;
+
+  delete clientPosUpdateQuery;
+  clientPosUpdateQuery = nullptr;
+
+  delete clientDeleteQuery;
+  clientDeleteQuery = nullptr;
+
+  delete atcDeleteQuery;
+  atcDeleteQuery = nullptr;
 }
 
 void WhazzupTextParser::resetForNewOptions()
@@ -81,6 +81,16 @@ public:
   void reset();
   void resetForNewOptions();
 
+  /* Forget about all rows in the database. Call after tables client and atc were cleared or recreated
+   * to get all rows inserted again on next update. */
+  void resetChangeTracking();
+
+  /* Rows in tables client and atc which were inserted, updated or deleted by the last successful call of read() */
+  const atools::fs::online::OnlineChanges& getChanges() const
+  {
+    return changes;
+  }
+
   /* Set default circle radii for certain ATC types where visual range is unusable */
   void setAtcSize(const QHash<atools::fs::online::fac::FacilityType, int>& value)
   {
@@ -117,20 +127,49 @@ private:
   QString convertName(QString name, bool utf8);
   int semiPermanentId(QHash<QString, int>& idMap, int& curId, const QString& key);
 
-  /* Read VATSIM JSON format and create a column list based on the whazzup.txt lists.
+  /* Read VATSIM JSON format with a streaming parser and create a column list based on the whazzup.txt lists.
    * This is read by the delimited methods. */
+  bool readInternalJsonVatsim(const QString& file, const QDateTime& lastUpdate);
+
+  /* Read IVAO JSON format and create a column list based on the whazzup.txt lists. */
   bool readInternalJson(const QString& file, const QDateTime& lastUpdate);
   bool readInternalDelimited(QTextStream& stream, const QDateTime& lastUpdate);
   void readPilotsJson(const QJsonArray& pilotsArr);
   void readControllersJson(const QJsonArray& controllersArr, bool observer);
   void readServersJson(const QJsonArray& serversArr, bool voice);
-  void readPrefilesJson(const QJsonObject& obj);
 
   void readAtisJson(const QJsonObject& obj);
 
   /* Insert flight plan values into columns. Used for clients and prefile */
   void assignFlightplan(QStringList& columns, const QJsonObject& flightplanObj);
 
+  /* Insert flight plan values collected by the VATSIM streaming parser into columns */
+  void assignFlightplanVatsim(QStringList& columns, const QVector<QString>& values);
+
+  /* Assign merged frequencies and position from transceivers or the given values if callsign has no transceivers */
+  void assignAtcFrequency(QStringList& columns, const QString& callsign, double frequency,
+                          const QString& latitude, const QString& longitude);
+
+  /* Hashes of bound values for a row in table client or atc to detect changes between updates */
+  struct RowHash
+  {
+    uint data = 0, /* All columns except id and position */
+         pos = 0; /* Position, altitude, speed, heading and state for clients */
+  };
+
+  /* Write prepared row using insert, position update or skip it if not changed since last update */
+  void writeRow(atools::sql::SqlQuery *insertQuery, bool isAtc, int id);
+
+  /* Prepare change tracking before parsing rows. */
+  void beginChanges();
+
+  /* Delete rows not found in update and update hashes. Tables are only cleaned up if present in update. */
+  void finishChanges(bool clientsPresent, bool atcPresent);
+
+  /* Delete all rows not contained in newRows and add ids to the deleted list */
+  void deleteStaleRows(atools::sql::SqlQuery *deleteQuery, const QHash<int, RowHash>& oldRows,
+                       const QHash<int, RowHash>& newRows, QVector<int>& deletedIds);
+
   QString curSection;
   atools::fs::online::Format format = atools::fs::online::UNKNOWN;
 
@@ -144,7 +183,16 @@ private:
   QDateTime updateTimestamp;
 
   atools::sql::SqlDatabase *db;
-  atools::sql::SqlQuery *clientInsertQuery = nullptr, *atcInsertQuery = nullptr, *serverInsertQuery = nullptr;
+  atools::sql::SqlQuery *clientInsertQuery = nullptr, *atcInsertQuery = nullptr, *serverInsertQuery = nullptr,
+                        *clientPosUpdateQuery = nullptr, *clientDeleteQuery = nullptr, *atcDeleteQuery = nullptr;
+
+  // Row hashes by database id for the rows currently in the database
+  QHash<int, RowHash> clientRows, atcRows;
+
+  // Row hashes collected while reading the current update. Replace the ones above on success.
+  QHash<int, RowHash> newClientRows, newAtcRows;
+
+  atools::fs::online::OnlineChanges changes;
 
   // Assign row ids manually
   int curClientId = 1, curAtcId = 1;
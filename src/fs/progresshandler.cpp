@@ -71,6 +71,11 @@ bool ProgressHandler::reportOtherInc(const QString& otherAction, int increment)
   return callHandler();
 }
 
+void ProgressHandler::reportStepTime(const QString& step, qint64 milliseconds)
+{
+  info.stepTimes.append(std::make_pair(step, milliseconds));
+}
+
 void ProgressHandler::reportError()
 {
   info.numErrors++;
@@ -123,6 +128,7 @@ void ProgressHandler::reset()
   info.newOther = false;
   info.firstCall = true;
   info.lastCall = false;
+  info.stepTimes.clear();
 }
 
 bool ProgressHandler::reportSceneryArea(const scenery::SceneryArea *sceneryArea)
@@ -175,6 +181,13 @@ void ProgressHandler::defaultProgressCallback()
 
   if(info.isNewOther())
     qInfo() << "=P===" << numbersAsString(info) << info.getOtherAction();
+
+  if(info.isLastCall() && !info.getStepTimes().isEmpty())
+  {
+    qInfo() << "=P=== Step times =====================================================";
+    for(const std::pair<QString, qint64>& stepTime : info.getStepTimes())
+      qInfo().nospace().noquote() << "=P=== " << stepTime.first << ": " << stepTime.second << " ms";
+  }
 }
 
 QString ProgressHandler::numbersAsString(const atools::fs::NavDatabaseProgress& inf)
@@ -77,6 +77,10 @@ public:
   /* Only send message without incrementing progress */
   bool reportOtherMsg(const QString& otherAction);
 
+  /* Remember execution time for a finished step. Times are available in NavDatabaseProgress::getStepTimes()
+   * and are printed by the default callback on finish. */
+  void reportStepTime(const QString& step, qint64 milliseconds);
+
   /* set total amount of progress steps */
   void setTotal(int total);
 
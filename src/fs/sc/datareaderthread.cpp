@@ -17,6 +17,7 @@
 
 #include "fs/sc/datareaderthread.h"
 
+#include "fs/sc/replayfile.h"
 #include "fs/sc/simconnecthandler.h"
 #include "fs/sc/xpconnecthandler.h"
 #include "atools.h"
@@ -221,6 +222,7 @@ DataReaderThread::DataReaderThread(QObject *parent, bool verboseLog)
   setObjectName("DataReaderThread");
 
   options = atools::fs::sc::FETCH_AI_AIRCRAFT | atools::fs::sc::FETCH_AI_BOAT;
+  replaySeekSecs.store(-1);
 }
 
 DataReaderThread::~DataReaderThread()
@@ -315,7 +317,7 @@ void DataReaderThread::run()
 
   // Try to connect first ============================================
 
-  if(loadReplayFile == nullptr)
+  if(replayReader == nullptr)
     // Connect to the simulator
     connectToSimulator();
   else
@@ -336,15 +338,19 @@ void DataReaderThread::run()
     atools::fs::sc::SimConnectData data;
     atools::fs::sc::Options opts = options;
 
-    if(loadReplayFile != nullptr)
+    if(replayReader != nullptr)
     {
       // Do replay ============================================
-      data.read(loadReplayFile);
+      qint64 seekSecs = replaySeekSecs.exchange(-1);
+      if(seekSecs >= 0 && !replayReader->seek(QDateTime::fromSecsSinceEpoch(seekSecs, Qt::UTC)))
+        emit postLogMessage(tr("Cannot seek in \"%1\". Replay file format does not support seeking.").
+                            arg(loadReplayFilepath), false, true);
 
-      if(data.getStatus() == OK)
+      if(replayReader->read(data))
       {
-        if(loadReplayFile->atEnd())
-          loadReplayFile->seek(REPLAY_FILE_DATA_START_OFFSET);
+        // Skip packets for faster replay instead of reducing the update rate
+        if(replaySpeed > 1 && replayReader->isSeekable())
+          replayReader->skip(replaySpeed - 1);
 
         // Remove boat and ship traffic depending on settings for testing purposes
         QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
@@ -387,10 +393,10 @@ void DataReaderThread::run()
       {
         emit postStatus(data.getStatus(), data.getStatusText());
         emit postLogMessage(tr("Error reading \"%1\": %2.").
-                            arg(loadReplayFilepath).arg(data.getStatusText()), false, true);
+                            arg(loadReplayFilepath).arg(replayReader->getErrorString()), false, true);
         closeReplay();
       }
-    } // if(loadReplayFile != nullptr)
+    } // if(replayReader != nullptr)
     else if(fetchData(data, aiFetchRadiusKm, opts))
     {
       // Data fetched from simconnect - send to client ============================================
@@ -399,9 +405,9 @@ void DataReaderThread::run()
 
       emit postSimConnectData(data);
 
-      if(saveReplayFile != nullptr && saveReplayFile->isOpen() && data.getPacketId() > 0)
+      if(replayWriter != nullptr && data.getPacketId() > 0)
         // Save only simulator packets, not weather replays
-        data.write(saveReplayFile);
+        replayWriter->write(data);
     }
     else
     {
@@ -458,9 +464,15 @@ void DataReaderThread::run()
     }
 
     unsigned long sleepMs = 500;
-    if(loadReplayFile != nullptr)
-      sleepMs = static_cast<unsigned long>(static_cast<float>(replayUpdateRateMs) /
-                                           static_cast<float>(replaySpeed));
+    if(replayReader != nullptr)
+    {
+      if(replayReader->isSeekable())
+        // Speed is done by skipping packets
+        sleepMs = replayUpdateRateMs;
+      else
+        sleepMs = static_cast<unsigned long>(static_cast<float>(replayUpdateRateMs) /
+                                             static_cast<float>(replaySpeed));
+    }
     else
       sleepMs = updateRate;
 
@@ -541,89 +553,63 @@ bool DataReaderThread::fetchData(atools::fs::sc::SimConnectData& data, int radiu
 
 void DataReaderThread::setupReplay()
 {
+  replaySeekSecs.store(-1);
+
   if(!loadReplayFilepath.isEmpty())
   {
-    loadReplayFile = new QFile(loadReplayFilepath);
-
-    if(loadReplayFile->size() > static_cast<qint64>(REPLAY_FILE_DATA_START_OFFSET))
+    replayReader = new ReplayReader(loadReplayFilepath);
+    if(replayReader->open())
     {
-      if(!loadReplayFile->open(QIODevice::ReadOnly))
-      {
-        emit postLogMessage(tr("Cannot open \"%1\".").arg(loadReplayFilepath), false, true);
-        delete loadReplayFile;
-        loadReplayFile = nullptr;
-      }
-      else
-      {
-        QDataStream in(loadReplayFile);
-        in.setVersion(QDataStream::Qt_5_5);
-        in.setFloatingPointPrecision(QDataStream::SinglePrecision);
-
-        quint32 magicNumber, version;
-
-        in >> magicNumber >> version >> replayUpdateRateMs;
-        if(magicNumber != REPLAY_FILE_MAGIC_NUMBER)
-        {
-          emit postLogMessage(tr("Cannot open \"%1\". Is not a replay file - wrong magic number.").
-                              arg(loadReplayFilepath), false, true);
-          closeReplay();
-          return;
-        }
-        if(version != REPLAY_FILE_VERSION)
-        {
-          emit postLogMessage(tr("Cannot open \"%1\". Wrong version.").arg(loadReplayFilepath), false, true);
-          closeReplay();
-          return;
-        }
-
-        emit postLogMessage(tr("Replaying from \"%1\".").arg(loadReplayFilepath), false, false);
-        emit connectedToSimulator();
-      }
+      replayUpdateRateMs = replayReader->getUpdateRateMs();
+      emit postLogMessage(tr("Replaying from \"%1\".").arg(loadReplayFilepath), false, false);
+      emit connectedToSimulator();
     }
     else
     {
-      emit postLogMessage(tr("Cannot open \"%1\". File is too small.").arg(loadReplayFilepath), false, true);
+      emit postLogMessage(tr("Cannot open \"%1\". %2.").
+                          arg(loadReplayFilepath).arg(replayReader->getErrorString()), false, true);
       closeReplay();
-      return;
     }
   }
   else if(!saveReplayFilepath.isEmpty())
   {
-    saveReplayFile = new QFile(saveReplayFilepath);
-    if(!saveReplayFile->open(QIODevice::WriteOnly))
-    {
-      emit postLogMessage(tr("Cannot open \"%1\".").arg(saveReplayFilepath), false, true);
-      delete saveReplayFile;
-      saveReplayFile = nullptr;
-    }
+    replayWriter = new ReplayWriter(saveReplayFilepath, updateRate);
+    if(replayWriter->open())
+      emit postLogMessage(tr("Saving replay to \"%1\".").arg(saveReplayFilepath), false, false);
     else
     {
-      emit postLogMessage(tr("Saving replay to \"%1\".").arg(saveReplayFilepath), false, false);
-
-      // Save file header
-      QDataStream out(saveReplayFile);
-      out << REPLAY_FILE_MAGIC_NUMBER << REPLAY_FILE_VERSION << static_cast<quint32>(updateRate);
+      emit postLogMessage(tr("Cannot open \"%1\". %2.").
+                          arg(saveReplayFilepath).arg(replayWriter->getErrorString()), false, true);
+      delete replayWriter;
+      replayWriter = nullptr;
     }
   }
 }
 
 void DataReaderThread::closeReplay()
 {
-  if(saveReplayFile != nullptr)
+  if(replayWriter != nullptr)
   {
-    saveReplayFile->close();
-    delete saveReplayFile;
-    saveReplayFile = nullptr;
+    // Writes index
+    replayWriter->close();
+    delete replayWriter;
+    replayWriter = nullptr;
   }
 
-  if(loadReplayFile != nullptr)
+  if(replayReader != nullptr)
   {
-    loadReplayFile->close();
-    delete loadReplayFile;
-    loadReplayFile = nullptr;
+    replayReader->close();
+    delete replayReader;
+    replayReader = nullptr;
   }
 }
 
+void DataReaderThread::seekReplay(const QDateTime& timestamp)
+{
+  replaySeekSecs.store(timestamp.toSecsSinceEpoch());
+  waitCondition.wakeAll();
+}
+
 bool DataReaderThread::isSimconnectAvailable() const
 {
   return handler->isLoaded();
@@ -655,9 +641,9 @@ void DataReaderThread::setWeatherRequest(atools::fs::sc::WeatherRequest request)
     return;
   }
 
-  if(saveReplayFile != nullptr)
+  if(replayReader != nullptr)
   {
-    // Post a dummy weather reply if replaying, do not pass to handler
+    // Post a dummy weather reply if replaying since no simulator is connected, do not pass to handler
     emit postSimConnectData(atools::fs::sc::SimConnectData());
     return;
   }
@@ -25,13 +25,14 @@
 #include <QThread>
 #include <QWaitCondition>
 
-class QFile;
 
 namespace atools {
 namespace fs {
 namespace sc {
 
 class ConnectHandler;
+class ReplayReader;
+class ReplayWriter;
 
 /* Actively reads flight simulator data using the simconnect interface in background and sends a
  * signal for each data package. */
@@ -98,11 +99,16 @@ public:
     loadReplayFilepath = value;
   }
 
+  /* Speed factor for replay. Packets are skipped for seekable files instead of sending them faster. */
   void setReplaySpeed(int value)
   {
     replaySpeed = std::max(1, value);
   }
 
+  /* Jump to the given time in the replay file with the next iteration. Can be called from any thread.
+   * Only supported for replay files in the indexed format. */
+  void seekReplay(const QDateTime& timestamp);
+
   /* Save and update whazzup file during replay only. */
   void setReplayWhazzupFile(const QString& filename)
   {
@@ -181,16 +187,15 @@ private:
   int numErrors = 0;
   const int MAX_NUMBER_OF_ERRORS = 10;
 
-  const quint32 REPLAY_FILE_MAGIC_NUMBER = 0XCACF4F27;
-  const quint32 REPLAY_FILE_VERSION = 1;
-  const int REPLAY_FILE_DATA_START_OFFSET = sizeof(REPLAY_FILE_MAGIC_NUMBER) + sizeof(REPLAY_FILE_VERSION) +
-                                            sizeof(quint32);
-
   QString saveReplayFilepath, loadReplayFilepath, replayWhazzupFile;
   int replaySpeed = 1, whazzupUpdateSeconds = 15;
-  QFile *saveReplayFile = nullptr, *loadReplayFile = nullptr;
+  atools::fs::sc::ReplayWriter *replayWriter = nullptr;
+  atools::fs::sc::ReplayReader *replayReader = nullptr;
   quint32 replayUpdateRateMs = 500;
 
+  /* Seconds since epoch for requested seek or -1 if none */
+  std::atomic<qint64> replaySeekSecs;
+
   bool terminate = false, verbose = false, failedTerminally = false;
   unsigned int updateRate = 500;
   int reconnectRateSec = 10;
@@ -0,0 +1,450 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/sc/replayfile.h"
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QtEndian>
+
+#include <algorithm>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+static const quint32 REPLAY_FILE_MAGIC_NUMBER = 0XCACF4F27;
+static const quint32 REPLAY_FILE_VERSION_LEGACY = 1;
+static const quint32 REPLAY_FILE_VERSION = 2;
+
+/* Magic number, version and update rate */
+static const qint64 REPLAY_FILE_DATA_START_OFFSET = 3 * sizeof(quint32);
+
+/* Magic number for index and trailer */
+static const quint32 REPLAY_INDEX_MAGIC_NUMBER = 0x1D3A4F27;
+
+/* Compressed size, timestamp and number of packets */
+static const qint64 BLOCK_HEADER_SIZE = 3 * sizeof(quint32);
+
+/* Index offset and magic number at end of file */
+static const qint64 TRAILER_SIZE = sizeof(quint64) + sizeof(quint32);
+
+/* Block limits - 120 packets is one minute at the default update rate */
+static const int BLOCK_MAX_PACKETS = 120;
+static const int BLOCK_MAX_BYTES = 4 * 1024 * 1024;
+
+/* Packet header up to keyframe flag: magic, size, version, packet id, timestamp and keyframe flag */
+static const int PACKET_PEEK_SIZE = 5 * sizeof(quint32) + 1;
+
+// ===========================================================================
+ReplayWriter::ReplayWriter(const QString& filepath, quint32 updateRateMs)
+  : file(filepath), updateRate(updateRateMs)
+{
+  // Keyframes only at block start or if deltas grow too large
+  encoder.setKeyframeInterval(BLOCK_MAX_PACKETS + 1);
+  blockEntry = {0, 0, 0};
+}
+
+ReplayWriter::~ReplayWriter()
+{
+  close();
+}
+
+bool ReplayWriter::open()
+{
+  if(!file.open(QIODevice::WriteOnly))
+    return false;
+
+  QDataStream out(&file);
+  out << REPLAY_FILE_MAGIC_NUMBER << REPLAY_FILE_VERSION << updateRate;
+  return out.status() == QDataStream::Ok;
+}
+
+void ReplayWriter::write(const SimConnectData& data)
+{
+  if(!file.isOpen())
+    return;
+
+  if(blockEntry.numPackets == 0)
+  {
+    // New block starts with a keyframe
+    encoder.clear();
+    blockEntry.timestamp = static_cast<quint32>(data.getPacketTimestamp().toSecsSinceEpoch());
+  }
+
+  block.append(data.writeDeltaToByteArray(encoder));
+  blockEntry.numPackets++;
+
+  if(blockEntry.numPackets >= BLOCK_MAX_PACKETS || block.size() >= BLOCK_MAX_BYTES)
+    writeBlock();
+}
+
+void ReplayWriter::writeBlock()
+{
+  if(blockEntry.numPackets == 0)
+    return;
+
+  QByteArray compressed = qCompress(block);
+
+  blockEntry.offset = static_cast<quint64>(file.pos());
+  index.append(blockEntry);
+
+  QDataStream out(&file);
+  out << static_cast<quint32>(compressed.size()) << blockEntry.timestamp << blockEntry.numPackets;
+  out.writeRawData(compressed.constData(), compressed.size());
+
+  // Write to disk to keep file readable in case of a crash
+  file.flush();
+
+  block.clear();
+  blockEntry = {0, 0, 0};
+}
+
+void ReplayWriter::close()
+{
+  if(!file.isOpen())
+    return;
+
+  writeBlock();
+
+  // Write index and trailer pointing to index
+  quint64 indexOffset = static_cast<quint64>(file.pos());
+  QDataStream out(&file);
+  out << REPLAY_INDEX_MAGIC_NUMBER << static_cast<quint32>(index.size());
+  for(const ReplayIndexEntry& entry : qAsConst(index))
+    out << entry.timestamp << entry.numPackets << entry.offset;
+  out << indexOffset << REPLAY_INDEX_MAGIC_NUMBER;
+
+  qDebug() << Q_FUNC_INFO << file.fileName() << "blocks" << index.size() << "size" << file.size();
+
+  file.close();
+  index.clear();
+}
+
+// ===========================================================================
+ReplayReader::ReplayReader(const QString& filepath)
+  : file(filepath)
+{
+
+}
+
+bool ReplayReader::open()
+{
+  errorString.clear();
+
+  if(file.size() <= REPLAY_FILE_DATA_START_OFFSET)
+  {
+    errorString = QObject::tr("File is too small");
+    return false;
+  }
+
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    errorString = file.errorString();
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  quint32 magicNumber;
+  in >> magicNumber >> version >> updateRateMs;
+  if(magicNumber != REPLAY_FILE_MAGIC_NUMBER)
+  {
+    errorString = QObject::tr("Is not a replay file - wrong magic number");
+    close();
+    return false;
+  }
+
+  if(version == REPLAY_FILE_VERSION)
+  {
+    if(!readIndex())
+      // No index written due to crash - rebuild it
+      scanIndex();
+
+    if(index.isEmpty())
+    {
+      errorString = QObject::tr("File contains no data");
+      close();
+      return false;
+    }
+  }
+  else if(version != REPLAY_FILE_VERSION_LEGACY)
+  {
+    errorString = QObject::tr("Wrong version");
+    close();
+    return false;
+  }
+
+  qDebug() << Q_FUNC_INFO << file.fileName() << "version" << version << "blocks" << index.size();
+  return true;
+}
+
+void ReplayReader::close()
+{
+  blockBuffer.close();
+  blockData.clear();
+  index.clear();
+  decoder.clear();
+  currentBlock = -1;
+  packetInBlock = 0;
+  file.close();
+}
+
+bool ReplayReader::readIndex()
+{
+  qint64 size = file.size();
+  if(size < REPLAY_FILE_DATA_START_OFFSET + TRAILER_SIZE)
+    return false;
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  quint64 indexOffset;
+  quint32 magicNumber;
+  file.seek(size - TRAILER_SIZE);
+  in >> indexOffset >> magicNumber;
+  if(magicNumber != REPLAY_INDEX_MAGIC_NUMBER || indexOffset < static_cast<quint64>(REPLAY_FILE_DATA_START_OFFSET) ||
+     indexOffset >= static_cast<quint64>(size - TRAILER_SIZE))
+    return false;
+
+  quint32 num;
+  file.seek(static_cast<qint64>(indexOffset));
+  in >> magicNumber >> num;
+
+  // Each entry has 16 bytes
+  if(magicNumber != REPLAY_INDEX_MAGIC_NUMBER || num > (static_cast<quint64>(size) - indexOffset) / 16)
+    return false;
+
+  index.reserve(static_cast<int>(num));
+  for(quint32 i = 0; i < num && in.status() == QDataStream::Ok; i++)
+  {
+    ReplayIndexEntry entry;
+    in >> entry.timestamp >> entry.numPackets >> entry.offset;
+    if(entry.numPackets > 0)
+      index.append(entry);
+  }
+
+  if(in.status() != QDataStream::Ok)
+  {
+    index.clear();
+    return false;
+  }
+  return true;
+}
+
+void ReplayReader::scanIndex()
+{
+  qWarning() << Q_FUNC_INFO << "No index in" << file.fileName() << "- scanning blocks";
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  index.clear();
+  qint64 offset = REPLAY_FILE_DATA_START_OFFSET, size = file.size();
+  file.seek(offset);
+  while(offset + BLOCK_HEADER_SIZE <= size)
+  {
+    quint32 compressedSize;
+    ReplayIndexEntry entry;
+    in >> compressedSize >> entry.timestamp >> entry.numPackets;
+    entry.offset = static_cast<quint64>(offset);
+
+    // Stop at truncated block
+    if(in.status() != QDataStream::Ok || offset + BLOCK_HEADER_SIZE + compressedSize > size)
+      break;
+
+    if(entry.numPackets > 0)
+      index.append(entry);
+
+    offset += BLOCK_HEADER_SIZE + compressedSize;
+    file.seek(offset);
+  }
+}
+
+bool ReplayReader::loadBlock(int blockIndex)
+{
+  const ReplayIndexEntry& entry = index.at(blockIndex);
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  quint32 compressedSize, timestamp, numPackets;
+  file.seek(static_cast<qint64>(entry.offset));
+  in >> compressedSize >> timestamp >> numPackets;
+
+  blockBuffer.close();
+  blockData = qUncompress(file.read(compressedSize));
+  blockBuffer.setBuffer(&blockData);
+  blockBuffer.open(QIODevice::ReadOnly);
+
+  // Each block starts with a keyframe
+  decoder.clear();
+  currentBlock = blockIndex;
+  packetInBlock = 0;
+
+  if(blockData.isEmpty())
+  {
+    errorString = QObject::tr("Cannot decompress block at offset %1").arg(entry.offset);
+    return false;
+  }
+  return true;
+}
+
+bool ReplayReader::read(SimConnectData& data)
+{
+  if(version == REPLAY_FILE_VERSION_LEGACY)
+  {
+    data.read(&file);
+
+    // Start from beginning
+    if(data.getStatus() == OK && file.atEnd())
+      file.seek(REPLAY_FILE_DATA_START_OFFSET);
+
+    errorString = data.getStatusText();
+    return data.getStatus() == OK;
+  }
+
+  if(currentBlock < 0 || blockBuffer.atEnd())
+  {
+    // Load next block and start from beginning at end of file
+    if(!loadBlock(currentBlock + 1 < index.size() ? currentBlock + 1 : 0))
+      return false;
+  }
+
+  data.read(&blockBuffer, &decoder);
+  packetInBlock++;
+  errorString = data.getStatusText();
+  return data.getStatus() == OK;
+}
+
+bool ReplayReader::peekPacket(quint32& size, quint32& timestamp, bool& keyframe)
+{
+  QByteArray header = blockBuffer.peek(PACKET_PEEK_SIZE);
+  if(header.size() < PACKET_PEEK_SIZE)
+    return false;
+
+  const uchar *ptr = reinterpret_cast<const uchar *>(header.constData());
+  size = qFromBigEndian<quint32>(ptr + sizeof(quint32));
+  timestamp = qFromBigEndian<quint32>(ptr + 4 * sizeof(quint32));
+  keyframe = ptr[5 * sizeof(quint32)] != 0;
+  return true;
+}
+
+bool ReplayReader::skipPacket()
+{
+  quint32 size, timestamp;
+  bool keyframe;
+  if(!peekPacket(size, timestamp, keyframe))
+    return false;
+
+  if(keyframe)
+  {
+    // Needed for following deltas
+    SimConnectData data;
+    data.read(&blockBuffer, &decoder);
+  }
+  else
+    // Size does not include magic number and size
+    blockBuffer.seek(blockBuffer.pos() + 2 * static_cast<qint64>(sizeof(quint32)) + size);
+
+  packetInBlock++;
+  return true;
+}
+
+void ReplayReader::skip(int num)
+{
+  if(num <= 0)
+    return;
+
+  if(version == REPLAY_FILE_VERSION_LEGACY)
+  {
+    // Have to read sequentially
+    for(int i = 0; i < num; i++)
+    {
+      SimConnectData data;
+      if(!read(data))
+        break;
+    }
+    return;
+  }
+
+  // Jump over whole blocks using the index
+  int block = std::max(currentBlock, 0);
+  int target = num + (currentBlock < 0 ? 0 : packetInBlock);
+  while(target >= static_cast<int>(index.at(block).numPackets))
+  {
+    target -= index.at(block).numPackets;
+    block = block + 1 < index.size() ? block + 1 : 0;
+  }
+
+  // Reload if the skip wraps around into the current block since reading cannot go back
+  if(block != currentBlock || target < packetInBlock)
+  {
+    if(!loadBlock(block))
+      return;
+  }
+
+  while(packetInBlock < target)
+  {
+    if(!skipPacket())
+      break;
+  }
+}
+
+bool ReplayReader::seek(const QDateTime& timestamp)
+{
+  if(!isSeekable() || index.isEmpty())
+    return false;
+
+  quint32 secs = static_cast<quint32>(timestamp.toSecsSinceEpoch());
+
+  // Find last block starting at or before timestamp
+  QVector<ReplayIndexEntry>::const_iterator it =
+    std::upper_bound(index.constBegin(), index.constEnd(), secs, [](quint32 ts, const ReplayIndexEntry& entry) {
+          return ts < entry.timestamp;
+        });
+  int block = it == index.constBegin() ? 0 : static_cast<int>(std::distance(index.constBegin(), it)) - 1;
+
+  if(!loadBlock(block))
+    return false;
+
+  // Skip packets before timestamp in block
+  quint32 size, packetTs;
+  bool keyframe;
+  while(peekPacket(size, packetTs, keyframe) && packetTs < secs)
+    skipPacket();
+
+  return true;
+}
+
+QDateTime ReplayReader::getStartTime() const
+{
+  return index.isEmpty() ? QDateTime() : QDateTime::fromSecsSinceEpoch(index.constFirst().timestamp, Qt::UTC);
+}
+
+QDateTime ReplayReader::getEndTime() const
+{
+  return index.isEmpty() ? QDateTime() : QDateTime::fromSecsSinceEpoch(index.constLast().timestamp, Qt::UTC);
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
@@ -0,0 +1,153 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_SC_REPLAYFILE_H
+#define ATOOLS_FS_SC_REPLAYFILE_H
+
+#include "fs/sc/simconnectdelta.h"
+
+#include <QBuffer>
+#include <QFile>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+class SimConnectData;
+
+/* Index entry for one compressed block of a replay file */
+struct ReplayIndexEntry
+{
+  quint32 timestamp; /* Seconds since epoch of first packet in block */
+  quint32 numPackets;
+  quint64 offset; /* File offset of block header */
+};
+
+/*
+ * Writes replay files in version 2 format.
+ *
+ * Packets are delta encoded where each block starts with a keyframe. Blocks are compressed and
+ * contain a header with size, timestamp and number of packets. An index with timestamps and offsets of all blocks
+ * is appended on close. Files without index due to a crash can still be read.
+ */
+class ReplayWriter
+{
+public:
+  ReplayWriter(const QString& filepath, quint32 updateRateMs);
+  ~ReplayWriter();
+
+  ReplayWriter(const ReplayWriter& other) = delete;
+  ReplayWriter& operator=(const ReplayWriter& other) = delete;
+
+  /* Creates file and writes header. Returns false if file cannot be opened. */
+  bool open();
+
+  /* Append a packet. Flushes a block if it is full. */
+  void write(const atools::fs::sc::SimConnectData& data);
+
+  /* Writes remaining block and index */
+  void close();
+
+  QString getErrorString() const
+  {
+    return file.errorString();
+  }
+
+private:
+  void writeBlock();
+
+  QFile file;
+  quint32 updateRate;
+
+  atools::fs::sc::SimConnectDeltaEncoder encoder;
+  QByteArray block;
+  ReplayIndexEntry blockEntry;
+  QVector<ReplayIndexEntry> index;
+};
+
+/*
+ * Reads replay files in version 1 (uncompressed sequential) and version 2 (indexed, compressed and delta encoded).
+ * Version 2 allows seeking to a timestamp and skipping packets without decoding them.
+ * Replay starts again from the beginning if the end of file is reached.
+ */
+class ReplayReader
+{
+public:
+  explicit ReplayReader(const QString& filepath);
+
+  ReplayReader(const ReplayReader& other) = delete;
+  ReplayReader& operator=(const ReplayReader& other) = delete;
+
+  /* Opens file and reads header and index. Returns false and sets error string on failure. */
+  bool open();
+  void close();
+
+  /* Read next packet. Returns false on error. */
+  bool read(atools::fs::sc::SimConnectData& data);
+
+  /* Skip number of packets. Only keyframes are decoded for version 2 files. */
+  void skip(int num);
+
+  /* Go to the first packet at or after timestamp. Returns false if not supported by file version. */
+  bool seek(const QDateTime& timestamp);
+
+  bool isSeekable() const
+  {
+    return version >= 2;
+  }
+
+  quint32 getUpdateRateMs() const
+  {
+    return updateRateMs;
+  }
+
+  /* Time of first and last block. Invalid for version 1. */
+  QDateTime getStartTime() const;
+  QDateTime getEndTime() const;
+
+  const QString& getErrorString() const
+  {
+    return errorString;
+  }
+
+private:
+  bool readIndex();
+  void scanIndex();
+  bool loadBlock(int blockIndex);
+
+  /* Read header values of next packet in block without consuming it */
+  bool peekPacket(quint32& size, quint32& timestamp, bool& keyframe);
+
+  /* Skip next packet in current block but decode it if it is a keyframe */
+  bool skipPacket();
+
+  QFile file;
+  quint32 version = 0, updateRateMs = 500;
+  QString errorString;
+
+  QVector<ReplayIndexEntry> index;
+  int currentBlock = -1, packetInBlock = 0;
+  QByteArray blockData;
+  QBuffer blockBuffer;
+  atools::fs::sc::SimConnectDeltaDecoder decoder;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_REPLAYFILE_H
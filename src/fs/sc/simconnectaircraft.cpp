@@ -127,6 +127,174 @@ void SimConnectAircraft::write(QDataStream& out) const
       << static_cast<quint8>(category) << static_cast<quint8>(engineType) << transponderCode << properties;
 }
 
+/* Field groups for delta encoding */
+enum DeltaField : quint16
+{
+  DELTA_FLAGS = 1 << 0,
+  DELTA_STRINGS = 1 << 1,
+  DELTA_POSITION = 1 << 2,
+  DELTA_HEADING = 1 << 3,
+  DELTA_SPEED = 1 << 4,
+  DELTA_VERT_SPEED = 1 << 5,
+  DELTA_IND_ALTITUDE = 1 << 6,
+  DELTA_MODEL = 1 << 7,
+  DELTA_TRANSPONDER = 1 << 8,
+  DELTA_PROPERTIES = 1 << 9,
+  DELTA_ALL = 0x3ff
+};
+
+void SimConnectAircraft::writeDelta(QDataStream& out, const SimConnectAircraft *baseline,
+                                    const std::function<quint32(const QString&)>& stringId) const
+{
+  quint16 mask = DELTA_ALL;
+  if(baseline != nullptr)
+  {
+    const SimConnectAircraft& b = *baseline;
+
+    // Exact comparison to avoid drift between keyframe and delta
+    auto changed = [](float f1, float f2) -> bool {
+                     return f1 < f2 || f1 > f2;
+                   };
+
+    mask = 0;
+    if(dataFlags != b.dataFlags || flags != b.flags)
+      mask |= DELTA_FLAGS;
+    if(airplaneTitle != b.airplaneTitle || airplaneModel != b.airplaneModel || airplaneReg != b.airplaneReg ||
+       airplaneType != b.airplaneType || airplaneAirline != b.airplaneAirline ||
+       airplaneFlightnumber != b.airplaneFlightnumber || fromIdent != b.fromIdent || toIdent != b.toIdent)
+      mask |= DELTA_STRINGS;
+    if(changed(position.getLonX(), b.position.getLonX()) || changed(position.getLatY(), b.position.getLatY()) ||
+       changed(position.getAltitude(), b.position.getAltitude()))
+      mask |= DELTA_POSITION;
+    if(changed(headingTrueDeg, b.headingTrueDeg) || changed(headingMagDeg, b.headingMagDeg))
+      mask |= DELTA_HEADING;
+    if(changed(groundSpeedKts, b.groundSpeedKts) || changed(indicatedSpeedKts, b.indicatedSpeedKts) ||
+       changed(trueAirspeedKts, b.trueAirspeedKts) || changed(machSpeed, b.machSpeed))
+      mask |= DELTA_SPEED;
+    if(changed(verticalSpeedFeetPerMin, b.verticalSpeedFeetPerMin))
+      mask |= DELTA_VERT_SPEED;
+    if(changed(indicatedAltitudeFt, b.indicatedAltitudeFt))
+      mask |= DELTA_IND_ALTITUDE;
+    if(numberOfEngines != b.numberOfEngines || wingSpanFt != b.wingSpanFt || modelRadiusFt != b.modelRadiusFt ||
+       deckHeight != b.deckHeight || category != b.category || engineType != b.engineType)
+      mask |= DELTA_MODEL;
+    if(transponderCode != b.transponderCode)
+      mask |= DELTA_TRANSPONDER;
+    if(properties != b.properties)
+      mask |= DELTA_PROPERTIES;
+  }
+
+  out << mask;
+
+  if(mask & DELTA_FLAGS)
+    out << static_cast<quint8>(dataFlags) << static_cast<quint16>(flags);
+
+  if(mask & DELTA_STRINGS)
+    out << stringId(airplaneTitle) << stringId(airplaneModel) << stringId(airplaneReg) << stringId(airplaneType)
+        << stringId(airplaneAirline) << stringId(airplaneFlightnumber) << stringId(fromIdent) << stringId(toIdent);
+
+  if(mask & DELTA_POSITION)
+    out << position.getLonX() << position.getLatY() << position.getAltitude();
+
+  if(mask & DELTA_HEADING)
+    out << headingTrueDeg << headingMagDeg;
+
+  if(mask & DELTA_SPEED)
+    out << groundSpeedKts << indicatedSpeedKts << trueAirspeedKts << machSpeed;
+
+  if(mask & DELTA_VERT_SPEED)
+    out << verticalSpeedFeetPerMin;
+
+  if(mask & DELTA_IND_ALTITUDE)
+    out << indicatedAltitudeFt;
+
+  if(mask & DELTA_MODEL)
+    out << numberOfEngines << wingSpanFt << modelRadiusFt << deckHeight
+        << static_cast<quint8>(category) << static_cast<quint8>(engineType);
+
+  if(mask & DELTA_TRANSPONDER)
+    out << transponderCode;
+
+  if(mask & DELTA_PROPERTIES)
+    out << properties;
+}
+
+bool SimConnectAircraft::readDelta(QDataStream& in, const SimConnectAircraft *baseline, const QVector<QString>& strings)
+{
+  if(baseline != nullptr)
+  {
+    // Keep own object id
+    quint32 id = objectId;
+    *this = *baseline;
+    objectId = id;
+  }
+
+  quint16 mask;
+  in >> mask;
+
+  if(mask & DELTA_FLAGS)
+  {
+    quint8 byteFlags;
+    quint16 shortFlags;
+    in >> byteFlags >> shortFlags;
+    dataFlags = DataFlags(byteFlags);
+    flags = AircraftFlags(shortFlags);
+  }
+
+  bool ok = true;
+  if(mask & DELTA_STRINGS)
+  {
+    for(QString *str : {&airplaneTitle, &airplaneModel, &airplaneReg, &airplaneType, &airplaneAirline,
+                        &airplaneFlightnumber, &fromIdent, &toIdent})
+    {
+      quint32 id;
+      in >> id;
+      if(id < static_cast<quint32>(strings.size()))
+        *str = strings.at(static_cast<int>(id));
+      else
+      {
+        str->clear();
+        ok = false;
+      }
+    }
+  }
+
+  if(mask & DELTA_POSITION)
+  {
+    float lonx, laty, altitude;
+    in >> lonx >> laty >> altitude;
+    position = atools::geo::Pos(lonx, laty, altitude);
+  }
+
+  if(mask & DELTA_HEADING)
+    in >> headingTrueDeg >> headingMagDeg;
+
+  if(mask & DELTA_SPEED)
+    in >> groundSpeedKts >> indicatedSpeedKts >> trueAirspeedKts >> machSpeed;
+
+  if(mask & DELTA_VERT_SPEED)
+    in >> verticalSpeedFeetPerMin;
+
+  if(mask & DELTA_IND_ALTITUDE)
+    in >> indicatedAltitudeFt;
+
+  if(mask & DELTA_MODEL)
+  {
+    quint8 categoryByte, engineTypeByte;
+    in >> numberOfEngines >> wingSpanFt >> modelRadiusFt >> deckHeight >> categoryByte >> engineTypeByte;
+    category = static_cast<Category>(categoryByte);
+    engineType = static_cast<EngineType>(engineTypeByte);
+  }
+
+  if(mask & DELTA_TRANSPONDER)
+    in >> transponderCode;
+
+  if(mask & DELTA_PROPERTIES)
+    in >> properties;
+
+  return ok;
+}
+
 int SimConnectAircraft::getId() const
 {
   if(objectId > std::numeric_limits<int>::max())
@@ -23,6 +23,9 @@
 #include "util/props.h"
 
 #include <QString>
+#include <QVector>
+
+#include <functional>
 
 class QIODevice;
 
@@ -40,6 +43,7 @@ class OnlinedataManager;
 namespace sc {
 
 class SimConnectHandler;
+class TrafficGeneratorHandler;
 class SimConnectHandlerPrivate;
 class SimConnectData;
 
@@ -94,6 +98,15 @@ public:
   virtual void read(QDataStream & in);
   virtual void write(QDataStream& out) const;
 
+  /* Write only field groups which differ from baseline preceded by a mask. All fields if baseline is null.
+   * Strings are written as ids provided by stringId. Object id is not written. */
+  void writeDelta(QDataStream& out, const SimConnectAircraft *baseline,
+                  const std::function<quint32(const QString&)>& stringId) const;
+
+  /* Read fields written by writeDelta. Unchanged fields are copied from baseline if not null.
+   * Returns false if a string id is not in the table. */
+  bool readDelta(QDataStream& in, const SimConnectAircraft *baseline, const QVector<QString>& strings);
+
   // fs data ----------------------------------------------------
 
   /* Mooney, Boeing, Actually aircraft model. */
@@ -449,6 +462,7 @@ private:
   friend class atools::fs::sc::SimConnectHandler;
   friend class atools::fs::sc::SimConnectHandlerPrivate;
   friend class atools::fs::sc::SimConnectData;
+  friend class atools::fs::sc::TrafficGeneratorHandler;
   friend class xpc::XpConnect;
   friend class xpc::AircraftFileLoader;
   friend class atools::fs::online::OnlinedataManager;
@@ -17,6 +17,8 @@
 
 #include "fs/sc/simconnectdata.h"
 
+#include "fs/sc/simconnectdelta.h"
+
 #include "geo/calculations.h"
 
 #include <QDebug>
@@ -44,7 +46,7 @@ SimConnectData::~SimConnectData()
 
 }
 
-bool SimConnectData::read(QIODevice *ioDevice)
+bool SimConnectData::read(QIODevice *ioDevice, SimConnectDeltaDecoder *decoder)
 {
   status = OK;
 
@@ -58,7 +60,7 @@ bool SimConnectData::read(QIODevice *ioDevice)
       return false;
 
     in >> magicNumber;
-    if(magicNumber != MAGIC_NUMBER_DATA)
+    if(magicNumber != MAGIC_NUMBER_DATA && !(decoder != nullptr && magicNumber == MAGIC_NUMBER_DELTA))
     {
       qWarning() << "SimConnectData::read: invalid magic number" << magicNumber;
       status = INVALID_MAGIC_NUMBER;
@@ -78,10 +80,13 @@ bool SimConnectData::read(QIODevice *ioDevice)
   if(ioDevice->bytesAvailable() < packetSize)
     return false;
 
+  bool delta = magicNumber == MAGIC_NUMBER_DELTA;
+  quint32 expectedVersion = delta ? DELTA_VERSION : DATA_VERSION;
+
   in >> version;
-  if(version != DATA_VERSION)
+  if(version != expectedVersion)
   {
-    qWarning() << "SimConnectData::read: version mismatch" << version << "!=" << DATA_VERSION;
+    qWarning() << "SimConnectData::read: version mismatch" << version << "!=" << expectedVersion;
     status = VERSION_MISMATCH;
     return false;
   }
@@ -91,6 +96,21 @@ bool SimConnectData::read(QIODevice *ioDevice)
   in >> ts;
   packetTs = QDateTime::fromSecsSinceEpoch(ts, Qt::UTC);
 
+  if(delta)
+  {
+    decoder->deltaReceived = true;
+    return readDelta(in, decoder);
+  }
+  else
+  {
+    readAircraft(in);
+    readMetars(in);
+    return true;
+  }
+}
+
+void SimConnectData::readAircraft(QDataStream& in)
+{
   quint8 hasUser = 0;
   in >> hasUser;
   if(hasUser == 1)
@@ -104,7 +124,87 @@ bool SimConnectData::read(QIODevice *ioDevice)
     ap.read(in);
     aiAircraft.append(ap);
   }
+}
+
+bool SimConnectData::readDelta(QDataStream& in, SimConnectDeltaDecoder *decoder)
+{
+  quint8 keyframe;
+  quint32 keyframeId;
+  in >> keyframe >> keyframeId;
+
+  // Size of version, packet id, timestamp, keyframe flag and id
+  const quint32 HEADER_SIZE = 17;
+
+  // Packets with keyframe id 0 like weather replies do not refer to a keyframe and can be read at any time
+  if(!keyframe && keyframeId != 0 && (!decoder->keyframeValid || keyframeId != decoder->keyframeId))
+  {
+    // Skip packet to keep stream in sync
+    qWarning() << "SimConnectData::read: keyframe" << keyframeId << "missing. Current" << decoder->keyframeId;
+    in.skipRawData(static_cast<int>(packetSize - HEADER_SIZE));
+    status = KEYFRAME_MISSING;
+    return false;
+  }
+
+  // Strings from keyframe table and new ones from this packet
+  QVector<QString> strings = keyframe || keyframeId == 0 ? QVector<QString>() : decoder->strings;
+  quint32 numStrings = 0;
+  in >> numStrings;
+  for(quint32 i = 0; i < numStrings && in.status() == QDataStream::Ok; i++)
+  {
+    QString str;
+    readString(in, str);
+    strings.append(str);
+  }
 
+  quint8 hasUser = 0;
+  in >> hasUser;
+  if(hasUser == 1)
+    userAircraft.read(in);
+
+  bool ok = true;
+  quint16 numAi = 0;
+  in >> numAi;
+  aiAircraft.reserve(numAi);
+  for(quint16 i = 0; i < numAi; i++)
+  {
+    SimConnectAircraft aircraft;
+    in >> aircraft.objectId;
+
+    const SimConnectAircraft *base = nullptr;
+    if(!keyframe)
+    {
+      QHash<quint32, SimConnectAircraft>::const_iterator it = decoder->baseline.constFind(aircraft.objectId);
+      if(it != decoder->baseline.constEnd())
+        base = &it.value();
+    }
+
+    ok &= aircraft.readDelta(in, base, strings);
+    aiAircraft.append(aircraft);
+  }
+
+  readMetars(in);
+
+  if(keyframe)
+  {
+    // Remember as baseline for following deltas
+    decoder->baseline.clear();
+    for(const SimConnectAircraft& aircraft : qAsConst(aiAircraft))
+      decoder->baseline.insert(aircraft.objectId, aircraft);
+    decoder->strings = strings;
+    decoder->keyframeId = keyframeId;
+    decoder->keyframeValid = ok;
+  }
+
+  if(!ok)
+  {
+    qWarning() << "SimConnectData::read: invalid string reference in keyframe" << keyframeId;
+    status = KEYFRAME_MISSING;
+  }
+  return ok;
+}
+
+void SimConnectData::readMetars(QDataStream& in)
+{
   quint16 numMetar = 0;
   in >> numMetar;
   for(quint16 i = 0; i < numMetar; i++)
@@ -127,20 +227,53 @@ bool SimConnectData::read(QIODevice *ioDevice)
 
     metarResults.append(result);
   }
-
-  return true;
 }
 
 int SimConnectData::write(QIODevice *ioDevice)
 {
   status = OK;
+  return SimConnectDataBase::writeBlock(ioDevice, writeToByteArray(), status);
+}
 
+void SimConnectData::writeHeader(QDataStream& out, quint32 magicNumberParam, quint32 versionParam) const
+{
+  out << magicNumberParam << packetSize << versionParam << packetId
+      << static_cast<quint32>(packetTs.toSecsSinceEpoch());
+}
+
+void SimConnectData::updateSize(QDataStream& out, QByteArray& block)
+{
+  // Go back and update size
+  out.device()->seek(sizeof(MAGIC_NUMBER_DATA));
+  int size = block.size() - static_cast<int>(sizeof(packetSize)) - static_cast<int>(sizeof(MAGIC_NUMBER_DATA));
+  out << static_cast<quint32>(size);
+}
+
+void SimConnectData::writeMetars(QDataStream& out) const
+{
+  qsizetype numMetar = std::min(static_cast<qsizetype>(65535), static_cast<qsizetype>(metarResults.size()));
+  out << static_cast<quint16>(numMetar);
+
+  for(int i = 0; i < numMetar; i++)
+  {
+    const MetarResult& result = metarResults.at(i);
+    writeString(out, result.requestIdent);
+    out << result.requestPos.getLonX() << result.requestPos.getLatY() << result.requestPos.getAltitude()
+        << static_cast<quint32>(result.timestamp.toSecsSinceEpoch());
+    writeLongString(out, result.metarForStation);
+    writeLongString(out, result.metarForNearest);
+    writeLongString(out, result.metarForInterpolated);
+  }
+}
+
+QByteArray SimConnectData::writeToByteArray() const
+{
   QByteArray block;
   QDataStream out(&block, QIODevice::WriteOnly);
   out.setVersion(QDataStream::Qt_5_5);
   out.setFloatingPointPrecision(QDataStream::SinglePrecision);
 
-  out << MAGIC_NUMBER_DATA << packetSize << DATA_VERSION << packetId << static_cast<quint32>(packetTs.toSecsSinceEpoch());
+  writeHeader(out, MAGIC_NUMBER_DATA, DATA_VERSION);
 
   bool userValid = userAircraft.getPosition().isValid();
   out << static_cast<quint8>(userValid);
@@ -153,26 +286,65 @@ int SimConnectData::write(QIODevice *ioDevice)
   for(int i = 0; i < numAi; i++)
     aiAircraft.at(i).write(out);
 
-  qsizetype numMetar = std::min(static_cast<qsizetype>(65535), static_cast<qsizetype>(metarResults.size()));
-  out << static_cast<quint16>(numMetar);
+  writeMetars(out);
+  updateSize(out, block);
+  return block;
+}
 
-  for(int i = 0; i < numMetar; i++)
+QByteArray SimConnectData::writeDeltaToByteArray(SimConnectDeltaEncoder& encoder) const
+{
+  bool keyframe = encoder.beginPacket(!isEmptyReply());
+
+  // Write AI aircraft first to collect strings which are not in the keyframe table
+  QByteArray aiBlock;
+  QDataStream aiOut(&aiBlock, QIODevice::WriteOnly);
+  aiOut.setVersion(QDataStream::Qt_5_5);
+  aiOut.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  int numAi = static_cast<int>(std::min(static_cast<qsizetype>(65535), static_cast<qsizetype>(aiAircraft.size())));
+  aiOut << static_cast<quint16>(numAi);
+
+  auto stringId = [&encoder](const QString& str) -> quint32 {
+                    return encoder.stringId(str);
+                  };
+
+  for(int i = 0; i < numAi; i++)
   {
-    const MetarResult& result = metarResults.at(i);
-    writeString(out, result.requestIdent);
-    out << result.requestPos.getLonX() << result.requestPos.getLatY() << result.requestPos.getAltitude()
-        << static_cast<quint32>(result.timestamp.toSecsSinceEpoch());
-    writeLongString(out, result.metarForStation);
-    writeLongString(out, result.metarForNearest);
-    writeLongString(out, result.metarForInterpolated);
+    const SimConnectAircraft& aircraft = aiAircraft.at(i);
+    aiOut << aircraft.objectId;
+    aircraft.writeDelta(aiOut, encoder.baselineAircraft(aircraft.objectId), stringId);
   }
 
-  // Go back and update size
-  out.device()->seek(sizeof(MAGIC_NUMBER_DATA));
-  int size = block.size() - static_cast<int>(sizeof(packetSize)) - static_cast<int>(sizeof(MAGIC_NUMBER_DATA));
-  out << static_cast<quint32>(size);
+  QByteArray block;
+  QDataStream out(&block, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+  out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  // Packets without AI aircraft do not use the keyframe baseline or string table - write id 0 to allow clients to
+  // read them before receiving the first keyframe
+  encoder.lastPacketKeyframeId = keyframe || numAi > 0 ? encoder.getKeyframeId() : 0;
+
+  writeHeader(out, MAGIC_NUMBER_DELTA, DELTA_VERSION);
+  out << static_cast<quint8>(keyframe) << encoder.lastPacketKeyframeId;
+
+  const QStringList& newStrings = encoder.getNewStrings();
+  out << static_cast<quint32>(newStrings.size());
+  for(const QString& str : newStrings)
+    writeString(out, str);
+
+  // User aircraft is always sent completely
+  bool userValid = userAircraft.getPosition().isValid();
+  out << static_cast<quint8>(userValid);
+  if(userValid)
+    userAircraft.write(out);
+
+  out.writeRawData(aiBlock.constData(), aiBlock.size());
+
+  writeMetars(out);
+  updateSize(out, block);
 
-  return SimConnectDataBase::writeBlock(ioDevice, block, status);
+  encoder.endPacket(aiAircraft, numAi);
+  return block;
 }
 
 SimConnectAircraft *SimConnectData::getAiAircraftById(int id)
@@ -26,6 +26,7 @@
 #include <QDateTime>
 
 class QIODevice;
+class QDataStream;
 
 namespace xpc {
 class XpConnect;
@@ -36,6 +37,8 @@ namespace fs {
 namespace sc {
 
 class SimConnectHandler;
+class SimConnectDeltaEncoder;
+class SimConnectDeltaDecoder;
 
 /*
  * Class that transfers flight simulator data read using the simconnect interface across the network to
@@ -51,9 +54,10 @@ public:
 
   /*
    * Read from IO device.
+   * Reads delta encoded packets too if decoder is given. Decoder has to be kept for the whole connection.
    * @return true if it was fully read. False if not or an error occured.
    */
-  bool read(QIODevice *ioDevice);
+  bool read(QIODevice *ioDevice, atools::fs::sc::SimConnectDeltaDecoder *decoder = nullptr);
 
   /*
    * Write to IO device.
@@ -61,6 +65,12 @@ public:
    */
   int write(QIODevice *ioDevice);
 
+  /* Serialize to a byte array in the same format as write(). Can be written to several devices. */
+  QByteArray writeToByteArray() const;
+
+  /* Serialize to a byte array in the delta format. Creates a keyframe or a delta depending on encoder state. */
+  QByteArray writeDeltaToByteArray(atools::fs::sc::SimConnectDeltaEncoder& encoder) const;
+
   // metadata ----------------------------------------------------
   /* Serial number for data packet. */
   int getPacketId() const
@@ -160,6 +170,19 @@ private:
   const static quint32 MAGIC_NUMBER_DATA = 0xF75E0AF3;
   const static quint32 DATA_VERSION = 11;
 
+  /* Delta encoded packets are only sent if the client requests them */
+  const static quint32 MAGIC_NUMBER_DELTA = 0xF75E0AF4;
+  const static quint32 DELTA_VERSION = 1;
+
+  /* Read legacy and delta packet content after the header */
+  void readAircraft(QDataStream& in);
+  bool readDelta(QDataStream& in, atools::fs::sc::SimConnectDeltaDecoder *decoder);
+  void readMetars(QDataStream& in);
+
+  void writeHeader(QDataStream& out, quint32 magicNumberParam, quint32 versionParam) const;
+  void writeMetars(QDataStream& out) const;
+  static void updateSize(QDataStream& out, QByteArray& block);
+
   quint32 packetId = 0;
   QDateTime packetTs;
   quint32 magicNumber = 0, packetSize = 0, version = 0;
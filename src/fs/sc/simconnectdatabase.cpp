@@ -34,9 +34,9 @@ SimConnectDataBase::~SimConnectDataBase()
 
 }
 
-QString SimConnectDataBase::getStatusText() const
+QString SimConnectDataBase::getStatusText(SimConnectStatus statusParam)
 {
-  switch(status)
+  switch(statusParam)
   {
     case atools::fs::sc::OK:
       return QObject::tr("No Error");
@@ -52,6 +52,9 @@ QString SimConnectDataBase::getStatusText() const
 
     case atools::fs::sc::WRITE_ERROR:
       return QObject::tr("Write error");
+
+    case atools::fs::sc::KEYFRAME_MISSING:
+      return QObject::tr("Keyframe missing");
   }
   return QObject::tr("Unknown Status");
 }
@@ -45,7 +45,12 @@ public:
   /*
    * @return Error status text for last reading or writing call
    */
-  QString getStatusText() const;
+  QString getStatusText() const
+  {
+    return getStatusText(status);
+  }
+
+  static QString getStatusText(atools::fs::sc::SimConnectStatus statusParam);
 
   static int writeBlock(QIODevice *ioDevice, const QByteArray& block,
                         atools::fs::sc::SimConnectStatus& status);
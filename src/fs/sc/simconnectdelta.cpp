@@ -0,0 +1,134 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/sc/simconnectdelta.h"
+
+#include <QDebug>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+/* Create a keyframe earlier if deltas grow beyond these limits */
+static const int MAX_DELTA_NEW_AIRCRAFT = 20;
+static const int MAX_DELTA_NEW_STRINGS = 100;
+
+SimConnectDeltaEncoder::SimConnectDeltaEncoder()
+  : keyframeRequested(true)
+{
+
+}
+
+void SimConnectDeltaEncoder::clear()
+{
+  baseline.clear();
+  keyframeStrings.clear();
+  newStringIds.clear();
+  newStrings.clear();
+  newAircraft = 0;
+  packetsSinceKeyframe = 0;
+  lastKeyframe = false;
+  keyframeRequested.store(true);
+}
+
+bool SimConnectDeltaEncoder::beginPacket(bool allowKeyframe)
+{
+  newStringIds.clear();
+  newStrings.clear();
+  newAircraft = 0;
+
+  // Weather replies never start a keyframe and a delta is always possible from an empty baseline
+  lastKeyframe = allowKeyframe && (keyframeRequested.exchange(false) || keyframeId == 0 ||
+                                   packetsSinceKeyframe >= keyframeInterval);
+
+  if(lastKeyframe)
+  {
+    keyframeId++;
+    packetsSinceKeyframe = 0;
+    baseline.clear();
+    keyframeStrings.clear();
+  }
+  else
+    packetsSinceKeyframe++;
+
+  return lastKeyframe;
+}
+
+void SimConnectDeltaEncoder::endPacket(const QVector<SimConnectAircraft>& aircraft, int numAircraft)
+{
+  if(lastKeyframe)
+  {
+    // Remember keyframe content as baseline for the following deltas
+    baseline.reserve(numAircraft);
+    for(int i = 0; i < numAircraft; i++)
+      baseline.insert(static_cast<quint32>(aircraft.at(i).getId()), aircraft.at(i));
+
+    for(int i = 0; i < newStrings.size(); i++)
+      keyframeStrings.insert(newStrings.at(i), static_cast<quint32>(i));
+  }
+  else if(newAircraft > MAX_DELTA_NEW_AIRCRAFT || newStrings.size() > MAX_DELTA_NEW_STRINGS)
+    // Too many changes relative to keyframe
+    keyframeRequested.store(true);
+}
+
+quint32 SimConnectDeltaEncoder::stringId(const QString& str)
+{
+  if(!lastKeyframe)
+  {
+    QHash<QString, quint32>::const_iterator it = keyframeStrings.constFind(str);
+    if(it != keyframeStrings.constEnd())
+      return it.value();
+  }
+
+  QHash<QString, quint32>::const_iterator it = newStringIds.constFind(str);
+  if(it != newStringIds.constEnd())
+    return it.value();
+
+  // Ids of new strings follow the keyframe table
+  quint32 id = static_cast<quint32>(keyframeStrings.size() + newStrings.size());
+  newStringIds.insert(str, id);
+  newStrings.append(str);
+  return id;
+}
+
+const SimConnectAircraft *SimConnectDeltaEncoder::baselineAircraft(quint32 objectId)
+{
+  if(lastKeyframe)
+    return nullptr;
+
+  QHash<quint32, SimConnectAircraft>::const_iterator it = baseline.constFind(objectId);
+  if(it != baseline.constEnd())
+    return &it.value();
+
+  // Not in keyframe - will be written completely
+  newAircraft++;
+  return nullptr;
+}
+
+// ===========================================================================
+void SimConnectDeltaDecoder::clear()
+{
+  baseline.clear();
+  strings.clear();
+  keyframeId = 0;
+  keyframeValid = false;
+  deltaReceived = false;
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
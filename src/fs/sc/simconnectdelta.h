@@ -0,0 +1,152 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_SIMCONNECTDELTA_H
+#define ATOOLS_FS_SIMCONNECTDELTA_H
+
+#include "fs/sc/simconnectaircraft.h"
+
+#include <QHash>
+#include <QStringList>
+
+#include <atomic>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+class SimConnectData;
+
+/*
+ * Server side state for the delta encoded data protocol.
+ *
+ * A keyframe contains all aircraft and a string table. Following packets contain only the changed field groups
+ * of each AI aircraft relative to the last keyframe and only strings which are not in the keyframe table.
+ * Since deltas refer to the keyframe and not to the previous packet a client can miss packets without harm.
+ *
+ * Keyframes are created periodically, on request or if the deltas grow too large.
+ * Not thread safe except for requestKeyframe().
+ */
+class SimConnectDeltaEncoder
+{
+public:
+  SimConnectDeltaEncoder();
+
+  /* Force a keyframe with the next packet. Can be called from any thread. */
+  void requestKeyframe()
+  {
+    keyframeRequested.store(true);
+  }
+
+  /* Number of packets between keyframes */
+  void setKeyframeInterval(int value)
+  {
+    keyframeInterval = value;
+  }
+
+  /* Id of the current keyframe which is incremented for each new keyframe. 0 if none was created yet. */
+  quint32 getKeyframeId() const
+  {
+    return keyframeId;
+  }
+
+  /* true if the last written packet was a keyframe */
+  bool isLastKeyframe() const
+  {
+    return lastKeyframe;
+  }
+
+  /* Keyframe id written into the last packet. 0 if the packet does not depend on any keyframe like weather replies
+   * without AI aircraft. */
+  quint32 getLastPacketKeyframeId() const
+  {
+    return lastPacketKeyframeId;
+  }
+
+  void clear();
+
+private:
+  friend class atools::fs::sc::SimConnectData;
+
+  /* Start a new packet and return true if it is a keyframe */
+  bool beginPacket(bool allowKeyframe);
+
+  /* Update baseline for keyframes and check if the next packet should be a keyframe */
+  void endPacket(const QVector<SimConnectAircraft>& aircraft, int numAircraft);
+
+  /* Get id for string and add it to the new strings if not in the keyframe table */
+  quint32 stringId(const QString& str);
+
+  /* Aircraft in the keyframe or null if not found or packet is a keyframe. Counts aircraft not found. */
+  const SimConnectAircraft *baselineAircraft(quint32 objectId);
+
+  /* Strings not in the keyframe table collected for the current packet */
+  const QStringList& getNewStrings() const
+  {
+    return newStrings;
+  }
+
+  /* Keyframe state */
+  QHash<quint32, SimConnectAircraft> baseline;
+  QHash<QString, quint32> keyframeStrings;
+
+  /* Current packet state */
+  QHash<QString, quint32> newStringIds;
+  QStringList newStrings;
+  int newAircraft = 0;
+
+  quint32 keyframeId = 0, lastPacketKeyframeId = 0;
+  int keyframeInterval = 20, packetsSinceKeyframe = 0;
+  bool lastKeyframe = false;
+  std::atomic_bool keyframeRequested;
+};
+
+/*
+ * Client side state for reading delta encoded packets. Pass to SimConnectData::read() for each packet
+ * received on the same connection.
+ */
+class SimConnectDeltaDecoder
+{
+public:
+  /* true if a keyframe was received */
+  bool hasKeyframe() const
+  {
+    return keyframeValid;
+  }
+
+  /* true if any delta packet was received which confirms that the server supports the delta protocol */
+  bool isDeltaNegotiated() const
+  {
+    return deltaReceived;
+  }
+
+  void clear();
+
+private:
+  friend class atools::fs::sc::SimConnectData;
+
+  QHash<quint32, SimConnectAircraft> baseline;
+  QVector<QString> strings;
+  quint32 keyframeId = 0;
+  bool keyframeValid = false, deltaReceived = false;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SIMCONNECTDELTA_H
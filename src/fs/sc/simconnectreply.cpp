@@ -17,6 +17,7 @@
 
 #include "fs/sc/simconnectreply.h"
 #include "fs/sc/simconnectdatabase.h"
+#include "fs/sc/simconnectdelta.h"
 
 #include <QDebug>
 #include <QDataStream>
@@ -97,6 +98,12 @@ bool SimConnectReply::read(QIODevice *ioDevice)
   return true;
 }
 
+void SimConnectReply::requestDeltaProtocol(const SimConnectDeltaDecoder& decoder)
+{
+  if(!command.testFlag(CMD_WEATHER_REQUEST) || decoder.isDeltaNegotiated())
+    command |= CMD_DELTA_DATA;
+}
+
 int SimConnectReply::write(QIODevice *ioDevice)
 {
   replyStatus = OK;
@@ -31,11 +31,20 @@ namespace atools {
 namespace fs {
 namespace sc {
 
+class SimConnectDeltaDecoder;
+
 // quint16
 enum CommandEnum
 {
-  CMD_NONE,
-  CMD_WEATHER_REQUEST
+  CMD_NONE = 0,
+
+  /* Older servers compare the command with this value instead of testing the flag */
+  CMD_WEATHER_REQUEST = 1 << 0,
+
+  /* Client can read delta encoded data packets. Set in every reply to enable and keep the delta protocol.
+   * Use SimConnectReply::requestDeltaProtocol() to add it which avoids sending it together with a weather request
+   * to servers which do not know the delta protocol. */
+  CMD_DELTA_DATA = 1 << 1
 };
 
 Q_DECLARE_FLAGS(Command, CommandEnum);
@@ -112,6 +121,12 @@ public:
     command = value;
   }
 
+  /* Adds CMD_DELTA_DATA to the command. Call after setCommand().
+   * Weather requests get the flag only after the server answered with a delta packet on this connection
+   * since older servers ignore a weather request having any other flag set. Plain replies always get the flag
+   * which is ignored by older servers. */
+  void requestDeltaProtocol(const atools::fs::sc::SimConnectDeltaDecoder& decoder);
+
   const atools::fs::sc::WeatherRequest& getWeatherRequest()
   {
     return weatherRequest;
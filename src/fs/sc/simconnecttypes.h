@@ -36,7 +36,8 @@ enum SimConnectStatus
   INVALID_MAGIC_NUMBER, /* Packet data does not start with expected magic number */
   VERSION_MISMATCH, /* Client and server data version does not match for either data or reply */
   INSUFFICIENT_WRITE, /* Wrote less than block */
-  WRITE_ERROR /* Error from IO device */
+  WRITE_ERROR, /* Error from IO device */
+  KEYFRAME_MISSING /* Delta packet received for an unknown keyframe or with invalid string references */
 };
 
 enum Option
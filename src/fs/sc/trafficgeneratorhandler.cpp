@@ -0,0 +1,299 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "fs/sc/trafficgeneratorhandler.h"
+
+#include "fs/sc/simconnectdata.h"
+#include "fs/weather/weathertypes.h"
+#include "geo/calculations.h"
+
+#include <QDateTime>
+#include <QStringBuilder>
+
+#include <algorithm>
+#include <cmath>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+namespace {
+/* Aircraft types with matching engine type and cruise speed range */
+struct TrafficType
+{
+  QString type, model;
+  EngineType engineType;
+  quint8 numberOfEngines;
+  float minSpeedKts, maxSpeedKts, minCruiseFt, maxCruiseFt;
+};
+
+const static QVector<TrafficType> TRAFFIC_TYPES(
+{
+  {"B738", "Boeing 737-800", JET, 2, 420.f, 460.f, 30000.f, 39000.f},
+  {"A320", "Airbus A320", JET, 2, 420.f, 460.f, 30000.f, 39000.f},
+  {"B77W", "Boeing 777-300ER", JET, 2, 470.f, 500.f, 31000.f, 41000.f},
+  {"A359", "Airbus A350-900", JET, 2, 470.f, 500.f, 31000.f, 41000.f},
+  {"B744", "Boeing 747-400", JET, 4, 470.f, 500.f, 31000.f, 39000.f},
+  {"E190", "Embraer E190", JET, 2, 400.f, 440.f, 28000.f, 37000.f},
+  {"CRJ9", "Bombardier CRJ-900", JET, 2, 400.f, 440.f, 28000.f, 37000.f},
+  {"DH8D", "De Havilland Dash 8-400", TURBOPROP, 2, 280.f, 320.f, 18000.f, 25000.f},
+  {"AT76", "ATR 72-600", TURBOPROP, 2, 250.f, 280.f, 16000.f, 23000.f},
+  {"C172", "Cessna 172", PISTON, 1, 100.f, 120.f, 4000.f, 9000.f}
+});
+
+const static QStringList AIRLINES({"DLH", "BAW", "AFR", "UAL", "DAL", "AAL", "KLM", "RYR", "EZY", "SWR", "QFA", "SIA"});
+
+/* Boats are limited to short routes */
+const float BOAT_MIN_SPEED_KTS = 10.f, BOAT_MAX_SPEED_KTS = 25.f;
+const float BOAT_MIN_ROUTE_NM = 20.f, BOAT_MAX_ROUTE_NM = 200.f;
+
+/* Simple climb and descent gradient */
+const float CLIMB_FT_PER_NM = 300.f;
+
+/* Object id of the user aircraft. AI objects start at 2. */
+const quint32 USER_OBJECT_ID = 1;
+}
+
+TrafficGeneratorHandler::TrafficGeneratorHandler(const TrafficGeneratorOptions& optionsParam)
+  : options(optionsParam)
+{
+  qDebug() << Q_FUNC_INFO << "aircraft" << options.numAircraft << "boats" << options.numBoats << "seed" << options.seed;
+}
+
+TrafficGeneratorHandler::~TrafficGeneratorHandler()
+{
+  qDebug() << Q_FUNC_INFO;
+}
+
+bool TrafficGeneratorHandler::connect()
+{
+  if(connected)
+    return true;
+
+  // Restart the sequence to get the same traffic after each connect
+  generator.seed(options.seed);
+  traffic.clear();
+  traffic.reserve(options.numAircraft + options.numBoats);
+
+  quint32 objectId = USER_OBJECT_ID + 1;
+  for(int i = 0; i < options.numAircraft + options.numBoats; i++)
+  {
+    Traffic t;
+    t.objectId = objectId++;
+    t.boat = i >= options.numAircraft;
+    t.typeIndex = randomIndex(TRAFFIC_TYPES.size());
+    t.airlineIndex = randomIndex(AIRLINES.size());
+    t.flightNumber = 1 + randomIndex(9999);
+    newRoute(t, randomPos());
+
+    // Distribute objects along their routes
+    t.flownMeter = random(0.f, t.routeLengthMeter);
+    traffic.append(t);
+  }
+
+  user.objectId = USER_OBJECT_ID;
+  user.boat = false;
+  user.typeIndex = user.airlineIndex = user.flightNumber = 0;
+  newRoute(user, randomPos());
+
+  connected = true;
+  return true;
+}
+
+bool TrafficGeneratorHandler::fetchData(SimConnectData& data, int radiusKm, Options fetchOptions)
+{
+  Q_UNUSED(radiusKm)
+
+  if(!connected)
+    return false;
+
+  const float stepHours = options.timeStepMs / 3600000.f;
+  const QString none;
+
+  // Calculate position, altitude, heading and vertical speed for the current state
+  auto position = [](const Traffic& t, float& headingDeg, float& verticalSpeedFtMin) -> atools::geo::Pos {
+                    atools::geo::Pos pos = t.origin.interpolate(t.destination, t.routeLengthMeter,
+                                                                t.flownMeter / t.routeLengthMeter);
+                    headingDeg = atools::geo::normalizeCourse(pos.angleDegTo(t.destination));
+
+                    float altFt = 0.f;
+                    verticalSpeedFtMin = 0.f;
+                    if(!t.boat)
+                    {
+                      float flownNm = atools::geo::meterToNm(t.flownMeter);
+                      float remainingNm = atools::geo::meterToNm(t.routeLengthMeter - t.flownMeter);
+                      float climbFt = flownNm * CLIMB_FT_PER_NM, descentFt = remainingNm * CLIMB_FT_PER_NM;
+                      altFt = std::min(t.cruiseAltFt, std::min(climbFt, descentFt));
+
+                      // Feet per NM times NM per minute
+                      if(climbFt < t.cruiseAltFt && climbFt < descentFt)
+                        verticalSpeedFtMin = CLIMB_FT_PER_NM * t.speedKts / 60.f;
+                      else if(descentFt < t.cruiseAltFt)
+                        verticalSpeedFtMin = -CLIMB_FT_PER_NM * t.speedKts / 60.f;
+                    }
+                    pos.setAltitude(altFt);
+                    return pos;
+                  };
+
+  // Move object and start a new route on arrival
+  auto advance = [this, stepHours](Traffic& t) {
+                   t.flownMeter += atools::geo::nmToMeter(t.speedKts * stepHours);
+                   if(t.flownMeter >= t.routeLengthMeter)
+                     newRoute(t, t.destination);
+                 };
+
+  // User aircraft =========================================================
+  if(options.userAircraft)
+  {
+    float lastHeading, lastVs;
+    atools::geo::Pos lastPos = position(user, lastHeading, lastVs);
+    advance(user);
+
+    float heading, verticalSpeed;
+    atools::geo::Pos pos = position(user, heading, verticalSpeed);
+    data = SimConnectData::buildDebugForPosition(pos, lastPos, false /* ground */, verticalSpeed, user.speedKts,
+                                                 2000.f /* fuelflow */, 20000.f /* totalFuel */, 0.f /* ice */,
+                                                 user.cruiseAltFt, 0.f /* magVar */, true /* jetFuel */,
+                                                 false /* helicopter */);
+  }
+
+  // AI aircraft and boats =========================================================
+  QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
+  aiAircraft.reserve(traffic.size());
+
+  for(Traffic& t : traffic)
+  {
+    advance(t);
+
+    if(t.boat ? !(fetchOptions & FETCH_AI_BOAT) : !(fetchOptions & FETCH_AI_AIRCRAFT))
+      continue;
+
+    const TrafficType& type = TRAFFIC_TYPES.at(t.typeIndex);
+    SimConnectAircraft aircraft;
+    float heading, verticalSpeed;
+    aircraft.position = position(t, heading, verticalSpeed);
+    aircraft.objectId = t.objectId;
+    aircraft.headingTrueDeg = aircraft.headingMagDeg = heading;
+    aircraft.groundSpeedKts = aircraft.trueAirspeedKts = t.speedKts;
+    aircraft.verticalSpeedFeetPerMin = verticalSpeed;
+    aircraft.indicatedAltitudeFt = aircraft.position.getAltitude();
+    aircraft.airplaneReg = QLatin1String("N") % QString::number(t.objectId);
+    aircraft.fromIdent = QLatin1String("G") % QString::number(t.objectId);
+    aircraft.toIdent = QLatin1String("G") % QString::number(t.objectId + 1);
+
+    if(t.boat)
+    {
+      aircraft.category = BOAT;
+      aircraft.engineType = NO_ENGINE;
+      aircraft.airplaneTitle = aircraft.airplaneModel = QLatin1String("Generated Boat");
+      aircraft.airplaneType = none;
+      aircraft.flags = ON_GROUND;
+    }
+    else
+    {
+      const QString& airline = AIRLINES.at(t.airlineIndex);
+      aircraft.category = AIRPLANE;
+      aircraft.engineType = type.engineType;
+      aircraft.numberOfEngines = type.numberOfEngines;
+      aircraft.airplaneType = type.type;
+      aircraft.airplaneModel = type.model;
+      aircraft.airplaneTitle = type.model % QLatin1String(" ") % airline;
+      aircraft.airplaneAirline = airline;
+      aircraft.airplaneFlightnumber = QString::number(t.flightNumber);
+      aircraft.indicatedSpeedKts = t.speedKts * 0.7f;
+      aircraft.machSpeed = type.engineType == JET ? t.speedKts / 573.f : 0.f;
+    }
+
+    aiAircraft.append(aircraft);
+  }
+
+  data.updateIndexesAndKeys();
+  return true;
+}
+
+bool TrafficGeneratorHandler::fetchWeatherData(SimConnectData& data)
+{
+  if(!connected || !weatherRequest.isValid())
+    return false;
+
+  QDateTime now = QDateTime::currentDateTimeUtc();
+  QString station = weatherRequest.getStation().isEmpty() ? QString("XXXX") : weatherRequest.getStation();
+  QString metar = station % QLatin1String(" ") % now.toString("ddhh") % QLatin1String("00Z 27010KT 9999 FEW030 15/10 Q1013");
+
+  atools::fs::weather::MetarResult result;
+  result.requestIdent = weatherRequest.getStation();
+  result.requestPos = weatherRequest.getPosition();
+  result.metarForStation = result.metarForNearest = result.metarForInterpolated = metar;
+  result.timestamp = now;
+  result.simulator = true;
+
+  data.setMetars({result});
+  return true;
+}
+
+void TrafficGeneratorHandler::newRoute(Traffic& t, const atools::geo::Pos& origin)
+{
+  float minNm = t.boat ? BOAT_MIN_ROUTE_NM : options.minRouteLengthNm;
+  float maxNm = t.boat ? BOAT_MAX_ROUTE_NM : options.maxRouteLengthNm;
+  float distMeter = atools::geo::nmToMeter(random(minNm, maxNm));
+  float course = random(0.f, 360.f);
+
+  atools::geo::Pos destination = origin.endpoint(distMeter, course).normalize();
+
+  // Turn around if destination leaves the latitude band
+  if(destination.getLatY() < options.minLatY || destination.getLatY() > options.maxLatY)
+    destination = origin.endpoint(distMeter, atools::geo::opposedCourseDeg(course)).normalize();
+
+  t.origin = origin;
+  t.origin.setAltitude(0.f);
+  t.destination = destination;
+  t.routeLengthMeter = std::max(1.f, origin.distanceMeterTo(destination));
+  t.flownMeter = 0.f;
+
+  if(t.boat)
+  {
+    t.speedKts = random(BOAT_MIN_SPEED_KTS, BOAT_MAX_SPEED_KTS);
+    t.cruiseAltFt = 0.f;
+  }
+  else
+  {
+    const TrafficType& type = TRAFFIC_TYPES.at(t.typeIndex);
+    t.speedKts = random(type.minSpeedKts, type.maxSpeedKts);
+    t.cruiseAltFt = std::round(random(type.minCruiseFt, type.maxCruiseFt) / 1000.f) * 1000.f;
+  }
+}
+
+atools::geo::Pos TrafficGeneratorHandler::randomPos()
+{
+  return atools::geo::Pos(random(-180.f, 180.f), random(options.minLatY, options.maxLatY), 0.f);
+}
+
+float TrafficGeneratorHandler::random(float min, float max)
+{
+  // Upper 24 bits of the 32 bit output convert exactly to float giving a value in [0, 1)
+  return min + (max - min) * (static_cast<float>(generator() >> 8) / 16777216.f);
+}
+
+int TrafficGeneratorHandler::randomIndex(int size)
+{
+  // Bias of the modulo is negligible for the small sizes used here
+  return static_cast<int>(static_cast<quint32>(generator()) % static_cast<quint32>(size));
+}
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
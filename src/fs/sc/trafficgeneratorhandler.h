@@ -0,0 +1,160 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_FS_SC_TRAFFICGENERATORHANDLER_H
+#define ATOOLS_FS_SC_TRAFFICGENERATORHANDLER_H
+
+#include "fs/sc/connecthandler.h"
+#include "fs/sc/weatherrequest.h"
+#include "geo/pos.h"
+
+#include <QVector>
+
+#include <random>
+
+namespace atools {
+namespace fs {
+namespace sc {
+
+/* Configuration for the traffic generator */
+struct TrafficGeneratorOptions
+{
+  /* Number of AI aircraft and boats */
+  int numAircraft = 1000, numBoats = 50;
+
+  /* Seed for the random number generator. Same seed and options give the same traffic. */
+  quint32 seed = 1;
+
+  /* Simulated time step for each fetch in milliseconds. Independent of real time to keep results reproducible.
+   * Should be set to the data reader update rate for realistic movement. */
+  int timeStepMs = 500;
+
+  /* Minimum and maximum great circle route length for aircraft */
+  float minRouteLengthNm = 100.f, maxRouteLengthNm = 3000.f;
+
+  /* Latitude range for origins and destinations */
+  float minLatY = -60.f, maxLatY = 70.f;
+
+  /* Send a user aircraft too */
+  bool userAircraft = true;
+};
+
+/*
+ * Connect handler which generates synthetic traffic for load testing on all platforms.
+ *
+ * Aircraft fly great circle routes between random positions with a simple climb, cruise and descent profile.
+ * Each aircraft starts a new route after arriving. Boats move slowly along short routes.
+ * Weather requests are answered with a static METAR.
+ *
+ * Can be set in DataReaderThread::setHandler() instead of a simulator handler.
+ * The fetch radius is ignored to allow generating worldwide traffic.
+ */
+class TrafficGeneratorHandler :
+  public atools::fs::sc::ConnectHandler
+{
+public:
+  explicit TrafficGeneratorHandler(const atools::fs::sc::TrafficGeneratorOptions& optionsParam =
+                                     atools::fs::sc::TrafficGeneratorOptions());
+  virtual ~TrafficGeneratorHandler() override;
+
+  /* Creates all objects. Always successful. */
+  virtual bool connect() override;
+
+  virtual bool isLoaded() const override
+  {
+    return true;
+  }
+
+  /* Moves all objects by one time step and fills data */
+  virtual bool fetchData(atools::fs::sc::SimConnectData& data, int radiusKm, atools::fs::sc::Options options) override;
+
+  /* Answers last weather request with a synthetic METAR */
+  virtual bool fetchWeatherData(atools::fs::sc::SimConnectData& data) override;
+
+  virtual void addWeatherRequest(const atools::fs::sc::WeatherRequest& request) override
+  {
+    weatherRequest = request;
+  }
+
+  virtual const atools::fs::sc::WeatherRequest& getWeatherRequest() const override
+  {
+    return weatherRequest;
+  }
+
+  virtual bool isSimRunning() const override
+  {
+    return connected;
+  }
+
+  virtual bool isSimPaused() const override
+  {
+    return false;
+  }
+
+  virtual bool canFetchWeather() const override
+  {
+    return true;
+  }
+
+  virtual atools::fs::sc::State getState() const override
+  {
+    return connected ? atools::fs::sc::STATEOK : atools::fs::sc::DISCONNECTED;
+  }
+
+  virtual QString getName() const override
+  {
+    return QLatin1String("TrafficGenerator");
+  }
+
+  const atools::fs::sc::TrafficGeneratorOptions& getOptions() const
+  {
+    return options;
+  }
+
+private:
+  /* State of one generated object */
+  struct Traffic
+  {
+    atools::geo::Pos origin, destination;
+    float routeLengthMeter, flownMeter, speedKts, cruiseAltFt;
+    quint32 objectId;
+    int typeIndex, airlineIndex, flightNumber;
+    bool boat;
+  };
+
+  void newRoute(Traffic& traffic, const atools::geo::Pos& origin);
+  atools::geo::Pos randomPos();
+
+  /* Random value between min and max and random index in the range [0, size).
+   * Both are derived directly from the engine output since the distributions of the standard library are
+   * implementation defined and would give different traffic for the same seed on other platforms. */
+  float random(float min, float max);
+  int randomIndex(int size);
+
+  atools::fs::sc::TrafficGeneratorOptions options;
+  atools::fs::sc::WeatherRequest weatherRequest;
+  QVector<Traffic> traffic;
+  Traffic user;
+  std::mt19937 generator;
+  bool connected = false;
+};
+
+} // namespace sc
+} // namespace fs
+} // namespace atools
+
+#endif // ATOOLS_FS_SC_TRAFFICGENERATORHANDLER_H
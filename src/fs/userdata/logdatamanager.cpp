@@ -28,9 +28,12 @@
 #include "geo/linestring.h"
 #include "sql/sqlcolumn.h"
 #include "fs/pln/flightplanio.h"
+#include "fs/common/binarytrail.h"
+#include "sql/sqltransaction.h"
 
 #include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QStringBuilder>
 
 namespace atools {
@@ -50,6 +53,10 @@ using atools::sql::SqlRecord;
 using atools::sql::SqlTransaction;
 using atools::sql::SqlColumn;
 
+/* Stored in "aircraft_trail_bin" if the GPX trail cannot be converted. Not a valid binary trail but a non-empty
+ * BLOB which is not converted again on each start and is not turned into null by fixEmptyFields() */
+const static QByteArray TRAIL_BIN_INVALID("invalid");
+
 /* *INDENT-OFF* */
 namespace csv {
 /* Column indexes in CSV format */
@@ -152,7 +159,7 @@ LogdataManager::LogdataManager(sql::SqlDatabase *sqlDb)
                     ":/atools/resources/sql/fs/logbook/create_logbook_schema_undo.sql",
                     ":/atools/resources/sql/fs/logbook/drop_logbook_schema.sql"), cache(MAX_CACHE_ENTRIES)
 {
-
+  binaryTrailColumn = util->hasTableAndColumn(tableName, "aircraft_trail_bin");
 }
 
 LogdataManager::~LogdataManager()
@@ -297,7 +304,10 @@ int LogdataManager::importCsv(const QString& filepath)
       // Add files as Gzipped BLOBS ===========================================
       insertQuery.bindValue(":flightplan", atools::zip::gzipCompress(at(values, csv::FLIGHTPLAN, true /* nowarn */).toUtf8()));
       insertQuery.bindValue(":aircraft_perf", atools::zip::gzipCompress(at(values, csv::AIRCRAFT_PERF, true /* nowarn */).toUtf8()));
-      insertQuery.bindValue(":aircraft_trail", atools::zip::gzipCompress(at(values, csv::AIRCRAFT_TRAIL, true /* nowarn */).toUtf8()));
+      QByteArray trail = atools::zip::gzipCompress(at(values, csv::AIRCRAFT_TRAIL, true /* nowarn */).toUtf8());
+      insertQuery.bindValue(":aircraft_trail", trail);
+      if(binaryTrailColumn)
+        insertQuery.bindValue(":aircraft_trail_bin", gpxToBinaryTrail(trail));
 
       // Fill null fields with empty strings to avoid issues when searching
       // Also turn empty BLOBs to NULL
@@ -601,8 +611,91 @@ void LogdataManager::updateSchema()
   addColumnIf("flightplan", "blob");
   addColumnIf("aircraft_perf", "blob");
   addColumnIf("aircraft_trail", "blob");
+  addColumnIf("aircraft_trail_bin", "blob");
 
   DataManagerBase::updateUndoSchema();
+
+  // Re-initialize queries since columns might have been added
+  initQueries();
+
+  binaryTrailColumn = true;
+  convertTrails();
+}
+
+int LogdataManager::convertTrails()
+{
+  if(!binaryTrailColumn)
+    return 0;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // Collect ids first to avoid modifying the table while selecting
+  QSet<int> ids;
+  SqlUtil(db).getIds(ids, tableName, idColumnName, "length(aircraft_trail) > 0 and aircraft_trail_bin is null");
+
+  if(!ids.isEmpty())
+  {
+    SqlTransaction transaction(db);
+
+    // Updates bypass undo since this is only a different representation of the GPX trail
+    SqlQuery update(db);
+    update.prepare("update " % tableName % " set aircraft_trail_bin = ? where " % idColumnName % " = ?");
+    for(int id : qAsConst(ids))
+    {
+      update.bindValue(0, gpxToBinaryTrail(getValue(id, "aircraft_trail").toByteArray()));
+      update.bindValue(1, id);
+      update.exec();
+    }
+    transaction.commit();
+  }
+
+  qDebug() << Q_FUNC_INFO << "Converted" << ids.size() << "trails in" << timer.elapsed() << "ms";
+  return ids.size();
+}
+
+void LogdataManager::updateDerivedColumns(SqlRecord& record)
+{
+  // Any path writing the GPX trail like record updates or replacing the GPX has to rewrite the binary trail
+  if(binaryTrailColumn && record.contains("aircraft_trail"))
+  {
+    QByteArray trailBin = gpxToBinaryTrail(record.valueBytes("aircraft_trail"));
+    if(record.contains("aircraft_trail_bin"))
+      record.setValue("aircraft_trail_bin", trailBin);
+    else
+      record.appendFieldAndValue("aircraft_trail_bin", trailBin);
+
+    if(trailBin.isNull())
+      record.setNull("aircraft_trail_bin");
+  }
+}
+
+QByteArray LogdataManager::gpxToBinaryTrail(const QByteArray& gpxGz)
+{
+  if(gpxGz.isEmpty())
+    // Nothing to convert
+    return QByteArray();
+  else
+  {
+    try
+    {
+      atools::fs::common::BinaryTrail trail;
+      atools::fs::pln::FlightplanIO().loadGpxGz(trail.getRoutePtr(), trail.getRouteNamesPtr(), trail.getTracksPtr(),
+                                                trail.getTimestampsMsPtr(), gpxGz);
+      return trail.writeToByteArray();
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot convert GPX trail" << e.what();
+    }
+    catch(std::exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot convert GPX trail" << e.what();
+    }
+  }
+
+  // Leave marker to avoid converting again
+  return TRAIL_BIN_INVALID;
 }
 
 void LogdataManager::clearGeometryCache()
@@ -679,9 +772,21 @@ void LogdataManager::loadGpx(int id)
   {
     LogEntryGeometry *entry = new LogEntryGeometry;
 
-    // Do not load timestamps
-    atools::fs::pln::FlightplanIO().loadGpxGz(&entry->route, &entry->names, &entry->tracks, nullptr /* timestampsMs */,
-                                              getValue(id, "aircraft_trail").toByteArray());
+    // Use compact binary trail if available which avoids decompression and XML parsing - do not load timestamps
+    atools::fs::common::BinaryTrail trail;
+    if(binaryTrailColumn)
+      trail.readFromByteArray(getValue(id, "aircraft_trail_bin").toByteArray(), false /* loadTimestamps */);
+
+    if(trail.isValid())
+    {
+      entry->route = trail.getRoute();
+      entry->names = trail.getRouteNames();
+      entry->tracks = trail.getTracks();
+    }
+    else
+      // Not converted yet - read GPX
+      atools::fs::pln::FlightplanIO().loadGpxGz(&entry->route, &entry->names, &entry->tracks, nullptr /* timestampsMs */,
+                                                getValue(id, "aircraft_trail").toByteArray());
     entry->routeRect = entry->route.boundingRect();
 
     entry->trackRect = atools::geo::Rect();
@@ -80,6 +80,10 @@ public:
   /* Clear cache used by getRouteGeometry and getTrackGeometry */
   void clearGeometryCache();
 
+  /* Create compact binary trails in column "aircraft_trail_bin" for all entries having only a GPX trail.
+   * Called by updateSchema(). Call this after adding entries with a GPX trail only. Commits. Returns number converted. */
+  int convertTrails();
+
   /* Remove entries by criteria */
   int cleanupLogEntries(bool departureAndDestEqual, bool departureOrDestEmpty, float minFlownDistance);
 
@@ -131,9 +135,18 @@ private:
   /* Returns with "or" concatenated where clause for query */
   QString cleanupWhere(bool departureAndDestEqual, bool departureOrDestEmpty, float minFlownDistance);
 
+  /* Writes the binary trail for any record containing a GPX trail to keep both in sync */
+  virtual void updateDerivedColumns(atools::sql::SqlRecord& record) override;
+
   /* Prime cache by loading the GpxCacheEntry */
   void loadGpx(int id);
 
+  /* Convert Gzipped GPX to binary trail. Returns null for an empty GPX and TRAIL_BIN_INVALID on error. */
+  static QByteArray gpxToBinaryTrail(const QByteArray& gpxGz);
+
+  /* true if column "aircraft_trail_bin" exists */
+  bool binaryTrailColumn = false;
+
   /* Cache to avoid reading BLOBs */
   QCache<int, LogEntryGeometry> cache;
 
@@ -29,8 +29,10 @@
 #include "sql/sqltransaction.h"
 #include "sql/sqlutil.h"
 #include "util/csvreader.h"
+#include "util/parallel.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QRegularExpression>
 #include <QStringBuilder>
 #include <QXmlStreamReader>
@@ -56,6 +58,9 @@ using Qt::endl;
 const static double VISIBLE_FROM_DEFAULT_NM = 250.;
 const static QStringList CLEANUP_COLUMNS({"type", "name", "ident", "region", "description", "tags"});
 
+/* Number of lines an import worker thread takes at once */
+const static int IMPORT_BATCH_SIZE = 1000;
+
 namespace csv {
 /* Column indexes in CSV format */
 enum Index
@@ -213,11 +218,7 @@ void UserdataManager::clearTemporary()
 // POI,  Cedar Butte lava flow,  POI,   43.4352891960911, -112.892122541337,0,0,   , photoreal areas
 int UserdataManager::importCsv(const QStringList& filepaths, atools::fs::userdata::Flags flags, QChar separator, QChar escape)
 {
-  int numImported = 0;
-
-  int id = getCurrentId() + 1;
-  atools::sql::DataManagerUndoHandler undoHandler(this, id);
-
+  QVector<ImportLine> lines;
   for(const QString& filepath : filepaths)
   {
     if(filepath.isEmpty())
@@ -226,15 +227,7 @@ int UserdataManager::importCsv(const QStringList& filepaths, atools::fs::userdat
     QFile file(filepath);
     if(file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
-      QString idBinding(":" % idColumnName);
-
-      // Autogenerate id
-      QString insert = SqlUtil(db).buildInsertStatement(tableName, QString(), QStringList(), true /* namedBindings */);
-      SqlQuery insertQuery(db);
-      insertQuery.prepare(insert);
-
       QString absfilepath = QFileInfo(filepath).absoluteFilePath();
-      QDateTime now = QDateTime::currentDateTime();
 
       atools::util::CsvReader reader(separator, escape, true /* trim */);
 
@@ -266,55 +259,9 @@ int UserdataManager::importCsv(const QStringList& filepaths, atools::fs::userdat
           // Still in an escaped line so continue to read unchanged until " shows the end of the field
           continue;
 
-        const QStringList& values = reader.getValues();
-
-        if(values.size() < csv::MIN_NUM_COLS)
-          throw atools::Exception(tr("File contains invalid data.\n\"%1\"\nLine %2.").arg(line).arg(lineNum));
-
-        insertQuery.bindValue(idBinding, id++);
-        insertQuery.bindValue(":type", at(values, csv::TYPE));
-        insertQuery.bindValue(":name", at(values, csv::NAME));
-        insertQuery.bindValue(":ident", at(values, csv::IDENT));
-        insertQuery.bindValue(":region", at(values, csv::REGION, true /* no warning */));
-        insertQuery.bindValue(":description", at(values, csv::DESCRIPTION));
-        insertQuery.bindValue(":tags", at(values, csv::TAGS));
-        insertQuery.bindValue(":import_file_path", absfilepath);
-        insertQuery.bindValue(":temp", 0);
-
-        // YYYY-MM-DDTHH:mm:ss
-        QDateTime lastEdit = QDateTime::fromString(at(values, csv::LAST_EDIT, true /* no warning */), Qt::ISODate);
-        if(lastEdit.isValid())
-          insertQuery.bindValue(":last_edit_timestamp", lastEdit.toString(Qt::ISODate));
-        else
-          insertQuery.bindValue(":last_edit_timestamp", now.toString(Qt::ISODate));
-
-        bool ok;
-        float visibleFrom = at(values, csv::VISIBLE_FROM, true /* no warning */).toFloat(&ok);
-        if(visibleFrom > 0.f && ok)
-          insertQuery.bindValue(":visible_from", visibleFrom);
-        else
-          insertQuery.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
-
-        QString altStr = at(values, csv::ALT).trimmed();
-        float alt = 0.f;
-        if(altStr.endsWith("f"))
-          alt = altStr.leftRef(altStr.size() - 1).toFloat();
-        else if(altStr.endsWith("m"))
-          alt = atools::geo::meterToFeet(altStr.leftRef(altStr.size() - 1).toFloat());
-        else
-          alt = altStr.toFloat();
-
-        insertQuery.bindValue(":altitude", alt);
-
-        validateCoordinates(line, at(values, csv::LONX), at(values, csv::LATY), lineNum, false /* checkNull */);
-        insertQuery.bindValue(":lonx", at(values, csv::LONX, true));
-        insertQuery.bindValue(":laty", at(values, csv::LATY, true));
-
-        insertQuery.exec();
-        undoHandler.inserted();
-
+        // Conversion and validation is done later in worker threads
+        lines.append({line, absfilepath, reader.getValues(), lineNum});
         lineNum++;
-        numImported++;
       }
       file.close();
     }
@@ -323,9 +270,52 @@ int UserdataManager::importCsv(const QStringList& filepaths, atools::fs::userdat
 
   } // for(const QString& filepath : filepaths)
 
-  undoHandler.finish();
+  QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+  const static QStringList BIND_NAMES({":type", ":name", ":ident", ":region", ":description", ":tags",
+                                       ":import_file_path", ":temp", ":last_edit_timestamp", ":visible_from",
+                                       ":altitude", ":lonx", ":laty"});
 
-  return numImported;
+  return importLines(lines, BIND_NAMES, QStringList(), [this, &now](const ImportLine& importLine) -> QVector<QVariant> {
+    const QStringList& values = importLine.values;
+
+    if(values.size() < csv::MIN_NUM_COLS)
+      throw atools::Exception(tr("File contains invalid data.\n\"%1\"\nLine %2.").
+                              arg(importLine.line).arg(importLine.lineNum));
+
+    // YYYY-MM-DDTHH:mm:ss
+    QDateTime lastEdit = QDateTime::fromString(at(values, csv::LAST_EDIT, true /* no warning */), Qt::ISODate);
+
+    bool ok;
+    float visibleFrom = at(values, csv::VISIBLE_FROM, true /* no warning */).toFloat(&ok);
+
+    QString altStr = at(values, csv::ALT).trimmed();
+    float alt = 0.f;
+    if(altStr.endsWith("f"))
+      alt = altStr.leftRef(altStr.size() - 1).toFloat();
+    else if(altStr.endsWith("m"))
+      alt = atools::geo::meterToFeet(altStr.leftRef(altStr.size() - 1).toFloat());
+    else
+      alt = altStr.toFloat();
+
+    validateCoordinates(importLine.line, at(values, csv::LONX), at(values, csv::LATY), importLine.lineNum,
+                        false /* checkNull */);
+
+    return {
+      at(values, csv::TYPE),
+      at(values, csv::NAME),
+      at(values, csv::IDENT),
+      at(values, csv::REGION, true /* no warning */),
+      at(values, csv::DESCRIPTION),
+      at(values, csv::TAGS),
+      importLine.filepath,
+      0,
+      lastEdit.isValid() ? lastEdit.toString(Qt::ISODate) : now,
+      visibleFrom > 0.f && ok ? QVariant(visibleFrom) : QVariant(VISIBLE_FROM_DEFAULT_NM),
+      alt,
+      at(values, csv::LONX, true),
+      at(values, csv::LATY, true)
+    };
+  });
 }
 
 // I
@@ -336,21 +326,11 @@ int UserdataManager::importCsv(const QStringList& filepaths, atools::fs::userdat
 // 37.770908333 -122.082811111 AAAME ENRT  K2 4530263
 int UserdataManager::importXplane(const QString& filepath)
 {
-  int numImported = 0;
+  QVector<ImportLine> lines;
+  QString absfilepath = QFileInfo(filepath).absoluteFilePath();
   QFile file(filepath);
   if(file.open(QIODevice::ReadOnly | QIODevice::Text))
   {
-    int id = getCurrentId() + 1;
-    atools::sql::DataManagerUndoHandler undoHandler(this, id);
-    QString idBinding(":" % idColumnName);
-
-    QString insert = SqlUtil(db).buildInsertStatement(tableName, QString(), {"description", "altitude"}, true /* namedBindings */);
-    SqlQuery insertQuery(db);
-    insertQuery.prepare(insert);
-
-    QString absfilepath = QFileInfo(filepath).absoluteFilePath();
-    QDateTime now = QDateTime::currentDateTime();
-
     QTextStream stream(&file);
     stream.setCodec("UTF-8");
 
@@ -375,44 +355,48 @@ int UserdataManager::importXplane(const QString& filepath)
       if(line == "99")
         break;
 
-      QStringList cols = line.split(' ');
-
-      // XP12 "51.801667   -8.573889  VP001 ENRT EI 2105430 HALFWAY ROUTE"
-      // XP11 "46.646819444 -123.722388889 AAYRR KSEA  K1 4530263"
-      QStringList tags;
-      tags.append(at(cols, xp::AIRPORT, true /* nowarn */));
-      tags.append(atools::fs::util::waypointFlagsFromXplane(at(cols, xp::FLAGS, true /* nowarn */)).replace(' ', '_'));
-      tags.removeAll(QString());
-
-      insertQuery.bindValue(idBinding, id++);
-      insertQuery.bindValue(":type", "Waypoint");
-      insertQuery.bindValue(":ident", at(cols, xp::IDENT));
-      insertQuery.bindValue(":region", at(cols, xp::REGION));
-      insertQuery.bindValue(":tags", tags.join(' '));
-      insertQuery.bindValue(":name", cols.mid(xp::NAME).join(' ')); // Get rest of line as name
-      insertQuery.bindValue(":last_edit_timestamp", now.toString(Qt::ISODate));
-      insertQuery.bindValue(":import_file_path", absfilepath);
-      insertQuery.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
-      insertQuery.bindValue(":temp", 0);
-
-      validateCoordinates(line, at(cols, xp::LONX), at(cols, xp::LATY), lineNum, false /* checkNull */);
-      insertQuery.bindValue(":lonx", at(cols, xp::LONX));
-      insertQuery.bindValue(":laty", at(cols, xp::LATY));
-
-      insertQuery.exec();
-      undoHandler.inserted();
-
-      numImported++;
+      // Conversion and validation is done later in worker threads
+      lines.append({line, absfilepath, QStringList(), lineNum});
       lineNum++;
     } // while(!stream.atEnd())
 
     file.close();
-    undoHandler.finish();
   } // if(file.open(QIODevice::ReadOnly | QIODevice::Text))
   else
     throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
 
-  return numImported;
+  QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+  const static QStringList BIND_NAMES({":type", ":ident", ":region", ":tags", ":name", ":last_edit_timestamp",
+                                       ":import_file_path", ":visible_from", ":temp", ":lonx", ":laty"});
+
+  return importLines(lines, BIND_NAMES, {"description", "altitude"},
+                     [this, &now](const ImportLine& importLine) -> QVector<QVariant> {
+    QStringList cols = importLine.line.split(' ');
+
+    // XP12 "51.801667   -8.573889  VP001 ENRT EI 2105430 HALFWAY ROUTE"
+    // XP11 "46.646819444 -123.722388889 AAYRR KSEA  K1 4530263"
+    QStringList tags;
+    tags.append(at(cols, xp::AIRPORT, true /* nowarn */));
+    tags.append(atools::fs::util::waypointFlagsFromXplane(at(cols, xp::FLAGS, true /* nowarn */)).replace(' ', '_'));
+    tags.removeAll(QString());
+
+    validateCoordinates(importLine.line, at(cols, xp::LONX), at(cols, xp::LATY), importLine.lineNum,
+                        false /* checkNull */);
+
+    return {
+      "Waypoint",
+      at(cols, xp::IDENT),
+      at(cols, xp::REGION),
+      tags.join(' '),
+      cols.mid(xp::NAME).join(' '), // Get rest of line as name
+      now,
+      importLine.filepath,
+      VISIBLE_FROM_DEFAULT_NM,
+      0,
+      at(cols, xp::LONX),
+      at(cols, xp::LATY)
+    };
+  });
 }
 
 // 3.2 File Contents
@@ -438,22 +422,11 @@ int UserdataManager::importXplane(const QString& filepath)
 // OCEAN,,32.687356725,-51.45543634
 int UserdataManager::importGarmin(const QString& filepath)
 {
-  int numImported = 0;
+  QVector<ImportLine> lines;
+  QString absfilepath = QFileInfo(filepath).absoluteFilePath();
   QFile file(filepath);
   if(file.open(QIODevice::ReadOnly | QIODevice::Text))
   {
-    int id = getCurrentId() + 1;
-    atools::sql::DataManagerUndoHandler undoHandler(this, id);
-    QString idBinding(":" % idColumnName);
-
-    QString insert = SqlUtil(db).buildInsertStatement(tableName, QString(),
-                                                      {"description", "altitude", "region"}, true /* namedBindings */);
-    SqlQuery insertQuery(db);
-    insertQuery.prepare(insert);
-
-    QString absfilepath = QFileInfo(filepath).absoluteFilePath();
-    QDateTime now = QDateTime::currentDateTime();
-
     QTextStream stream(&file);
     stream.setCodec("UTF-8");
 
@@ -464,33 +437,131 @@ int UserdataManager::importGarmin(const QString& filepath)
       if(line.isEmpty())
         continue;
 
-      QStringList cols = line.split(",");
-
-      insertQuery.bindValue(idBinding, id++);
-      insertQuery.bindValue(":type", "Waypoint");
-      insertQuery.bindValue(":name", at(cols, gm::NAME));
-      insertQuery.bindValue(":ident", at(cols, gm::IDENT));
-      insertQuery.bindValue(":last_edit_timestamp", now.toString(Qt::ISODate));
-      insertQuery.bindValue(":import_file_path", absfilepath);
-      insertQuery.bindValue(":visible_from", VISIBLE_FROM_DEFAULT_NM);
-      insertQuery.bindValue(":temp", 0);
-
-      validateCoordinates(line, at(cols, gm::LONX), at(cols, gm::LATY), lineNum, false /* checkNull */);
-      insertQuery.bindValue(":lonx", at(cols, gm::LONX));
-      insertQuery.bindValue(":laty", at(cols, gm::LATY));
-
-      insertQuery.exec();
-      undoHandler.inserted();
-
-      numImported++;
+      // Conversion and validation is done later in worker threads
+      lines.append({line, absfilepath, QStringList(), lineNum});
       lineNum++;
     }
 
     file.close();
-    undoHandler.finish();
   } // if(file.open(QIODevice::ReadOnly | QIODevice::Text))
   else
     throw atools::Exception(tr("Cannot open file \"%1\". Reason: %2.").arg(filepath).arg(file.errorString()));
+
+  QString now = QDateTime::currentDateTime().toString(Qt::ISODate);
+  const static QStringList BIND_NAMES({":type", ":name", ":ident", ":last_edit_timestamp", ":import_file_path",
+                                       ":visible_from", ":temp", ":lonx", ":laty"});
+
+  return importLines(lines, BIND_NAMES, {"description", "altitude", "region"},
+                     [this, &now](const ImportLine& importLine) -> QVector<QVariant> {
+    QStringList cols = importLine.line.split(",");
+
+    validateCoordinates(importLine.line, at(cols, gm::LONX), at(cols, gm::LATY), importLine.lineNum,
+                        false /* checkNull */);
+
+    return {
+      "Waypoint",
+      at(cols, gm::NAME),
+      at(cols, gm::IDENT),
+      now,
+      importLine.filepath,
+      VISIBLE_FROM_DEFAULT_NM,
+      0,
+      at(cols, gm::LONX),
+      at(cols, gm::LATY)
+    };
+  });
+}
+
+int UserdataManager::importLines(const QVector<ImportLine>& lines, const QStringList& bindNames,
+                                 const QStringList& excludeColumns, const ImportParserType& parser)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Duplicates are detected by all waypoint data - not by file path or timestamp
+  // which would make identical waypoints from different files or edits unique
+  const static QStringList KEY_EXCLUDE_BIND_NAMES({":import_file_path", ":last_edit_timestamp"});
+
+  // Numbers are compared as values since files differ in number of decimals
+  const static QStringList KEY_NUMBER_BIND_NAMES({":lonx", ":laty", ":altitude", ":visible_from"});
+  QVector<int> keyIndexes, keyNumberIndexes;
+  for(int i = 0; i < bindNames.size(); i++)
+  {
+    if(KEY_NUMBER_BIND_NAMES.contains(bindNames.at(i)))
+      keyNumberIndexes.append(i);
+    else if(!KEY_EXCLUDE_BIND_NAMES.contains(bindNames.at(i)))
+      keyIndexes.append(i);
+  }
+
+  // Parse and validate in worker threads ==============================================
+  // Bind values and key for duplicate detection for each line
+  std::vector<std::pair<QVector<QVariant>, QString> > rows(static_cast<size_t>(lines.size()));
+
+  // Stops after the first invalid line and reports the same error as when reading sequentially
+  atools::util::runParallel(lines.size(), IMPORT_BATCH_SIZE,
+                            [&lines, &parser, &rows, &keyIndexes, &keyNumberIndexes](int begin, int end, int) -> void {
+    for(int i = begin; i < end; i++)
+    {
+      std::pair<QVector<QVariant>, QString>& row = rows[static_cast<size_t>(i)];
+      row.first = parser(lines.at(i));
+
+      QStringList key;
+      for(int index : keyIndexes)
+        key.append(row.first.at(index).toString());
+
+      for(int index : keyNumberIndexes)
+      {
+        // Keep empty values apart from zero
+        const QVariant& value = row.first.at(index);
+        bool ok;
+        double number = value.toDouble(&ok);
+        key.append(ok ? QString::number(number, 'f', 8) : value.toString());
+      }
+      row.second = key.join(QChar(0x1f));
+    }
+  });
+
+  qint64 parseTime = timer.elapsed();
+
+  // Insert all rows skipping duplicates ==============================================
+  int id = getCurrentId() + 1;
+  atools::sql::DataManagerUndoHandler undoHandler(this, id);
+  SqlTransaction transaction(db);
+
+  QString idBinding(":" % idColumnName);
+  SqlQuery insertQuery(db);
+  insertQuery.prepare(SqlUtil(db).buildInsertStatement(tableName, QString(), excludeColumns, true /* namedBindings */));
+
+  int numImported = 0, numDuplicates = 0;
+  QSet<QString> keys;
+  keys.reserve(lines.size());
+  for(const std::pair<QVector<QVariant>, QString>& row : rows)
+  {
+    if(keys.contains(row.second))
+    {
+      numDuplicates++;
+      continue;
+    }
+    keys.insert(row.second);
+
+    insertQuery.bindValue(idBinding, id++);
+    for(int i = 0; i < bindNames.size(); i++)
+      insertQuery.bindValue(bindNames.at(i), row.first.at(i));
+
+    insertQuery.exec();
+    undoHandler.inserted();
+    numImported++;
+  }
+
+  // Add all inserted rows to the undo table as one group
+  undoHandler.finish();
+  transaction.commit();
+
+  qint64 elapsed = timer.elapsed();
+  qDebug() << Q_FUNC_INFO << "Imported" << numImported << "rows, skipped" << numDuplicates << "duplicates in"
+           << elapsed << "ms, parsing" << parseTime << "ms,"
+           << static_cast<int>(numImported * 1000. / std::max(elapsed, static_cast<qint64>(1))) << "rows/s";
+
   return numImported;
 }
 
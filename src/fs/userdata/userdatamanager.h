@@ -107,6 +107,25 @@ public:
                             const QVector<atools::sql::SqlColumn>& columns);
 
 private:
+  /* Line or CSV record read from an import file. Parsed and validated later in worker threads. */
+  struct ImportLine
+  {
+    QString line, filepath;
+    QStringList values; /* Values split by the CSV reader. Empty for other formats. */
+    int lineNum;
+  };
+
+  /* Converts an import line to bind values in the order of the bind names. Called from worker threads and has
+   * to be thread safe. Throws atools::Exception if the line is not valid. */
+  typedef std::function<QVector<QVariant>(const ImportLine& line)> ImportParserType;
+
+  /* Parses and validates all lines in worker threads, drops duplicate rows and inserts the rest in one
+   * transaction as one undo group. Rows are duplicates if all values except
+   * file path and timestamp are equal.
+   * bindNames have to contain ":lonx" and ":laty". Returns number of inserted rows. */
+  int importLines(const QVector<ImportLine>& lines, const QStringList& bindNames, const QStringList& excludeColumns,
+                  const ImportParserType& parser);
+
   /* Returns a union query returning the ids to delete */
   QString cleanupWhere(const QStringList& duplicateColumns, bool duplicateCoordinates, bool empty);
 
@@ -19,11 +19,10 @@
 
 #include "geo/pos.h"
 #include "atools.h"
-#include "exception.h"
 
 #include <cmath>
-#include <QRegularExpression>
 #include <QLocale>
+#include <QVector>
 
 using atools::geo::Pos;
 
@@ -31,56 +30,70 @@ namespace atools {
 namespace fs {
 namespace util {
 
-// N48194W123096
+// Garmin GFP N48194W123096
 const static QString COORDS_FLIGHTPLAN_FORMAT_GFP("%1%2%3%4%5%6");
-const static QRegularExpression LONG_FORMAT_REGEXP_GFP("^([NS])([0-9]{2})([0-9]{3})"
-                                                       "([EW])([0-9]{3})([0-9]{3})$");
-
-// 46N078W
-const static QRegularExpression LONG_FORMAT_REGEXP_DEG("^([0-9]{2})([NS])"
-                                                       "([0-9]{3})([EW])$");
 
 // 4510N06810W
 const static QString COORDS_FLIGHTPLAN_FORMAT_DEG_MIN("%1%2%3%4%5%6");
-const static QRegularExpression LONG_FORMAT_REGEXP_DEG_MIN("^([0-9]{2})([0-9]{2})([NS])"
-                                                           "([0-9]{3})([0-9]{2})([EW])$");
 
 // 481200N0112842E
 const static QString COORDS_FLIGHTPLAN_FORMAT_DEG_MIN_SEC("%1%2%3%4%5%6%7%8");
-const static QRegularExpression LONG_FORMAT_REGEXP_DEG_MIN_SEC("^([0-9]{2})([0-9]{2})([0-9]{2})([NS])"
-                                                               "([0-9]{3})([0-9]{2})([0-9]{2})([EW])$");
-
-// Pattern allows trailing garbage
-// 50:40:42 N 003:13:30 E
-// 31:30:00 N 086:44:59 W
-static QRegularExpression MATCH_COORD_OPENAIR_MIN_SEC("^([\\d]+):([\\d]+):([\\d\\.]+)\\s*([NS])\\s*"
-                                                      "([\\d]+):([\\d]+):([\\d\\.]+)\\s*([EW])");
-
-// Pattern allows trailing garbage
-// 39:06.2 N 121:35.5 W
-static QRegularExpression MATCH_COORD_OPENAIR_MIN("^([\\d]+):([\\d\\.]+)\\s*([NS])\\s*"
-                                                  "([\\d]+):([\\d\\.]+)\\s*([EW])");
-
-// ARINC full degreee waypoints
-// 57N30 5730N 5730E 57E30
-// 57W30 5730W 5730S 57S30
-const static QRegularExpression LONG_FORMAT_REGEXP_ARINC("^([0-9]{2})"
-                                                         "([0-9]{2})([NWES])$");
-const static QRegularExpression LONG_FORMAT_REGEXP_ARINC2("^([0-9]{2})([NWES])"
-                                                          "([0-9]{2})$");
 
 // N6400 W07000 or N6400/W07000
 const static QString COORDS_FLIGHTPLAN_FORMAT_PAIR("%1%2/%3%4");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR("^([NS])([0-9]{2})([0-9]{2})[ /]"
-                                                        "([EW])([0-9]{3})([0-9]{2})$");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR2("^([0-9]{2})([0-9]{2})([NS])[ /]"
-                                                         "([0-9]{3})([0-9]{2})([EW])$");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR_LAT("^([NS])([0-9]{2})([0-9]{2})$");
-const static QRegularExpression LONG_FORMAT_REGEXP_PAIR_LON("^([EW])([0-9]{3})([0-9]{2})$");
 
 atools::geo::Pos degMinSecFormatFromCapture(const QStringList& captured);
 atools::geo::Pos degMinFormatFromCapture(const QStringList& captured);
 
+// ================================================================================
+// Scanner helpers for the fixed width formats
+
+/* true if num ASCII digits start at pos */
+static bool isDigits(const QString& str, int pos, int num)
+{
+  if(pos + num > str.size())
+    return false;
+
+  for(int i = pos; i < pos + num; i++)
+  {
+    ushort c = str.at(i).unicode();
+    if(c < '0' || c > '9')
+      return false;
+  }
+  return true;
+}
+
+/* true if character at pos is one of the given ASCII characters */
+static bool isOneOf(const QString& str, int pos, const char *chars)
+{
+  if(pos >= str.size())
+    return false;
+
+  ushort c = str.at(pos).unicode();
+  for(const char *ch = chars; *ch != '\0'; ch++)
+  {
+    if(c == static_cast<ushort>(*ch))
+      return true;
+  }
+  return false;
+}
+
+/* Skip ASCII digits and returns position after last one */
+static int skipDigits(const QString& str, int pos, bool allowDot)
+{
+  while(pos < str.size() && (isDigits(str, pos, 1) || (allowDot && str.at(pos) == '.')))
+    pos++;
+  return pos;
+}
+
+/* Skip ASCII white space like \s in regular expressions */
+static int skipSpace(const QString& str, int pos)
+{
+  while(pos < str.size() && isOneOf(str, pos, " \t\n\r\f\v"))
+    pos++;
+  return pos;
+}
+
 QString toGfpFormat(const atools::geo::Pos& pos)
 {
   if(pos.isValid())
@@ -128,11 +141,14 @@ QString toDegMinSecFormat(const atools::geo::Pos& pos)
 // Garmin format N48194W123096
 atools::geo::Pos fromGfpFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_GFP.match(str.simplified().toUpper());
+  QString coords = str.simplified().toUpper();
 
-  if(match.hasMatch())
+  // N48194W123096
+  if(coords.size() == 13 && isOneOf(coords, 0, "NS") && isDigits(coords, 1, 5) && isOneOf(coords, 6, "EW") &&
+     isDigits(coords, 7, 6))
   {
-    QStringList captured = match.capturedTexts();
+    QStringList captured({coords, coords.mid(0, 1), coords.mid(1, 2), coords.mid(3, 3),
+                          coords.mid(6, 1), coords.mid(7, 3), coords.mid(10, 3)});
 
     if(captured.size() == 7)
     {
@@ -160,11 +176,13 @@ atools::geo::Pos fromGfpFormat(const QString& str)
 // Degrees only 46N078W
 atools::geo::Pos fromDegFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG.match(str.simplified().toUpper());
+  QString coords = str.simplified().toUpper();
 
-  if(match.hasMatch())
+  // 46N078W
+  if(coords.size() == 7 && isDigits(coords, 0, 2) && isOneOf(coords, 2, "NS") && isDigits(coords, 3, 3) &&
+     isOneOf(coords, 6, "EW"))
   {
-    QStringList captured = match.capturedTexts();
+    QStringList captured({coords, coords.mid(0, 2), coords.mid(2, 1), coords.mid(3, 3), coords.mid(6, 1)});
 
     if(captured.size() == 5)
     {
@@ -188,11 +206,14 @@ atools::geo::Pos fromDegFormat(const QString& str)
 // Degrees and minutes 4510N06810W
 atools::geo::Pos fromDegMinFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG_MIN.match(str.simplified().toUpper());
+  QString coords = str.simplified().toUpper();
 
-  if(match.hasMatch())
+  // 4510N06810W
+  if(coords.size() == 11 && isDigits(coords, 0, 4) && isOneOf(coords, 4, "NS") && isDigits(coords, 5, 5) &&
+     isOneOf(coords, 10, "EW"))
   {
-    QStringList captured = match.capturedTexts();
+    QStringList captured({coords, coords.mid(0, 2), coords.mid(2, 2), coords.mid(4, 1),
+                          coords.mid(5, 3), coords.mid(8, 2), coords.mid(10, 1)});
 
     if(captured.size() == 7)
     {
@@ -219,10 +240,14 @@ atools::geo::Pos fromDegMinFormat(const QString& str)
 // Degrees, minutes and seconds 481200N0112842E
 atools::geo::Pos fromDegMinSecFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_DEG_MIN_SEC.match(str.simplified().toUpper());
+  QString coords = str.simplified().toUpper();
 
-  if(match.hasMatch())
-    return degMinSecFormatFromCapture(match.capturedTexts());
+  // 481200N0112842E
+  if(coords.size() == 15 && isDigits(coords, 0, 6) && isOneOf(coords, 6, "NS") && isDigits(coords, 7, 7) &&
+     isOneOf(coords, 14, "EW"))
+    return degMinSecFormatFromCapture({coords, coords.mid(0, 2), coords.mid(2, 2), coords.mid(4, 2),
+                                       coords.mid(6, 1), coords.mid(7, 3), coords.mid(10, 2), coords.mid(12, 2),
+                                       coords.mid(14, 1)});
 
   return atools::geo::EMPTY_POS;
 }
@@ -230,41 +255,33 @@ atools::geo::Pos fromDegMinSecFormat(const QString& str)
 // Degrees and minutes in pair N6400 W07000 or N6400/W07000
 atools::geo::Pos fromDegMinPairFormat(const QString& str)
 {
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_PAIR.match(str.simplified().toUpper());
+  QString coords = str.simplified().toUpper();
 
   bool latOk = false, lonOk = false, latMinOk = false, lonMinOk = false;
   QString ns, ew;
   int latYDeg = 0, latYMin = 0, lonXDeg = 0, lonXMin = 0;
 
-  if(match.hasMatch())
+  if(coords.size() == 12 && isOneOf(coords, 5, " /"))
   {
-    QStringList captured = match.capturedTexts();
-    if(captured.size() == 7)
+    if(isOneOf(coords, 0, "NS") && isDigits(coords, 1, 4) && isOneOf(coords, 6, "EW") && isDigits(coords, 7, 5))
     {
-      ns = captured.at(1);
-      latYDeg = captured.at(2).toInt(&latOk);
-      latYMin = captured.at(3).toInt(&latMinOk);
-      ew = captured.at(4);
-      lonXDeg = captured.at(5).toInt(&lonOk);
-      lonXMin = captured.at(6).toInt(&lonMinOk);
+      // N6400 W07000
+      ns = coords.mid(0, 1);
+      latYDeg = coords.mid(1, 2).toInt(&latOk);
+      latYMin = coords.mid(3, 2).toInt(&latMinOk);
+      ew = coords.mid(6, 1);
+      lonXDeg = coords.mid(7, 3).toInt(&lonOk);
+      lonXMin = coords.mid(10, 2).toInt(&lonMinOk);
     }
-  }
-  else
-  {
-    QRegularExpressionMatch match2 = LONG_FORMAT_REGEXP_PAIR2.match(str.simplified().toUpper());
-
-    if(match2.hasMatch())
+    else if(isDigits(coords, 0, 4) && isOneOf(coords, 4, "NS") && isDigits(coords, 6, 5) && isOneOf(coords, 11, "EW"))
     {
-      QStringList captured = match2.capturedTexts();
-      if(captured.size() == 7)
-      {
-        latYDeg = captured.at(1).toInt(&latOk);
-        latYMin = captured.at(2).toInt(&latMinOk);
-        ns = captured.at(3);
-        lonXDeg = captured.at(4).toInt(&lonOk);
-        lonXMin = captured.at(5).toInt(&lonMinOk);
-        ew = captured.at(6);
-      }
+      // 6400N 07000W
+      latYDeg = coords.mid(0, 2).toInt(&latOk);
+      latYMin = coords.mid(2, 2).toInt(&latMinOk);
+      ns = coords.mid(4, 1);
+      lonXDeg = coords.mid(6, 3).toInt(&lonOk);
+      lonXMin = coords.mid(9, 2).toInt(&lonMinOk);
+      ew = coords.mid(11, 1);
     }
   }
 
@@ -280,12 +297,12 @@ atools::geo::Pos fromDegMinPairFormat(const QString& str)
 // 57N30 5730N 5730E 57E30 57W30 5730W 5730S 57S30
 atools::geo::Pos fromArincFormat(const QString& str)
 {
-  // 5730N 5730E 5730W 5730S
-  QRegularExpressionMatch match = LONG_FORMAT_REGEXP_ARINC.match(str.simplified().toUpper());
+  QString coords = str.simplified().toUpper();
 
-  if(match.hasMatch())
+  // 5730N 5730E 5730W 5730S
+  if(coords.size() == 5 && isDigits(coords, 0, 4) && isOneOf(coords, 4, "NWES"))
   {
-    QStringList captured = match.capturedTexts();
+    QStringList captured({coords, coords.mid(0, 2), coords.mid(2, 2), coords.mid(4, 1)});
 
     if(captured.size() == 4)
     {
@@ -314,11 +331,9 @@ atools::geo::Pos fromArincFormat(const QString& str)
   }
 
   // 57N30 57E30 57W30 57S30 longitude + 100
-  match = LONG_FORMAT_REGEXP_ARINC2.match(str.simplified().toUpper());
-
-  if(match.hasMatch())
+  if(coords.size() == 5 && isDigits(coords, 0, 2) && isOneOf(coords, 2, "NWES") && isDigits(coords, 3, 2))
   {
-    QStringList captured = match.capturedTexts();
+    QStringList captured({coords, coords.mid(0, 2), coords.mid(2, 1), coords.mid(3, 2)});
 
     if(captured.size() == 4)
     {
@@ -373,18 +388,70 @@ atools::geo::Pos fromAnyWaypointFormat(const QString& str)
   return atools::geo::EMPTY_POS;
 }
 
+/* Scans a number consisting of digits followed by ":" or a number with digits and dots if dotted is true.
+ * Appends the number to captured and returns the position after the number or separator. -1 if not matching. */
+static int scanOpenAirNumber(const QString& str, int pos, bool dotted, QStringList& captured)
+{
+  int end = skipDigits(str, pos, dotted);
+  if(end == pos || (!dotted && !isOneOf(str, end, ":")))
+    return -1;
+
+  captured.append(str.mid(pos, end - pos));
+  return dotted ? end : end + 1;
+}
+
+/* Scans optional space, designator and optional space. Returns position after space or -1 if not matching */
+static int scanOpenAirDesignator(const QString& str, int pos, const char *designators, QStringList& captured)
+{
+  pos = skipSpace(str, pos);
+  if(!isOneOf(str, pos, designators))
+    return -1;
+
+  captured.append(str.mid(pos, 1));
+  return skipSpace(str, pos + 1);
+}
+
 geo::Pos fromOpenAirFormat(const QString& coordStr)
 {
-  QRegularExpressionMatch match = MATCH_COORD_OPENAIR_MIN_SEC.match(coordStr.toUpper());
-  if(match.hasMatch())
-    return degMinSecFormatFromCapture(match.capturedTexts());
-  else
+  // Scanners allow trailing garbage
+  // 50:40:42 N 003:13:30 E
+  // 31:30:00 N 086:44:59 W
+  QString coords = coordStr.toUpper();
+  QStringList captured({coords});
+  int pos = 0;
+  for(const char *designators : {"NS", "EW"})
   {
-    match = MATCH_COORD_OPENAIR_MIN.match(coordStr);
-    if(match.hasMatch())
-      return degMinFormatFromCapture(match.capturedTexts());
+    for(bool dotted : {false, false, true})
+    {
+      if(pos != -1)
+        pos = scanOpenAirNumber(coords, pos, dotted, captured);
+    }
+
+    if(pos != -1)
+      pos = scanOpenAirDesignator(coords, pos, designators, captured);
   }
 
+  if(pos != -1)
+    return degMinSecFormatFromCapture(captured);
+
+  // 39:06.2 N 121:35.5 W
+  captured = QStringList({coordStr});
+  pos = 0;
+  for(const char *designators : {"NS", "EW"})
+  {
+    for(bool dotted : {false, true})
+    {
+      if(pos != -1)
+        pos = scanOpenAirNumber(coordStr, pos, dotted, captured);
+    }
+
+    if(pos != -1)
+      pos = scanOpenAirDesignator(coordStr, pos, designators, captured);
+  }
+
+  if(pos != -1)
+    return degMinFormatFromCapture(captured);
+
   return atools::geo::EMPTY_POS;
 }
 
@@ -434,90 +501,282 @@ atools::geo::Pos degMinSecFormatFromCapture(const QStringList& captured)
   return atools::geo::EMPTY_POS;
 }
 
-QRegularExpressionMatch safeMatch(const QRegularExpression& regexp, const QString& str)
+// ================================================================================
+// Single pass scanner for fromAnyFormatInternal
+
+/* Number or designator token including the separator characters following it */
+struct CoordToken
 {
-  if(!regexp.isValid())
-    throw atools::Exception("Invalid regular expression: " + regexp.errorString() + " at " +
-                            QString::number(regexp.patternErrorOffset()));
-  else
-    return regexp.match(str);
+  QString text, gap;
+  bool designator = false, sign = false, dot = false;
+};
+
+/* Type of token expected in a format */
+enum CoordField
+{
+  FIELD_NS, /* N or S */
+  FIELD_EW, /* E or W */
+  FIELD_INT, /* [0-9]+ */
+  FIELD_DEC, /* [0-9.]+ */
+  FIELD_SIGNED_INT, /* [+-]?[0-9]+ */
+  FIELD_SIGNED_DEC /* [+-]?[0-9.]+ */
+};
+
+/* Separator characters allowed after a token */
+enum CoordGap
+{
+  GAP_NONE, /* End of string */
+  GAP_SPACE, /* Optional space */
+  GAP_SPACE_REQ, /* Required at least one space */
+  GAP_DEG, /* Degree sign or space */
+  GAP_MIN, /* Minute sign or space */
+  GAP_SEC, /* Second sign or space */
+  GAP_DEG_END, /* Optional degree sign */
+  GAP_MIN_END, /* Optional minute sign */
+  GAP_SEC_END, /* Optional second sign */
+  GAP_COMMA, /* Comma and optional space */
+  GAP_SEPARATOR /* Space, slash or hash */
+};
+
+/* Index into the captured values */
+enum CoordSlot
+{
+  SLOT_NS,
+  SLOT_EW,
+  SLOT_LATY_DEG,
+  SLOT_LATY_MIN,
+  SLOT_LATY_SEC,
+  SLOT_LONX_DEG,
+  SLOT_LONX_MIN,
+  SLOT_LONX_SEC,
+  SLOT_SIZE
+};
+
+struct CoordFormatElement
+{
+  CoordField field;
+  CoordSlot slot;
+  CoordGap gap;
+};
+
+typedef QVector<CoordFormatElement> CoordFormat;
+
+/* Splits the normalized string into numbers and designators. Returns false if any unknown character is found. */
+static bool scanCoordTokens(const QString& str, QVector<CoordToken>& tokens)
+{
+  static const QString GAP_CHARS(QString(" *'\",/#") + QChar(L'°'));
+
+  int pos = 0;
+  while(pos < str.size())
+  {
+    CoordToken token;
+    if(isOneOf(str, pos, "NSEW"))
+    {
+      token.designator = true;
+      token.text = str.at(pos++);
+    }
+    else
+    {
+      int start = pos;
+      if(isOneOf(str, pos, "+-") && (isDigits(str, pos + 1, 1) || isOneOf(str, pos + 1, ".")))
+      {
+        token.sign = true;
+        pos++;
+      }
+
+      int end = skipDigits(str, pos, true /* allowDot */);
+      if(end == pos)
+        return false;
+
+      token.text = str.mid(start, end - start);
+      token.dot = token.text.contains('.');
+      pos = end;
+    }
+
+    int gapStart = pos;
+    while(pos < str.size() && GAP_CHARS.contains(str.at(pos)))
+      pos++;
+    token.gap = str.mid(gapStart, pos - gapStart);
+
+    tokens.append(token);
+  }
+  return true;
+}
+
+/* true if gap consists of spaces and at most one of signChars */
+static bool isCoordGap(const QString& gap, const QString& signChars, bool required)
+{
+  int numSigns = 0;
+  for(QChar c : gap)
+  {
+    if(signChars.contains(c))
+      numSigns++;
+    else if(c != ' ')
+      return false;
+  }
+  return numSigns <= 1 && (!required || !gap.isEmpty());
+}
+
+static bool matchCoordGap(const QString& gap, CoordGap type)
+{
+  static const QString DEG_SIGNS(QString("*") + QChar(L'°'));
+
+  switch(type)
+  {
+    case GAP_NONE:
+      return gap.isEmpty();
+
+    case GAP_SPACE:
+      return isCoordGap(gap, QString(), false);
+
+    case GAP_SPACE_REQ:
+      return isCoordGap(gap, QString(), true);
+
+    case GAP_DEG:
+      return isCoordGap(gap, DEG_SIGNS, true);
+
+    case GAP_MIN:
+      return isCoordGap(gap, "'", true);
+
+    case GAP_SEC:
+      return isCoordGap(gap, "\"", true);
+
+    case GAP_DEG_END:
+      return isCoordGap(gap, DEG_SIGNS, false);
+
+    case GAP_MIN_END:
+      return isCoordGap(gap, "'", false);
+
+    case GAP_SEC_END:
+      return isCoordGap(gap, "\"", false);
+
+    case GAP_COMMA:
+      return gap.contains(',') && isCoordGap(gap, ",", true);
+
+    case GAP_SEPARATOR:
+      for(QChar c : gap)
+      {
+        if(c != ' ' && c != '/' && c != '#')
+          return false;
+      }
+      return !gap.isEmpty();
+  }
+  return false;
 }
 
-QString safeCaptured(const QRegularExpressionMatch& match, const QString& str)
+/* Matches tokens against format and fills captured by slot. Returns false if not matching. */
+static bool matchCoordFormat(const QVector<CoordToken>& tokens, const CoordFormat& format, QVector<QString>& captured)
 {
-  QString retval = match.captured(str);
-  if(retval.isNull())
-    throw atools::Exception("Match not found: " + str + " in " + match.regularExpression().pattern() +
-                            ". Match groups: " + match.regularExpression().namedCaptureGroups().join(", "));
-  return retval;
+  if(tokens.size() != format.size())
+    return false;
+
+  for(int i = 0; i < tokens.size(); i++)
+  {
+    const CoordToken& token = tokens.at(i);
+    const CoordFormatElement& element = format.at(i);
+
+    bool ok = false;
+    switch(element.field)
+    {
+      case FIELD_NS:
+        ok = token.designator && (token.text == "N" || token.text == "S");
+        break;
+
+      case FIELD_EW:
+        ok = token.designator && (token.text == "E" || token.text == "W");
+        break;
+
+      case FIELD_INT:
+        ok = !token.designator && !token.sign && !token.dot;
+        break;
+
+      case FIELD_DEC:
+        ok = !token.designator && !token.sign;
+        break;
+
+      case FIELD_SIGNED_INT:
+        ok = !token.designator && !token.dot;
+        break;
+
+      case FIELD_SIGNED_DEC:
+        ok = !token.designator;
+        break;
+    }
+
+    if(!ok || !matchCoordGap(token.gap, element.gap))
+      return false;
+
+    captured[element.slot] = token.text;
+  }
+  return true;
 }
 
-atools::geo::Pos degMinSecFromMatch(const QRegularExpressionMatch& match)
+atools::geo::Pos degMinSecFromCapture(const QVector<QString>& captured)
 {
-  QString ns = safeCaptured(match, "NS");
-  int latYDeg = safeCaptured(match, "LATY_DEG").toInt();
-  int latYMin = safeCaptured(match, "LATY_MIN").toInt();
-  float latYSec = safeCaptured(match, "LATY_DEC_SEC").toFloat();
+  QString ns = captured.at(SLOT_NS);
+  int latYDeg = captured.at(SLOT_LATY_DEG).toInt();
+  int latYMin = captured.at(SLOT_LATY_MIN).toInt();
+  float latYSec = captured.at(SLOT_LATY_SEC).toFloat();
 
-  QString ew = safeCaptured(match, "EW");
-  int lonXDeg = safeCaptured(match, "LONX_DEG").toInt();
-  int lonXMin = safeCaptured(match, "LONX_MIN").toInt();
-  float lonXSec = safeCaptured(match, "LONX_DEC_SEC").toFloat();
+  QString ew = captured.at(SLOT_EW);
+  int lonXDeg = captured.at(SLOT_LONX_DEG).toInt();
+  int lonXMin = captured.at(SLOT_LONX_MIN).toInt();
+  float lonXSec = captured.at(SLOT_LONX_SEC).toFloat();
 
   float latY = (latYDeg + latYMin / 60.f + latYSec / 3600.f) * (ns == "S" ? -1.f : 1.f);
   float lonX = (lonXDeg + lonXMin / 60.f + lonXSec / 3600.f) * (ew == "W" ? -1.f : 1.f);
   return Pos(lonX, latY);
 }
 
-atools::geo::Pos degMinDesignatorFromMatch(const QRegularExpressionMatch& match)
+atools::geo::Pos degMinDesignatorFromCapture(const QVector<QString>& captured)
 {
-  QString ns = safeCaptured(match, "NS");
-  int latYDeg = safeCaptured(match, "LATY_DEG").toInt();
-  float latYMin = safeCaptured(match, "LATY_DEC_MIN").toFloat();
+  QString ns = captured.at(SLOT_NS);
+  int latYDeg = captured.at(SLOT_LATY_DEG).toInt();
+  float latYMin = captured.at(SLOT_LATY_MIN).toFloat();
 
-  QString ew = safeCaptured(match, "EW");
-  int lonXDeg = safeCaptured(match, "LONX_DEG").toInt();
-  float lonXMin = safeCaptured(match, "LONX_DEC_MIN").toFloat();
+  QString ew = captured.at(SLOT_EW);
+  int lonXDeg = captured.at(SLOT_LONX_DEG).toInt();
+  float lonXMin = captured.at(SLOT_LONX_MIN).toFloat();
 
   float latY = (latYDeg + latYMin / 60.f) * (ns == "S" ? -1.f : 1.f);
   float lonX = (lonXDeg + lonXMin / 60.f) * (ew == "W" ? -1.f : 1.f);
   return Pos(lonX, latY);
 }
 
-atools::geo::Pos degMinFromMatch(const QRegularExpressionMatch& match)
+atools::geo::Pos degMinFromCapture(const QVector<QString>& captured)
 {
-  int latYDeg = safeCaptured(match, "LATY_DEG").toInt();
-  float latYMin = safeCaptured(match, "LATY_DEC_MIN").toFloat();
+  int latYDeg = captured.at(SLOT_LATY_DEG).toInt();
+  float latYMin = captured.at(SLOT_LATY_MIN).toFloat();
 
-  int lonXDeg = safeCaptured(match, "LONX_DEG").toInt();
-  float lonXMin = safeCaptured(match, "LONX_DEC_MIN").toFloat();
+  int lonXDeg = captured.at(SLOT_LONX_DEG).toInt();
+  float lonXMin = captured.at(SLOT_LONX_MIN).toFloat();
 
   float latY = (latYDeg >= 0.f ? 1.f : -1.f) * (std::abs(latYDeg) + latYMin / 60.f);
   float lonX = (lonXDeg >= 0.f ? 1.f : -1.f) * (std::abs(lonXDeg) + lonXMin / 60.f);
   return Pos(lonX, latY);
 }
 
-atools::geo::Pos degFromMatchSigned(const QRegularExpressionMatch& match)
+atools::geo::Pos degFromCaptureSigned(const QVector<QString>& captured)
 {
   bool ok;
-  float latYDeg = safeCaptured(match, "LATY_DEC_DEG_SIGN").toFloat(&ok);
+  float latYDeg = captured.at(SLOT_LATY_DEG).toFloat(&ok);
   if(!ok)
     return atools::geo::EMPTY_POS;
 
-  float lonXDeg = safeCaptured(match, "LONX_DEC_DEG_SIGN").toFloat(&ok);
+  float lonXDeg = captured.at(SLOT_LONX_DEG).toFloat(&ok);
   if(!ok)
     return atools::geo::EMPTY_POS;
 
   return Pos(lonXDeg, latYDeg);
 }
 
-atools::geo::Pos degFromMatch(const QRegularExpressionMatch& match)
+atools::geo::Pos degFromCapture(const QVector<QString>& captured)
 {
-  float latYDeg = safeCaptured(match, "LATY_DEC_DEG").toFloat();
-  QString ns = safeCaptured(match, "NS");
+  float latYDeg = captured.at(SLOT_LATY_DEG).toFloat();
+  QString ns = captured.at(SLOT_NS);
 
-  float lonXDeg = safeCaptured(match, "LONX_DEC_DEG").toFloat();
-  QString ew = safeCaptured(match, "EW");
+  float lonXDeg = captured.at(SLOT_LONX_DEG).toFloat();
+  QString ew = captured.at(SLOT_EW);
 
   float latY = latYDeg * (ns == "S" ? -1.f : 1.f);
   float lonX = lonXDeg * (ew == "W" ? -1.f : 1.f);
@@ -561,101 +820,78 @@ geo::Pos fromAnyFormatInternal(const QString& coords, bool replaceDecimals, bool
 
   coordStr = coordStr.simplified();
 
-  // North/south and east/west designator
-  const static QLatin1String NS("(?<NS>[NS])");
-  const static QLatin1String EW("(?<EW>[EW])");
-
-  // Optional n-space
-  const static QLatin1String SP("\\s*"); // Optional space
-  const static QLatin1String SPREQ("\\s+"); // Required at least one space
-  const static QLatin1String COMMA(",");
-
-  // Degree, minute and seconds signs or space
-  const static QString DEG("[ °\\*]");
-  const static QLatin1String MIN("[ ']");
-  const static QLatin1String SEC("[ \"]");
-
-  // Degree, minute and seconds signs
-  const static QString DEGEND("[°\\*]?");
-  const static QLatin1String MINEND("[']?");
-  const static QLatin1String SECEND("[\"]?");
-
-  // Integer degree with named capture
-  const static QLatin1String LONX_DEG("(?<LONX_DEG>[0-9]+)");
-  const static QLatin1String LATY_DEG("(?<LATY_DEG>[0-9]+)");
-
-  // Integer degree with named capture and sign
-  const static QLatin1String LONX_DEG_SIGN("(?<LONX_DEG>[+-]?[0-9]+)");
-  const static QLatin1String LATY_DEG_SIGN("(?<LATY_DEG>[+-]?[0-9]+)");
-
-  // Decimal degree
-  const static QLatin1String LONX_DEC_DEG("(?<LONX_DEC_DEG>[0-9\\.]+)");
-  const static QLatin1String LATY_DEC_DEG("(?<LATY_DEC_DEG>[0-9\\.]+)");
-
-  // Decimal degree with sign
-  const static QLatin1String LONX_DEC_DEG_SIGN("(?<LONX_DEC_DEG_SIGN>[+-]?[0-9\\.]+)");
-  const static QLatin1String LATY_DEC_DEG_SIGN("(?<LATY_DEC_DEG_SIGN>[+-]?[0-9\\.]+)");
-
-  // Minutes
-  const static QLatin1String LONX_MIN("(?<LONX_MIN>[0-9]+)");
-  const static QLatin1String LATY_MIN("(?<LATY_MIN>[0-9]+)");
-
-  // Decimal minutes
-  const static QLatin1String LONX_DEC_MIN("(?<LONX_DEC_MIN>[0-9\\.]+)");
-  const static QLatin1String LATY_DEC_MIN("(?<LATY_DEC_MIN>[0-9\\.]+)");
-
-  // Decimal seconds
-  const static QLatin1String LONX_DEC_SEC("(?<LONX_DEC_SEC>[0-9\\.]+)");
-  const static QLatin1String LATY_DEC_SEC("(?<LATY_DEC_SEC>[0-9\\.]+)");
-
   // ================================================================================
-  // Build regular expressions
+  // Format descriptions. Each element is the expected token, the slot it is captured into and the allowed
+  // separator characters following the token.
 
   // N49° 26' 41.57" E9° 12' 5.49"
-  static const QRegularExpression FORMAT_DEG_MIN_SEC_REGEXP(
-    "^" + NS + SP + LATY_DEG + SP + DEG + SP + LATY_MIN + SP + MIN + SP + LATY_DEC_SEC + SP + SEC + SP +
-    "" + EW + SP + LONX_DEG + SP + DEG + SP + LONX_MIN + SP + MIN + SP + LONX_DEC_SEC + SP + SECEND + "$");
+  static const CoordFormat FORMAT_DEG_MIN_SEC({
+    {FIELD_NS, SLOT_NS, GAP_SPACE},
+    {FIELD_INT, SLOT_LATY_DEG, GAP_DEG}, {FIELD_INT, SLOT_LATY_MIN, GAP_MIN}, {FIELD_DEC, SLOT_LATY_SEC, GAP_SEC},
+    {FIELD_EW, SLOT_EW, GAP_SPACE},
+    {FIELD_INT, SLOT_LONX_DEG, GAP_DEG}, {FIELD_INT, SLOT_LONX_MIN, GAP_MIN}, {FIELD_DEC, SLOT_LONX_SEC, GAP_SEC_END}
+  });
 
   // 49° 26' 41,57" N 9° 12' 5,49" E
-  static const QRegularExpression FORMAT_DEG_MIN_SEC_REGEXP2(
-    "^" + LATY_DEG + SP + DEG + SP + LATY_MIN + SP + MIN + SP + LATY_DEC_SEC + SP + SECEND + SP + NS + SP +
-    "" + LONX_DEG + SP + DEG + SP + LONX_MIN + SP + MIN + SP + LONX_DEC_SEC + SP + SECEND + SP + EW + "$");
+  static const CoordFormat FORMAT_DEG_MIN_SEC2({
+    {FIELD_INT, SLOT_LATY_DEG, GAP_DEG}, {FIELD_INT, SLOT_LATY_MIN, GAP_MIN}, {FIELD_DEC, SLOT_LATY_SEC, GAP_SEC_END},
+    {FIELD_NS, SLOT_NS, GAP_SPACE},
+    {FIELD_INT, SLOT_LONX_DEG, GAP_DEG}, {FIELD_INT, SLOT_LONX_MIN, GAP_MIN}, {FIELD_DEC, SLOT_LONX_SEC, GAP_SEC_END},
+    {FIELD_EW, SLOT_EW, GAP_NONE}
+  });
 
   // 49° 26,69' N 9° 12,09' E
-  static const QRegularExpression FORMAT_DEG_MIN_REGEXP2(
-    "^" + LATY_DEG + SP + DEG + SP + LATY_DEC_MIN + SP + MIN + SP + NS + SP +
-    "" + LONX_DEG + SP + DEG + SP + LONX_DEC_MIN + SP + MIN + SP + EW + "$");
+  static const CoordFormat FORMAT_DEG_MIN2({
+    {FIELD_INT, SLOT_LATY_DEG, GAP_DEG}, {FIELD_DEC, SLOT_LATY_MIN, GAP_MIN},
+    {FIELD_NS, SLOT_NS, GAP_SPACE},
+    {FIELD_INT, SLOT_LONX_DEG, GAP_DEG}, {FIELD_DEC, SLOT_LONX_MIN, GAP_MIN},
+    {FIELD_EW, SLOT_EW, GAP_NONE}
+  });
 
   // N54* 16.82' W008* 35.95'
-  static const QRegularExpression FORMAT_DEG_MIN_REGEXP(
-    "^" + NS + SP + LATY_DEG + SP + DEG + SP + LATY_DEC_MIN + SP + MIN + SP +
-    "" + EW + SP + LONX_DEG + SP + DEG + SP + LONX_DEC_MIN + SP + MINEND + SP + "$");
+  static const CoordFormat FORMAT_DEG_MIN({
+    {FIELD_NS, SLOT_NS, GAP_SPACE},
+    {FIELD_INT, SLOT_LATY_DEG, GAP_DEG}, {FIELD_DEC, SLOT_LATY_MIN, GAP_MIN},
+    {FIELD_EW, SLOT_EW, GAP_SPACE},
+    {FIELD_INT, SLOT_LONX_DEG, GAP_DEG}, {FIELD_DEC, SLOT_LONX_MIN, GAP_MIN_END}
+  });
 
   // 49,4449° N 9,2015° E
-  static const QRegularExpression FORMAT_DEG_REGEXP(
-    "^" + LATY_DEC_DEG + SP + DEGEND + SP + NS + SP +
-    "" + LONX_DEC_DEG + SP + DEGEND + SP + EW + "$");
+  static const CoordFormat FORMAT_DEG({
+    {FIELD_DEC, SLOT_LATY_DEG, GAP_DEG_END}, {FIELD_NS, SLOT_NS, GAP_SPACE},
+    {FIELD_DEC, SLOT_LONX_DEG, GAP_DEG_END}, {FIELD_EW, SLOT_EW, GAP_NONE}
+  });
 
   // N 49,4449° E 9,2015°
-  static const QRegularExpression FORMAT_DEG_REGEXP2(
-    "^" + NS + SP + LATY_DEC_DEG + SP + DEG + SP +
-    "" + EW + SP + LONX_DEC_DEG + SP + DEGEND + "$");
+  static const CoordFormat FORMAT_DEG2({
+    {FIELD_NS, SLOT_NS, GAP_SPACE}, {FIELD_DEC, SLOT_LATY_DEG, GAP_DEG},
+    {FIELD_EW, SLOT_EW, GAP_SPACE}, {FIELD_DEC, SLOT_LONX_DEG, GAP_DEG_END}
+  });
 
   // Signed Lat lon or lon lat
-  static const QRegularExpression FORMAT_NUMBER_SIGNED(
-    "^" + LATY_DEC_DEG_SIGN + "[\\s\\|_/#;:]+" + LONX_DEC_DEG_SIGN + "$");
+  static const CoordFormat FORMAT_NUMBER_SIGNED({
+    {FIELD_SIGNED_DEC, SLOT_LATY_DEG, GAP_SEPARATOR}, {FIELD_SIGNED_DEC, SLOT_LONX_DEG, GAP_NONE}
+  });
 
   // Google format -120 19.70, 46 42.88
-  static const QRegularExpression FORMAT_NUMBER_GOOGLE(
-    "^" + LATY_DEG_SIGN + SPREQ + LATY_DEC_MIN + SP + COMMA + SP + LONX_DEG_SIGN + SPREQ + LONX_DEC_MIN + "$");
+  static const CoordFormat FORMAT_NUMBER_GOOGLE({
+    {FIELD_SIGNED_INT, SLOT_LATY_DEG, GAP_SPACE_REQ}, {FIELD_DEC, SLOT_LATY_MIN, GAP_COMMA},
+    {FIELD_SIGNED_INT, SLOT_LONX_DEG, GAP_SPACE_REQ}, {FIELD_DEC, SLOT_LONX_MIN, GAP_NONE}
+  });
+
+  // Scan string once and match the token list against the formats below
+  QVector<CoordToken> tokens;
+  if(!scanCoordTokens(coordStr, tokens))
+    return fromAnyWaypointFormat(coordStr);
+
+  QVector<QString> captured(SLOT_SIZE);
 
   // ================================================================================
   // Decimal degree formats
   // 49,4449 -9,2015
-  QRegularExpressionMatch match = safeMatch(FORMAT_NUMBER_SIGNED, coordStr);
-  if(match.hasMatch())
+  if(matchCoordFormat(tokens, FORMAT_NUMBER_SIGNED, captured))
   {
-    Pos pos = degFromMatchSigned(match);
+    Pos pos = degFromCaptureSigned(captured);
 
     if(hemisphere != nullptr)
       *hemisphere = false; // caller probably has to swap lat/lon
@@ -665,19 +901,17 @@ geo::Pos fromAnyFormatInternal(const QString& coords, bool replaceDecimals, bool
   }
 
   // 49,4449° N 9,2015° E
-  match = safeMatch(FORMAT_DEG_REGEXP, coordStr);
-  if(match.hasMatch())
+  if(matchCoordFormat(tokens, FORMAT_DEG, captured))
   {
-    Pos pos = degFromMatch(match);
+    Pos pos = degFromCapture(captured);
     if(pos.isValidRange())
       return pos;
   }
 
   // N 49,4449° E 9,2015°
-  match = safeMatch(FORMAT_DEG_REGEXP2, coordStr);
-  if(match.hasMatch())
+  if(matchCoordFormat(tokens, FORMAT_DEG2, captured))
   {
-    Pos pos = degFromMatch(match);
+    Pos pos = degFromCapture(captured);
     if(pos.isValidRange())
       return pos;
   }
@@ -685,28 +919,25 @@ geo::Pos fromAnyFormatInternal(const QString& coords, bool replaceDecimals, bool
   // ================================================================================
   // Degree and decimal minute formats
   // N54* 16.82' W008* 35.95'
-  match = safeMatch(FORMAT_DEG_MIN_REGEXP, coordStr);
-  if(match.hasMatch())
+  if(matchCoordFormat(tokens, FORMAT_DEG_MIN, captured))
   {
-    Pos pos = degMinDesignatorFromMatch(match);
+    Pos pos = degMinDesignatorFromCapture(captured);
     if(pos.isValidRange())
       return pos;
   }
 
   // 49° 26,69' N 9° 12,09' E
-  match = safeMatch(FORMAT_DEG_MIN_REGEXP2, coordStr);
-  if(match.hasMatch())
+  if(matchCoordFormat(tokens, FORMAT_DEG_MIN2, captured))
   {
-    Pos pos = degMinDesignatorFromMatch(match);
+    Pos pos = degMinDesignatorFromCapture(captured);
     if(pos.isValidRange())
       return pos;
   }
 
   // -120 19.70, 46 42.88
-  match = safeMatch(FORMAT_NUMBER_GOOGLE, coordStr);
-  if(match.hasMatch())
+  if(matchCoordFormat(tokens, FORMAT_NUMBER_GOOGLE, captured))
   {
-    Pos pos = degMinFromMatch(match);
+    Pos pos = degMinFromCapture(captured);
     if(pos.isValidRange())
       return pos;
   }
@@ -714,19 +945,17 @@ geo::Pos fromAnyFormatInternal(const QString& coords, bool replaceDecimals, bool
   // ================================================================================
   // Degree, minute and second formats
   // N49° 26' 41.57" E9° 12' 5.49"
-  match = safeMatch(FORMAT_DEG_MIN_SEC_REGEXP, coordStr);
-  if(match.hasMatch())
+  if(matchCoordFormat(tokens, FORMAT_DEG_MIN_SEC, captured))
   {
-    Pos pos = degMinSecFromMatch(match);
+    Pos pos = degMinSecFromCapture(captured);
     if(pos.isValidRange())
       return pos;
   }
 
   // 49° 26' 41,57" N 9° 12' 5,49" E
-  match = safeMatch(FORMAT_DEG_MIN_SEC_REGEXP2, coordStr);
-  if(match.hasMatch())
+  if(matchCoordFormat(tokens, FORMAT_DEG_MIN_SEC2, captured))
   {
-    Pos pos = degMinSecFromMatch(match);
+    Pos pos = degMinSecFromCapture(captured);
     if(pos.isValidRange())
       return pos;
   }
@@ -19,9 +19,12 @@
 
 #include "geo/spatialindex.h"
 #include "fs/weather/weathertypes.h"
+#include "fs/weather/metarparser.h"
 #include "atools.h"
+#include "util/parallel.h"
 
 #include <QTimeZone>
+#include <QElapsedTimer>
 #include <QJsonDocument>
 #include <QJsonArray>
 #include <QJsonObject>
@@ -59,6 +62,17 @@ struct MetarData
 
 };
 
+/* METAR read from a stream but not yet added to the index */
+struct MetarIndex::PendingMetar
+{
+  QString metar, ident;
+  QDateTime timestamp;
+};
+
+/* Run parsing in the calling thread if there are less METARs to parse */
+static const int MIN_METARS_PARALLEL = 500;
+static const int MAX_PARSER_THREADS = 16;
+
 inline bool isDigit(QChar c)
 {
   return c >= '0' && c <= '9';
@@ -81,11 +95,14 @@ MetarIndex::~MetarIndex()
   delete spatialIndex;
 }
 
-int MetarIndex::read(QTextStream& stream, const QString& fileOrUrl, bool merge)
+int MetarIndex::read(QTextStream& stream, const QString& fileOrUrl, bool merge, const std::function<bool()>& readValid)
 {
   Q_ASSERT(format != UNKNOWN);
   Q_ASSERT(fetchAirportCoords);
 
+  // Collect all first to be able to discard them if the stream turns out to be invalid
+  QVector<PendingMetar> metars;
+  int found = 0;
   switch(format)
   {
     case atools::fs::weather::UNKNOWN:
@@ -93,15 +110,43 @@ int MetarIndex::read(QTextStream& stream, const QString& fileOrUrl, bool merge)
 
     case atools::fs::weather::NOAA:
     case atools::fs::weather::XPLANE:
-      return readNoaaXplane(stream, fileOrUrl, merge);
+      found = readNoaaXplane(stream, fileOrUrl, metars);
+      break;
 
     case atools::fs::weather::FLAT:
-      return readFlat(stream, fileOrUrl, merge);
+      found = readFlat(stream, fileOrUrl, metars);
+      break;
 
     case atools::fs::weather::JSON:
-      return readJson(stream, fileOrUrl, merge);
+      found = readJson(stream, fileOrUrl, metars);
+      break;
+  }
+
+  if(readValid && !readValid())
+  {
+    qWarning() << Q_FUNC_INFO << "Discarding" << metars.size() << "METARs from invalid data" << fileOrUrl;
+    return 0;
+  }
+
+  if(!merge)
+  {
+    spatialIndex->clear();
+    identIndexMap.clear();
+  }
+
+  for(const PendingMetar& metar : qAsConst(metars))
+    updateOrInsert(metar.metar, metar.ident, metar.timestamp);
+
+  updateIndex();
+
+  if(verbose)
+  {
+    qDebug() << "index->size()" << spatialIndex->size();
+    qDebug() << "metarMap.size()" << identIndexMap.size();
   }
-  return 0;
+
+  qDebug() << Q_FUNC_INFO << fileOrUrl << spatialIndex->size();
+  return found;
 }
 
 // 2017/07/30 18:45
@@ -112,14 +157,8 @@ int MetarIndex::read(QTextStream& stream, const QString& fileOrUrl, bool merge)
 //
 // 2017/07/30 18:47
 // KADS 301847Z 06005G14KT 13SM SKC 32/19 A3007
-int MetarIndex::readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bool merge)
+int MetarIndex::readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, QVector<PendingMetar>& metars)
 {
-  if(!merge)
-  {
-    spatialIndex->clear();
-    identIndexMap.clear();
-  }
-
   QDateTime latest, oldest;
   QString latestIdent, oldestIdent;
 
@@ -201,7 +240,7 @@ int MetarIndex::readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bo
         }
 
         found++;
-        updateOrInsert(line, ident, lastTimestamp);
+        metars.append({line, ident, lastTimestamp});
       }
       else
         qWarning() << "Ident in METAR does not match in file/URL"
@@ -210,18 +249,13 @@ int MetarIndex::readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bo
     lineNum++;
   }
 
-  updateIndex();
-
   if(verbose)
   {
-    qDebug() << "index->size()" << spatialIndex->size();
-    qDebug() << "metarMap.size()" << identIndexMap.size();
     qDebug() << "found " << found << "futureDates " << futureDates << "invalidDates" << invalidDates;
     qDebug() << "Latest" << latestIdent << latest;
     qDebug() << "Oldest" << oldestIdent << oldest;
   }
 
-  qDebug() << Q_FUNC_INFO << fileOrUrl << spatialIndex->size();
   return found;
 }
 
@@ -232,14 +266,8 @@ int MetarIndex::readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bo
 // AGGH 100900Z 16003KT 9999 FEW016 FEW017CB SCT300 27/25 Q1010
 // ANYN 100900Z 08005KT 9999 FEW020 27/23 Q1010
 // AYMH 100800Z 16015KT 9999 SHRA BKN090 18/16 Q1018 RMK
-int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, bool merge)
+int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, QVector<PendingMetar>& metars)
 {
-  if(!merge)
-  {
-    spatialIndex->clear();
-    identIndexMap.clear();
-  }
-
   QDateTime latest, oldest;
   QString latestIdent, oldestIdent;
 
@@ -316,7 +344,7 @@ int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, bool mer
         }
 
         found++;
-        updateOrInsert(line, ident, metarDateTime);
+        metars.append({line, ident, metarDateTime});
       }
       else if(verbose)
         qWarning() << "Invalid METAR in file/URL" << fileOrUrl << "line num" << lineNum << "line" << line;
@@ -324,18 +352,13 @@ int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, bool mer
     lineNum++;
   }
 
-  updateIndex();
-
   if(verbose)
   {
-    qDebug() << "index->size()" << spatialIndex->size();
-    qDebug() << "metarMap.size()" << identIndexMap.size();
     qDebug() << "found " << found << "futureDates " << futureDates << "invalidDates" << invalidDates;
     qDebug() << "Latest" << latestIdent << latest;
     qDebug() << "Oldest" << oldestIdent << oldest;
   }
 
-  qDebug() << Q_FUNC_INFO << fileOrUrl << spatialIndex->size();
   return found;
 }
 
@@ -355,14 +378,8 @@ int MetarIndex::readFlat(QTextStream& stream, const QString& fileOrUrl, bool mer
 // .    "metar": "AYMH 090800Z VRB04KT 9999 -SHRA SCT008 BKN030 -/- Q1019",
 // .    "updatedAt": "2022-03-09T08:00:00.000Z"
 // .  },
-int MetarIndex::readJson(QTextStream& stream, const QString& fileOrUrl, bool merge)
+int MetarIndex::readJson(QTextStream& stream, const QString& fileOrUrl, QVector<PendingMetar>& metars)
 {
-  if(!merge)
-  {
-    spatialIndex->clear();
-    identIndexMap.clear();
-  }
-
   QDateTime latest, oldest;
   QString latestIdent, oldestIdent;
 
@@ -407,21 +424,16 @@ int MetarIndex::readJson(QTextStream& stream, const QString& fileOrUrl, bool mer
     }
 
     found++;
-    updateOrInsert(metar, ident, metarDateTime);
+    metars.append({metar, ident, metarDateTime});
   }
 
-  updateIndex();
-
   if(verbose)
   {
-    qDebug() << "index->size()" << spatialIndex->size();
-    qDebug() << "metarMap.size()" << identIndexMap.size();
     qDebug() << "found " << found << "futureDates " << futureDates << "invalidDates" << invalidDates;
     qDebug() << "Latest" << latestIdent << latest;
     qDebug() << "Oldest" << oldestIdent << oldest;
   }
 
-  qDebug() << Q_FUNC_INFO << fileOrUrl << spatialIndex->size();
   return found;
 }
 
@@ -452,6 +464,7 @@ void MetarIndex::clear()
 {
   spatialIndex->clear();
   identIndexMap.clear();
+  summaryCache.clear();
 }
 
 bool MetarIndex::isEmpty() const
@@ -505,6 +518,91 @@ void MetarIndex::updateIndex()
 {
   Q_ASSERT(spatialIndex->size() == identIndexMap.size());
   spatialIndex->updateIndex();
+  updateSummaries();
+}
+
+/* Parse METAR and return decoded values. Returns an invalid summary for bogus METARs. Thread safe. */
+static MetarSummary parseSummary(const QString& metar)
+{
+  try
+  {
+    return MetarParser(metar).getSummary();
+  }
+  catch(const std::exception&)
+  {
+    // Bogus METAR - counted as invalid by caller
+  }
+  return MetarSummary();
+}
+
+void MetarIndex::updateSummaries()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Keep summaries of unchanged METARs and collect the ones which need parsing =========
+  QHash<QString, MetarSummary> cache;
+  cache.reserve(spatialIndex->size());
+  QVector<QString> metars;
+  for(int i = 0; i < spatialIndex->size(); i++)
+  {
+    const QString& metar = spatialIndex->at(i).metar;
+    auto it = summaryCache.constFind(metar);
+    if(it != summaryCache.constEnd())
+      cache.insert(metar, it.value());
+    else if(!metar.isEmpty())
+      metars.append(metar);
+  }
+
+  // Parse all new METARs in parallel =========
+  // Work directly on raw arrays to avoid detaching in the threads
+  QVector<MetarSummary> summaries(metars.size());
+  const QString *metarData = metars.constData();
+  MetarSummary *summaryData = summaries.data();
+  const int size = metars.size();
+
+  int maxThreads = size < MIN_METARS_PARALLEL ? 1 : MAX_PARSER_THREADS;
+  atools::util::runParallel(size, 1, [metarData, summaryData](int begin, int end, int) -> void {
+    for(int i = begin; i < end; i++)
+      summaryData[i] = parseSummary(metarData[i]);
+  }, maxThreads);
+  int numThreads = atools::util::parallelThreadCount(size, 1, maxThreads);
+
+  int invalid = 0;
+  for(int i = 0; i < size; i++)
+  {
+    if(!summaryData[i].isValid())
+      invalid++;
+    cache.insert(metarData[i], summaryData[i]);
+  }
+  summaryCache.swap(cache);
+
+  qDebug() << Q_FUNC_INFO << "Parsed" << size << "METARs" << invalid << "invalid using" << numThreads << "threads in"
+           << timer.elapsed() << "ms." << summaryCache.size() << "cached";
+}
+
+MetarSummary MetarIndex::getMetarSummary(const QString& station) const
+{
+  int idx = identIndexMap.value(station, -1);
+  if(idx != -1)
+    return summaryCache.value(spatialIndex->at(idx).metar);
+
+  return MetarSummary();
+}
+
+MetarSummary MetarIndex::getMetarSummaryForMetar(const QString& metar)
+{
+  if(metar.isEmpty())
+    return MetarSummary();
+
+  auto it = summaryCache.constFind(metar);
+  if(it != summaryCache.constEnd())
+    return it.value();
+
+  // Not in index, e.g. interpolated or from simulator
+  MetarSummary summary = parseSummary(metar);
+  summaryCache.insert(metar, summary);
+  return summary;
 }
 
 MetarData MetarIndex::metarData(const QString& ident)
@@ -20,6 +20,10 @@
 
 #include "fs/weather/weathertypes.h"
 
+#include <QVector>
+
+#include <functional>
+
 class QTextStream;
 
 namespace atools {
@@ -33,6 +37,7 @@ namespace weather {
 
 struct MetarResult;
 struct MetarData;
+struct MetarSummary;
 
 /*
  * Reads, caches and indexes (by position) METAR reports in NOAA style as also used by X-Plane.
@@ -65,8 +70,11 @@ public:
 
   /* Read METARs from stream and add them to the index. Merges into current list or clears list before.
    * Older of duplicates are ignored/removed.
+   * readValid is called after reading the whole stream if given. The index is not changed if it returns false,
+   * e.g. for truncated or corrupt compressed data.
    * Returns number of METARs read. */
-  int read(QTextStream& stream, const QString& fileName, bool merge);
+  int read(QTextStream& stream, const QString& fileName, bool merge,
+           const std::function<bool()>& readValid = nullptr);
 
   /* Clears all lists */
   void clear();
@@ -81,6 +89,12 @@ public:
    * Also keeps position and ident of original request.*/
   atools::fs::weather::MetarResult getMetar(const QString& station, const atools::geo::Pos& pos);
 
+  /* Get decoded values for the METAR of a station from the cache. Invalid if station has no valid METAR. */
+  atools::fs::weather::MetarSummary getMetarSummary(const QString& station) const;
+
+  /* Get decoded values for a METAR string as returned in MetarResult. Parses and caches the METAR if not found. */
+  atools::fs::weather::MetarSummary getMetarSummaryForMetar(const QString& metar);
+
   /* Set to a function that returns the coordinates for an airport ident. Needed to find the nearest. */
   void setFetchAirportCoords(const std::function<atools::geo::Pos(const QString&)>& value)
   {
@@ -88,23 +102,28 @@ public:
   }
 
 private:
+  struct PendingMetar;
+
   /* Get a METAR string. Empty if not available */
   MetarData metarData(const QString& ident);
 
   /* Read NOAA or XPLANE format */
-  int readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, bool merge);
+  int readNoaaXplane(QTextStream& stream, const QString& fileOrUrl, QVector<PendingMetar>& metars);
 
   /* Read flat file format like VATSIM */
-  int readFlat(QTextStream& stream, const QString& fileOrUrl, bool merge);
+  int readFlat(QTextStream& stream, const QString& fileOrUrl, QVector<PendingMetar>& metars);
 
   /* Read JSON file format from IVAO */
-  int readJson(QTextStream& stream, const QString& fileOrUrl, bool merge);
+  int readJson(QTextStream& stream, const QString& fileOrUrl, QVector<PendingMetar>& metars);
 
   /* Copy airports from the complete list to the index with coordinates.
    * Copies only airports that exist in the current simulator database, i.e. where fetchAirportCoords returns
    * a valid coordinate. */
   void updateIndex();
 
+  /* Parse all METARs not found in the cache in parallel and remove the ones which are not used anymore */
+  void updateSummaries();
+
   /* Update or insert a METAR entry */
   void updateOrInsert(const QString& metar, const QString& ident, const QDateTime& lastTimestamp);
 
@@ -118,6 +137,9 @@ private:
    * not considered in the index. */
   atools::geo::SpatialIndex<MetarData> *spatialIndex = nullptr;
 
+  /* Decoded values keyed by raw METAR string */
+  QHash<QString, atools::fs::weather::MetarSummary> summaryCache;
+
   bool verbose = false;
   atools::fs::weather::MetarFormat format = atools::fs::weather::UNKNOWN;
 
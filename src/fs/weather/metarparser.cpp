@@ -561,6 +561,8 @@ void MetarParser::postProcess()
     }
   }
 
+  ceilingMeter = minAltitudeMeter;
+
   // Calculate the flight rules depending on ceiling and visiblity
   float ceilingFt = atools::geo::meterToFeet(minAltitudeMeter);
   float visibilityMi = atools::geo::meterToMi(getMinVisibility().getVisibilityMeter());
@@ -1484,6 +1486,22 @@ float MetarParser::getPrevailingWindSpeedKnots() const
     return INVALID_METAR_VALUE;
 }
 
+MetarSummary MetarParser::getSummary() const
+{
+  MetarSummary summary;
+  summary.valid = isValid();
+  summary.flightRules = static_cast<qint8>(flightRules);
+  summary.windDirDeg = static_cast<qint16>(prevailingWindDir);
+  summary.windSpeedKts = getPrevailingWindSpeedKnots();
+  summary.gustSpeedKts = getGustSpeedKts();
+  summary.visibilityMeter = getMinVisibility().getVisibilityMeter();
+  summary.pressureMbar = getPressureMbar();
+
+  if(ceilingMeter < INVALID_METAR_VALUE / 2.f)
+    summary.ceilingFt = atools::geo::meterToFeet(ceilingMeter);
+  return summary;
+}
+
 // [AQ]\d{4}             (spec)
 // [AQ]\d{2}(\d{2}|//)   (Namibia)
 bool MetarParser::scanPressure()
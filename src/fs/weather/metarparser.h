@@ -46,6 +46,28 @@ const Q_DECL_CONSTEXPR float INVALID_METAR_VALUE = std::numeric_limits<float>::m
 
 class MetarParser;
 
+/*
+ * Compact decoded values of a METAR report. Cached by MetarIndex to avoid parsing METARs again on map redraws.
+ * Values are INVALID_METAR_VALUE or -1 if not available.
+ */
+struct MetarSummary
+{
+  float windSpeedKts = INVALID_METAR_VALUE, /* Prevailing wind speed */
+        gustSpeedKts = INVALID_METAR_VALUE,
+        ceilingFt = INVALID_METAR_VALUE, /* Lowest broken or overcast layer */
+        visibilityMeter = INVALID_METAR_VALUE, /* Minimum visibility */
+        pressureMbar = INVALID_METAR_VALUE;
+  qint16 windDirDeg = -1; /* Prevailing wind direction. Average of variable wind. */
+  qint8 flightRules = -1; /* MetarParser::FlightRules. -1 is unknown. */
+  bool valid = false;
+
+  bool isValid() const
+  {
+    return valid;
+  }
+
+};
+
 // ============================================================================
 // ============================================================================
 class MetarVisibility
@@ -497,6 +519,15 @@ public:
 
   float getPrevailingWindSpeedKnots() const;
 
+  /* Get compact decoded values for caching */
+  MetarSummary getSummary() const;
+
+  /* Lowest broken or overcast cloud layer or INVALID_METAR_VALUE if none */
+  float getCeilingMeter() const
+  {
+    return ceilingMeter;
+  }
+
   /* Thickest cloud coverage */
   MetarCloud::Coverage getMaxCoverage() const
   {
@@ -583,6 +614,7 @@ private:
   MetarCloud::Coverage lowestCoverage = MetarCloud::COVERAGE_CLEAR;
   int prevailingWindDir = -1;
   float prevailingWindSpeed = INVALID_METAR_VALUE;
+  float ceilingMeter = INVALID_METAR_VALUE;
 
   MetarVisibility _min_visibility;
   MetarVisibility _max_visibility;
@@ -19,7 +19,7 @@
 
 #include "fs/weather/metarindex.h"
 #include "util/httpdownloader.h"
-#include "zip/gzip.h"
+#include "zip/gzipdevice.h"
 
 namespace atools {
 namespace fs {
@@ -77,8 +77,23 @@ bool NoaaWeatherDownloader::isDownloading() const
 
 bool NoaaWeatherDownloader::read(const QByteArray& data, const QString& url)
 {
-  QTextStream stream(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO));
-  return metarIndex->read(stream, url, true /* merge */) > 0;
+  // Decompress while reading if needed
+  atools::zip::GzipDevice device(data);
+  if(!device.open(QIODevice::ReadOnly))
+    return false;
+
+  QTextStream stream(&device);
+
+  // Do not merge partial data from truncated or corrupt downloads
+  auto readValid = [&device]() -> bool {
+                     return !device.hasError();
+                   };
+  int numRead = metarIndex->read(stream, url, true /* merge */, readValid);
+
+  if(device.hasError())
+    qWarning() << Q_FUNC_INFO << "Error decompressing" << url << device.errorString();
+
+  return numRead > 0;
 }
 
 void NoaaWeatherDownloader::downloadFinished(const QByteArray& data, QString url)
@@ -19,7 +19,7 @@
 
 #include "util/httpdownloader.h"
 #include "fs/weather/metarindex.h"
-#include "zip/gzip.h"
+#include "zip/gzipdevice.h"
 
 namespace atools {
 namespace fs {
@@ -43,8 +43,25 @@ void WeatherNetDownload::downloadFinished(const QByteArray& data, QString url)
   // AGGH 161200Z 14002KT 9999 FEW016 25/24 Q1010
   // AYNZ 160800Z 09005G10KT 9999 SCT030 BKN ABV050 27/24 Q1007 RMK
   // AYPY 160700Z 28010KT 9999 SCT025 OVC050 28/23 Q1008 RMK/ BUILD UPS TO S/W
-  QTextStream stream(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), QIODevice::ReadOnly | QIODevice::Text);
-  metarIndex->read(stream, downloader->getUrl(), false /* merge */);
+  // Decompress while reading if needed
+  atools::zip::GzipDevice device(data);
+  if(device.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    QTextStream stream(&device);
+
+    // Keep the previous METARs if the download is truncated or corrupt
+    auto readValid = [&device]() -> bool {
+                       return !device.hasError();
+                     };
+    metarIndex->read(stream, downloader->getUrl(), false /* merge */, readValid);
+  }
+
+  if(device.hasError())
+  {
+    qWarning() << Q_FUNC_INFO << "Error decompressing" << url << device.errorString();
+    emit weatherDownloadFailed(tr("Cannot decompress METAR download: %1").arg(device.errorString()), 0, url);
+    return;
+  }
 
   if(verbose)
     qDebug() << Q_FUNC_INFO << "Loaded" << data.size() << "bytes and" << metarIndex->size()
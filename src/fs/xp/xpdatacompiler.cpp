@@ -411,7 +411,7 @@ bool XpDataCompiler::compileUserFix()
 
 bool XpDataCompiler::compileMagDeclBgl()
 {
-  magDecReader->readFromWmm();
+  magDecReader->readFromWmm(QDate::currentDate(), options.getMagDecCellsPerDegree());
   magDecReader->writeToTable(db);
   db.commit();
   return false;
@@ -22,7 +22,6 @@
 #include "gribreader.h"
 #include "exception.h"
 #include "atools.h"
-#include "zip/gzip.h"
 
 #include <QCoreApplication>
 #include <QDir>
@@ -140,7 +139,7 @@ void GribDownloader::downloadFinished(const QByteArray& data, QString downloadUr
   {
     // Decode and copy the data
     GribReader reader(verbose);
-    reader.readData(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO));
+    reader.readData(data);
     datasets = reader.getDatasets();
   }
   catch(atools::Exception& e)
@@ -19,12 +19,14 @@
 #include "geo/calculations.h"
 #include "io/tempfile.h"
 #include "exception.h"
+#include "zip/gzipdevice.h"
 
 extern "C" {
 #include "g2clib/grib2.h"
 }
 
 #include <QCoreApplication>
+#include <QBuffer>
 #include <QDataStream>
 #include <QDebug>
 #include <QDir>
@@ -468,14 +470,31 @@ void GribReader::readFile(const QString& filename)
 
 void GribReader::readData(const QByteArray& data)
 {
-  if(data.isEmpty())
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+  readData(&buffer);
+}
+
+void GribReader::readData(QIODevice *device)
+{
+  // Decompress while copying if needed
+  atools::zip::GzipDevice gzipDevice(device);
+  if(!gzipDevice.open(QIODevice::ReadOnly))
+    throw atools::Exception(tr("Cannot read GRIB data"));
+
+  // Check header without consuming bytes
+  QByteArray header = gzipDevice.peek(8);
+  if(header.isEmpty())
     throw atools::Exception(tr("GRIB data empty"));
 
-  if(!validateGribData(data))
+  if(!validateGribData(header))
     throw atools::Exception(tr("Not a GRIB file"));
 
   // Create a temporary file since the GRIB reader can only deal with files
-  atools::io::TempFile temp(data, ".grib");
+  atools::io::TempFile temp(&gzipDevice, ".grib");
+  if(gzipDevice.hasError())
+    throw atools::Exception(tr("Cannot read GRIB data. Reason: %1").arg(gzipDevice.errorString()));
 
   datasets.clear();
   readFile(temp.getFilePath());
@@ -23,6 +23,8 @@
 #include <QVector>
 #include <QCoreApplication>
 
+class QIODevice;
+
 namespace atools {
 namespace grib {
 
@@ -41,10 +43,12 @@ class GribReader
 public:
   GribReader(bool verboseParam = false);
 
-  /* Reads a GRIB dataset from a file or byte array.
+  /* Reads a GRIB dataset from a file, byte array or open device.
+   * Byte array and device data can be Gzip compressed and is decompressed while copying to a temporary file.
    * Throws atools::Exception if parameters are not correct. */
   void readFile(const QString& filename);
   void readData(const QByteArray& data);
+  void readData(QIODevice *device);
 
   /* Clear dataset for reuse */
   void clear();
@@ -5,6 +5,7 @@
 
 #include "httpconnectionhandler.h"
 #include "httpresponse.h"
+#include "httpeventstream.h"
 
 using namespace stefanfrings;
 
@@ -17,6 +18,7 @@ HttpConnectionHandler::HttpConnectionHandler(QHash<QString, QVariant> settings,
   this->requestHandler = requestHandler;
   this->sslConfiguration = sslConfiguration;
   currentRequest = nullptr;
+  eventSubscriber = nullptr;
   busy = false;
 
   // execute signals in a new thread
@@ -43,6 +45,8 @@ HttpConnectionHandler::HttpConnectionHandler(QHash<QString, QVariant> settings,
 void HttpConnectionHandler::thread_done()
 {
   readTimer.stop();
+  delete eventSubscriber;
+  eventSubscriber = nullptr;
   socket->close();
   delete socket;
   qDebug("HttpConnectionHandler (%p): thread stopped", static_cast<void *>(this));
@@ -137,11 +141,25 @@ void HttpConnectionHandler::disconnected()
   qDebug("HttpConnectionHandler (%p): disconnected", static_cast<void *>(this));
   socket->close();
   readTimer.stop();
+
+  // Might be called from within the subscriber if it closes the connection
+  if(eventSubscriber != nullptr)
+  {
+    eventSubscriber->deleteLater();
+    eventSubscriber = nullptr;
+  }
   busy = false;
 }
 
 void HttpConnectionHandler::read()
 {
+  if(eventSubscriber != nullptr)
+  {
+    // Event stream clients do not send further requests
+    socket->readAll();
+    return;
+  }
+
   // The loop adds support for HTTP pipelinig
   while(socket->bytesAvailable())
   {
@@ -218,6 +236,17 @@ void HttpConnectionHandler::read()
                   static_cast<void *>(this));
       }
 
+      // Keep the connection open for server-sent events - no read timeout and no further requests
+      eventSubscriber = response.takeEventSubscriber();
+      if(eventSubscriber != nullptr)
+      {
+        response.flush();
+        eventSubscriber->attach(socket);
+        delete currentRequest;
+        currentRequest = nullptr;
+        return;
+      }
+
       // Finalize sending the response if not already done
       if(!response.hasSentLastPart())
       {
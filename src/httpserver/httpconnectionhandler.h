@@ -18,6 +18,8 @@
 
 namespace stefanfrings {
 
+class HttpEventSubscriber;
+
 /** Alias type definition, for compatibility to different Qt versions */
 #if QT_VERSION >= 0x050000
 typedef qintptr tSocketDescriptor;
@@ -86,6 +88,9 @@ private:
   /** Storage for the current incoming HTTP request */
   HttpRequest *currentRequest;
 
+  /** Not null if the connection was turned into a server-sent event stream */
+  HttpEventSubscriber *eventSubscriber;
+
   /** Dispatches received requests to services */
   HttpRequestHandler *requestHandler;
 
@@ -15,8 +15,7 @@ HttpConnectionHandlerPool::HttpConnectionHandlerPool(QHash<QString, QVariant> se
 {
   this->settings = settings;
   this->requestHandler = requestHandler;
-  this->sslConfiguration = NULL;
-  loadSslConfig();
+  this->sslConfiguration = loadSslConfig(settings);
   cleanupTimer.start(settings.value("cleanupInterval", 1000).toInt());
   connect(&cleanupTimer, SIGNAL(timeout()), SLOT(cleanup()));
 }
@@ -82,7 +81,7 @@ void HttpConnectionHandlerPool::cleanup()
   mutex.unlock();
 }
 
-void HttpConnectionHandlerPool::loadSslConfig()
+QSslConfiguration *HttpConnectionHandlerPool::loadSslConfig(const QHash<QString, QVariant>& settings)
 {
   // If certificate and key files are configured, then load them
   QString sslKeyFileName = settings.value("sslKeyFile", "").toString();
@@ -108,7 +107,7 @@ void HttpConnectionHandlerPool::loadSslConfig()
     if(!certFile.open(QIODevice::ReadOnly))
     {
       qCritical("HttpConnectionHandlerPool: cannot open sslCertFile %s", qPrintable(sslCertFileName));
-      return;
+      return nullptr;
     }
     QSslCertificate certificate(&certFile, QSsl::Pem);
     certFile.close();
@@ -118,13 +117,13 @@ void HttpConnectionHandlerPool::loadSslConfig()
     if(!keyFile.open(QIODevice::ReadOnly))
     {
       qCritical("HttpConnectionHandlerPool: cannot open sslKeyFile %s", qPrintable(sslKeyFileName));
-      return;
+      return nullptr;
     }
     QSslKey sslKey(&keyFile, QSsl::Rsa, QSsl::Pem);
     keyFile.close();
 
     // Create the SSL configuration
-    sslConfiguration = new QSslConfiguration();
+    QSslConfiguration *sslConfiguration = new QSslConfiguration();
     sslConfiguration->setLocalCertificate(certificate);
     sslConfiguration->setPrivateKey(sslKey);
     sslConfiguration->setPeerVerifyMode(QSslSocket::VerifyNone);
@@ -134,6 +133,8 @@ void HttpConnectionHandlerPool::loadSslConfig()
     sslConfiguration->setProtocol(QSsl::TlsV1SslV3);
 #endif
     qDebug("HttpConnectionHandlerPool: SSL settings loaded");
+    return sslConfiguration;
          #endif
   }
+  return nullptr;
 }
@@ -66,6 +66,12 @@ public:
   /** Get a free connection handler, or 0 if not available. */
   HttpConnectionHandler *getConnectionHandler();
 
+  /**
+   *  Load SSL configuration from the settings sslKeyFile and sslCertFile.
+   *  @return new configuration owned by the caller or null if SSL is not configured or files cannot be loaded.
+   */
+  static QSslConfiguration *loadSslConfig(const QHash<QString, QVariant>& settings);
+
 private:
   /** Settings for this pool */
   QHash<QString, QVariant> settings;
@@ -85,9 +91,6 @@ private:
   /** The SSL configuration (certificate, key and other settings) */
   QSslConfiguration *sslConfiguration;
 
-  /** Load SSL configuration */
-  void loadSslConfig();
-
 private slots:
   /** Received from the clean-up timer.  */
   void cleanup();
@@ -0,0 +1,534 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "httpeventlooppool.h"
+#include "httpconnectionhandlerpool.h"
+#include "httprequest.h"
+#include "httpresponse.h"
+#include "httpeventstream.h"
+
+#include <QMutex>
+#include <QRunnable>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <algorithm>
+#ifndef QT_NO_OPENSSL
+    #include <QSslSocket>
+#endif
+
+/** Worker waits if this number of bytes is passed to the event loop but not sent yet */
+static const qint64 MAX_PENDING_OUTPUT = 262144;
+
+namespace stefanfrings {
+
+/** Shared by a worker sending a response in parts and the event loop which writes the parts to the socket */
+struct HttpEventLoopOutput
+{
+  QMutex mutex;
+  QWaitCondition condition;
+
+  /** Bytes passed to the event loop and not yet written to the socket */
+  qint64 queuedBytes = 0;
+
+  /** Bytes in the write buffer of the socket */
+  qint64 socketBytes = 0;
+
+  /** Client disconnected */
+  bool closed = false;
+};
+
+/** Calls the request handler in a worker thread and passes the buffered response back to the event loop */
+class HttpEventLoopTask :
+  public QRunnable, public HttpResponseWriter
+{
+public:
+  HttpEventLoopTask(HttpEventLoop *loopParam, quint64 idParam, HttpRequest *requestParam)
+    : loop(loopParam), id(idParam), request(requestParam), output(new HttpEventLoopOutput)
+  {
+  }
+
+  virtual ~HttpEventLoopTask() override
+  {
+    delete request;
+  }
+
+  virtual void run() override;
+
+  /** Passes a part of a large response to the event loop and waits until most of it is sent */
+  virtual bool writeBuffer(const QByteArray& data) override;
+
+private:
+  HttpEventLoop *loop;
+  quint64 id;
+  HttpRequest *request;
+  QSharedPointer<HttpEventLoopOutput> output;
+};
+
+} // end of namespace
+
+using namespace stefanfrings;
+
+void HttpEventLoopTask::run()
+{
+  QByteArray buffer;
+  HttpResponse response(&buffer, this);
+
+  // Copy the Connection:close header to the response
+  bool closeConnection = QString::compare(request->getHeader("Connection"), "close", Qt::CaseInsensitive) == 0;
+
+  // In case of HTTP 1.0 protocol add the Connection:close header.
+  // This ensures that the HttpResponse does not activate chunked mode, which is not spported by HTTP 1.0.
+  if(!closeConnection)
+    closeConnection = QString::compare(request->getVersion(), "HTTP/1.0", Qt::CaseInsensitive) == 0;
+
+  if(closeConnection)
+    response.setHeader("Connection", "close");
+
+  // Call the request mapper
+  try
+  {
+    loop->requestHandler->service(*request, response);
+  }
+  catch(...)
+  {
+    qCritical("HttpEventLoopTask: An uncatched exception occured in the request handler");
+  }
+
+  // Event streams are kept open - pass the subscriber to the event loop thread which owns the socket
+  HttpEventSubscriber *eventSubscriber = response.takeEventSubscriber();
+  if(eventSubscriber != nullptr)
+    eventSubscriber->moveToThread(loop->thread());
+  else if(!response.hasSentLastPart())
+    // Finalize the response if not already done
+    response.write(QByteArray(), true);
+
+  if(!closeConnection && eventSubscriber == nullptr)
+  {
+    // Maybe the request handler added a Connection:close header in the meantime. Responses without
+    // Content-Length header and without chunked mode have to close the connection to indicate the end too.
+    QMap<QByteArray, QByteArray>& headers = response.getHeaders();
+    closeConnection =
+      QString::compare(headers.value("Connection"), "close", Qt::CaseInsensitive) == 0 ||
+      (!headers.contains("Content-Length") &&
+       QString::compare(headers.value("Transfer-Encoding"), "chunked", Qt::CaseInsensitive) != 0);
+  }
+
+  // Pass response to the event loop thread which owns the socket
+  HttpEventLoop *eventLoop = loop;
+  quint64 connectionId = id;
+  QMetaObject::invokeMethod(eventLoop, [eventLoop, connectionId, buffer, closeConnection, eventSubscriber]() {
+    eventLoop->responseReady(connectionId, buffer, closeConnection, eventSubscriber);
+  }, Qt::QueuedConnection);
+}
+
+bool HttpEventLoopTask::writeBuffer(const QByteArray& data)
+{
+  {
+    QMutexLocker locker(&output->mutex);
+    if(output->closed)
+      return false;
+    output->queuedBytes += data.size();
+  }
+
+  // Parts and the final response are queued to the same object and keep their order
+  HttpEventLoop *eventLoop = loop;
+  quint64 connectionId = id;
+  QSharedPointer<HttpEventLoopOutput> eventLoopOutput = output;
+  QMetaObject::invokeMethod(eventLoop, [eventLoop, connectionId, data, eventLoopOutput]() {
+    eventLoop->responsePart(connectionId, data, eventLoopOutput);
+  }, Qt::QueuedConnection);
+
+  // Limit memory usage for slow clients
+  QMutexLocker locker(&output->mutex);
+  while(!output->closed && output->queuedBytes + output->socketBytes > MAX_PENDING_OUTPUT)
+    output->condition.wait(&output->mutex);
+  return !output->closed;
+}
+
+// ==================================================================================================
+HttpEventLoop::HttpEventLoop(const QHash<QString, QVariant>& settings, HttpRequestHandler *requestHandler,
+                             QThreadPool *workerPool, const QSslConfiguration *sslConfiguration)
+  : QObject(), idleTimer(this), numConnections(0)
+{
+  Q_ASSERT(requestHandler != nullptr);
+  Q_ASSERT(workerPool != nullptr);
+  this->settings = settings;
+  this->requestHandler = requestHandler;
+  this->workerPool = workerPool;
+  this->sslConfiguration = sslConfiguration;
+
+  readTimeout = settings.value("readTimeout", 10000).toInt();
+  clock.start();
+
+  // Check often enough to keep the timeout reasonably accurate
+  idleTimer.setInterval(std::max(100, std::min(1000, readTimeout / 4)));
+  connect(&idleTimer, &QTimer::timeout, this, &HttpEventLoop::closeIdleConnections);
+}
+
+HttpEventLoop::~HttpEventLoop()
+{
+  // Sockets are children and deleted automatically
+  for(const Connection& connection : qAsConst(connections))
+  {
+    delete connection.request;
+    delete connection.eventSubscriber;
+  }
+  qDebug("HttpEventLoop (%p): destroyed", static_cast<void *>(this));
+}
+
+void HttpEventLoop::addConnection(tSocketDescriptor socketDescriptor)
+{
+  // Count immediately to allow the pool to balance bursts of connections
+  numConnections++;
+
+  // The descriptor is passed via event queue because the loop lives in another thread
+  QMetaObject::invokeMethod(this, "handleConnection", Qt::QueuedConnection, Q_ARG(tSocketDescriptor, socketDescriptor));
+}
+
+QTcpSocket *HttpEventLoop::createSocket()
+{
+  // If SSL is supported and configured, then create an instance of QSslSocket
+#ifndef QT_NO_OPENSSL
+  if(sslConfiguration)
+  {
+    QSslSocket *sslSocket = new QSslSocket(this);
+    sslSocket->setSslConfiguration(*sslConfiguration);
+    return sslSocket;
+  }
+#endif
+  // else create an instance of QTcpSocket
+  return new QTcpSocket(this);
+}
+
+void HttpEventLoop::handleConnection(const tSocketDescriptor socketDescriptor)
+{
+  QTcpSocket *socket = createSocket();
+  if(!socket->setSocketDescriptor(socketDescriptor))
+  {
+    qCritical("HttpEventLoop (%p): cannot initialize socket: %s",
+              static_cast<void *>(this), qPrintable(socket->errorString()));
+    delete socket;
+    numConnections--;
+    return;
+  }
+
+#ifndef QT_NO_OPENSSL
+  // Switch on encryption, if SSL is configured
+  if(sslConfiguration)
+    (static_cast<QSslSocket *>(socket))->startServerEncryption();
+#endif
+
+  quint64 id = nextConnectionId++;
+  Connection connection;
+  connection.socket = socket;
+  connection.lastActivityMs = clock.elapsed();
+  connections.insert(id, connection);
+
+  connect(socket, &QTcpSocket::readyRead, this, [this, id]() {
+    read(id);
+  });
+
+  connect(socket, &QTcpSocket::bytesWritten, this, [this, id]() {
+    bytesWritten(id);
+  });
+
+  // Queued to avoid removing the connection while it is used in read() or responseReady()
+  connect(socket, &QTcpSocket::disconnected, this, [this, id]() {
+    disconnected(id);
+  }, Qt::QueuedConnection);
+
+  if(!idleTimer.isActive())
+    idleTimer.start();
+
+  // Data might have arrived before the signals were connected
+  if(socket->bytesAvailable() > 0)
+    read(id);
+}
+
+void HttpEventLoop::read(quint64 id)
+{
+  auto it = connections.find(id);
+  if(it == connections.end())
+    return;
+
+  Connection& connection = it.value();
+  QTcpSocket *socket = connection.socket;
+
+  if(connection.eventSubscriber != nullptr)
+  {
+    // Event stream clients do not send further requests
+    socket->readAll();
+    return;
+  }
+
+  // The loop adds support for HTTP pipelining. Reading stops while a request is processed to keep the order of responses.
+  while(!connection.busy && socket->bytesAvailable())
+  {
+    connection.lastActivityMs = clock.elapsed();
+
+    // Create new HttpRequest object if necessary
+    if(connection.request == nullptr)
+      connection.request = new HttpRequest(settings);
+
+    // Collect available data for the request object - does not block
+    while(socket->bytesAvailable() && connection.request->getStatus() != HttpRequest::complete &&
+          connection.request->getStatus() != HttpRequest::abort)
+      connection.request->readFromSocket(socket);
+
+    // If the request is aborted, return error message and close the connection
+    if(connection.request->getStatus() == HttpRequest::abort)
+    {
+      socket->write("HTTP/1.1 413 entity too large\r\nConnection: close\r\n\r\n413 Entity too large\r\n");
+
+      // Closes after all pending data is written
+      socket->disconnectFromHost();
+      delete connection.request;
+      connection.request = nullptr;
+      connection.busy = true;
+      return;
+    }
+
+    // If the request is complete, pass it to a worker. The task takes ownership of the request.
+    if(connection.request->getStatus() == HttpRequest::complete)
+    {
+      connection.busy = true;
+      workerPool->start(new HttpEventLoopTask(this, id, connection.request));
+      connection.request = nullptr;
+    }
+  }
+}
+
+void HttpEventLoop::responseReady(quint64 id, const QByteArray& response, bool closeConnection,
+                                  HttpEventSubscriber *eventSubscriber)
+{
+  auto it = connections.find(id);
+  if(it == connections.end())
+  {
+    // Client disconnected while the request was processed
+    delete eventSubscriber;
+    return;
+  }
+
+  Connection& connection = it.value();
+  connection.socket->write(response);
+  connection.lastActivityMs = clock.elapsed();
+
+  // Worker is done
+  connection.output.reset();
+
+  if(eventSubscriber != nullptr)
+  {
+    // Keep busy to stop reading - connection stays open until the client disconnects
+    connection.eventSubscriber = eventSubscriber;
+    eventSubscriber->attach(connection.socket);
+    return;
+  }
+
+  if(closeConnection)
+    // Keep busy to stop reading and close after all pending data is written
+    connection.socket->disconnectFromHost();
+  else
+  {
+    connection.busy = false;
+
+    // Continue with pipelined requests
+    if(connection.socket->bytesAvailable() > 0)
+      read(id);
+  }
+}
+
+void HttpEventLoop::responsePart(quint64 id, const QByteArray& part,
+                                 const QSharedPointer<HttpEventLoopOutput>& output)
+{
+  auto it = connections.find(id);
+
+  QMutexLocker locker(&output->mutex);
+  output->queuedBytes -= part.size();
+  if(it == connections.end())
+    // Client disconnected while the request was processed
+    output->closed = true;
+  else
+  {
+    Connection& connection = it.value();
+    connection.output = output;
+    connection.socket->write(part);
+    connection.lastActivityMs = clock.elapsed();
+    output->socketBytes = connection.socket->bytesToWrite();
+  }
+  output->condition.wakeAll();
+}
+
+void HttpEventLoop::bytesWritten(quint64 id)
+{
+  auto it = connections.find(id);
+  if(it == connections.end())
+    return;
+
+  Connection& connection = it.value();
+  connection.lastActivityMs = clock.elapsed();
+  if(!connection.output.isNull())
+  {
+    QMutexLocker locker(&connection.output->mutex);
+    connection.output->socketBytes = connection.socket->bytesToWrite();
+    connection.output->condition.wakeAll();
+  }
+}
+
+void HttpEventLoop::closeOutput(Connection& connection)
+{
+  if(!connection.output.isNull())
+  {
+    QMutexLocker locker(&connection.output->mutex);
+    connection.output->closed = true;
+    connection.output->condition.wakeAll();
+  }
+  connection.output.reset();
+}
+
+void HttpEventLoop::disconnected(quint64 id)
+{
+  auto it = connections.find(id);
+  if(it == connections.end())
+    return;
+
+  closeOutput(it.value());
+  delete it.value().request;
+  if(it.value().eventSubscriber != nullptr)
+    // Might be called from within the subscriber if it closes the connection
+    it.value().eventSubscriber->deleteLater();
+  it.value().socket->deleteLater();
+  connections.erase(it);
+  numConnections--;
+
+  if(connections.isEmpty())
+    idleTimer.stop();
+}
+
+void HttpEventLoop::closeIdleConnections()
+{
+  qint64 now = clock.elapsed();
+  for(Connection& connection : connections)
+  {
+    // Event streams are kept open
+    if(connection.eventSubscriber == nullptr && now - connection.lastActivityMs > readTimeout)
+    {
+      if(connection.socket->state() == QAbstractSocket::ClosingState || !connection.output.isNull())
+        // Client does not read the remaining data - disconnected() is called later through the queue
+        // and stops a worker which is still sending parts of the response
+        connection.socket->abort();
+      else if(!connection.busy)
+      {
+        // Wait one more timeout for pending data before aborting
+        qDebug("HttpEventLoop (%p): read timeout occured", static_cast<void *>(this));
+        connection.busy = true;
+        connection.lastActivityMs = now;
+        connection.socket->disconnectFromHost();
+      }
+    }
+  }
+}
+
+void HttpEventLoop::shutdown()
+{
+  idleTimer.stop();
+
+  QHash<quint64, Connection> closing;
+  closing.swap(connections);
+  for(Connection& connection : closing)
+  {
+    // Workers still sending parts get closed by responsePart() if they are not waiting yet
+    closeOutput(connection);
+    delete connection.request;
+    delete connection.eventSubscriber;
+    connection.socket->abort();
+    delete connection.socket;
+  }
+  numConnections = 0;
+  qDebug("HttpEventLoop (%p): shut down", static_cast<void *>(this));
+}
+
+// ==================================================================================================
+HttpEventLoopPool::HttpEventLoopPool(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler)
+  : QObject()
+{
+  this->settings = settings;
+  this->requestHandler = requestHandler;
+  this->sslConfiguration = HttpConnectionHandlerPool::loadSslConfig(settings);
+  maxConnections = settings.value("maxConnections", 1000).toInt();
+
+  int numWorkers = settings.value("workerThreads", 0).toInt();
+  workerPool.setMaxThreadCount(numWorkers > 0 ? numWorkers : QThread::idealThreadCount());
+
+  int numLoops = std::max(1, settings.value("eventLoopThreads", 1).toInt());
+  for(int i = 0; i < numLoops; i++)
+  {
+    QThread *thread = new QThread();
+    HttpEventLoop *loop = new HttpEventLoop(settings, requestHandler, &workerPool, sslConfiguration);
+    loop->moveToThread(thread);
+    thread->start();
+    threads.append(thread);
+    loops.append(loop);
+  }
+
+  qDebug("HttpEventLoopPool (%p): started %i event loops and %i workers", static_cast<void *>(this),
+         numLoops, workerPool.maxThreadCount());
+}
+
+HttpEventLoopPool::~HttpEventLoopPool()
+{
+  // Close all connections first to stop dispatching of new requests
+  for(HttpEventLoop *loop : qAsConst(loops))
+    QMetaObject::invokeMethod(loop, "shutdown", Qt::BlockingQueuedConnection);
+
+  // Wait for running request handlers - the results are dropped since the connections are gone
+  workerPool.waitForDone();
+
+  for(int i = 0; i < loops.size(); i++)
+  {
+    threads.at(i)->quit();
+    threads.at(i)->wait();
+    delete loops.at(i);
+    delete threads.at(i);
+  }
+
+  delete sslConfiguration;
+  qDebug("HttpEventLoopPool (%p): destroyed", static_cast<void *>(this));
+}
+
+bool HttpEventLoopPool::handleConnection(tSocketDescriptor socketDescriptor)
+{
+  // Find the event loop with the least connections
+  HttpEventLoop *freeLoop = nullptr;
+  int minConnections = 0, totalConnections = 0;
+  for(HttpEventLoop *loop : qAsConst(loops))
+  {
+    int numConnections = loop->getNumConnections();
+    totalConnections += numConnections;
+    if(freeLoop == nullptr || numConnections < minConnections)
+    {
+      freeLoop = loop;
+      minConnections = numConnections;
+    }
+  }
+
+  if(freeLoop == nullptr || totalConnections >= maxConnections)
+    return false;
+
+  freeLoop->addConnection(socketDescriptor);
+  return true;
+}
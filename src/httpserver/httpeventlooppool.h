@@ -0,0 +1,231 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef HTTPEVENTLOOPPOOL_H
+#define HTTPEVENTLOOPPOOL_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include "httpglobal.h"
+#include "httpconnectionhandler.h"
+#include "httprequesthandler.h"
+
+#include <atomic>
+
+class QThread;
+
+namespace stefanfrings {
+
+class HttpRequest;
+class HttpEventLoopTask;
+class HttpEventSubscriber;
+struct HttpEventLoopOutput;
+
+/**
+ *  Serves many connections in one thread using non-blocking sockets.
+ *  <p>
+ *  Incoming data is parsed in the event loop thread. Complete requests are passed to a shared worker
+ *  pool where the request handler creates a buffered response. The response is handed back to the event loop
+ *  which writes it without blocking. Large responses are handed back in parts while the worker waits until the
+ *  socket has sent most of the previous parts. Connections are kept alive and pipelined requests are processed
+ *  one after the other so responses keep their order.
+ *  <p>
+ *  Idle connections are closed after readTimeout milliseconds.
+ *  @see HttpEventLoopPool
+ */
+class DECLSPEC HttpEventLoop :
+  public QObject
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(HttpEventLoop)
+
+  friend class HttpEventLoopTask;
+
+public:
+  /**
+   *  Constructor.
+   *  @param settings Configuration settings of the HTTP webserver
+   *  @param requestHandler Handler that will process each incoming HTTP request
+   *  @param workerPool Thread pool where the request handler is called
+   *  @param sslConfiguration SSL (HTTPS) will be used if not NULL
+   */
+  HttpEventLoop(const QHash<QString, QVariant>& settings, HttpRequestHandler *requestHandler,
+                QThreadPool *workerPool, const QSslConfiguration *sslConfiguration = nullptr);
+
+  /** Destructor */
+  virtual ~HttpEventLoop() override;
+
+  /**
+   *  Pass a new connection to this event loop. Can be called from any thread.
+   *  @param socketDescriptor references the accepted connection.
+   */
+  void addConnection(tSocketDescriptor socketDescriptor);
+
+  /** Number of open and pending connections. Thread safe. */
+  int getNumConnections() const
+  {
+    return numConnections.load();
+  }
+
+public slots:
+  /** Close all connections and stop the idle timer. Has to be called in the event loop thread before it stops. */
+  void shutdown();
+
+private slots:
+  /** Start processing a new connection in the event loop thread */
+  void handleConnection(const tSocketDescriptor socketDescriptor);
+
+private:
+  /** State of one client connection */
+  struct Connection
+  {
+    QTcpSocket *socket = nullptr;
+
+    /** Request which is currently read from the socket */
+    HttpRequest *request = nullptr;
+
+    /** Time of last read or write from clock */
+    qint64 lastActivityMs = 0L;
+
+    /** A request is processed by a worker. Reading is suspended until the response arrives. */
+    bool busy = false;
+
+    /** Not null if the connection was turned into a server-sent event stream */
+    HttpEventSubscriber *eventSubscriber = nullptr;
+
+    /** Flow control for the worker while it sends a response in parts */
+    QSharedPointer<HttpEventLoopOutput> output;
+  };
+
+  /** Read available data and dispatch complete requests */
+  void read(quint64 id);
+
+  /**
+   *  Called in the event loop thread when a worker has finished a request.
+   *  eventSubscriber is not null if the response is an event stream which keeps the connection open.
+   */
+  void responseReady(quint64 id, const QByteArray& response, bool closeConnection,
+                     HttpEventSubscriber *eventSubscriber);
+
+  /** Called in the event loop thread for each part of a large response before responseReady() */
+  void responsePart(quint64 id, const QByteArray& part, const QSharedPointer<HttpEventLoopOutput>& output);
+
+  /** Socket has sent data. Lets a waiting worker continue. */
+  void bytesWritten(quint64 id);
+
+  /** Stop a worker which is sending a response in parts to this connection */
+  void closeOutput(Connection& connection);
+
+  /** Remove connection and free resources */
+  void disconnected(quint64 id);
+
+  /** Close connections without activity. Called by idleTimer. */
+  void closeIdleConnections();
+
+  /** Create SSL or TCP socket */
+  QTcpSocket *createSocket();
+
+  /** Configuration settings */
+  QHash<QString, QVariant> settings;
+
+  /** Dispatches received requests to services */
+  HttpRequestHandler *requestHandler;
+
+  /** Runs the request handler */
+  QThreadPool *workerPool;
+
+  /** Configuration for SSL */
+  const QSslConfiguration *sslConfiguration;
+
+  /** Open connections by id. Ids are never reused so late worker results for closed connections are dropped. */
+  QHash<quint64, Connection> connections;
+  quint64 nextConnectionId = 1L;
+
+  /** Checks idle connections periodically */
+  QTimer idleTimer;
+  QElapsedTimer clock;
+  int readTimeout;
+
+  std::atomic_int numConnections;
+};
+
+/**
+ *  Alternative to HttpConnectionHandlerPool which does not need a thread per connection.
+ *  <p>
+ *  Creates a small number of HttpEventLoop threads which share a bounded worker pool for the request handler.
+ *  New connections are passed to the event loop with the least connections.
+ *  <p>
+ *  Example for the required configuration settings:
+ *  <code><pre>
+ *  eventLoopThreads=2
+ *  workerThreads=4
+ *  maxConnections=1000
+ *  readTimeout=60000
+ *  </pre></code>
+ *  The number of worker threads defaults to the number of CPU cores.
+ *  SSL is configured like in HttpConnectionHandlerPool.
+ *  @see HttpListener which uses this pool if eventLoopThreads is greater than zero
+ */
+class DECLSPEC HttpEventLoopPool :
+  public QObject
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(HttpEventLoopPool)
+
+public:
+  /**
+   *  Constructor. Starts all event loop threads.
+   *  @param settings Configuration settings for the HTTP server.
+   *  @param requestHandler The handler that will process each received HTTP request.
+   */
+  HttpEventLoopPool(QHash<QString, QVariant> settings, HttpRequestHandler *requestHandler);
+
+  /** Destructor. Waits for running requests, closes all connections and stops the threads. */
+  virtual ~HttpEventLoopPool() override;
+
+  /**
+   *  Pass a new connection to the least loaded event loop.
+   *  @return false if the maximum number of connections is reached. Caller has to reject the connection.
+   */
+  bool handleConnection(tSocketDescriptor socketDescriptor);
+
+private:
+  /** Settings for this pool */
+  QHash<QString, QVariant> settings;
+
+  /** Will be assigned to each event loop */
+  HttpRequestHandler *requestHandler;
+
+  /** Shared by all event loops to call the request handler */
+  QThreadPool workerPool;
+
+  QVector<QThread *> threads;
+  QVector<HttpEventLoop *> loops;
+
+  /** The SSL configuration (certificate, key and other settings) */
+  QSslConfiguration *sslConfiguration;
+
+  int maxConnections;
+};
+
+} // end of namespace
+
+#endif // HTTPEVENTLOOPPOOL_H
@@ -0,0 +1,226 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "httpeventstream.h"
+
+#include <QTcpSocket>
+#include <QTimer>
+
+using namespace stefanfrings;
+
+/** Stop writing to the socket if this number of bytes is not sent yet */
+static const qint64 MAX_SOCKET_BUFFER = 65536;
+
+HttpEventStream::HttpEventStream(const QHash<QString, QVariant>& settings, QObject *parent)
+  : QObject(parent)
+{
+  maxSubscribers = settings.value("maxSubscribers", 100).toInt();
+  maxQueuedBytes = settings.value("maxQueuedBytes", 1000000).toLongLong();
+  keepAliveInterval = settings.value("keepAliveInterval", 15000).toInt();
+  qDebug("HttpEventStream (%p): maxSubscribers=%i, maxQueuedBytes=%lli", static_cast<void *>(this),
+         maxSubscribers, maxQueuedBytes);
+}
+
+HttpEventStream::~HttpEventStream()
+{
+  QMutexLocker locker(&mutex);
+  if(!subscribers.isEmpty())
+    qWarning("HttpEventStream (%p): destroyed with %i subscribers", static_cast<void *>(this),
+             static_cast<int>(subscribers.size()));
+
+  // Detach remaining subscribers
+  for(HttpEventSubscriber *subscriber : qAsConst(subscribers))
+    subscriber->stream = nullptr;
+}
+
+QByteArray HttpEventStream::formatEvent(const QByteArray& data, const QByteArray& event)
+{
+  QByteArray frame;
+  frame.reserve(data.size() + event.size() + 32);
+
+  if(!event.isEmpty())
+  {
+    frame.append("event: ");
+    frame.append(event);
+    frame.append('\n');
+  }
+
+  // Each line needs its own data field
+  int start = 0;
+  while(start <= data.size())
+  {
+    int end = data.indexOf('\n', start);
+    if(end < 0)
+      end = data.size();
+
+    frame.append("data: ");
+    frame.append(data.constData() + start, end - start);
+    frame.append('\n');
+    start = end + 1;
+  }
+
+  // Empty line dispatches the event
+  frame.append('\n');
+  return frame;
+}
+
+void HttpEventStream::publish(const QByteArray& data, const QByteArray& event)
+{
+  // Format once - all queues share the same buffer
+  QByteArray frame = formatEvent(data, event);
+
+  QMutexLocker locker(&mutex);
+  for(HttpEventSubscriber *subscriber : qAsConst(subscribers))
+    subscriber->enqueue(frame);
+}
+
+int HttpEventStream::getNumSubscribers() const
+{
+  QMutexLocker locker(&mutex);
+  return subscribers.size();
+}
+
+HttpEventSubscriber *HttpEventStream::subscribe(bool chunked)
+{
+  QMutexLocker locker(&mutex);
+  if(maxSubscribers > 0 && subscribers.size() >= maxSubscribers)
+  {
+    qWarning("HttpEventStream (%p): maximum of %i subscribers reached", static_cast<void *>(this), maxSubscribers);
+    return nullptr;
+  }
+
+  HttpEventSubscriber *subscriber = new HttpEventSubscriber(this, chunked);
+  subscribers.append(subscriber);
+  return subscriber;
+}
+
+void HttpEventStream::unsubscribe(HttpEventSubscriber *subscriber)
+{
+  QMutexLocker locker(&mutex);
+  subscribers.removeOne(subscriber);
+}
+
+// ==================================================================================================
+HttpEventSubscriber::HttpEventSubscriber(HttpEventStream *stream, bool chunked)
+  : QObject(), stream(stream), chunked(chunked), scheduled(false)
+{
+}
+
+HttpEventSubscriber::~HttpEventSubscriber()
+{
+  if(stream != nullptr)
+    stream->unsubscribe(this);
+}
+
+void HttpEventSubscriber::attach(QTcpSocket *socket)
+{
+  Q_ASSERT(thread() == socket->thread());
+  this->socket = socket;
+
+  // Continue writing when the client has read data
+  connect(socket, &QTcpSocket::bytesWritten, this, &HttpEventSubscriber::writePending);
+
+  if(stream != nullptr && stream->keepAliveInterval > 0)
+  {
+    keepAliveTimer = new QTimer(this);
+    connect(keepAliveTimer, &QTimer::timeout, this, &HttpEventSubscriber::keepAlive);
+    keepAliveTimer->start(stream->keepAliveInterval);
+  }
+
+  // Send everything published since subscribing
+  writePending();
+}
+
+void HttpEventSubscriber::enqueue(const QByteArray& frame)
+{
+  {
+    QMutexLocker locker(&mutex);
+    if(overflow)
+      return;
+
+    if(queuedBytes + frame.size() > stream->maxQueuedBytes)
+    {
+      // Client is too slow - drop everything and close connection in socket thread
+      overflow = true;
+      queue.clear();
+      queuedBytes = 0L;
+    }
+    else
+    {
+      queue.enqueue(frame);
+      queuedBytes += frame.size();
+    }
+  }
+
+  // Avoid flooding the event queue of the socket thread with calls
+  if(!scheduled.exchange(true))
+    QMetaObject::invokeMethod(this, [this]() {
+      writePending();
+    }, Qt::QueuedConnection);
+}
+
+void HttpEventSubscriber::writePending()
+{
+  scheduled.store(false);
+
+  if(socket == nullptr || socket->state() != QAbstractSocket::ConnectedState)
+    // Not attached yet or closing
+    return;
+
+  QMutexLocker locker(&mutex);
+  if(overflow)
+  {
+    locker.unlock();
+    qWarning("HttpEventSubscriber (%p): client too slow - closing connection", static_cast<void *>(this));
+
+    // Connection handler deletes this object later on disconnect
+    socket->abort();
+    return;
+  }
+
+  while(!queue.isEmpty() && socket->bytesToWrite() < MAX_SOCKET_BUFFER)
+  {
+    QByteArray frame = queue.dequeue();
+    queuedBytes -= frame.size();
+    writeFrame(frame);
+  }
+}
+
+void HttpEventSubscriber::keepAlive()
+{
+  if(socket == nullptr || socket->state() != QAbstractSocket::ConnectedState)
+    return;
+
+  // Send a comment line only if the connection was idle
+  if(!active && socket->bytesToWrite() == 0)
+    writeFrame(":\n\n");
+  active = false;
+}
+
+void HttpEventSubscriber::writeFrame(const QByteArray& frame)
+{
+  if(chunked)
+  {
+    socket->write(QByteArray::number(frame.size(), 16));
+    socket->write("\r\n");
+    socket->write(frame);
+    socket->write("\r\n");
+  }
+  else
+    socket->write(frame);
+  active = true;
+}
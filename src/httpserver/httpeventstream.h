@@ -0,0 +1,183 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef HTTPEVENTSTREAM_H
+#define HTTPEVENTSTREAM_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QVariant>
+#include <QVector>
+#include "httpglobal.h"
+
+#include <atomic>
+
+class QTcpSocket;
+class QTimer;
+
+namespace stefanfrings {
+
+class HttpEventSubscriber;
+
+/**
+ *  Publisher for server-sent events (content type text/event-stream).
+ *  <p>
+ *  A request handler subscribes a client by calling HttpResponse::startEventStream(). The connection
+ *  is kept open after the handler returns and all events passed to publish() are pushed to the client.
+ *  One producer can serve many subscribers since each event is formatted only once and the same buffer is
+ *  shared by all client queues.
+ *  <p>
+ *  Each subscriber has a bounded queue. If a client does not read fast enough and the queue exceeds
+ *  maxQueuedBytes, the connection is closed. Browsers reconnect automatically and should then request
+ *  a full update since delta messages were lost.
+ *  <p>
+ *  Example for the optional configuration settings:
+ *  <code><pre>
+ *  maxSubscribers=100
+ *  maxQueuedBytes=1000000
+ *  keepAliveInterval=15000
+ *  </pre></code>
+ *  A comment line is sent to idle clients every keepAliveInterval milliseconds to avoid timeouts in
+ *  proxies. Zero disables keep alive messages.
+ *  <p>
+ *  Example for a request handler sending a full state and then deltas:
+ *  <code><pre>
+ *   if(response.startEventStream(aircraftStream))
+ *     response.writeEvent(fullStateJson, "full");
+ *  </pre></code>
+ *  Deltas are sent from any thread by calling aircraftStream->publish(deltaJson, "delta").
+ *  <p>
+ *  @warning The stream has to outlive the HttpListener since open connections refer to it.
+ *  @see HttpResponse::startEventStream
+ */
+class DECLSPEC HttpEventStream :
+  public QObject
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(HttpEventStream)
+
+public:
+  /**
+   *  Constructor.
+   *  @param settings Configuration settings as shown above
+   *  @param parent Parent object
+   */
+  HttpEventStream(const QHash<QString, QVariant>& settings, QObject *parent = nullptr);
+
+  /** Destructor */
+  virtual ~HttpEventStream() override;
+
+  /**
+   *  Send an event to all subscribers. Does not block on slow clients. Thread safe.
+   *  @param data Event payload. Multiple lines are sent as multiple data fields.
+   *  @param event Optional event type which is used to dispatch to listeners in the browser
+   */
+  void publish(const QByteArray& data, const QByteArray& event = QByteArray());
+
+  /** Number of connected and pending subscribers. Thread safe. */
+  int getNumSubscribers() const;
+
+  /** Format an event according to the text/event-stream specification */
+  static QByteArray formatEvent(const QByteArray& data, const QByteArray& event = QByteArray());
+
+private:
+  friend class HttpEventSubscriber;
+  friend class HttpResponse;
+
+  /**
+   *  Register a new subscriber which queues all events from now on.
+   *  @param chunked Use chunked transfer encoding when writing to the socket
+   *  @return null if maxSubscribers is reached
+   */
+  HttpEventSubscriber *subscribe(bool chunked);
+
+  /** Called by the subscriber destructor */
+  void unsubscribe(HttpEventSubscriber *subscriber);
+
+  /** Used to synchronize threads */
+  mutable QMutex mutex;
+
+  QVector<HttpEventSubscriber *> subscribers;
+
+  int maxSubscribers, keepAliveInterval;
+  qint64 maxQueuedBytes;
+};
+
+/**
+ *  One client connection of a HttpEventStream.
+ *  <p>
+ *  Created by HttpResponse::startEventStream() and handed over to the connection handler which attaches
+ *  the socket once the response headers are written. Events published before are kept in the queue.
+ *  The connection handler deletes the subscriber when the client disconnects.
+ */
+class DECLSPEC HttpEventSubscriber :
+  public QObject
+{
+  Q_OBJECT
+  Q_DISABLE_COPY(HttpEventSubscriber)
+
+public:
+  /** Destructor. Removes the subscriber from the stream. Does not touch the socket. */
+  virtual ~HttpEventSubscriber() override;
+
+  /**
+   *  Start writing queued events to the socket. Has to be called in the thread of the socket and
+   *  the subscriber has to be moved to this thread before.
+   */
+  void attach(QTcpSocket *socket);
+
+private:
+  friend class HttpEventStream;
+
+  HttpEventSubscriber(HttpEventStream *stream, bool chunked);
+
+  /** Add a formatted event to the queue. Called by the stream from any thread. */
+  void enqueue(const QByteArray& frame);
+
+  /** Write queued events as long as the socket buffer is not full. Called in socket thread. */
+  void writePending();
+
+  /** Send a comment if nothing was sent in the meantime. Called by keepAliveTimer. */
+  void keepAlive();
+
+  void writeFrame(const QByteArray& frame);
+
+  HttpEventStream *stream;
+  QTcpSocket *socket = nullptr;
+  QTimer *keepAliveTimer = nullptr;
+  bool chunked;
+
+  /** Synchronizes queue access between publisher and socket thread */
+  QMutex mutex;
+  QQueue<QByteArray> queue;
+  qint64 queuedBytes = 0L;
+
+  /** Queue limit exceeded - connection will be closed */
+  bool overflow = false;
+
+  /** Data written since the last keep alive check */
+  bool active = false;
+
+  /** A call of writePending() is already queued */
+  std::atomic_bool scheduled;
+};
+
+} // end of namespace
+
+#endif // HTTPEVENTSTREAM_H
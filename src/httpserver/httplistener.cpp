@@ -15,6 +15,7 @@ HttpListener::HttpListener(QHash<QString, QVariant> settings, HttpRequestHandler
 {
   Q_ASSERT(requestHandler != nullptr);
   pool = nullptr;
+  eventLoopPool = nullptr;
   this->settings = settings;
   this->requestHandler = requestHandler;
   // Reqister type of socketDescriptor for signal/slot handling
@@ -31,7 +32,14 @@ HttpListener::~HttpListener()
 
 void HttpListener::listen()
 {
-  if(!pool)
+  if(settings.value("eventLoopThreads", 0).toInt() > 0)
+  {
+    if(!eventLoopPool)
+    {
+      eventLoopPool = new HttpEventLoopPool(settings, requestHandler);
+    }
+  }
+  else if(!pool)
   {
     pool = new HttpConnectionHandlerPool(settings, requestHandler);
   }
@@ -57,6 +65,11 @@ void HttpListener::close()
     delete pool;
     pool = nullptr;
   }
+  if(eventLoopPool)
+  {
+    delete eventLoopPool;
+    eventLoopPool = nullptr;
+  }
 }
 
 void HttpListener::incomingConnection(tSocketDescriptor socketDescriptor)
@@ -65,6 +78,16 @@ void HttpListener::incomingConnection(tSocketDescriptor socketDescriptor)
   qDebug("HttpListener: New connection");
 #endif
 
+  if(eventLoopPool)
+  {
+    // Let the least loaded event loop process the new connection
+    if(!eventLoopPool->handleConnection(socketDescriptor))
+    {
+      rejectConnection(socketDescriptor);
+    }
+    return;
+  }
+
   HttpConnectionHandler *freeHandler = nullptr;
   if(pool)
   {
@@ -80,12 +103,16 @@ void HttpListener::incomingConnection(tSocketDescriptor socketDescriptor)
   }
   else
   {
-    // Reject the connection
-    qDebug("HttpListener: Too many incoming connections");
-    QTcpSocket *socket = new QTcpSocket(this);
-    socket->setSocketDescriptor(socketDescriptor);
-    connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
-    socket->write("HTTP/1.1 503 too many connections\r\nConnection: close\r\n\r\nToo many connections\r\n");
-    socket->disconnectFromHost();
+    rejectConnection(socketDescriptor);
   }
 }
+
+void HttpListener::rejectConnection(tSocketDescriptor socketDescriptor)
+{
+  qDebug("HttpListener: Too many incoming connections");
+  QTcpSocket *socket = new QTcpSocket(this);
+  socket->setSocketDescriptor(socketDescriptor);
+  connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+  socket->write("HTTP/1.1 503 too many connections\r\nConnection: close\r\n\r\nToo many connections\r\n");
+  socket->disconnectFromHost();
+}
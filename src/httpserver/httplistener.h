@@ -11,6 +11,7 @@
 #include "httpglobal.h"
 #include "httpconnectionhandler.h"
 #include "httpconnectionhandlerpool.h"
+#include "httpeventlooppool.h"
 #include "httprequesthandler.h"
 
 namespace stefanfrings {
@@ -35,7 +36,16 @@ namespace stefanfrings {
  *  The optional host parameter binds the listener to one network interface.
  *  The listener handles all network interfaces if no host is configured.
  *  The port number specifies the incoming TCP port that this listener listens to.
+ *  <p>
+ *  Setting eventLoopThreads to a value greater than zero enables the event driven mode which serves
+ *  all connections with a few event loop threads and a bounded worker pool instead of one thread per connection.
+ *  <code><pre>
+ *  eventLoopThreads=2
+ *  workerThreads=4
+ *  maxConnections=1000
+ *  </pre></code>
  *  @see HttpConnectionHandlerPool for description of config settings minThreads, maxThreads, cleanupInterval and ssl settings
+ *  @see HttpEventLoopPool for description of config settings eventLoopThreads, workerThreads and maxConnections
  *  @see HttpConnectionHandler for description of the readTimeout
  *  @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize
  */
@@ -90,6 +100,12 @@ private:
   /** Pool of connection handlers */
   HttpConnectionHandlerPool *pool;
 
+  /** Event loops used instead of pool if eventLoopThreads is set */
+  HttpEventLoopPool *eventLoopPool;
+
+  /** Send error and close connection */
+  void rejectConnection(tSocketDescriptor socketDescriptor);
+
 signals:
   /**
    *  Sent to the connection handler to process a new incoming connection.
@@ -4,17 +4,49 @@
  */
 
 #include "httpresponse.h"
+#include "httpeventstream.h"
 
 using namespace stefanfrings;
 
+/** Pass the buffer to the writer if it reaches this size */
+static const int MAX_OUTPUT_BUFFER = 65536;
+
+HttpResponseWriter::~HttpResponseWriter()
+{
+}
+
 HttpResponse::HttpResponse(QTcpSocket *socket)
 {
   this->socket = socket;
+  outputBuffer = nullptr;
+  writer = nullptr;
+  writerConnected = true;
+  statusCode = 200;
+  statusText = "OK";
+  sentHeaders = false;
+  sentLastPart = false;
+  chunkedMode = false;
+  eventSubscriber = nullptr;
+}
+
+HttpResponse::HttpResponse(QByteArray *buffer, HttpResponseWriter *writer)
+{
+  Q_ASSERT(buffer != nullptr);
+  this->socket = nullptr;
+  outputBuffer = buffer;
+  this->writer = writer;
+  writerConnected = true;
   statusCode = 200;
   statusText = "OK";
   sentHeaders = false;
   sentLastPart = false;
   chunkedMode = false;
+  eventSubscriber = nullptr;
+}
+
+HttpResponse::~HttpResponse()
+{
+  delete eventSubscriber;
 }
 
 void HttpResponse::setHeader(QByteArray name, QByteArray value)
@@ -69,12 +101,29 @@ void HttpResponse::writeHeaders()
   }
   buffer.append("\r\n");
   writeToSocket(buffer);
-  socket->flush();
+  flush();
   sentHeaders = true;
 }
 
 bool HttpResponse::writeToSocket(QByteArray data)
 {
+  if(socket == nullptr)
+  {
+    if(!writerConnected)
+    {
+      return false;
+    }
+
+    outputBuffer->append(data);
+    if(writer != nullptr && outputBuffer->size() >= MAX_OUTPUT_BUFFER)
+    {
+      // Pass large output on instead of collecting all of it
+      writerConnected = writer->writeBuffer(*outputBuffer);
+      outputBuffer->clear();
+    }
+    return writerConnected;
+  }
+
   int remaining = data.size();
   const char *ptr = data.constData();
   while(socket->isOpen() && remaining > 0)
@@ -108,10 +157,14 @@ void HttpResponse::write(QByteArray data, bool lastPart)
     if(lastPart)
     {
       // Automatically set the Content-Length header
-      headers.insert("Content-Length", QByteArray::number(data.size()));
+      // 204 and 304 responses must not contain a body or Content-Length
+      if(statusCode != 204 && statusCode != 304)
+      {
+        headers.insert("Content-Length", QByteArray::number(data.size()));
+      }
     }
-    // else if we will not close the connection at the end, them we must use the chunked mode.
-    else
+    // else if we will not close the connection at the end and do not know the size, them we must use the chunked mode.
+    else if(!headers.contains("Content-Length"))
     {
       QByteArray connectionValue = headers.value("Connection", headers.value("connection"));
       bool connectionClose = QString::compare(connectionValue, "close", Qt::CaseInsensitive) == 0;
@@ -152,7 +205,7 @@ void HttpResponse::write(QByteArray data, bool lastPart)
     {
       writeToSocket("0\r\n\r\n");
     }
-    socket->flush();
+    flush();
     sentLastPart = true;
   }
 }
@@ -185,10 +238,55 @@ void HttpResponse::redirect(const QByteArray& url)
 
 void HttpResponse::flush()
 {
-  socket->flush();
+  if(socket != nullptr)
+    socket->flush();
 }
 
 bool HttpResponse::isConnected() const
 {
-  return socket->isOpen();
+  // Buffered responses can detect a lost connection only if they have a writer
+  return socket == nullptr ? writerConnected : socket->isOpen();
+}
+
+bool HttpResponse::startEventStream(HttpEventStream *stream)
+{
+  Q_ASSERT(sentHeaders == false);
+  Q_ASSERT(stream != nullptr);
+
+  // Use chunked mode unless the connection is closed at the end, e.g. for HTTP/1.0
+  QByteArray connectionValue = headers.value("Connection", headers.value("connection"));
+  bool connectionClose = QString::compare(connectionValue, "close", Qt::CaseInsensitive) == 0;
+
+  eventSubscriber = stream->subscribe(!connectionClose);
+  if(eventSubscriber == nullptr)
+  {
+    setStatus(503, "Service Unavailable");
+    setHeader("Retry-After", 10);
+    write("Too many event stream clients", true);
+    return false;
+  }
+
+  headers.remove("Content-Length");
+  headers.insert("Content-Type", "text/event-stream");
+  headers.insert("Cache-Control", "no-cache");
+  if(!connectionClose)
+  {
+    headers.insert("Transfer-Encoding", "chunked");
+    chunkedMode = true;
+  }
+  writeHeaders();
+  return true;
+}
+
+void HttpResponse::writeEvent(const QByteArray& data, const QByteArray& event)
+{
+  Q_ASSERT(eventSubscriber != nullptr);
+  write(HttpEventStream::formatEvent(data, event));
+}
+
+HttpEventSubscriber *HttpResponse::takeEventSubscriber()
+{
+  HttpEventSubscriber *subscriber = eventSubscriber;
+  eventSubscriber = nullptr;
+  return subscriber;
 }
@@ -14,6 +14,25 @@
 
 namespace stefanfrings {
 
+class HttpEventStream;
+class HttpEventSubscriber;
+
+/**
+ *  Receives the output of a buffered HttpResponse in parts while the response is still being written.
+ *  This avoids keeping large responses like file downloads completely in memory.
+ */
+class DECLSPEC HttpResponseWriter
+{
+public:
+  virtual ~HttpResponseWriter();
+
+  /**
+   *  Pass on a part of the response. May block until the receiver can take more data.
+   *  @return false if the client is not connected anymore. The remaining output is discarded.
+   */
+  virtual bool writeBuffer(const QByteArray& data) = 0;
+};
+
 /**
  *  This object represents a HTTP response, used to return something to the web client.
  *  <p>
@@ -44,6 +63,20 @@ public:
    */
   HttpResponse(QTcpSocket *socket);
 
+  /**
+   *  Constructor for buffered responses.
+   *  All output including status line and headers is appended to the given buffer
+   *  instead of being written to a socket. Used when the request handler runs in a worker thread
+   *  which does not own the socket.
+   *  @param buffer receives the response. Must stay valid while the response is used.
+   *  @param writer if not null, the buffer content is passed to the writer each time the buffer exceeds 64 KB.
+   *  The buffer contains only the remaining output afterwards.
+   */
+  HttpResponse(QByteArray *buffer, HttpResponseWriter *writer = nullptr);
+
+  /** Destructor. Deletes the event subscriber if not taken by the connection handler. */
+  ~HttpResponse();
+
   /**
    *  Set a HTTP response header.
    *  You must call this method before the first write().
@@ -121,6 +154,31 @@ public:
    */
   bool isConnected() const;
 
+  /**
+   *  Turn this response into a server-sent event stream and subscribe the client to the given stream.
+   *  Sends the headers immediately. The connection stays open after HttpRequestHandler::service() returns
+   *  and all events published on the stream afterwards are pushed to the client.
+   *  <p>
+   *  If the subscriber limit of the stream is reached, a 503 error is sent instead.
+   *  You must call this method before the first write().
+   *  @return true if the client was subscribed
+   *  @see HttpEventStream
+   */
+  bool startEventStream(HttpEventStream *stream);
+
+  /**
+   *  Send an event only to this client, e.g. the current full state before the deltas
+   *  published on the stream. Only valid after startEventStream() returned true.
+   */
+  void writeEvent(const QByteArray& data, const QByteArray& event = QByteArray());
+
+  /**
+   *  Get the subscriber created by startEventStream() and pass ownership to the caller.
+   *  Used by the connection handlers to keep the connection open.
+   *  @return null if this is not an event stream
+   */
+  HttpEventSubscriber *takeEventSubscriber();
+
 private:
   /** Request headers */
   QMap<QByteArray, QByteArray> headers;
@@ -128,6 +186,15 @@ private:
   /** Socket for writing output */
   QTcpSocket *socket;
 
+  /** Buffer for writing output if socket is null */
+  QByteArray *outputBuffer;
+
+  /** Optionally receives parts of the buffer */
+  HttpResponseWriter *writer;
+
+  /** Cleared if the writer reports that the client is gone */
+  bool writerConnected;
+
   /** HTTP status code*/
   int statusCode;
 
@@ -146,6 +213,9 @@ private:
   /** Cookies */
   QMap<QByteArray, HttpCookie> cookies;
 
+  /** Not null if this response was turned into an event stream */
+  HttpEventSubscriber *eventSubscriber;
+
   /** Write raw data to the socket. This method blocks until all bytes have been passed to the TCP buffer */
   bool writeToSocket(QByteArray data);
 
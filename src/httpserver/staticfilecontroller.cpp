@@ -7,6 +7,12 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QDateTime>
+#include <QCryptographicHash>
+#include <QLocale>
+
+#include "zip/gzip.h"
+
+#include <algorithm>
 
 using namespace stefanfrings;
 
@@ -29,6 +35,7 @@ StaticFileController::StaticFileController(QHash<QString, QVariant> settings, QO
   maxCachedFileSize = settings.value("maxCachedFileSize", "65536").toInt();
   cache.setMaxCost(settings.value("cacheSize", "1000000").toInt());
   cacheTimeout = settings.value("cacheTime", "60000").toInt();
+  compressMinSize = settings.value("compressMinSize", "256").toInt();
   qDebug("StaticFileController: cache timeout=%i, size=%i", cacheTimeout, cache.maxCost());
 }
 
@@ -37,23 +44,49 @@ void StaticFileController::service(HttpRequest& request, HttpResponse& response)
   QByteArray path = request.getPath();
   // Check if we have the file in cache
   qint64 now = QDateTime::currentMSecsSinceEpoch();
+  CacheEntry entry;
+  bool found = false, expired = false;
   mutex.lock();
-  CacheEntry *entry = cache.object(path);
-  if(entry && (cacheTimeout == 0 || entry->created > now - cacheTimeout))
+  CacheEntry *cached = cache.object(path);
+  if(cached)
+  {
+    // Copy the cached entry, because other threads may destroy it immediately after mutex unlock.
+    // This is cheap since all byte arrays are implicitly shared.
+    entry = *cached;
+    found = true;
+    expired = cacheTimeout != 0 && cached->created <= now - cacheTimeout;
+  }
+  mutex.unlock();
+
+  if(found && expired)
+  {
+    // Keep content, hash and compressed variant if the file did not change
+    QFileInfo fileInfo(docroot + entry.filename);
+    if(fileInfo.size() == entry.document.size() && fileInfo.lastModified() == entry.modified)
+    {
+      mutex.lock();
+      cached = cache.object(path);
+      if(cached)
+      {
+        cached->created = now;
+      }
+      mutex.unlock();
+    }
+    else
+    {
+      found = false;
+    }
+  }
+
+  if(found)
   {
-    QByteArray document = entry->document;   // copy the cached document, because other threads may destroy the cached entry immediately after mutex unlock.
-    QByteArray filename = entry->filename;
-    mutex.unlock();
 #ifdef DEBUG_INFORMATION_WEB
     qDebug("StaticFileController: Cache hit for %s", path.constData());
 #endif
-    setContentType(filename, response);
-    response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
-    response.write(document);
+    sendDocument(request, response, entry);
   }
   else
   {
-    mutex.unlock();
     // The file is not in cache.
 #ifdef DEBUG_INFORMATION_WEB
     qDebug("StaticFileController: Cache miss for %s", path.constData());
@@ -78,31 +111,38 @@ void StaticFileController::service(HttpRequest& request, HttpResponse& response)
 #endif
     if(file.open(QIODevice::ReadOnly))
     {
-      setContentType(path, response);
-      response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
       if(file.size() <= maxCachedFileSize)
       {
         // Return the file content and store it also in the cache
-        entry = new CacheEntry();
-        while(!file.atEnd() && !file.error())
+        entry.document = file.readAll();
+        QByteArray hash = QCryptographicHash::hash(entry.document, QCryptographicHash::Md5).toHex();
+        entry.etag = "\"" + hash + "\"";
+        entry.modified = QFileInfo(file).lastModified();
+        entry.lastModified = httpDate(entry.modified);
+        entry.created = now;
+        entry.filename = path;
+
+        if(entry.document.size() >= compressMinSize && isCompressible(path))
         {
-          QByteArray buffer = file.read(65536);
-          response.write(buffer);
-          entry->document.append(buffer);
+          // Keep compressed variant only if it saves at least ten percent
+          QByteArray gzipDocument = atools::zip::gzipCompress(entry.document, 9);
+          if(!gzipDocument.isEmpty() && gzipDocument.size() < entry.document.size() / 10 * 9)
+          {
+            entry.gzipDocument = gzipDocument;
+            entry.gzipEtag = "\"" + hash + "-gzip\"";
+          }
         }
-        entry->created = now;
-        entry->filename = path;
+
         mutex.lock();
-        cache.insert(request.getPath(), entry, entry->document.size());
+        cache.insert(request.getPath(), new CacheEntry(entry), entry.document.size() + entry.gzipDocument.size());
         mutex.unlock();
+
+        sendDocument(request, response, entry);
       }
       else
       {
         // Return the file content, do not store in cache
-        while(!file.atEnd() && !file.error())
-        {
-          response.write(file.read(65536));
-        }
+        sendFile(request, response, file, path);
       }
       file.close();
     }
@@ -123,6 +163,328 @@ void StaticFileController::service(HttpRequest& request, HttpResponse& response)
   }
 }
 
+void StaticFileController::sendDocument(const HttpRequest& request, HttpResponse& response, const CacheEntry& entry) const
+{
+  // Ranges always refer to the uncompressed document
+  bool gzip = !entry.gzipDocument.isEmpty() && request.getHeader("Range").isEmpty() &&
+              acceptsGzip(request.getHeader("Accept-Encoding"));
+
+  // Each variant has its own entity tag
+  const QByteArray& etag = gzip ? entry.gzipEtag : entry.etag;
+
+  setContentType(entry.filename, response);
+  setCacheHeaders(response, etag, entry.lastModified);
+  if(!entry.gzipDocument.isEmpty())
+  {
+    response.setHeader("Vary", "Accept-Encoding");
+  }
+
+  if(isNotModified(request, etag, entry.modified))
+  {
+    // Sent without body and Content-Length
+    response.setStatus(304, "Not Modified");
+    response.write(QByteArray(), true);
+    return;
+  }
+
+  qint64 start = 0, end = 0, size = entry.document.size();
+  RangeResult range = getRange(request, entry.etag, entry.modified, size, start, end);
+  if(range != RANGE_NONE)
+  {
+    setRangeHeaders(response, range, start, end, size);
+    if(range == RANGE_VALID)
+    {
+      response.write(entry.document.mid(static_cast<int>(start), static_cast<int>(end - start + 1)), true);
+    }
+    else
+    {
+      response.write("416 range not satisfiable", true);
+    }
+    return;
+  }
+
+  if(gzip)
+  {
+    response.setHeader("Content-Encoding", "gzip");
+    response.write(entry.gzipDocument, true);
+  }
+  else
+  {
+    response.write(entry.document, true);
+  }
+}
+
+void StaticFileController::sendFile(const HttpRequest& request, HttpResponse& response, QFile& file,
+                                    const QByteArray& filename) const
+{
+  // Hashing large files is too expensive - use size and modification time for the entity tag
+  qint64 size = file.size();
+  QDateTime modified = QFileInfo(file).lastModified();
+  QByteArray etag = "\"" + QByteArray::number(size, 16) + "-" +
+                    QByteArray::number(modified.toMSecsSinceEpoch(), 16) + "\"";
+  QByteArray lastModified = httpDate(modified);
+
+  setContentType(filename, response);
+  setCacheHeaders(response, etag, lastModified);
+
+  if(isNotModified(request, etag, modified))
+  {
+    // Sent without body and Content-Length
+    response.setStatus(304, "Not Modified");
+    response.write(QByteArray(), true);
+    return;
+  }
+
+  qint64 start = 0, end = size - 1;
+  RangeResult range = getRange(request, etag, modified, size, start, end);
+  if(range == RANGE_INVALID)
+  {
+    setRangeHeaders(response, range, start, end, size);
+    response.write("416 range not satisfiable", true);
+    return;
+  }
+  else if(range == RANGE_VALID)
+  {
+    setRangeHeaders(response, range, start, end, size);
+    file.seek(start);
+  }
+
+  // Known length avoids chunked mode
+  // Stop reading if the client is gone
+  qint64 remaining = end - start + 1;
+  response.setHeader("Content-Length", QByteArray::number(remaining));
+  while(remaining > 0 && !file.atEnd() && !file.error() && response.isConnected())
+  {
+    QByteArray buffer = file.read(std::min(remaining, static_cast<qint64>(65536)));
+    if(buffer.isEmpty())
+    {
+      break;
+    }
+    remaining -= buffer.size();
+    response.write(buffer);
+  }
+}
+
+void StaticFileController::setCacheHeaders(HttpResponse& response, const QByteArray& etag,
+                                           const QByteArray& lastModified) const
+{
+  response.setHeader("Cache-Control", "max-age=" + QByteArray::number(maxAge / 1000));
+  response.setHeader("ETag", etag);
+  if(!lastModified.isEmpty())
+  {
+    response.setHeader("Last-Modified", lastModified);
+  }
+  response.setHeader("Accept-Ranges", "bytes");
+}
+
+bool StaticFileController::isNotModified(const HttpRequest& request, const QByteArray& etag,
+                                         const QDateTime& modified) const
+{
+  QByteArray ifNoneMatch = request.getHeader("If-None-Match");
+  if(!ifNoneMatch.isEmpty())
+  {
+    // Weak comparison
+    QByteArray tag = etag.startsWith("W/") ? etag.mid(2) : etag;
+    for(QByteArray match : ifNoneMatch.split(','))
+    {
+      match = match.trimmed();
+      if(match == "*" || (match.startsWith("W/") ? match.mid(2) : match) == tag)
+      {
+        return true;
+      }
+    }
+
+    // If-Modified-Since has to be ignored if If-None-Match is present
+    return false;
+  }
+
+  // Compare as date since clients can send any valid date and not only the Last-Modified value
+  // Header dates have a resolution of one second
+  QDateTime ifModifiedSince = parseHttpDate(request.getHeader("If-Modified-Since"));
+  return ifModifiedSince.isValid() && modified.isValid() &&
+         modified.toSecsSinceEpoch() <= ifModifiedSince.toSecsSinceEpoch();
+}
+
+StaticFileController::RangeResult StaticFileController::getRange(const HttpRequest& request, const QByteArray& etag,
+                                                                 const QDateTime& modified, qint64 size,
+                                                                 qint64& start, qint64& end) const
+{
+  // Multiple ranges are not supported and the whole document is sent instead
+  QByteArray range = request.getHeader("Range").trimmed();
+  if(!range.startsWith("bytes=") || range.contains(','))
+  {
+    return RANGE_NONE;
+  }
+
+  // Send whole document if it changed since the client got the first part
+  QByteArray ifRange = request.getHeader("If-Range").trimmed();
+  if(!ifRange.isEmpty())
+  {
+    bool match = false;
+    if(ifRange.startsWith('"') || ifRange.startsWith("W/"))
+    {
+      // Entity tags need a strong comparison - weak tags never match
+      match = ifRange == etag;
+    }
+    else
+    {
+      // Dates have to match exactly
+      QDateTime date = parseHttpDate(ifRange);
+      match = date.isValid() && modified.isValid() && date.toSecsSinceEpoch() == modified.toSecsSinceEpoch();
+    }
+
+    if(!match)
+    {
+      return RANGE_NONE;
+    }
+  }
+
+  QByteArray spec = range.mid(6);
+  int dash = spec.indexOf('-');
+  if(dash < 0)
+  {
+    return RANGE_NONE;
+  }
+
+  bool okStart = true, okEnd = true;
+  QByteArray startStr = spec.left(dash).trimmed(), endStr = spec.mid(dash + 1).trimmed();
+  if(startStr.isEmpty())
+  {
+    // Suffix range like "-500" for the last 500 bytes
+    qint64 suffix = endStr.toLongLong(&okEnd);
+    if(!okEnd)
+    {
+      return RANGE_NONE;
+    }
+    if(suffix <= 0)
+    {
+      return RANGE_INVALID;
+    }
+    start = std::max(static_cast<qint64>(0), size - suffix);
+    end = size - 1;
+  }
+  else
+  {
+    start = startStr.toLongLong(&okStart);
+    end = endStr.isEmpty() ? size - 1 : endStr.toLongLong(&okEnd);
+    if(!okStart || !okEnd || start < 0 || end < start)
+    {
+      return RANGE_NONE;
+    }
+    end = std::min(end, size - 1);
+  }
+
+  return start < size ? RANGE_VALID : RANGE_INVALID;
+}
+
+void StaticFileController::setRangeHeaders(HttpResponse& response, RangeResult range, qint64 start, qint64 end,
+                                           qint64 size) const
+{
+  if(range == RANGE_VALID)
+  {
+    response.setStatus(206, "Partial Content");
+    response.setHeader("Content-Range", "bytes " + QByteArray::number(start) + "-" + QByteArray::number(end) +
+                       "/" + QByteArray::number(size));
+  }
+  else if(range == RANGE_INVALID)
+  {
+    response.setStatus(416, "Range Not Satisfiable");
+    response.setHeader("Content-Range", "bytes */" + QByteArray::number(size));
+  }
+}
+
+bool StaticFileController::isCompressible(const QString& fileName)
+{
+  return fileName.endsWith(".html") || fileName.endsWith(".htm") || fileName.endsWith(".txt") ||
+         fileName.endsWith(".css") || fileName.endsWith(".js") || fileName.endsWith(".json") ||
+         fileName.endsWith(".xml") || fileName.endsWith(".svg");
+}
+
+bool StaticFileController::acceptsGzip(const QByteArray& acceptEncoding)
+{
+  // List of codings with optional weight like "deflate, gzip;q=0.5, *;q=0"
+  bool gzipListed = false, gzipAccepted = false, anyAccepted = false;
+  const QList<QByteArray> elements = acceptEncoding.split(',');
+  for(const QByteArray& element : elements)
+  {
+    QList<QByteArray> params = element.split(';');
+    QByteArray coding = params.takeFirst().trimmed().toLower();
+
+    double weight = 1.;
+    for(const QByteArray& param : qAsConst(params))
+    {
+      QByteArray trimmed = param.trimmed().toLower();
+      if(trimmed.startsWith("q="))
+      {
+        // Treat a malformed weight as not acceptable
+        bool ok;
+        weight = trimmed.mid(2).trimmed().toDouble(&ok);
+        if(!ok)
+          weight = 0.;
+      }
+    }
+
+    if(coding == "gzip" || coding == "x-gzip")
+    {
+      gzipListed = true;
+      gzipAccepted |= weight > 0.;
+    }
+    else if(coding == "*")
+      anyAccepted = weight > 0.;
+  }
+
+  // An explicitly listed gzip overrides the wildcard
+  return gzipListed ? gzipAccepted : anyAccepted;
+}
+
+QByteArray StaticFileController::httpDate(const QDateTime& datetime)
+{
+  if(!datetime.isValid())
+  {
+    return QByteArray();
+  }
+  // Use C locale to get English day and month names
+  return QLocale::c().toString(datetime.toUTC(), "ddd, dd MMM yyyy hh:mm:ss 'GMT'").toLatin1();
+}
+
+QDateTime StaticFileController::parseHttpDate(const QByteArray& date)
+{
+  // Recipients have to accept all three formats - weekday is ignored
+  QStringList tokens = QString::fromLatin1(date).simplified().split(' ');
+  QLocale locale = QLocale::c();
+  QDate day;
+  QString timeStr;
+  if(tokens.size() == 6 && tokens.at(5) == "GMT")
+  {
+    // IMF-fixdate "Sun, 06 Nov 1994 08:49:37 GMT"
+    day = locale.toDate(tokens.at(1) + ' ' + tokens.at(2) + ' ' + tokens.at(3), "dd MMM yyyy");
+    timeStr = tokens.at(4);
+  }
+  else if(tokens.size() == 4 && tokens.at(3) == "GMT")
+  {
+    // Obsolete RFC 850 "Sunday, 06-Nov-94 08:49:37 GMT" - two digit years are read as 19xx
+    day = locale.toDate(tokens.at(1), "dd-MMM-yy");
+    if(day.isValid() && day.year() < 1970)
+    {
+      day = day.addYears(100);
+    }
+    timeStr = tokens.at(2);
+  }
+  else if(tokens.size() == 5)
+  {
+    // asctime "Sun Nov  6 08:49:37 1994"
+    day = locale.toDate(tokens.at(1) + ' ' + tokens.at(2) + ' ' + tokens.at(4), "MMM d yyyy");
+    timeStr = tokens.at(3);
+  }
+
+  QTime time = QTime::fromString(timeStr, "hh:mm:ss");
+  if(!day.isValid() || !time.isValid())
+  {
+    return QDateTime();
+  }
+  return QDateTime(day, time, Qt::UTC);
+}
+
 void StaticFileController::setContentType(const QString fileName, HttpResponse& response) const
 {
   if(fileName.endsWith(".png"))
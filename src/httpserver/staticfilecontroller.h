@@ -7,6 +7,8 @@
 #define STATICFILECONTROLLER_H
 
 #include <QCache>
+#include <QDateTime>
+#include <QFile>
 #include <QMutex>
 #include "httpglobal.h"
 #include "httprequest.h"
@@ -27,6 +29,7 @@ namespace stefanfrings {
  *  cacheTime=60000
  *  cacheSize=1000000
  *  maxCachedFileSize=65536
+ *  compressMinSize=256
  *  </pre></code>
  *  The path is relative to the directory of the config file. In case of windows, if the
  *  settings are in the registry, the path is relative to the current working directory.
@@ -36,6 +39,12 @@ namespace stefanfrings {
  *  The cache improves performance of small files when loaded from a network
  *  drive. Large files are not cached. Files are cached as long as possible,
  *  when cacheTime=0. The maxAge value (in msec!) controls the remote browsers cache.
+ *  Expired cache entries are reused if size and modification time of the file did not change.
+ *  <p>
+ *  Responses contain ETag and Last-Modified headers. Conditional requests with If-None-Match or
+ *  If-Modified-Since are answered with 304 Not Modified. Cached text files not smaller than compressMinSize
+ *  are compressed once and sent gzip encoded if the client accepts it. The compressed variant has its own
+ *  entity tag. Single byte ranges are supported for all files. If-Range accepts an entity tag or a date.
  *  <p>
  *  Do not instantiate this class in each request, because this would make the file cache
  *  useless. Better create one instance during start-up and call it when the application
@@ -77,16 +86,41 @@ private:
   struct CacheEntry
   {
     QByteArray document;
+
+    /** Gzip compressed document or empty if not compressible */
+    QByteArray gzipDocument;
+
+    /** Entity tag from content hash including quotes */
+    QByteArray etag;
+
+    /** Entity tag of the gzip compressed variant */
+    QByteArray gzipEtag;
+
+    /** Last-Modified header value and file modification time to detect changes */
+    QByteArray lastModified;
+    QDateTime modified;
+
     qint64 created;
     QByteArray filename;
   };
 
+  /** Result of parsing the Range header */
+  enum RangeResult
+  {
+    RANGE_NONE, /* No range or range ignored - send whole document */
+    RANGE_VALID, /* Send partial content */
+    RANGE_INVALID /* Range not satisfiable */
+  };
+
   /** Timeout for each cached file */
   int cacheTimeout;
 
   /** Maximum size of files in cache, larger files are not cached */
   int maxCachedFileSize;
 
+  /** Minimum size of text files to compress */
+  int compressMinSize;
+
   /** Cache storage */
   QCache<QString, CacheEntry> cache;
 
@@ -96,6 +130,37 @@ private:
   /** Set a content-type header in the response depending on the ending of the filename */
   void setContentType(const QString file, HttpResponse& response) const;
 
+  /** Set Cache-Control, ETag, Last-Modified and Accept-Ranges headers */
+  void setCacheHeaders(HttpResponse& response, const QByteArray& etag, const QByteArray& lastModified) const;
+
+  /** Send cached document considering conditional, range and gzip requests */
+  void sendDocument(const HttpRequest& request, HttpResponse& response, const CacheEntry& entry) const;
+
+  /** Stream a large file which is not cached considering conditional and range requests */
+  void sendFile(const HttpRequest& request, HttpResponse& response, QFile& file, const QByteArray& filename) const;
+
+  /** true if If-None-Match or If-Modified-Since match the current document */
+  bool isNotModified(const HttpRequest& request, const QByteArray& etag, const QDateTime& modified) const;
+
+  /** Parse a single byte range from the Range header considering If-Range. start and end are inclusive. */
+  RangeResult getRange(const HttpRequest& request, const QByteArray& etag, const QDateTime& modified, qint64 size,
+                       qint64& start, qint64& end) const;
+
+  /** Send 206 or 416 headers for a range result */
+  void setRangeHeaders(HttpResponse& response, RangeResult range, qint64 start, qint64 end, qint64 size) const;
+
+  /** true if the type of file can be compressed */
+  static bool isCompressible(const QString& fileName);
+
+  /** true if the Accept-Encoding header allows gzip. Considers "*" and q values where q=0 excludes a coding. */
+  static bool acceptsGzip(const QByteArray& acceptEncoding);
+
+  /** Format date for HTTP headers like "Sun, 06 Nov 1994 08:49:37 GMT" */
+  static QByteArray httpDate(const QDateTime& datetime);
+
+  /** Parse a date from HTTP headers in IMF-fixdate, RFC 850 or asctime format. Returns an invalid date on error. */
+  static QDateTime parseHttpDate(const QByteArray& date);
+
 };
 
 } // end of namespace
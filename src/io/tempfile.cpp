@@ -57,6 +57,41 @@ TempFile::TempFile(const QByteArray& bytes, const QString& suffix)
   init(bytes, suffix);
 }
 
+TempFile::TempFile(QIODevice *device, const QString& suffix)
+{
+  QFile temp(buildFilename(suffix));
+  if(temp.open(QIODevice::WriteOnly))
+  {
+    // Copy in chunks to avoid keeping all data in memory
+    QByteArray chunk(64 * 1024, '\0');
+    qint64 numRead = 0;
+    while((numRead = device->read(chunk.data(), chunk.size())) > 0)
+    {
+      if(temp.write(chunk.constData(), numRead) != numRead)
+      {
+        QString error = temp.errorString();
+        temp.close();
+        temp.remove();
+        throw atools::Exception(tr("Cannot write to \"%1\". Error: %2").arg(temp.fileName()).arg(error));
+      }
+    }
+
+    if(numRead < 0)
+    {
+      temp.close();
+      temp.remove();
+      throw atools::Exception(tr("Cannot read data for \"%1\". Error: %2").
+                              arg(temp.fileName()).arg(device->errorString()));
+    }
+
+    filepath = temp.fileName();
+    filepathData = filepath.toUtf8();
+    temp.close();
+  }
+  else
+    throw atools::Exception(tr("Cannot open \"%1\" for writing. Error: %2").arg(temp.fileName()).arg(temp.errorString()));
+}
+
 TempFile::~TempFile()
 {
   if(!filepath.isEmpty() && !QFile::remove(filepath))
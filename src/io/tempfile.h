@@ -20,12 +20,15 @@
 
 #include <QCoreApplication>
 
+class QIODevice;
+
 namespace atools {
 namespace io {
 
 /*
- * Creates a temporary file either from another filename (e.g. resources)
- * or a byte array. File is closed after construction/copying and deleted in the destructor.
+ * Creates a temporary file either from another filename (e.g. resources), a byte array
+ * or an open device which is copied in chunks.
+ * File is closed after construction/copying and deleted in the destructor.
  *
  * File is created in the system temp folder and contains application name and a GUID.
  *
@@ -39,6 +42,7 @@ public:
   /* Default suffix is ".temp" if empty */
   TempFile(const QString& filepathParam, const QString& suffix = QString());
   TempFile(const QByteArray& bytes, const QString& suffix = QString());
+  TempFile(QIODevice *device, const QString& suffix = QString());
   ~TempFile();
 
   /* Get full path and filename */
@@ -316,6 +316,17 @@ void LoggingConfig::readConfigurationSection(QSettings *settings)
   rolling = settings->value("configuration/files").toString() == "roll";
   maximumBackupFiles = settings->value("configuration/maxfiles").toInt();
 
+  async = settings->value("configuration/async", false).toBool();
+  queueSize = qMax(settings->value("configuration/queuesize", 8192).toInt(), 64);
+
+  QString overflow = settings->value("configuration/overflow", QVariant("block")).toString();
+  if(overflow == "block")
+    overflowPolicy = OVERFLOW_BLOCK;
+  else if(overflow == "drop")
+    overflowPolicy = OVERFLOW_DROP;
+  else
+    qWarning() << "Invalid value for configuration/overflow:" << overflow << "use either block (default) or drop.";
+
   QString abortOn = settings->value("configuration/abort", QVariant("fatal")).toString();
   if(abortOn == "warning")
     abortType = QtWarningMsg;
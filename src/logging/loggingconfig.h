@@ -31,6 +31,7 @@ namespace atools {
 namespace logging {
 class LoggingHandler;
 namespace internal {
+class LoggingWriter;
 
 /* Internal logging class that reads the configuration and sets up all the
  * streams. */
@@ -45,6 +46,7 @@ public:
 
 private:
   friend class atools::logging::LoggingHandler;
+  friend class atools::logging::internal::LoggingWriter;
 
   /* get a list of log files (excluding stdout and stderr) */
   QStringList getLogFiles() const;
@@ -120,6 +122,15 @@ private:
   /* Shorten file and method names if true. */
   bool narrow = false;
 
+  /* Write messages in a background thread if true */
+  bool async = false;
+
+  /* Maximum number of queued messages in asynchronous mode */
+  int queueSize = 8192;
+
+  /* What to do if the queue is full in asynchronous mode */
+  OverflowPolicy overflowPolicy = OVERFLOW_BLOCK;
+
   QString logConfig, logDir, logPrefix;
 
   // Messages of this type or worse cause a call to abort()
@@ -61,6 +61,9 @@ void LoggingGuiAbortHandler::guiAbortFunction(const QString& msg)
   Q_UNUSED(msg)
 #endif
 
+  // Write anything left in the asynchronous log queue before exiting
+  LoggingHandler::flush();
+
 #ifdef Q_OS_WIN32
   // Will not call any crash handler on windows - is not helpful anyway
   std::exit(1);
@@ -90,6 +93,9 @@ void LoggingGuiAbortHandler::setGuiAbortFunction(QWidget *parent)
         Q_UNUSED(type)
         Q_UNUSED(context)
 
+        // Make sure the fatal message is written even if the dialog crashes or hangs
+        LoggingHandler::flush();
+
         // Call guiAbortFunc on main thread context
         emit LoggingHandler::instance->guiAbortSignal(msg);
 
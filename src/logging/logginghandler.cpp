@@ -17,6 +17,7 @@
 
 #include "logging/logginghandler.h"
 #include "logging/loggingconfig.h"
+#include "logging/loggingwriter.h"
 
 #include <QDebug>
 #include <QDir>
@@ -45,6 +46,9 @@ LoggingHandler::LoggingHandler(const QString& logConfiguration,
 {
   logConfig = new LoggingConfig(logConfiguration, logDirectory, logFilePrefix);
 
+  if(logConfig->async)
+    writer = new internal::LoggingWriter(logConfig, logConfig->queueSize, logConfig->overflowPolicy);
+
   // Override category filter since some systems disable debug logging in the qtlogging.ini
   oldCategoryFilter = QLoggingCategory::installFilter(categoryFilter);
 
@@ -59,6 +63,11 @@ LoggingHandler::~LoggingHandler()
 {
   qInstallMessageHandler(oldMessageHandler);
   QLoggingCategory::installFilter(oldCategoryFilter);
+
+  // Writes all pending messages and stops thread
+  delete writer;
+  writer = nullptr;
+
   delete logConfig;
 }
 
@@ -111,6 +120,12 @@ void LoggingHandler::shutdown()
   }
 }
 
+void LoggingHandler::flush()
+{
+  if(instance != nullptr && instance->writer != nullptr)
+    instance->writer->flush();
+}
+
 const QStringList LoggingHandler::getLogFiles()
 {
   if(instance != nullptr)
@@ -119,9 +134,26 @@ const QStringList LoggingHandler::getLogFiles()
     return QStringList();
 }
 
-void LoggingHandler::logToCatChannels(internal::ChannelMap& streamListCat,
+void LoggingHandler::logToCatChannels(QtMsgType type, internal::ChannelMap& streamListCat,
                                       internal::ChannelVector& streamList, const QString& message, const QString& category)
 {
+  if(writer != nullptr)
+  {
+    // Asynchronous mode - channel lists are not modified after configuration which allows to read without lock
+    if(category.isEmpty())
+    {
+      if(!streamList.isEmpty())
+        writer->append(type, message, streamList);
+    }
+    else
+    {
+      auto it = streamListCat.constFind(category);
+      if(it != streamListCat.constEnd() && !it.value().isEmpty())
+        writer->append(type, message, it.value());
+    }
+    return;
+  }
+
   QMutexLocker locker(&instance->mutex);
 
   if(category.isEmpty())
@@ -165,6 +197,10 @@ void LoggingHandler::checkAbortType(QtMsgType type, const QMessageLogContext& co
       break;
   }
 
+  // Fatal always ends the application - do not lose messages still in the queue
+  if(doAbort || type == QtFatalMsg)
+    flush();
+
   if(doAbort)
   {
     if(abortFunc)
@@ -185,7 +221,7 @@ void LoggingHandler::messageHandler(QtMsgType type, const QMessageLogContext& co
   if(category == DEFAULT)
     category.clear();
 
-  instance->logToCatChannels(instance->logConfig->getCatStream(type), instance->logConfig->getStream(type),
+  instance->logToCatChannels(type, instance->logConfig->getCatStream(type), instance->logConfig->getStream(type),
                              qFormatLogMessage(type, context, msg), category);
 
   instance->checkAbortType(type, context, msg);
@@ -273,7 +309,7 @@ void LoggingHandler::messageHandlerNarrow(QtMsgType type, const QMessageLogConte
   if(category == DEFAULT)
     category.clear();
 
-  instance->logToCatChannels(instance->logConfig->getCatStream(type), instance->logConfig->getStream(type),
+  instance->logToCatChannels(type, instance->logConfig->getCatStream(type), instance->logConfig->getStream(type),
                              qFormatLogMessage(type, ctx, message), category);
 
   instance->checkAbortType(type, ctx, message);
@@ -34,6 +34,7 @@ namespace atools {
 namespace logging {
 namespace internal {
 class LoggingConfig;
+class LoggingWriter;
 }
 
 class LoggingGuiAbortHandler;
@@ -55,6 +56,12 @@ class LoggingGuiAbortHandler;
  * maxfiles = 2
  * abort = fatal
  *
+ * # Optional asynchronous mode. Messages are formatted on the calling thread and written
+ * # by a background thread. overflow is either "block" or "drop" (discards debug and info if queue is full).
+ * async = true
+ * queuesize = 8192
+ * overflow = block
+ *
  * [channels]
  * console     = stdio
  * console-err = stderr
@@ -103,6 +110,12 @@ public:
    */
   static void shutdown();
 
+  /*
+   * Write all pending messages and flush all streams on the calling thread.
+   * Needed only in asynchronous mode. Called automatically before aborting.
+   */
+  static void flush();
+
   /*
    * @return A list of log files using absolute path
    */
@@ -143,8 +156,9 @@ private:
   LoggingHandler(const LoggingHandler& other) = delete;
   LoggingHandler& operator=(const LoggingHandler& other) = delete;
 
-  void logToCatChannels(atools::logging::internal::ChannelMap& streamListCat, atools::logging::internal::ChannelVector& streamList,
-                        const QString& message, const QString& category = QString());
+  void logToCatChannels(QtMsgType type, atools::logging::internal::ChannelMap& streamListCat,
+                        atools::logging::internal::ChannelVector& streamList, const QString& message,
+                        const QString& category = QString());
 
   void checkAbortType(QtMsgType type, const QMessageLogContext& context, const QString& msg);
 
@@ -156,6 +170,9 @@ private:
   static LoggingHandler *instance;
 
   atools::logging::internal::LoggingConfig *logConfig;
+
+  /* Not null if asynchronous logging is enabled */
+  atools::logging::internal::LoggingWriter *writer = nullptr;
   QtMessageHandler oldMessageHandler = nullptr;
   QLoggingCategory::CategoryFilter oldCategoryFilter = nullptr;
 
@@ -39,6 +39,13 @@ struct Channel
 typedef  QVector<Channel *> ChannelVector;
 typedef  QHash<QString, ChannelVector> ChannelMap;
 
+/* What to do in asynchronous mode if the message queue is full */
+enum OverflowPolicy
+{
+  OVERFLOW_BLOCK, /* Wait until the writer thread has taken messages from the queue */
+  OVERFLOW_DROP /* Discard debug and info messages and count them. Warnings and worse always wait. */
+};
+
 } // namespace internal
 } // namespace logging
 } // namespace atools
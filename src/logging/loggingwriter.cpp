@@ -0,0 +1,220 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "logging/loggingwriter.h"
+#include "logging/loggingconfig.h"
+
+#include <QTextStream>
+
+namespace atools {
+namespace logging {
+namespace internal {
+
+/* Maximum number of messages written before streams are flushed and the write lock is released */
+static const int BATCH_SIZE = 512;
+
+/* Writer thread wakes up at least this often even if no notification arrives */
+static const int WAIT_MS = 100;
+
+LoggingWriter::LoggingWriter(LoggingConfig *loggingConfig, int queueSize, OverflowPolicy overflowPolicy)
+  : config(loggingConfig), policy(overflowPolicy), enqueuePos(0), dequeuePos(0), dropped(0), waiting(false),
+  terminate(false)
+{
+  // Round up to power of two to allow masking instead of modulo
+  size_t size = 2;
+  while(size < static_cast<size_t>(queueSize))
+    size <<= 1;
+
+  mask = size - 1;
+  cells.reset(new Cell[size]);
+  for(size_t i = 0; i < size; i++)
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+
+  thread = std::thread(&LoggingWriter::run, this);
+}
+
+LoggingWriter::~LoggingWriter()
+{
+  terminate.store(true);
+  waitCondition.notify_one();
+  thread.join();
+
+  // Catch anything added by other threads while stopping
+  flush();
+}
+
+void LoggingWriter::append(QtMsgType type, const QString& message, const ChannelVector& channels)
+{
+  while(!enqueue(message, channels))
+  {
+    // Queue is full
+    if(policy == OVERFLOW_DROP && (type == QtDebugMsg || type == QtInfoMsg))
+    {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    // Wake up writer and wait for free space
+    waitCondition.notify_one();
+    std::this_thread::yield();
+  }
+
+  if(waiting.load())
+    waitCondition.notify_one();
+}
+
+void LoggingWriter::flush()
+{
+  std::lock_guard<std::mutex> lock(writeMutex);
+  while(writeBatch(BATCH_SIZE) > 0)
+    ;
+}
+
+bool LoggingWriter::enqueue(const QString& message, const ChannelVector& channels)
+{
+  Cell *cell = nullptr;
+  size_t pos = enqueuePos.load(std::memory_order_relaxed);
+  while(true)
+  {
+    cell = &cells[pos & mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+    if(diff == 0)
+    {
+      // Cell is free - try to claim it
+      if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if(diff < 0)
+      // Cell still occupied by a message from the last round - queue full
+      return false;
+    else
+      // Another producer was faster
+      pos = enqueuePos.load(std::memory_order_relaxed);
+  }
+
+  cell->message = message;
+  cell->channels = channels;
+
+  // Publish to consumer
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+bool LoggingWriter::dequeue(QString& message, ChannelVector& channels)
+{
+  Cell *cell = nullptr;
+  size_t pos = dequeuePos.load(std::memory_order_relaxed);
+  while(true)
+  {
+    cell = &cells[pos & mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+    if(diff == 0)
+    {
+      if(dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if(diff < 0)
+      // Empty or producer did not finish writing yet
+      return false;
+    else
+      pos = dequeuePos.load(std::memory_order_relaxed);
+  }
+
+  message = cell->message;
+  channels = cell->channels;
+
+  // Release memory of the message before handing the cell back to the producers
+  cell->message.clear();
+  cell->channels.clear();
+
+  cell->sequence.store(pos + mask + 1, std::memory_order_release);
+  return true;
+}
+
+bool LoggingWriter::isEmpty() const
+{
+  return enqueuePos.load() == dequeuePos.load();
+}
+
+void LoggingWriter::run()
+{
+  while(true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(waitMutex);
+      waiting.store(true);
+      waitCondition.wait_for(lock, std::chrono::milliseconds(WAIT_MS), [this]() -> bool {
+            return terminate.load() || !isEmpty();
+          });
+      waiting.store(false);
+    }
+
+    // Write in batches and release lock in between to allow flush() from other threads
+    int written = BATCH_SIZE;
+    while(written == BATCH_SIZE)
+    {
+      std::lock_guard<std::mutex> lock(writeMutex);
+      written = writeBatch(BATCH_SIZE);
+    }
+
+    if(terminate.load() && isEmpty())
+      break;
+  }
+}
+
+int LoggingWriter::writeBatch(int maxEntries)
+{
+  // This needs to be called within writeMutex lock
+  QString message;
+  ChannelVector channels, touchedChannels;
+  int numWritten = 0;
+
+  while(numWritten < maxEntries && dequeue(message, channels))
+  {
+    int numDropped = dropped.load(std::memory_order_relaxed) > 0 ? dropped.exchange(0) : 0;
+
+    for(Channel *channel : qAsConst(channels))
+    {
+      if(numDropped > 0)
+        (*channel->stream) << "[" << numDropped << " log messages dropped due to queue overflow]" << '\n';
+
+      // Do not use endl since it flushes the stream
+      (*channel->stream) << message << '\n';
+
+      if(!touchedChannels.contains(channel))
+        touchedChannels.append(channel);
+    }
+    numWritten++;
+  }
+
+  // Flush only once per batch and check file sizes for rolling
+  for(Channel *channel : qAsConst(touchedChannels))
+  {
+    channel->stream->flush();
+    config->checkStreamSize(channel);
+  }
+
+  return numWritten;
+}
+
+} // namespace internal
+} // namespace logging
+} // namespace atools
@@ -0,0 +1,115 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_LOGGING_LOGGINGWRITER_H
+#define ATOOLS_LOGGING_LOGGINGWRITER_H
+
+#include "logging/loggingtypes.h"
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace atools {
+namespace logging {
+namespace internal {
+
+class LoggingConfig;
+
+/*
+ * Background writer for asynchronous logging.
+ *
+ * Messages are passed from any number of threads through a bounded lock-free ring buffer
+ * to a single writer thread. The writer takes messages in batches, writes them to the channel
+ * streams and flushes each touched stream once per batch. File size limits and rolling are checked
+ * after each flush with the same semantics as in synchronous mode.
+ */
+class LoggingWriter
+{
+public:
+  /* queueSize is rounded up to the next power of two */
+  LoggingWriter(LoggingConfig *loggingConfig, int queueSize, OverflowPolicy overflowPolicy);
+
+  /* Writes all pending messages and stops the writer thread */
+  ~LoggingWriter();
+
+  LoggingWriter(const LoggingWriter& other) = delete;
+  LoggingWriter& operator=(const LoggingWriter& other) = delete;
+
+  /* Add a formatted message for the given channels. Does not lock unless the queue is full and
+   * the overflow policy requires waiting. */
+  void append(QtMsgType type, const QString& message, const ChannelVector& channels);
+
+  /* Write all pending messages and flush the streams on the calling thread.
+   * Used before aborting or on crash to avoid losing the last messages. */
+  void flush();
+
+private:
+  /* Slot in the ring buffer. sequence is used to synchronize producers and consumers. */
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    QString message;
+    ChannelVector channels;
+  };
+
+  bool enqueue(const QString& message, const ChannelVector& channels);
+  bool dequeue(QString& message, ChannelVector& channels);
+  bool isEmpty() const;
+
+  /* Thread function */
+  void run();
+
+  /* Take up to maxEntries messages from the queue and write them. Needs writeMutex locked.
+   * Returns number of messages written. */
+  int writeBatch(int maxEntries);
+
+  LoggingConfig *config;
+  OverflowPolicy policy;
+
+  std::unique_ptr<Cell[]> cells;
+  size_t mask;
+
+  /* Separate cache lines for producer and consumer positions */
+  alignas(64) std::atomic<size_t> enqueuePos;
+  alignas(64) std::atomic<size_t> dequeuePos;
+
+  /* Number of discarded messages since last report */
+  std::atomic_int dropped;
+
+  /* Serializes writing to streams between writer thread and flush() */
+  std::mutex writeMutex;
+
+  /* Used only to put the writer thread to sleep if the queue is empty */
+  std::mutex waitMutex;
+  std::condition_variable waitCondition;
+  std::atomic_bool waiting, terminate;
+
+  std::thread thread;
+};
+
+} // namespace internal
+} // namespace logging
+} // namespace atools
+
+#endif // ATOOLS_LOGGING_LOGGINGWRITER_H
@@ -20,6 +20,7 @@
 #include "geo/calculations.h"
 #include "io/binaryutil.h"
 #include "routing/routenetwork.h"
+#include "sql/sqlcursor.h"
 #include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
@@ -30,6 +31,7 @@
 
 using atools::sql::SqlUtil;
 using atools::sql::SqlQuery;
+using atools::sql::SqlCursor;
 using atools::geo::nmToMeter;
 using atools::geo::Point3D;
 using atools::charAt;
@@ -236,8 +238,9 @@ void RouteNetworkLoader::readTrackStartEndPoints() const
   for(const Node& node : network->getNodes())
     nodeIdIndexMap.insert(node.id, node.index);
 
-  SqlQuery query("select startpoint_id, endpoint_id from trackmeta", dbTrack);
-  query.exec();
+  SqlQuery trackQuery(dbTrack);
+  SqlCursor query(trackQuery);
+  query.exec("select startpoint_id, endpoint_id from trackmeta");
   while(query.next())
   {
     network->nodeIndex[nodeIdIndexMap.value(query.valueInt(STARTPOINT_ID))].addConnection(CONNECTION_TRACK_START_END);
@@ -286,8 +289,10 @@ void RouteNetworkLoader::readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, boo
     TRACK_TYPE
   };
 
-  SqlQuery query(queryTxt, track ? dbTrack : dbNav);
-  query.exec();
+  // Use cursor to avoid per value checks and row caching in the driver
+  SqlQuery edgeQuery(track ? dbTrack : dbNav);
+  SqlCursor query(edgeQuery);
+  query.exec(queryTxt);
   while(query.next())
   {
     Edge edge;
@@ -372,7 +377,7 @@ void RouteNetworkLoader::readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, boo
         edge.hasAltLevels = true;
         network->altLevelsEast.insert(edge.id,
                                       atools::io::readVector<quint16, quint16>(
-                                        query.value(ALT_LEVELS_EAST).toByteArray()));
+                                        query.valueBytes(ALT_LEVELS_EAST)));
       }
 
       if(!query.isNull(ALT_LEVELS_WEST))
@@ -380,7 +385,7 @@ void RouteNetworkLoader::readEdgesAirway(QMultiHash<int, Edge>& nodeEdgeMap, boo
         edge.hasAltLevels = true;
         network->altLevelsWest.insert(edge.id,
                                       atools::io::readVector<quint16, quint16>(
-                                        query.value(ALT_LEVELS_WEST).toByteArray()));
+                                        query.valueBytes(ALT_LEVELS_WEST)));
       }
 
       // Forward only track is always running from/to
@@ -436,8 +441,9 @@ void RouteNetworkLoader::readNodesAirway(QVector<Node>& nodes, QHash<int, int>&
     }
   }
 
-  SqlQuery query(queryStr, track ? dbTrack : dbNav);
-  query.exec();
+  SqlQuery nodeQuery(track ? dbTrack : dbNav);
+  SqlCursor query(nodeQuery);
+  query.exec(queryStr);
   while(query.next())
   {
     int nodeId = query.valueInt(ID);
@@ -493,7 +499,7 @@ void RouteNetworkLoader::readNodesAirway(QVector<Node>& nodes, QHash<int, int>&
     // Connection flags are populated later by analyzing edges
 
     if(node.type == NODE_NONE)
-      qWarning() << Q_FUNC_INFO << "No node type" << query.record();
+      qWarning() << Q_FUNC_INFO << "No node type" << nodeQuery.record();
 
     nodes.append(node);
     nodeIdIndexMap.insert(node.id, node.index);
@@ -513,8 +519,9 @@ void RouteNetworkLoader::readNodesRadio(const QString& queryStr, bool vor)
     HAS_DME
   };
 
-  SqlQuery query(queryStr, dbNav);
-  query.exec();
+  SqlQuery nodeQuery(dbNav);
+  SqlCursor query(nodeQuery);
+  query.exec(queryStr);
   while(query.next())
   {
     Node node;
@@ -27,6 +27,7 @@
 #include "sql/sqlutil.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QStringBuilder>
 #include <QAction>
 
@@ -194,6 +195,7 @@ void DataManagerBase::insertOneRecord(SqlRecord record, int id)
 
   // Insert id in record if id column is 0 or missing
   updateIdColumn(record, id);
+  updateDerivedColumns(record);
   preUndoInsert({record});
 
   queryInsertRecords->bindAndExecRecord(record, ":");
@@ -206,7 +208,10 @@ void DataManagerBase::insertRecords(sql::SqlRecordList records)
 
   // Insert id in records if id column is 0 or missing
   for(SqlRecord& record : records)
+  {
     updateIdColumn(record, getNextId());
+    updateDerivedColumns(record);
+  }
 
   preUndoInsert(records);
   queryInsertRecords->bindAndExecRecords(records, ":");
@@ -227,7 +232,19 @@ void DataManagerBase::updateField(const QString& column, const QSet<int>& ids, c
 {
   if(!ids.isEmpty())
   {
+    SqlRecord record;
+    record.appendFieldAndValue(column, value);
+    updateDerivedColumns(record);
+
     preUndoUpdate(ids);
+    if(record.count() > 1)
+    {
+      // Derived columns added - update all together
+      updateRecordsInternal(record, ids);
+      postUndo();
+      return;
+    }
+
     SqlQuery query(db);
     query.prepare("update " + tableName + " set " + column + " = ? where " + idColumnName + " = ?");
 
@@ -257,8 +274,11 @@ void DataManagerBase::updateRecords(const sql::SqlRecord& record, const QSet<int
 {
   if(!ids.isEmpty())
   {
+    SqlRecord derivedRecord(record);
+    updateDerivedColumns(derivedRecord);
+
     preUndoUpdate(ids);
-    updateRecordsInternal(record, ids);
+    updateRecordsInternal(derivedRecord, ids);
     postUndo();
   }
 }
@@ -550,23 +570,17 @@ void DataManagerBase::postUndoBulkInsert()
     initCurrentId();
     db->analyze(); // Avoid long running queries
 
-    // Fetch all ids that were inserted in the bulk import
-    SqlQuery select(db);
-    select.prepare("select * from " % tableName % " where " % idColumnName % " between ? and ?");
-    select.bindValue(0, preBulkInsertId);
-    select.bindValue(1, currentId);
-    select.exec();
+    // Stage all ids that were inserted in the bulk import
+    clearUndoIds();
+    SqlQuery stage(db);
+    stage.prepare("insert into temp.undo_ids (id) select " % idColumnName % " from " % tableName %
+                  " where " % idColumnName % " between ? and ?");
+    stage.bindValue(0, preBulkInsertId);
+    stage.bindValue(1, currentId);
+    stage.exec();
 
-    // Add all  records to the undo table - this is one undo group
-    while(select.next())
-    {
-      SqlRecord rec = select.record();
-      rec.insertFieldAndValue(0, "undo_data_id", ++currentUndoId);
-      rec.insertFieldAndValue(1, "undo_group_id", currentUndoGroupId);
-      rec.insertFieldAndValue(2, "undo_type", atools::charToStr(UNDO_INSERT));
-      queryInsertUndoData->bindRecord(rec, ":");
-      queryInsertUndoData->exec();
-    }
+    // Add all records to the undo table - this is one undo group
+    copyStagedToUndo(UNDO_INSERT);
 
     // Update current id
     preBulkInsertId = -1;
@@ -588,17 +602,10 @@ void DataManagerBase::preUndoDeleteAll()
     currentUndoGroupId++;
 
     // Add all records to delete to the undo table
-    SqlQuery selectQuery("select * from " % tableName, db);
-    selectQuery.exec();
-    while(selectQuery.next())
-    {
-      SqlUtil::copyRowValues(selectQuery, *queryInsertUndoData);
-
-      queryInsertUndoData->bindValue(":undo_data_id", ++currentUndoId);
-      queryInsertUndoData->bindValue(":undo_group_id", currentUndoGroupId);
-      queryInsertUndoData->bindValue(":undo_type", atools::charToStr(UNDO_DELETE));
-      queryInsertUndoData->exec();
-    }
+    clearUndoIds();
+    SqlQuery query(db);
+    query.exec("insert into temp.undo_ids (id) select " % idColumnName % " from " % tableName);
+    copyStagedToUndo(UNDO_DELETE);
   }
 }
 
@@ -619,20 +626,53 @@ void DataManagerBase::preUndoCopyInternal(const QSet<int>& ids, UndoAction actio
     truncateUndoIf();
     currentUndoGroupId++;
 
-    QueryWrapper wrapped("select * from " % tableName, db, ids, idColumnName);
-    wrapped.exec();
-    while(wrapped.next())
+    // Stage ids in temporary table and copy all rows with one statement
+    clearUndoIds();
+    SqlQuery stage(db);
+    stage.prepare("insert into temp.undo_ids (id) values(?)");
+    for(int id : ids)
     {
-      SqlUtil::copyRowValues(wrapped.query, *queryInsertUndoData);
-
-      queryInsertUndoData->bindValue(":undo_data_id", ++currentUndoId);
-      queryInsertUndoData->bindValue(":undo_group_id", currentUndoGroupId);
-      queryInsertUndoData->bindValue(":undo_type", atools::charToStr(action));
-      queryInsertUndoData->exec();
+      stage.bindValue(0, id);
+      stage.exec();
     }
+
+    copyStagedToUndo(action);
   }
 }
 
+void DataManagerBase::clearUndoIds()
+{
+  // Sequence is used to number the undo rows. Starts at one again after deleting since no autoincrement is used.
+  SqlQuery query(db);
+  query.exec("create temp table if not exists undo_ids (seq integer primary key, id integer not null)");
+  query.exec("delete from temp.undo_ids");
+}
+
+void DataManagerBase::copyStagedToUndo(UndoAction action)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  SqlQuery insert(db);
+  insert.prepare("insert into undo_data (undo_data_id, undo_group_id, undo_type, " % undoColumnList() % ") "
+                 "select :base + u.seq, :group, :type, " % undoColumnList("t.") % " from " % tableName % " t "
+                 "join temp.undo_ids u on t." % idColumnName % " = u.id");
+  insert.bindValue(":base", currentUndoId);
+  insert.bindValue(":group", currentUndoGroupId);
+  insert.bindValue(":type", atools::charToStr(action));
+  insert.exec();
+  int rows = insert.numRowsAffected();
+
+  currentUndoId = util->getMaxId("undo_data", "undo_data_id");
+
+  qDebug() << Q_FUNC_INFO << "Copied" << rows << "rows to undo in" << timer.elapsed() << "ms";
+}
+
+QString DataManagerBase::undoColumnList(const QString& prefix) const
+{
+  return db->record(tableName, prefix).fieldNames().join(", ");
+}
+
 void DataManagerBase::postUndo()
 {
   // Write current undo state to database
@@ -651,99 +691,114 @@ void DataManagerBase::checkUndoTable(const QString& table)
 
 void DataManagerBase::undoRedo(bool undo)
 {
-  bool canceled = false;
-  int undoGroupId = currentUndoGroupId;
-
   if(undoActive)
   {
-    if(!undo)
-      // Increment before for redo
-      undoGroupId++;
-
-    int total = undoRedoStepCount(undo, nullptr), current = 0;
+    QElapsedTimer timer;
+    timer.start();
 
-    // Get all records from the undo table for the current step to undo/redo
-    selectUndoByGroup->bindValue(":id", undoGroupId);
-    selectUndoByGroup->exec();
+    // Undo id points to the step which will be reverted - increment before for redo
+    int undoGroupId = undo ? currentUndoGroupId : currentUndoGroupId + 1;
 
-    while(selectUndoByGroup->next())
-    {
-      SqlRecord undoRec = selectUndoByGroup->record();
+    // All rows in an undo group have the same type
+    UndoAction action = UNDO_INVALID;
+    int total = undoRedoStepCount(undo, &action);
 
-      // Get all undo table values before removing the fields
-      UndoAction action = static_cast<UndoAction>(atools::strToChar(undoRec.valueStr("undo_type")));
-      int id = undoRec.valueInt(idColumnName);
-      int undoDataId = undoRec.valueInt("undo_data_id");
+    // Changes are applied at once with set based statements - callback can only cancel before
+    if(!invokeCallback(total, 0))
+      return;
 
-      // Get rid if fields except the ones from the main table
-      undoRec.remove({"undo_data_id", "undo_group_id", "undo_type"});
+    switch(action)
+    {
+      case atools::sql::DataManagerBase::UNDO_INSERT:
+        if(undo)
+          // Revert insert - delete values and keep copy in undo table for redo
+          deleteUndoGroupRows(undoGroupId);
+        else
+          // Insert again - keep copy in undo table for undo
+          insertUndoGroupRows(undoGroupId);
+        break;
 
-      switch(action)
-      {
-        case atools::sql::DataManagerBase::UNDO_INSERT:
-          if(undo)
-            // Revert insert - delete value and keep copy in undo table for redo
-            deleteRowsInternal({id});
-          else
-          {
-            // Insert again - keep copy in undo table for undo
-            updateIdColumn(undoRec, id);
-            queryInsertRecords->bindAndExecRecord(undoRec, ":");
-          }
-          break;
+      case atools::sql::DataManagerBase::UNDO_UPDATE:
+        // Undo: Revert update - swap values
+        // Redo: Apply update again - swap values
+        swapUndoGroupRows(undoGroupId);
+        break;
 
-        case atools::sql::DataManagerBase::UNDO_UPDATE:
-          {
-            // Undo: Revert update - swap values
-            // Redo: Apply update again - swap values
+      case atools::sql::DataManagerBase::UNDO_DELETE:
+        if(undo)
+          // Revert delete - insert values from undo table and keep copy in undo table for redo
+          insertUndoGroupRows(undoGroupId);
+        else
+          // Delete again - keep copy in undo table for undo
+          deleteUndoGroupRows(undoGroupId);
+        break;
 
-            // Get temporary values from main table
-            SqlRecord tempRecord = getRecord(id);
+      case atools::sql::DataManagerBase::UNDO_INVALID:
+        break;
+    }
 
-            // Copy from undo table back to original table
-            updateRecordsInternal(undoRec, {id});
+    if(undo)
+      undoGroupId--;
 
-            // Update undo table with temp value from original table
-            updateUndoById->bindRecord(tempRecord, ":");
-            updateUndoById->bindValue(":id", undoDataId);
-            updateUndoById->exec();
-          }
-          break;
+    currentUndoGroupId = undoGroupId;
 
-        case atools::sql::DataManagerBase::UNDO_DELETE:
-          if(undo)
-          {
-            // Revert delete - insert values from undo table and keep copy in undo table for redo
-            updateIdColumn(undoRec, id);
-            queryInsertRecords->bindAndExecRecord(undoRec, ":");
-          }
-          else
-            // Delete again - keep copy in undo table for undo
-            deleteRowsInternal({id});
-          break;
+    syncCurrentUndoGroupToDb();
+    updateUndoRedoActions();
 
-        case atools::sql::DataManagerBase::UNDO_INVALID:
-          break;
-      }
+    qDebug() << Q_FUNC_INFO << (undo ? "Undo" : "Redo") << total << "rows in" << timer.elapsed() << "ms";
+  }
+}
 
-      if(!invokeCallback(total, current++))
-      {
-        canceled = true;
-        break;
-      }
-    }
+void DataManagerBase::deleteUndoGroupRows(int undoGroupId)
+{
+  SqlQuery query(db);
+  query.prepare("delete from " % tableName % " where " % idColumnName % " in "
+                "(select " % idColumnName % " from undo_data where undo_group_id = ?)");
+  query.bindValue(0, undoGroupId);
+  query.exec();
+}
 
-    if(!canceled)
-    {
-      if(undo)
-        undoGroupId--;
+void DataManagerBase::insertUndoGroupRows(int undoGroupId)
+{
+  const QString columns = undoColumnList();
+  SqlQuery query(db);
+  query.prepare("insert into " % tableName % " (" % columns % ") select " % columns % " from undo_data where undo_group_id = ?");
+  query.bindValue(0, undoGroupId);
+  query.exec();
+}
 
-      currentUndoGroupId = undoGroupId;
+void DataManagerBase::swapUndoGroupRows(int undoGroupId)
+{
+  const QString columns = undoColumnList();
 
-      syncCurrentUndoGroupToDb();
-      updateUndoRedoActions();
-    }
-  }
+  // Save current values from main table - recreate since columns might have been added
+  SqlQuery query(db);
+  query.exec("drop table if exists temp.undo_swap");
+  query.exec("create temp table undo_swap as select 0 as undo_data_id, " % columns % " from " % tableName % " where 0");
+
+  SqlQuery save(db);
+  save.prepare("insert into temp.undo_swap (undo_data_id, " % columns % ") "
+               "select u.undo_data_id, " % undoColumnList("t.") % " from " % tableName % " t "
+               "join undo_data u on t." % idColumnName % " = u." % idColumnName % " where u.undo_group_id = ?");
+  save.bindValue(0, undoGroupId);
+  save.exec();
+
+  // Copy from undo table back to original table
+  SqlQuery restore(db);
+  restore.prepare("insert or replace into " % tableName % " (" % columns % ") "
+                  "select " % columns % " from undo_data where undo_group_id = ?");
+  restore.bindValue(0, undoGroupId);
+  restore.exec();
+
+  // Update undo table with saved values from original table
+  SqlQuery update(db);
+  update.prepare("insert or replace into undo_data (undo_data_id, undo_group_id, undo_type, " % columns % ") "
+                 "select undo_data_id, ?, ?, " % columns % " from temp.undo_swap");
+  update.bindValue(0, undoGroupId);
+  update.bindValue(1, atools::charToStr(UNDO_UPDATE));
+  update.exec();
+
+  query.exec("drop table if exists temp.undo_swap");
 }
 
 void DataManagerBase::updateUndoRedoActions()
@@ -950,12 +1005,6 @@ void DataManagerBase::initQueries()
     querySelectUndoByGroup = new SqlQuery(db);
     querySelectUndoByGroup->prepare("select undo_type, count(1) from undo_data where undo_group_id = ? group by undo_group_id");
 
-    updateUndoById = new SqlQuery(db);
-    updateUndoById->prepare(util->buildUpdateStatement("undo_data", "undo_data_id = :id", {"undo_data_id", "undo_group_id", "undo_type"}));
-
-    selectUndoByGroup = new SqlQuery(db);
-    selectUndoByGroup->prepare("select * from undo_data where undo_group_id = :id");
-
     queryInsertUndoData = new SqlQuery(db);
     queryInsertUndoData->prepare(util->buildInsertStatement("undo_data"));
   }
@@ -990,12 +1039,6 @@ void DataManagerBase::deInitQueries()
   delete querySelectUndoByGroup;
   querySelectUndoByGroup = nullptr;
 
-  delete updateUndoById;
-  updateUndoById = nullptr;
-
-  delete selectUndoByGroup;
-  selectUndoByGroup = nullptr;
-
   delete queryInsertUndoData;
   queryInsertUndoData = nullptr;
 
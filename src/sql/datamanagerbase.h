@@ -81,13 +81,16 @@ public:
   /* true if all two undo tables are present */
   bool hasUndoSchema() const;
 
-  /* Undo last change. Call canUndo() before running this to check if steps are available. */
+  /* Undo last change. Call canUndo() before running this to check if steps are available.
+   * All rows of the step are changed at once by set based statements. Progress callback is called at most once
+   * before with current number 0 which allows to cancel. No progress is reported while the step is applied. */
   void undo()
   {
     undoRedo(true);
   }
 
-  /* Redo last change. Call canRedo() before running this to check if steps are available. */
+  /* Redo last change. Call canRedo() before running this to check if steps are available.
+   * Reports progress like undo(). */
   void redo()
   {
     undoRedo(false);
@@ -252,7 +255,9 @@ public:
     return undoRedoStepCount(false /* undo */, nullptr);
   }
 
-  /* return false to stop calculation. */
+  /* return false to stop calculation.
+   * undo() and redo() call this at most once before changing any rows. A progress dialog cannot show progress
+   * or cancel while the rows are changed. */
   typedef std::function<bool (int totalNumber, int currentNumber)> UndoRedoCallbackType;
 
   void setProgressCallback(UndoRedoCallbackType progressCallback)
@@ -325,6 +330,12 @@ private:
    * Returns true if table was changed. */
   bool addColumnIf(const QString& colName, const QString& colType);
 
+  /* Called for each record before it is inserted or updated in the main table. Override to add or update
+   * columns which are derived from other columns in the record. */
+  virtual void updateDerivedColumns(atools::sql::SqlRecord&)
+  {
+  }
+
   atools::sql::SqlDatabase *db = nullptr;
 
   QString tableName, idColumnName;
@@ -347,11 +358,25 @@ private:
   void preUndoCopyInternal(const QSet<int>& ids, UndoAction undoAction);
   void preUndoDeleteAll();
 
+  /* Create or clear the temporary table "undo_ids" which stages the main table ids to copy to the undo table */
+  void clearUndoIds();
+
+  /* Copy all main table rows for ids staged in table "undo_ids" to the undo table with one statement */
+  void copyStagedToUndo(UndoAction action);
+
+  /* Comma separated list of main table columns. Prefix is added to each column. */
+  QString undoColumnList(const QString& prefix = QString()) const;
+
   /* Copies current undo_group_id to table undo_current */
   void postUndo();
 
   void undoRedo(bool undo);
 
+  /* Set based undo and redo steps for all rows in an undo group */
+  void deleteUndoGroupRows(int undoGroupId);
+  void insertUndoGroupRows(int undoGroupId);
+  void swapUndoGroupRows(int undoGroupId);
+
   QString undoRedoStepName(bool undo) const;
 
   /* Check if user tries to modify main table bypassing undo with undo system enabled. Throws exception. */
@@ -385,8 +410,8 @@ private:
   QAction *undoAction = nullptr, *redoAction = nullptr;
 
   atools::sql::SqlQuery *queryUndoCurrent = nullptr, *queryTruncateUndoData = nullptr, *selectMinMax = nullptr,
-                        *queryTruncateUndoDataCurrent = nullptr, *querySelectUndoByGroup = nullptr, *updateUndoById = nullptr,
-                        *selectUndoByGroup = nullptr, *queryInsertUndoData = nullptr, *queryDeleteRowById = nullptr,
+                        *queryTruncateUndoDataCurrent = nullptr, *querySelectUndoByGroup = nullptr,
+                        *queryInsertUndoData = nullptr, *queryDeleteRowById = nullptr,
                         *queryInsertRecords = nullptr, *querySelectById = nullptr;
 
   UndoRedoCallbackType callback;
@@ -0,0 +1,74 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "sql/sqlcursor.h"
+
+#include "sql/sqlexception.h"
+#include "sql/sqlquery.h"
+
+#include <QStringBuilder>
+
+namespace atools {
+namespace sql {
+
+SqlCursor::SqlCursor(SqlQuery *queryParam)
+  : sqlQuery(queryParam), query(&queryParam->query)
+{
+}
+
+SqlCursor::SqlCursor(SqlQuery& queryParam)
+  : sqlQuery(&queryParam), query(&queryParam.query)
+{
+}
+
+void SqlCursor::exec()
+{
+  prepareExec();
+  sqlQuery->exec();
+  finishExec();
+}
+
+void SqlCursor::exec(const QString& queryStr)
+{
+  prepareExec();
+  sqlQuery->exec(queryStr);
+  finishExec();
+}
+
+void SqlCursor::prepareExec()
+{
+  // Keeps the driver from caching all rows which are not needed when iterating once
+  query->setForwardOnly(true);
+}
+
+void SqlCursor::finishExec()
+{
+  // Copy record once - calling QSqlQuery::record() or value(name) for each row is expensive
+  record = query->record();
+}
+
+int SqlCursor::index(const QString& name) const
+{
+  int idx = record.indexOf(name);
+  if(idx == -1)
+    throw SqlException(QLatin1String(Q_FUNC_INFO) % ": Column \"" % name % "\" does not exist in query \"" %
+                       sqlQuery->getQueryString() % "\"");
+  return idx;
+}
+
+} // namespace sql
+} // namespace atools
@@ -0,0 +1,142 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_SQL_SQLCURSOR_H
+#define ATOOLS_SQL_SQLCURSOR_H
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QVariant>
+
+namespace atools {
+namespace sql {
+
+class SqlQuery;
+
+/*
+ * Fast forward only cursor for loops reading large result sets.
+ *
+ * The wrapped query is set to forward only before execution which avoids caching of all rows in the driver.
+ * Columns are resolved once by name using index() after executing. The typed getters then read the current
+ * row by index without the name lookups and error checks done for each value in SqlQuery.
+ * Values have to be read with the correct column type. No checks for invalid indexes except in debug builds.
+ *
+ * SqlException is thrown for errors when executing or for unknown column names.
+ */
+class SqlCursor
+{
+public:
+  /* Query has to be prepared and bound but not executed */
+  explicit SqlCursor(atools::sql::SqlQuery *queryParam);
+  explicit SqlCursor(atools::sql::SqlQuery& queryParam);
+
+  /* Set to forward only and execute the prepared query */
+  void exec();
+
+  /* Set to forward only and execute the given query string */
+  void exec(const QString& queryStr);
+
+  /* Move to the next row. Returns false if no more rows are available. */
+  bool next()
+  {
+    return query->next();
+  }
+
+  /* Get index for column name. Call once before looping. Throws SqlException if the column does not exist. */
+  int index(const QString& name) const;
+
+  /* As above but returns -1 if the column does not exist */
+  int indexOrNull(const QString& name) const
+  {
+    return record.indexOf(name);
+  }
+
+  /* Number of columns in result */
+  int count() const
+  {
+    return record.count();
+  }
+
+  bool isNull(int col) const
+  {
+    Q_ASSERT(col >= 0 && col < record.count());
+    return query->isNull(col);
+  }
+
+  /* Typed getters for the current row */
+  int valueInt(int col) const
+  {
+    Q_ASSERT(col >= 0 && col < record.count());
+    return query->value(col).toInt();
+  }
+
+  qint64 valueLongLong(int col) const
+  {
+    Q_ASSERT(col >= 0 && col < record.count());
+    return query->value(col).toLongLong();
+  }
+
+  float valueFloat(int col) const
+  {
+    Q_ASSERT(col >= 0 && col < record.count());
+    return query->value(col).toFloat();
+  }
+
+  double valueDouble(int col) const
+  {
+    Q_ASSERT(col >= 0 && col < record.count());
+    return query->value(col).toDouble();
+  }
+
+  bool valueBool(int col) const
+  {
+    Q_ASSERT(col >= 0 && col < record.count());
+    return query->value(col).toBool();
+  }
+
+  QString valueStr(int col) const
+  {
+    Q_ASSERT(col >= 0 && col < record.count());
+    return query->value(col).toString();
+  }
+
+  /* Blob value. The returned array shares the buffer read by the driver without copying the data. */
+  QByteArray valueBytes(int col) const
+  {
+    Q_ASSERT(col >= 0 && col < record.count());
+    return query->value(col).toByteArray();
+  }
+
+  QVariant value(int col) const
+  {
+    Q_ASSERT(col >= 0 && col < record.count());
+    return query->value(col);
+  }
+
+private:
+  void prepareExec();
+  void finishExec();
+
+  atools::sql::SqlQuery *sqlQuery;
+  QSqlQuery *query;
+  QSqlRecord record;
+};
+
+} // namespace sql
+} // namespace atools
+
+#endif // ATOOLS_SQL_SQLCURSOR_H
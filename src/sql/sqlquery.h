@@ -259,6 +259,7 @@ public:
 
 private:
   friend class SqlDatabase;
+  friend class SqlCursor;
 
   SqlQuery(const QSqlQuery& otherQuery, QString queryStr);
 
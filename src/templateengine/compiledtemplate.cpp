@@ -0,0 +1,357 @@
+/**
+ *  @file
+ *  @author Stefan Frings
+ */
+
+#include "compiledtemplate.h"
+
+using namespace stefanfrings;
+
+/** Names of variables, conditions and loops cannot contain white space */
+static bool isValidName(const QString& name)
+{
+  if(name.isEmpty())
+  {
+    return false;
+  }
+  for(const QChar& c : name)
+  {
+    if(c.isSpace())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+CompiledTemplate::CompiledTemplate(const QString& source, const QString& sourceName)
+  : source(source), sourceName(sourceName)
+{
+  Type terminator;
+  parse(0, QString(), false, terminator);
+}
+
+int CompiledTemplate::parse(int pos, const QString& endName, bool allowElse, Type& terminator)
+{
+  terminator = LITERAL;
+  while(pos < source.length())
+  {
+    int open = source.indexOf('{', pos);
+    if(open < 0)
+    {
+      break;
+    }
+    addLiteral(pos, open - pos);
+
+    int close = source.indexOf('}', open + 1);
+    if(close < 0)
+    {
+      pos = open;
+      break;
+    }
+
+    int nextOpen = source.indexOf('{', open + 1);
+    if(nextOpen >= 0 && nextOpen < close)
+    {
+      // Not a tag - continue at next opening brace
+      addLiteral(open, nextOpen - open);
+      pos = nextOpen;
+      continue;
+    }
+
+    QString tag = source.mid(open + 1, close - open - 1);
+    int tagLength = close - open + 1;
+    pos = close + 1;
+
+    Type type = LITERAL;
+    QString name;
+    int space = tag.indexOf(' ');
+    if(space > 0)
+    {
+      QString keyword = tag.left(space);
+      name = tag.mid(space + 1);
+      if(keyword == "if")
+      {
+        type = IF;
+      }
+      else if(keyword == "ifnot")
+      {
+        type = IFNOT;
+      }
+      else if(keyword == "loop")
+      {
+        type = LOOP;
+      }
+      else if(keyword == "else")
+      {
+        type = ELSE;
+      }
+      else if(keyword == "end")
+      {
+        type = END;
+      }
+
+      if(!isValidName(name))
+      {
+        type = LITERAL;
+      }
+    }
+    else if(isValidName(tag))
+    {
+      type = VARIABLE;
+      name = tag;
+    }
+
+    switch(type)
+    {
+      case LITERAL:
+        addLiteral(open, tagLength);
+        break;
+
+      case VARIABLE:
+        instructions.append({VARIABLE, 0, 0, name, -1, -1});
+        break;
+
+      case ELSE:
+      case END:
+        if(name == endName && !endName.isEmpty() && (type == END || allowElse))
+        {
+          // Closes the current block
+          terminator = type;
+          return pos;
+        }
+        // Does not belong to any open block
+        addLiteral(open, tagLength);
+        break;
+
+      case IF:
+      case IFNOT:
+      case LOOP:
+        if(source.indexOf("{end " + name + "}", pos) < 0)
+        {
+          qWarning("Template: missing %s end {end %s} in %s", type == LOOP ? "loop" : "condition",
+                   qPrintable(name), qPrintable(sourceName));
+          addLiteral(open, tagLength);
+        }
+        else
+        {
+          int blockIndex = instructions.size();
+          instructions.append({type, 0, 0, name, -1, -1});
+
+          Type blockTerminator;
+          pos = parse(pos, name, true, blockTerminator);
+          if(blockTerminator == ELSE)
+          {
+            instructions[blockIndex].elseIndex = instructions.size();
+            instructions.append({ELSE, 0, 0, name, -1, -1});
+            pos = parse(pos, name, false, blockTerminator);
+          }
+
+          if(blockTerminator != END)
+          {
+            // End tag was consumed by a nested block with the same name - end at the end of the source
+            qWarning("Template: missing %s end {end %s} in %s", type == LOOP ? "loop" : "condition",
+                     qPrintable(name), qPrintable(sourceName));
+          }
+          instructions[blockIndex].endIndex = instructions.size();
+          instructions.append({END, 0, 0, name, -1, -1});
+        }
+        break;
+    }
+  }
+
+  addLiteral(pos, source.length() - pos);
+  return source.length();
+}
+
+void CompiledTemplate::addLiteral(int start, int length)
+{
+  if(length <= 0)
+  {
+    return;
+  }
+
+  literalLength += length;
+  if(!instructions.isEmpty())
+  {
+    Instruction& last = instructions.last();
+    if(last.type == LITERAL && last.start + last.length == start)
+    {
+      last.length += length;
+      return;
+    }
+  }
+  instructions.append({LITERAL, start, length, QString(), -1, -1});
+}
+
+QString CompiledTemplate::resolveName(const QString& name, const QVector<Frame>& stack)
+{
+  QString resolved = name;
+  for(const Frame& frame : stack)
+  {
+    // Only active loop iterations number names - condition frames have no repetitions
+    if(!frame.unset && frame.counter < frame.repetitions)
+    {
+      int length = frame.name.length();
+      if(resolved.length() > length && resolved.at(length) == '.' && resolved.startsWith(frame.name))
+      {
+        resolved = frame.name + QString::number(frame.counter) + resolved.mid(length);
+      }
+    }
+  }
+  return resolved;
+}
+
+int CompiledTemplate::nextIteration(QVector<Frame>& stack, const Instruction& instruction) const
+{
+  Frame& frame = stack.last();
+  frame.counter++;
+  if(frame.counter < frame.repetitions)
+  {
+    return frame.index + 1;
+  }
+
+  stack.removeLast();
+  return instruction.endIndex + 1;
+}
+
+QString CompiledTemplate::render(const TemplateValues& values) const
+{
+  QString out;
+  out.reserve(literalLength + values.valueLength);
+
+  QVector<Frame> stack;
+  int index = 0;
+  while(index < instructions.size())
+  {
+    const Instruction& instruction = instructions.at(index);
+    switch(instruction.type)
+    {
+      case LITERAL:
+        out.append(source.constData() + instruction.start, instruction.length);
+        index++;
+        break;
+
+      case VARIABLE:
+      {
+        QString name = resolveName(instruction.name, stack);
+        auto it = values.variables.constFind(name);
+        if(it != values.variables.constEnd())
+        {
+          out.append(it.value());
+        }
+        else
+        {
+          // Keep tag like Template does
+          out.append('{').append(name).append('}');
+        }
+        index++;
+        break;
+      }
+
+      case IF:
+      case IFNOT:
+      {
+        QString name = resolveName(instruction.name, stack);
+        auto it = values.conditions.constFind(name);
+        if(it == values.conditions.constEnd())
+        {
+          stack.append({index, true, 0, 0, name});
+          out.append(instruction.type == IF ? "{if " : "{ifnot ").append(name).append('}');
+          index++;
+        }
+        else if(it.value() == (instruction.type == IF))
+        {
+          // True part
+          stack.append({index, false, 0, 0, name});
+          index++;
+        }
+        else if(instruction.elseIndex >= 0)
+        {
+          // False part
+          stack.append({index, false, 0, 0, name});
+          index = instruction.elseIndex + 1;
+        }
+        else
+        {
+          index = instruction.endIndex + 1;
+        }
+        break;
+      }
+
+      case LOOP:
+      {
+        QString name = resolveName(instruction.name, stack);
+        auto it = values.loops.constFind(name);
+        if(it == values.loops.constEnd())
+        {
+          stack.append({index, true, 0, 0, name});
+          out.append("{loop ").append(name).append('}');
+          index++;
+        }
+        else if(it.value() > 0)
+        {
+          stack.append({index, false, 0, it.value(), name});
+          index++;
+        }
+        else if(instruction.elseIndex >= 0)
+        {
+          // Zero repetitions - else part
+          stack.append({index, false, 0, 0, name});
+          index = instruction.elseIndex + 1;
+        }
+        else
+        {
+          index = instruction.endIndex + 1;
+        }
+        break;
+      }
+
+      case ELSE:
+      {
+        const Frame& frame = stack.last();
+        const Instruction& block = instructions.at(frame.index);
+        if(frame.unset)
+        {
+          out.append("{else ").append(frame.name).append('}');
+          index++;
+        }
+        else if(block.type == LOOP && frame.repetitions > 0)
+        {
+          // End of loop body
+          index = nextIteration(stack, block);
+        }
+        else
+        {
+          // End of true part - skip else part
+          stack.removeLast();
+          index = block.endIndex + 1;
+        }
+        break;
+      }
+
+      case END:
+      {
+        const Frame& frame = stack.last();
+        const Instruction& block = instructions.at(frame.index);
+        if(frame.unset)
+        {
+          out.append("{end ").append(frame.name).append('}');
+          stack.removeLast();
+          index++;
+        }
+        else if(block.type == LOOP && frame.repetitions > 0)
+        {
+          index = nextIteration(stack, block);
+        }
+        else
+        {
+          stack.removeLast();
+          index++;
+        }
+        break;
+      }
+    }
+  }
+  return out;
+}
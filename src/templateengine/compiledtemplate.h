@@ -0,0 +1,178 @@
+/**
+ *  @file
+ *  @author Stefan Frings
+ */
+
+#ifndef COMPILEDTEMPLATE_H
+#define COMPILEDTEMPLATE_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include "templateglobal.h"
+
+namespace stefanfrings {
+
+/**
+ *  Values for rendering a CompiledTemplate. Names and numbering of loop variables
+ *  are the same as for Template:
+ *  <p><code><pre>
+ *  TemplateValues v;
+ *  v.setVariable("username", "Stefan");
+ *  v.setCondition("locked",false);
+ *  v.loop("user",2);
+ *  v.setVariable("user0.name,"Markus");
+ *  v.setVariable("user1.name,"Roland");
+ *  </pre></code></p>
+ *  @see CompiledTemplate
+ */
+
+class DECLSPEC TemplateValues
+{
+public:
+  /**
+   *  Set the value of a variable. Affects tags with the syntax {name}.
+   *  The value is inserted as is and not scanned for further tags.
+   */
+  void setVariable(const QString& name, const QString& value)
+  {
+    variables.insert(name, value);
+    valueLength += value.length();
+  }
+
+  /**
+   *  Set a condition. Affects {if name}, {ifnot name}, {else name} and {end name}.
+   */
+  void setCondition(const QString& name, bool value)
+  {
+    conditions.insert(name, value);
+  }
+
+  /**
+   *  Set number of repetitions of a loop. Affects {loop name}, {else name} and {end name}.
+   */
+  void loop(const QString& name, int repetitions)
+  {
+    Q_ASSERT(repetitions >= 0);
+    loops.insert(name, repetitions);
+  }
+
+private:
+  friend class CompiledTemplate;
+
+  QHash<QString, QString> variables;
+  QHash<QString, bool> conditions;
+  QHash<QString, int> loops;
+
+  /** Sum of all variable lengths used to estimate the output size */
+  int valueLength = 0;
+};
+
+/**
+ *  Template which is parsed once into a list of instructions (literal text, variables,
+ *  conditions and loops) and can be rendered any number of times with different values.
+ *  Rendering is a single pass over the instruction list into a preallocated buffer
+ *  instead of repeated search and replace on the whole text as done by Template.
+ *  <p>
+ *  Syntax is the same as for Template. Tags without a value are kept in the output
+ *  like Template does for variables, conditions and loops which are never set.
+ *  <p>
+ *  Objects are immutable after construction and can be shared between threads.
+ *  @see Template
+ *  @see TemplateLoader::getCompiledTemplate
+ */
+
+class DECLSPEC CompiledTemplate
+{
+public:
+  /**
+   *  Parse the template source.
+   *  @param source The template source text
+   *  @param sourceName Name of the source file, used for logging
+   */
+  CompiledTemplate(const QString& source, const QString& sourceName);
+
+  /**
+   *  Render the template with the given values.
+   *  This method is thread safe.
+   */
+  QString render(const TemplateValues& values) const;
+
+  /** True if the source text was empty */
+  bool isEmpty() const
+  {
+    return source.isEmpty();
+  }
+
+  const QString& getSourceName() const
+  {
+    return sourceName;
+  }
+
+private:
+  enum Type
+  {
+    LITERAL,
+    VARIABLE,
+    IF,
+    IFNOT,
+    LOOP,
+    ELSE,
+    END
+  };
+
+  struct Instruction
+  {
+    Type type;
+
+    /** Offset and length of literal text in source */
+    int start, length;
+
+    /** Name of variable, condition or loop */
+    QString name;
+
+    /** Index of the else and end instruction for blocks. -1 if there is no else part. */
+    int elseIndex, endIndex;
+  };
+
+  /** State of an open block while rendering */
+  struct Frame
+  {
+    int index;
+
+    /** Block is not set in values and tags are copied to the output */
+    bool unset;
+
+    /** Loop counter and repetitions */
+    int counter, repetitions;
+
+    /** Resolved name of the block, e.g. "row0.column" for loop "row.column" */
+    QString name;
+  };
+
+  /**
+   *  Parse instructions until {end endName}, {else endName} or end of source.
+   *  @param terminator Set to END or ELSE if parsing stopped at the respective tag
+   *  @return Position after the last parsed tag
+   */
+  int parse(int pos, const QString& endName, bool allowElse, Type& terminator);
+
+  /** Add literal text or append it to the last literal instruction */
+  void addLiteral(int start, int length);
+
+  /** Apply loop numbering of all open loops to the name */
+  static QString resolveName(const QString& name, const QVector<Frame>& stack);
+
+  /** Jump to next iteration or end of loop. Returns next instruction index. */
+  int nextIteration(QVector<Frame>& stack, const Instruction& instruction) const;
+
+  QString source, sourceName;
+  QVector<Instruction> instructions;
+
+  /** Total length of all literal parts */
+  int literalLength = 0;
+};
+
+} // end of namespace
+
+#endif // COMPILEDTEMPLATE_H
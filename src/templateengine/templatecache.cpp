@@ -34,3 +34,37 @@ QString TemplateCache::tryFile(const QString localizedName)
   mutex.unlock();
   return entry->document;
 }
+
+QSharedPointer<const CompiledTemplate> TemplateCache::tryCompiledFile(const QString localizedName)
+{
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  mutex.lock();
+  // search in cache
+  qDebug("TemplateCache: trying cached compiled %s", qPrintable(localizedName));
+  CacheEntry *entry = cache.object(localizedName);
+  if(entry && (cacheTimeout == 0 || entry->created > now - cacheTimeout))
+  {
+    // Parse only once for each cache entry
+    if(entry->compiled.isNull() && !entry->document.isEmpty())
+    {
+      entry->compiled = QSharedPointer<const CompiledTemplate>(new CompiledTemplate(entry->document, localizedName));
+    }
+    QSharedPointer<const CompiledTemplate> compiled = entry->compiled;
+    mutex.unlock();
+    return compiled;
+  }
+  // search on filesystem
+  entry = new CacheEntry();
+  entry->created = now;
+  entry->document = TemplateLoader::tryFile(localizedName);
+  if(!entry->document.isEmpty())
+  {
+    entry->compiled = QSharedPointer<const CompiledTemplate>(new CompiledTemplate(entry->document, localizedName));
+  }
+  // Keep a reference since the cache might delete the entry immediately if it is too large
+  QSharedPointer<const CompiledTemplate> compiled = entry->compiled;
+  // Store in cache even when the file did not exist, to remember that there is no such file
+  cache.insert(localizedName, entry, entry->document.size());
+  mutex.unlock();
+  return compiled;
+}
@@ -68,11 +68,22 @@ protected:
    */
   virtual QString tryFile(const QString localizedName) override;
 
+  /**
+   *  Try to get a parsed template from cache or filesystem.
+   *  Templates are parsed only once and shared until the cache entry expires.
+   *  @param localizedName Name of the template with locale to find
+   *  @return The parsed template, or null if not found
+   */
+  virtual QSharedPointer<const CompiledTemplate> tryCompiledFile(const QString localizedName) override;
+
 private:
   struct CacheEntry
   {
     QString document;
     qint64 created;
+
+    /** Created on first request */
+    QSharedPointer<const CompiledTemplate> compiled;
   };
 
   /** Timeout for each cached file */
@@ -59,8 +59,49 @@ QString TemplateLoader::tryFile(QString localizedName)
   return "";
 }
 
+QSharedPointer<const CompiledTemplate> TemplateLoader::tryCompiledFile(const QString localizedName)
+{
+  QString document = tryFile(localizedName);
+  if(!document.isEmpty())
+  {
+    return QSharedPointer<const CompiledTemplate>(new CompiledTemplate(document, localizedName));
+  }
+  return QSharedPointer<const CompiledTemplate>();
+}
+
 Template TemplateLoader::getTemplate(QString templateName, QString locales)
 {
+  foreach(QString localizedName, localizedNames(templateName, locales))
+  {
+    QString document = tryFile(localizedName);
+    if(!document.isEmpty())
+    {
+      return Template(document, localizedName);
+    }
+  }
+
+  qCritical("TemplateCache: cannot find template %s", qPrintable(templateName));
+  return Template("", templateName);
+}
+
+QSharedPointer<const CompiledTemplate> TemplateLoader::getCompiledTemplate(QString templateName, QString locales)
+{
+  foreach(QString localizedName, localizedNames(templateName, locales))
+  {
+    QSharedPointer<const CompiledTemplate> compiled = tryCompiledFile(localizedName);
+    if(!compiled.isNull())
+    {
+      return compiled;
+    }
+  }
+
+  qCritical("TemplateCache: cannot find template %s", qPrintable(templateName));
+  return QSharedPointer<const CompiledTemplate>(new CompiledTemplate("", templateName));
+}
+
+QStringList TemplateLoader::localizedNames(const QString& templateName, const QString& locales) const
+{
+  QStringList names;
   QSet<QString> tried;   // used to suppress duplicate attempts
 
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
@@ -76,11 +117,7 @@ Template TemplateLoader::getTemplate(QString templateName, QString locales)
     QString localizedName = templateName + "-" + loc.trimmed();
     if(!tried.contains(localizedName))
     {
-      QString document = tryFile(localizedName);
-      if(!document.isEmpty())
-      {
-        return Template(document, localizedName);
-      }
+      names.append(localizedName);
       tried.insert(localizedName);
     }
   }
@@ -92,22 +129,12 @@ Template TemplateLoader::getTemplate(QString templateName, QString locales)
     QString localizedName = templateName + "-" + loc.trimmed();
     if(!tried.contains(localizedName))
     {
-      QString document = tryFile(localizedName);
-      if(!document.isEmpty())
-      {
-        return Template(document, localizedName);
-      }
+      names.append(localizedName);
       tried.insert(localizedName);
     }
   }
 
   // Search for default file
-  QString document = tryFile(templateName);
-  if(!document.isEmpty())
-  {
-    return Template(document, templateName);
-  }
-
-  qCritical("TemplateCache: cannot find template %s", qPrintable(templateName));
-  return Template("", templateName);
+  names.append(templateName);
+  return names;
 }
@@ -10,8 +10,10 @@
 #include <QSettings>
 #include <QTextCodec>
 #include <QMutex>
+#include <QSharedPointer>
 #include "templateglobal.h"
 #include "template.h"
+#include "compiledtemplate.h"
 
 namespace stefanfrings {
 
@@ -62,6 +64,17 @@ public:
    */
   Template getTemplate(const QString templateName, const QString locales = QString());
 
+  /**
+   *  Get a parsed template for a given locale. Uses the same search order as getTemplate().
+   *  The returned object is immutable and can be rendered with different values from any thread.
+   *  This method is thread safe.
+   *  @param templateName base name of the template file, without suffix and without locale
+   *  @param locales Requested locale(s), e.g. "de_DE, en_EN".
+   *  @return If the template cannot be loaded, an error message is logged and an empty template is returned.
+   */
+  QSharedPointer<const CompiledTemplate> getCompiledTemplate(const QString templateName,
+                                                             const QString locales = QString());
+
 protected:
   /**
    *  Try to get a file from cache or filesystem.
@@ -70,6 +83,13 @@ protected:
    */
   virtual QString tryFile(const QString localizedName);
 
+  /**
+   *  Try to get a file from cache or filesystem and parse it.
+   *  @param localizedName Name of the template with locale to find
+   *  @return The parsed template, or null if not found
+   */
+  virtual QSharedPointer<const CompiledTemplate> tryCompiledFile(const QString localizedName);
+
   /** Directory where the templates are searched */
   QString templatePath;
 
@@ -78,6 +98,10 @@ protected:
 
   /** Codec for decoding the files */
   QTextCodec *textCodec;
+
+private:
+  /** Get all file names to try in the search order for the locales */
+  QStringList localizedNames(const QString& templateName, const QString& locales) const;
 };
 
 } // end of namespace
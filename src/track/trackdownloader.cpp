@@ -19,7 +19,6 @@
 
 #include "track/trackreader.h"
 #include "util/httpdownloader.h"
-#include "zip/gzip.h"
 #include "exception.h"
 
 #include <QFile>
@@ -124,7 +123,7 @@ void TrackDownloader::natDownloadFinished(const QByteArray& data, QString downlo
 #endif
 
     TrackReader reader;
-    reader.readTracks(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), NAT);
+    reader.readTracks(data, NAT);
     trackList[NAT] = reader.getTracks();
 
     emit trackDownloadFinished(trackList.value(NAT), NAT);
@@ -150,7 +149,7 @@ void TrackDownloader::pacotsDownloadFinished(const QByteArray& data, QString dow
 #endif
 
     TrackReader reader;
-    reader.readTracks(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), PACOTS);
+    reader.readTracks(data, PACOTS);
     trackList[PACOTS] = reader.getTracks();
 
     emit trackDownloadFinished(trackList.value(PACOTS), PACOTS);
@@ -176,7 +175,7 @@ void TrackDownloader::ausotsDownloadFinished(const QByteArray& data, QString dow
 #endif
 
     TrackReader reader;
-    reader.readTracks(atools::zip::gzipDecompressIf(data, Q_FUNC_INFO), AUSOTS);
+    reader.readTracks(data, AUSOTS);
     trackList[AUSOTS] = reader.getTracks();
 
     emit trackDownloadFinished(trackList.value(AUSOTS), AUSOTS);
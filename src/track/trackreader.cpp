@@ -18,7 +18,9 @@
 #include "track/trackreader.h"
 #include "exception.h"
 #include "atools.h"
+#include "zip/gzipdevice.h"
 
+#include <QBuffer>
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
@@ -55,8 +57,30 @@ void TrackReader::readTracks(const QString& filename, TrackType type)
 
 void TrackReader::readTracks(const QByteArray& data, TrackType type)
 {
-  QTextStream stream(data);
+  QBuffer buffer;
+  buffer.setData(data);
+  buffer.open(QIODevice::ReadOnly);
+  readTracks(&buffer, type);
+}
+
+void TrackReader::readTracks(QIODevice *device, TrackType type)
+{
+  // Decompress while reading if needed
+  atools::zip::GzipDevice gzipDevice(device);
+  if(!gzipDevice.open(QIODevice::ReadOnly))
+    throw atools::Exception(tr("Cannot read track data."));
+
+  // Remember size to remove tracks extracted from partial data
+  int numTracks = tracks.size();
+
+  QTextStream stream(&gzipDevice);
   readTracks(stream, type);
+
+  if(gzipDevice.hasError())
+  {
+    tracks.erase(tracks.begin() + numTracks, tracks.end());
+    throw atools::Exception(tr("Cannot read track data. Reason: %1").arg(gzipDevice.errorString()));
+  }
 }
 
 void TrackReader::readTracks(QTextStream& stream, TrackType type)
@@ -24,6 +24,7 @@
 
 class QStringList;
 class QTextStream;
+class QIODevice;
 
 namespace atools {
 namespace track {
@@ -45,10 +46,13 @@ public:
   ~TrackReader();
 
   /* Read tracks from HTML or text pages. throws an exception on error.
-   * Track objects are added to the internal list without clearing it before.*/
+   * Track objects are added to the internal list without clearing it before.
+   * Byte array and device data can be Gzip compressed and is decompressed while reading. Device has to be open.
+   * Tracks read from truncated or corrupt compressed data are removed again before the exception is thrown. */
   void readTracks(const QString& filename, atools::track::TrackType type);
   void readTracks(QTextStream& stream, atools::track::TrackType type);
   void readTracks(const QByteArray& data, atools::track::TrackType type);
+  void readTracks(QIODevice *device, atools::track::TrackType type);
 
   /* Clear list of tracks */
   void clear()
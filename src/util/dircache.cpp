@@ -0,0 +1,136 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "util/dircache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+
+namespace atools {
+namespace util {
+
+namespace {
+
+/* Listing of one directory */
+struct Snapshot
+{
+  /* Modification time of the directory when it was read */
+  qint64 modifiedMs = 0L;
+
+  /* Name to directory flag */
+  QHash<QString, bool> names;
+
+  /* Case folded name to name */
+  QHash<QString, QString> foldedNames;
+};
+
+typedef QSharedPointer<const Snapshot> SnapshotPtr;
+
+/* Whole cache is dropped if this number of directories is exceeded */
+const int MAX_DIRECTORIES = 50000;
+
+QReadWriteLock snapshotLock;
+QHash<QString, SnapshotPtr> snapshots;
+
+SnapshotPtr readSnapshot(const QString& dirPath, qint64 modifiedMs)
+{
+  Snapshot *snapshot = new Snapshot;
+  snapshot->modifiedMs = modifiedMs;
+
+  const QFileInfoList entries = QDir(dirPath).entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::System |
+                                                            QDir::NoDotAndDotDot, QDir::Name | QDir::IgnoreCase);
+  snapshot->names.reserve(entries.size());
+  snapshot->foldedNames.reserve(entries.size());
+  for(const QFileInfo& entry : entries)
+  {
+    QString name = entry.fileName();
+    snapshot->names.insert(name, entry.isDir());
+
+    // Keep first in sorted order if names differ only in case
+    QString folded = name.toCaseFolded();
+    if(!snapshot->foldedNames.contains(folded))
+      snapshot->foldedNames.insert(folded, name);
+  }
+  return SnapshotPtr(snapshot);
+}
+
+}
+
+bool DirCache::findEntry(const QString& dirPath, const QString& name, QString& entryName, bool& isDir)
+{
+  QFileInfo dirInfo(dirPath);
+  if(!dirInfo.isDir())
+    return false;
+
+  // Uses the already fetched stat information
+  qint64 modifiedMs = dirInfo.lastModified().toMSecsSinceEpoch();
+
+  SnapshotPtr snapshot;
+  {
+    QReadLocker locker(&snapshotLock);
+    snapshot = snapshots.value(dirPath);
+  }
+
+  if(snapshot.isNull() || snapshot->modifiedMs != modifiedMs)
+  {
+    // Not cached or changed - read directory outside of lock. Concurrent reads of the same directory are harmless.
+    snapshot = readSnapshot(dirPath, modifiedMs);
+
+    QWriteLocker locker(&snapshotLock);
+    if(snapshots.size() >= MAX_DIRECTORIES)
+      snapshots.clear();
+    snapshots.insert(dirPath, snapshot);
+  }
+
+  // Exact match first
+  QHash<QString, bool>::const_iterator it = snapshot->names.constFind(name);
+  if(it != snapshot->names.constEnd())
+  {
+    entryName = name;
+    isDir = it.value();
+    return true;
+  }
+
+  // Case insensitive match
+  QHash<QString, QString>::const_iterator foldedIt = snapshot->foldedNames.constFind(name.toCaseFolded());
+  if(foldedIt != snapshot->foldedNames.constEnd())
+  {
+    entryName = foldedIt.value();
+    isDir = snapshot->names.value(entryName);
+    return true;
+  }
+
+  return false;
+}
+
+void DirCache::clear()
+{
+  QWriteLocker locker(&snapshotLock);
+  snapshots.clear();
+}
+
+int DirCache::size()
+{
+  QReadLocker locker(&snapshotLock);
+  return static_cast<int>(snapshots.size());
+}
+
+} // namespace util
+} // namespace atools
@@ -0,0 +1,60 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_DIRCACHE_H
+#define ATOOLS_DIRCACHE_H
+
+#include <QString>
+
+namespace atools {
+namespace util {
+
+/*
+ * Process wide cache of directory listings used to resolve file and directory names ignoring case.
+ *
+ * Each directory is read once and stored with exact and case folded name maps.
+ * A snapshot is read again if the modification time of the directory changes, i.e. if entries were added,
+ * removed or renamed. Lookups cost one stat call for the directory instead of a full listing.
+ *
+ * All methods are thread safe.
+ */
+class DirCache
+{
+public:
+  /*
+   * Find an entry in a directory. An exact match is preferred before a case insensitive match.
+   *
+   * @param dirPath Directory to search
+   * @param name File or directory name in any case
+   * @param entryName Name in correct case if found
+   * @param isDir true if the entry is a directory or a link to one
+   * @return false if directory or entry do not exist
+   */
+  static bool findEntry(const QString& dirPath, const QString& name, QString& entryName, bool& isDir);
+
+  /* Remove all directory snapshots */
+  static void clear();
+
+  /* Number of directories in cache */
+  static int size();
+
+};
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_DIRCACHE_H
@@ -0,0 +1,98 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_UTIL_PARALLEL_H
+#define ATOOLS_UTIL_PARALLEL_H
+
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace atools {
+namespace util {
+
+/* Number of threads used by runParallel() for count items in batches of batch items including the calling thread.
+ * Limited to maxThreads if this is greater than 0. Returns at least one. */
+inline int parallelThreadCount(int count, int batch = 1, int maxThreads = 0)
+{
+  batch = std::max(batch, 1);
+  int numThreads = std::min(std::max(QThread::idealThreadCount(), 1), (count + batch - 1) / batch);
+  if(maxThreads > 0)
+    numThreads = std::min(numThreads, maxThreads);
+  return std::max(numThreads, 1);
+}
+
+/*
+ * Calls func(begin, end, thread) for consecutive index ranges [begin, end) of at most batch items covering
+ * 0 to count - 1. Uses parallelThreadCount() threads and the calling thread is one of them.
+ * Order of calls is undefined. thread is the number of the running thread from 0 to parallelThreadCount() - 1
+ * and can be used to select resources like buffers or writers which cannot be shared.
+ *
+ * Batches after a failed one are skipped. The exception of the first failed batch in index order is rethrown in the
+ * calling thread once all threads are finished. This reports the same error as a sequential loop.
+ */
+template<typename FUNC>
+void runParallel(int count, int batch, FUNC func, int maxThreads = 0)
+{
+  batch = std::max(batch, 1);
+  std::atomic_int next(0), errorBegin(count);
+  std::exception_ptr exception;
+  std::mutex exceptionMutex;
+
+  // Each thread takes the next batch until all are done or an error was found before the batch
+  auto worker = [count, batch, &func, &next, &errorBegin, &exception, &exceptionMutex](int thread) -> void {
+                  for(int begin = next.fetch_add(batch); begin < count && begin < errorBegin;
+                      begin = next.fetch_add(batch))
+                  {
+                    try
+                    {
+                      func(begin, std::min(begin + batch, count), thread);
+                    }
+                    catch(...)
+                    {
+                      std::lock_guard<std::mutex> lock(exceptionMutex);
+                      if(begin < errorBegin)
+                      {
+                        errorBegin = begin;
+                        exception = std::current_exception();
+                      }
+                    }
+                  }
+                };
+
+  int numThreads = parallelThreadCount(count, batch, maxThreads);
+  std::vector<std::thread> threads;
+  for(int i = 1; i < numThreads; i++)
+    threads.emplace_back(worker, i);
+  worker(0); // Use this thread too
+
+  for(std::thread& thread : threads)
+    thread.join();
+
+  if(exception)
+    std::rethrow_exception(exception);
+}
+
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_UTIL_PARALLEL_H
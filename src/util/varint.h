@@ -0,0 +1,79 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_VARINT_H
+#define ATOOLS_VARINT_H
+
+#include <QByteArray>
+
+namespace atools {
+namespace util {
+
+/*
+ * Helpers for variable length integer encoding as used by protocol buffers.
+ * Seven bits per byte with the high bit set on all bytes except the last one.
+ * Signed values are zigzag encoded to keep small negative numbers short.
+ */
+namespace varint {
+
+inline void write(QByteArray& bytes, quint64 value)
+{
+  while(value >= 0x80)
+  {
+    bytes.append(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  bytes.append(static_cast<char>(value));
+}
+
+inline void writeSigned(QByteArray& bytes, qint64 value)
+{
+  write(bytes, (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63));
+}
+
+/* Read value at ptr and advance ptr. Sets ok to false and returns 0 if end is reached or value is too long. */
+inline quint64 read(const quint8 *& ptr, const quint8 *end, bool& ok)
+{
+  quint64 value = 0;
+  for(int shift = 0; shift < 64; shift += 7)
+  {
+    if(ptr >= end)
+    {
+      ok = false;
+      return 0;
+    }
+
+    quint8 byte = *ptr++;
+    value |= static_cast<quint64>(byte & 0x7f) << shift;
+    if(!(byte & 0x80))
+      return value;
+  }
+  ok = false;
+  return 0;
+}
+
+inline qint64 readSigned(const quint8 *& ptr, const quint8 *end, bool& ok)
+{
+  quint64 value = read(ptr, end, ok);
+  return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+
+} // namespace varint
+} // namespace util
+} // namespace atools
+
+#endif // ATOOLS_VARINT_H
@@ -19,6 +19,7 @@
 #include "io/tempfile.h"
 #include "exception.h"
 #include "geo/pos.h"
+#include "util/parallel.h"
 
 extern "C" {
 #include <stdio.h>
@@ -39,15 +40,13 @@ extern "C" {
 #include <QFile>
 #include <QVector>
 
-#include <cstring>
-
 namespace atools {
 namespace wmm {
 
-/* Copy of MAG_Grid function with simplifications also avoiding the need to write the output to a file */
-QVector<float> MAG_GridInternal(int year, int month,
-                                MAGtype_MagneticModel *magneticModel,
-                                MAGtype_Geoid *Geoid, MAGtype_Ellipsoid ellipsoid);
+/* Copy of MAG_Grid function with simplifications also avoiding the need to write the output to a file.
+ * Calculates a grid with "cellsPerDegree" values per degree. Rows are calculated in parallel. */
+QVector<float> MAG_GridInternal(int year, int month, int cellsPerDegree, MAGtype_MagneticModel *magneticModel,
+                                MAGtype_Geoid *geoid, MAGtype_Ellipsoid ellipsoid);
 
 // ==============================================================================
 
@@ -61,15 +60,18 @@ MagDecTool::~MagDecTool()
   clear();
 }
 
-void MagDecTool::init(const QDate& dateTimeParam)
+void MagDecTool::init(const QDate& dateTimeParam, int cellsPerDegreeParam)
 {
-  return init(dateTimeParam.year(), dateTimeParam.month());
+  return init(dateTimeParam.year(), dateTimeParam.month(), cellsPerDegreeParam);
 }
 
-void MagDecTool::init(int year, int month)
+void MagDecTool::init(int year, int month, int cellsPerDegreeParam)
 {
   clear();
 
+  if(cellsPerDegreeParam < 1 || cellsPerDegreeParam > MAX_CELLS_PER_DEGREE)
+    throw atools::Exception(tr("Invalid magnetic declination grid resolution %1.").arg(cellsPerDegreeParam));
+
   if(year <= 0 || month <= 0)
   {
     QDateTime dt = QDateTime::currentDateTimeUtc();
@@ -116,16 +118,13 @@ void MagDecTool::init(int year, int month)
   geoid.Geoid_Initialized = 1;
 
   // Calculate declination grid
-  QVector<float> declinations = MAG_GridInternal(year, month, magneticModel, &geoid, ellipsoid);
-  if(declinations.isEmpty())
+  magdecGrid = MAG_GridInternal(year, month, cellsPerDegreeParam, magneticModel, &geoid, ellipsoid);
+  if(magdecGrid.isEmpty())
     throw atools::Exception(tr("Error in MAG_GridInternal."));
+  cellsPerDegree = cellsPerDegreeParam;
 
   MAG_FreeMagneticModelMemory(magneticModel);
 
-  // Create new plain float array and copy data before vector is destroyed
-  magdecGrid = new float[static_cast<unsigned int>(declinations.size())];
-  std::memcpy(magdecGrid, declinations.data(), static_cast<unsigned int>(declinations.size()) * sizeof(float));
-
   fclose(f);
 
   // Reset locale to previous value
@@ -163,33 +162,46 @@ QString MagDecTool::getVersion() const
   return VERSIONDATE_LARGE;
 }
 
-float MagDecTool::getMagVar(const geo::Pos& pos)
+float MagDecTool::getMagVar(const geo::Pos& pos) const
 {
-  if(pos.nearGrid(1.f, atools::geo::Pos::POS_EPSILON_500M))
+  const float step = 1.f / cellsPerDegree;
+  if(pos.nearGrid(step, atools::geo::Pos::POS_EPSILON_500M))
     // Get point value without interpolation if position is close to a grid point
-    return getMagVar(atools::roundToInt(pos.getLonX()), atools::roundToInt(pos.getLatY()));
+    return getGridValue(atools::roundToInt((pos.getLonX() + 180.f) * cellsPerDegree),
+                        atools::roundToInt((pos.getLatY() + 90.f) * cellsPerDegree));
   else
   {
+    // Position in grid units
+    float x = (pos.getLonX() + 180.f) * cellsPerDegree, y = (pos.getLatY() + 90.f) * cellsPerDegree;
+
     // Get all four boundaries
-    float left = std::floor(pos.getLonX());
-    float right = std::ceil(pos.getLonX());
-    float top = std::ceil(pos.getLatY());
-    float bottom = std::floor(pos.getLatY());
-
-    // Interpolate along top boundary
-    float t = atools::interpolate(getMagVar(left, top), getMagVar(right, top), left, right, pos.getLonX());
-    // Interpolate along bottom boundary
-    float b = atools::interpolate(getMagVar(left, bottom), getMagVar(right, bottom), left, right, pos.getLonX());
-
-    // Interpolate between top and bottom
-    return atools::interpolate(t, b, top, bottom, pos.getLatY());
+    int left = static_cast<int>(std::floor(x)), bottom = static_cast<int>(std::floor(y));
+    float fracX = x - left, fracY = y - bottom;
+
+    // Interpolate along bottom and top boundary
+    float b = getGridValue(left, bottom) * (1.f - fracX) + getGridValue(left + 1, bottom) * fracX;
+    float t = getGridValue(left, bottom + 1) * (1.f - fracX) + getGridValue(left + 1, bottom + 1) * fracX;
+
+    // Interpolate between bottom and top
+    return b * (1.f - fracY) + t * fracY;
   }
 }
 
+float MagDecTool::getGridValue(int lonIndex, int latIndex) const
+{
+  int numCols = getNumColumns(), numRows = getNumRows();
+
+  // Wrap around at anti-meridian and clamp at poles
+  lonIndex = ((lonIndex % numCols) + numCols) % numCols;
+  latIndex = std::max(std::min(latIndex, numRows - 1), 0);
+
+  return magdecGrid.at(lonIndex + latIndex * numCols);
+}
+
 void MagDecTool::clear()
 {
-  delete magdecGrid;
-  magdecGrid = nullptr;
+  magdecGrid.clear();
+  cellsPerDegree = 1;
 }
 
 QVector<float> MagDecTool::readGeoidBuffer()
@@ -215,95 +227,89 @@ QVector<float> MagDecTool::readGeoidBuffer()
   return retval;
 }
 
-QVector<float> MAG_GridInternal(int year, int month, MAGtype_MagneticModel *magneticModel,
+QVector<float> MAG_GridInternal(int year, int month, int cellsPerDegree, MAGtype_MagneticModel *magneticModel,
                                 MAGtype_Geoid *geoid, MAGtype_Ellipsoid ellipsoid)
 {
-  // Boundary always covers whole world
-  MAGtype_CoordGeodetic minimum;
-  minimum.phi = -90.;
-  minimum.lambda = -180.;
-  minimum.HeightAboveGeoid = minimum.HeightAboveEllipsoid = 0.;
-  minimum.UseGeoid = 1;
-
-  MAGtype_CoordGeodetic maximum;
-  maximum.phi = 90.;
-  maximum.lambda = 179.;
-  maximum.HeightAboveGeoid = maximum.HeightAboveEllipsoid = 0.;
-  maximum.UseGeoid = 1;
-
-  // Only one date - no range
-  MAGtype_Date startdate, enddate;
-  startdate.DecimalYear = enddate.DecimalYear = year + (month - 1) / 12.;
-
-  int numTerms;
-  double b, c;
-
-  MAGtype_MagneticModel *timedMagneticModel;
-  MAGtype_CoordSpherical coordSpherical;
-  MAGtype_MagneticResults magneticResultsSph, magneticResultsGeo, magneticResultsSphVar, magneticResultsGeoVar;
-  MAGtype_SphericalHarmonicVariables *sphericalVariables;
-  MAGtype_GeoMagneticElements geoMagneticElements, errors;
-  MAGtype_LegendreFunction *legendreFunction;
-
-  double cord_step_size = 1.;
-  if(fabs(cord_step_size) < 1.0e-10)
-    cord_step_size = 99999.0; // checks to make sure that the step_size is not too small
-
-  numTerms = ((magneticModel->nMax + 1) * (magneticModel->nMax + 2) / 2);
-  timedMagneticModel = MAG_AllocateModelMemory(numTerms);
-  legendreFunction = MAG_AllocateLegendreFunctionMemory(numTerms); // For storing the ALF functions
-  sphericalVariables = MAG_AllocateSphVarMemory(magneticModel->nMax);
+  const int nMax = magneticModel->nMax;
+  const int numCols = 360 * cellsPerDegree, numRows = 180 * cellsPerDegree + 1;
+  const double step = 1. / cellsPerDegree;
+
+  // Only one date - no range. This modifies the Magnetic coefficients to the correct date once for all cells.
+  MAGtype_Date date;
+  date.DecimalYear = year + (month - 1) / 12.;
+
+  int numTerms = ((nMax + 1) * (nMax + 2) / 2);
+  MAGtype_MagneticModel *timedMagneticModel = MAG_AllocateModelMemory(numTerms);
+  MAG_TimelyModifyMagneticModel(date, magneticModel, timedMagneticModel);
+
+  // Latitude Y (-90 to 90) is the major and longitude X (-180 to 179) the minor index
+  QVector<float> retval(numCols * numRows);
+  float *grid = retval.data();
+
+  // Buffers for each thread. Timed model and geoid are only read by the threads.
+  const int numThreads = atools::util::parallelThreadCount(numRows);
+  QVector<MAGtype_LegendreFunction *> legendreFunctions;
+  QVector<MAGtype_SphericalHarmonicVariables *> sphericalVariablesList;
+  for(int i = 0; i < numThreads; i++)
+  {
+    legendreFunctions.append(MAG_AllocateLegendreFunctionMemory(numTerms));
+    sphericalVariablesList.append(MAG_AllocateSphVarMemory(nMax));
+  }
 
-  QVector<float> retval;
-  retval.reserve(360 * 181);
+  // Calculates whole rows
+  atools::util::runParallel(numRows, 1, [&](int row, int, int thread) -> void {
+    MAGtype_LegendreFunction *legendreFunction = legendreFunctions.at(thread);
+    MAGtype_SphericalHarmonicVariables *sphericalVariables = sphericalVariablesList.at(thread);
 
-  b = minimum.phi;
-  c = minimum.lambda;
-  for(minimum.phi = b; minimum.phi <= maximum.phi; minimum.phi += cord_step_size) // Latitude Y loop
-  {
-    for(minimum.lambda = c; minimum.lambda <= maximum.lambda; minimum.lambda += cord_step_size) // Longitude X loop
+    MAGtype_CoordGeodetic coordGeodetic;
+    coordGeodetic.phi = -90. + row * step;
+    coordGeodetic.HeightAboveGeoid = coordGeodetic.HeightAboveEllipsoid = 0.;
+    coordGeodetic.UseGeoid = 1;
+
+    float *gridRow = grid + row * numCols;
+    for(int col = 0; col < numCols; col++) // Longitude X loop
     {
+      coordGeodetic.lambda = -180. + col * step;
+
       if(geoid->UseGeoid == 1)
         // This converts the height above mean sea level to height above the WGS-84 ellipsoid
-        MAG_ConvertGeoidToEllipsoidHeight(&minimum, geoid);
+        MAG_ConvertGeoidToEllipsoidHeight(&coordGeodetic, geoid);
       else
-        minimum.HeightAboveEllipsoid = minimum.HeightAboveGeoid;
+        coordGeodetic.HeightAboveEllipsoid = coordGeodetic.HeightAboveGeoid;
 
-      MAG_GeodeticToSpherical(ellipsoid, minimum, &coordSpherical);
+      // Geocentric latitude and radius depend on the ellipsoid height which varies per cell
+      MAGtype_CoordSpherical coordSpherical;
+      MAG_GeodeticToSpherical(ellipsoid, coordGeodetic, &coordSpherical);
 
       // Compute Spherical Harmonic variables
-      MAG_ComputeSphericalHarmonicVariables(ellipsoid, coordSpherical, magneticModel->nMax, sphericalVariables);
+      MAG_ComputeSphericalHarmonicVariables(ellipsoid, coordSpherical, nMax, sphericalVariables);
 
       // Compute ALF  Equations 5-6, WMM Technical report
-      MAG_AssociatedLegendreFunction(coordSpherical, magneticModel->nMax, legendreFunction);
-
-      // This modifies the Magnetic coefficients to the correct date.
-      MAG_TimelyModifyMagneticModel(startdate, magneticModel, timedMagneticModel);
+      MAG_AssociatedLegendreFunction(coordSpherical, nMax, legendreFunction);
 
       // Accumulate the spherical harmonic coefficients Equations 10:12 , WMM Technical report
-      MAG_Summation(legendreFunction, timedMagneticModel, *sphericalVariables, coordSpherical, &magneticResultsSph);
-
-      // Sum the Secular Variation Coefficients, Equations 13:15 , WMM Technical report
-      MAG_SecVarSummation(legendreFunction, timedMagneticModel, *sphericalVariables, coordSpherical,
-                          &magneticResultsSphVar);
+      MAGtype_MagneticResults magneticResultsSph, magneticResultsGeo;
+      MAG_Summation(legendreFunction, timedMagneticModel, *sphericalVariables, coordSpherical,
+                    &magneticResultsSph);
 
       // Map the computed Magnetic fields to Geodetic coordinates Equation 16 , WMM Technical report
-      MAG_RotateMagneticVector(coordSpherical, minimum, magneticResultsSph, &magneticResultsGeo);
-
-      // Map the secular variation field components to Geodetic coordinates, Equation 17 , WMM Technical report
-      MAG_RotateMagneticVector(coordSpherical, minimum, magneticResultsSphVar, &magneticResultsGeoVar);
+      MAG_RotateMagneticVector(coordSpherical, coordGeodetic, magneticResultsSph, &magneticResultsGeo);
 
       // Calculate the Geomagnetic elements, Equation 18 , WMM Technical report
+      MAGtype_GeoMagneticElements geoMagneticElements;
       MAG_CalculateGeoMagneticElements(&magneticResultsGeo, &geoMagneticElements);
-      MAG_WMMErrorCalc(geoMagneticElements.H, &errors);
 
-      retval.append(static_cast<float>(geoMagneticElements.Decl));
+      gridRow[col] = static_cast<float>(geoMagneticElements.Decl);
     } // Longitude Loop
-  } // Latitude Loop
+  }, numThreads); // Latitude Loop
+
+  for(int i = 0; i < numThreads; i++)
+  {
+    MAG_FreeLegendreMemory(legendreFunctions.at(i));
+    MAG_FreeSphVarMemory(sphericalVariablesList.at(i));
+  }
 
   MAG_FreeMagneticModelMemory(timedMagneticModel);
-  MAG_FreeLegendreMemory(legendreFunction);
-  MAG_FreeSphVarMemory(sphericalVariables);
 
   return retval;
 }
@@ -22,6 +22,7 @@
 
 #include <QCoreApplication>
 #include <QDate>
+#include <QVector>
 
 namespace atools {
 namespace geo {
@@ -31,7 +32,8 @@ namespace wmm {
 
 /*
  * Interface to GeomagnetismLibrary. Calculates an array for 360 x 181 values and provides accessors and
- * interpolation methods to this array (i.e. one degree grid).
+ * interpolation methods to this array (i.e. one degree grid). Finer grids can be calculated by passing
+ * more than one cell per degree, e.g. 4 for a 0.25 degree grid with 1440 x 721 values.
  *
  * Declination values are not calculated on the fly.
  */
@@ -46,19 +48,45 @@ public:
   MagDecTool(const MagDecTool& other) = delete;
   MagDecTool& operator=(const MagDecTool& other) = delete;
 
-  /* Build the declination array for current year/month or given values. January = 1 */
-  void init(int year = 0, int month = 1);
-  void init(const QDate& dateTime);
+  /* Maximum value for cellsPerDegree in init() */
+  static const int MAX_CELLS_PER_DEGREE = 10;
+
+  /* Build the declination array for current year/month or given values. January = 1
+   * cellsPerDegree defines the resolution of the grid. 1 is a one degree grid. Throws exception on error. */
+  void init(int year = 0, int month = 1, int cellsPerDegree = 1);
+  void init(const QDate& dateTime, int cellsPerDegree = 1);
 
   /* Get version information for the GeomagnetismLibrary */
   QString getVersion() const;
 
-  /* Get magnetic variance/declination. Positive is east and negative is west. */
-  float getMagVar(const atools::geo::Pos& pos);
+  /* Get magnetic variance/declination. Positive is east and negative is west.
+   * Uses bilinear interpolation between the four surrounding grid points. */
+  float getMagVar(const atools::geo::Pos& pos) const;
+
+  /* Get value at full degree grid point. lonX -180 to 179 and latY -90 to 90 */
+  float getMagVar(int lonX, int latY) const
+  {
+    return getGridValue((lonX + 180) * cellsPerDegree, (latY + 90) * cellsPerDegree);
+  }
+
+  /* Get value at grid point. lonIndex 0 (-180) to getNumColumns() - 1 and latIndex 0 (-90) to getNumRows() - 1.
+   * Longitude wraps around and latitude is clamped. */
+  float getGridValue(int lonIndex, int latIndex) const;
+
+  /* Grid resolution as given in init() */
+  int getCellsPerDegree() const
+  {
+    return cellsPerDegree;
+  }
+
+  int getNumColumns() const
+  {
+    return 360 * cellsPerDegree;
+  }
 
-  float getMagVar(int col, int row)
+  int getNumRows() const
   {
-    return magdecGrid[col + 180 + (row + 90) * 360];
+    return 180 * cellsPerDegree + 1;
   }
 
   /* Reference date as given or current date */
@@ -70,7 +98,7 @@ public:
   /* Valid if data is calculated */
   bool isValid() const
   {
-    return magdecGrid != nullptr;
+    return !magdecGrid.isEmpty();
   }
 
   /* Frees all and sets status to invalid */
@@ -82,17 +110,13 @@ public:
 #endif
 
 private:
-  float getMagVar(float col, float row)
-  {
-    return magdecGrid[atools::roundToInt(col) + 180 + (atools::roundToInt(row) + 90) * 360];
-  }
-
   // Read EGM9615.buf - only needed for grid creating
   QVector<float> readGeoidBuffer();
 
-  // latY (-90 to 90), lonX (-180 to 179)
+  // latY (-90 to 90), lonX (-180 to 179) in steps of 1 / cellsPerDegree
   // -90.00 -180.00, -90.00 -179.00 ... 90.00 178.00, 90.00 179.00
-  float *magdecGrid = nullptr;
+  QVector<float> magdecGrid;
+  int cellsPerDegree = 1;
 
   QDate referenceDate;
 };
@@ -0,0 +1,214 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "zip/gzipdevice.h"
+
+#include "zip/gzip.h"
+
+#include <QBuffer>
+#include <QDebug>
+
+#include <algorithm>
+#include <limits>
+
+namespace atools {
+namespace zip {
+
+/* Window bits for inflateInit2 - 15 plus 16 to accept Gzip headers only */
+static const int GZIP_WINDOW_BITS = 15 + 16;
+
+/* Size of compressed chunks read from the source device */
+static const int GZIP_INPUT_CHUNK_SIZE = 32 * 1024;
+
+GzipDevice::GzipDevice(QIODevice *sourceDevice, QObject *parent)
+  : QIODevice(parent), source(sourceDevice)
+{
+}
+
+GzipDevice::GzipDevice(const QByteArray& data, QObject *parent)
+  : QIODevice(parent)
+{
+  buffer = new QBuffer;
+  buffer->setData(data);
+  source = buffer;
+}
+
+GzipDevice::~GzipDevice()
+{
+  close();
+  delete buffer;
+}
+
+bool GzipDevice::open(QIODevice::OpenMode mode)
+{
+  if(isOpen())
+  {
+    qWarning() << Q_FUNC_INFO << "Device already open";
+    return false;
+  }
+
+  if((mode & QIODevice::ReadWrite) != QIODevice::ReadOnly)
+  {
+    qWarning() << Q_FUNC_INFO << "Only read mode supported";
+    return false;
+  }
+
+  if(buffer != nullptr && !buffer->isOpen())
+    buffer->open(QIODevice::ReadOnly);
+
+  if(source == nullptr || !source->isReadable())
+  {
+    qWarning() << Q_FUNC_INFO << "Source device is not readable";
+    return false;
+  }
+
+  finished = error = false;
+
+  // Check magic number without consuming bytes - pass data through if not compressed
+  compressed = isGzipCompressed(source->peek(2));
+
+  if(compressed)
+  {
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.avail_in = 0;
+    stream.next_in = Z_NULL;
+
+    if(inflateInit2(&stream, GZIP_WINDOW_BITS) != Z_OK)
+    {
+      qWarning() << Q_FUNC_INFO << "Error initializing inflate";
+      return false;
+    }
+    inflating = true;
+    inputBuffer.resize(GZIP_INPUT_CHUNK_SIZE);
+  }
+
+  return QIODevice::open(mode);
+}
+
+void GzipDevice::close()
+{
+  if(isOpen())
+    QIODevice::close();
+
+  endInflate();
+  inputBuffer.clear();
+
+  if(buffer != nullptr)
+    buffer->close();
+}
+
+bool GzipDevice::atEnd() const
+{
+  if(!isOpen())
+    return true;
+
+  if(compressed)
+    // Flags are set by readData() once the end of stream is reached or an error occurred
+    return finished && QIODevice::bytesAvailable() == 0;
+  else
+    return QIODevice::bytesAvailable() == 0 && source->atEnd();
+}
+
+qint64 GzipDevice::readData(char *data, qint64 maxSize)
+{
+  if(!compressed)
+    // Pass through
+    return source->read(data, maxSize);
+
+  if(error)
+    return -1;
+
+  if(finished || maxSize <= 0)
+    return 0;
+
+  stream.next_out = reinterpret_cast<Bytef *>(data);
+  stream.avail_out = static_cast<uInt>(std::min(maxSize, static_cast<qint64>(std::numeric_limits<uInt>::max())));
+  uInt maxOut = stream.avail_out;
+
+  while(stream.avail_out > 0 && !finished)
+  {
+    if(stream.avail_in == 0)
+    {
+      // Fetch next chunk of compressed data from the source
+      qint64 numRead = source->read(inputBuffer.data(), inputBuffer.size());
+
+      if(numRead < 0 || (numRead == 0 && source->atEnd()))
+      {
+        setError(tr("Unexpected end of compressed data"));
+        break;
+      }
+      else if(numRead == 0)
+        // Nothing available for now - return what is decompressed
+        break;
+
+      stream.next_in = reinterpret_cast<Bytef *>(inputBuffer.data());
+      stream.avail_in = static_cast<uInt>(numRead);
+    }
+
+    int ret = inflate(&stream, Z_NO_FLUSH);
+    switch(ret)
+    {
+      case Z_STREAM_END:
+        finished = true;
+        endInflate();
+        break;
+
+      case Z_NEED_DICT:
+      case Z_DATA_ERROR:
+      case Z_MEM_ERROR:
+      case Z_STREAM_ERROR:
+        setError(tr("Error decompressing data: %1").
+                 arg(stream.msg != nullptr ? QString::fromLatin1(stream.msg) : QString::number(ret)));
+        break;
+    }
+
+    if(error)
+      break;
+  }
+
+  qint64 numDecompressed = static_cast<qint64>(maxOut - stream.avail_out);
+
+  // Report error only if nothing could be returned
+  return error && numDecompressed == 0 ? -1 : numDecompressed;
+}
+
+qint64 GzipDevice::writeData(const char *, qint64)
+{
+  return -1;
+}
+
+void GzipDevice::setError(const QString& message)
+{
+  qWarning() << Q_FUNC_INFO << message;
+  setErrorString(message);
+  error = finished = true;
+  endInflate();
+}
+
+void GzipDevice::endInflate()
+{
+  if(inflating)
+  {
+    inflateEnd(&stream);
+    inflating = false;
+  }
+}
+
+} // namespace zip
+} // namespace atools
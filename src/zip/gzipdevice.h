@@ -0,0 +1,98 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ATOOLS_ZIP_GZIPDEVICE_H
+#define ATOOLS_ZIP_GZIPDEVICE_H
+
+#include <QIODevice>
+
+#include <zlib.h>
+
+class QBuffer;
+
+namespace atools {
+namespace zip {
+
+/*
+ * Read-only sequential device which inflates Gzip compressed data from another device or a byte array
+ * incrementally while reading. Allows to parse compressed data with QTextStream or other readers
+ * without keeping a decompressed copy in memory.
+ *
+ * Data is passed through unchanged if it is not prefixed with the Gzip magic number.
+ * See atools::zip::gzipDecompressIf().
+ */
+class GzipDevice :
+  public QIODevice
+{
+  Q_OBJECT
+
+public:
+  /* Read compressed data from sourceDevice which has to be open for reading. sourceDevice is not owned. */
+  explicit GzipDevice(QIODevice *sourceDevice, QObject *parent = nullptr);
+
+  /* Read compressed data from byte array. The implicitly shared data is not copied. */
+  explicit GzipDevice(const QByteArray& data, QObject *parent = nullptr);
+  virtual ~GzipDevice() override;
+
+  GzipDevice(const GzipDevice& other) = delete;
+  GzipDevice& operator=(const GzipDevice& other) = delete;
+
+  /* Only QIODevice::ReadOnly with optional QIODevice::Text is supported */
+  virtual bool open(QIODevice::OpenMode mode) override;
+  virtual void close() override;
+
+  virtual bool isSequential() const override
+  {
+    return true;
+  }
+
+  virtual bool atEnd() const override;
+
+  /* true if the compressed data is invalid or truncated. Message is available in errorString(). */
+  bool hasError() const
+  {
+    return error;
+  }
+
+  /* true if the source is Gzip compressed. Valid after open(). */
+  bool isCompressed() const
+  {
+    return compressed;
+  }
+
+protected:
+  virtual qint64 readData(char *data, qint64 maxSize) override;
+  virtual qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+  void setError(const QString& message);
+  void endInflate();
+
+  QIODevice *source = nullptr;
+  QBuffer *buffer = nullptr; /* Owned source if reading from byte array */
+
+  z_stream stream;
+  bool inflating = false, compressed = false, finished = false, error = false;
+
+  /* Compressed input read from source */
+  QByteArray inputBuffer;
+};
+
+} // namespace zip
+} // namespace atools
+
+#endif // ATOOLS_ZIP_GZIPDEVICE_H
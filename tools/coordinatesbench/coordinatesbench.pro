@@ -0,0 +1,28 @@
+#*****************************************************************************
+# Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#****************************************************************************
+
+# Checks the coordinate parsers against a corpus of expected results and prints parser and OpenAir import throughput
+
+include(../tools.pri)
+
+TARGET = coordinatesbench
+
+DEFINES += COORDINATES_CORPUS=\\\"$$PWD/coordinatescorpus.txt\\\"
+
+SOURCES += main.cpp
+
+OTHER_FILES += coordinatescorpus.txt
@@ -0,0 +1,359 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/*
+ * Conformance check and benchmark for the coordinate parsers in atools::fs::util.
+ *
+ * Runs fromAnyFormat, fromAnyWaypointFormat and fromOpenAirFormat over the inputs in coordinatescorpus.txt and
+ * compares the results with the expected values. These were recorded with the former regular expression based
+ * parser. Coordinates have to be equal to the last bit and fromAnyFormat has to return the same hemisphere flag.
+ *
+ * Then measures throughput for generated OpenAir coordinates, userpoint coordinates in various formats and the
+ * import of a generated OpenAir file with AirspaceReaderOpenAir into a temporary database.
+ *
+ * Usage: coordinatesbench [options] - see coordinatesbench --help
+ * Returns 0 if all corpus entries match and all generated airspaces are imported.
+ */
+
+#include "fs/userdata/airspacereaderopenair.h"
+#include "fs/util/coordinates.h"
+#include "geo/pos.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlscript.h"
+#include "atools.h"
+#include "exception.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLocale>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using atools::fs::userdata::AirspaceReaderOpenAir;
+using atools::geo::Pos;
+using atools::sql::SqlDatabase;
+using atools::sql::SqlScript;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+using Qt::endl;
+#endif
+
+namespace {
+
+const int MAX_PRINTED_MISMATCHES = 20;
+
+/* Reverts the escaping of tab, CR, LF, VT and backslash in corpus input */
+QString unescape(const QString& str)
+{
+  QString retval;
+  for(int i = 0; i < str.size(); i++)
+  {
+    QChar c = str.at(i);
+    if(c == '\\' && i + 1 < str.size())
+    {
+      c = str.at(++i);
+      if(c == 't')
+        c = '\t';
+      else if(c == 'r')
+        c = '\r';
+      else if(c == 'n')
+        c = '\n';
+      else if(c == 'v')
+        c = '\v';
+    }
+    retval.append(c);
+  }
+  return retval;
+}
+
+QString posToString(const Pos& pos)
+{
+  return pos.isValid() ? QString::number(pos.getLonX(), 'g', 9) + " " + QString::number(pos.getLatY(), 'g', 9) :
+         QString("invalid");
+}
+
+/* Runs all corpus entries and prints the result. Returns true if all entries match. */
+bool checkCorpus(const QString& filepath)
+{
+  QFile file(filepath);
+  if(!file.open(QIODevice::ReadOnly))
+    throw atools::Exception(QString("Cannot open \"%1\"").arg(filepath));
+
+  int numEntries = 0, numValid = 0, numMismatches = 0, lineNum = 0;
+  const QStringList lines = QString::fromUtf8(file.readAll()).split('\n');
+  file.close();
+
+  for(QString line : lines)
+  {
+    lineNum++;
+    if(line.endsWith('\r'))
+      line.chop(1);
+
+    if(line.isEmpty() || line.startsWith('#'))
+      continue;
+
+    // function<TAB>input<TAB>longitude<TAB>latitude<TAB>hemisphere or function<TAB>input<TAB>invalid
+    const QStringList fields = line.split('\t');
+    if(fields.size() != 3 && fields.size() != 5)
+      throw atools::Exception(QString("Invalid corpus line %1 in \"%2\"").arg(lineNum).arg(filepath));
+
+    const QString function = fields.at(0), input = unescape(fields.at(1));
+    bool expectedValid = fields.size() == 5, hemisphere = true, expectedHemisphere = fields.value(4) != "0";
+
+    Pos pos;
+    if(function == "any")
+      pos = atools::fs::util::fromAnyFormat(input, &hemisphere);
+    else if(function == "waypoint")
+      pos = atools::fs::util::fromAnyWaypointFormat(input);
+    else if(function == "openair")
+      pos = atools::fs::util::fromOpenAirFormat(input);
+    else
+      throw atools::Exception(QString("Invalid function \"%1\" in line %2").arg(function).arg(lineNum));
+
+    bool match;
+    if(expectedValid)
+      // Compare exactly since both parsers do the same float calculations
+      match = pos.isValid() && pos.getLonX() == fields.at(2).toFloat() && pos.getLatY() == fields.at(3).toFloat() &&
+              (function != "any" || hemisphere == expectedHemisphere);
+    else
+      match = !pos.isValid();
+
+    numEntries++;
+    if(expectedValid)
+      numValid++;
+
+    if(!match)
+    {
+      if(numMismatches < MAX_PRINTED_MISMATCHES)
+        QTextStream(stdout) << "Mismatch in line " << lineNum << " " << function << " \"" << fields.at(1)
+                            << "\": expected " << (expectedValid ? fields.mid(2).join(" ") : QString("invalid"))
+                            << ", got " << posToString(pos)
+                            << (function == "any" && pos.isValid() ? QString(" %1").arg(hemisphere ? 1 : 0) : QString())
+                            << endl;
+      numMismatches++;
+    }
+  }
+
+  QTextStream(stdout) << "Corpus: " << numEntries << " entries, " << numValid << " valid positions, "
+                      << numMismatches << " mismatches" << (numMismatches > 0 ? " FAILED" : "") << endl;
+  return numMismatches == 0;
+}
+
+/* OpenAir coordinate like "50:40:42 N 003:13:30 E" */
+QString openAirCoord(double laty, double lonx)
+{
+  int latSec = static_cast<int>(std::abs(laty) * 3600.), lonSec = static_cast<int>(std::abs(lonx) * 3600.);
+  return QString("%1:%2:%3 %4 %5:%6:%7 %8").
+         arg(latSec / 3600, 2, 10, QChar('0')).arg(latSec / 60 % 60, 2, 10, QChar('0')).
+         arg(latSec % 60, 2, 10, QChar('0')).arg(laty < 0. ? "S" : "N").
+         arg(lonSec / 3600, 3, 10, QChar('0')).arg(lonSec / 60 % 60, 2, 10, QChar('0')).
+         arg(lonSec % 60, 2, 10, QChar('0')).arg(lonx < 0. ? "W" : "E");
+}
+
+/* Points are spread over a grid to get different numbers of digits */
+double laty(int index)
+{
+  return -80. + (index % 1600) * 0.1 + 0.0123;
+}
+
+double lonx(int index)
+{
+  return -179. + (index / 1600 % 3580) * 0.1 + 0.0456;
+}
+
+/* Userpoint coordinates in the formats accepted by fromAnyFormat for user input and CSV import */
+QString userpointCoord(int index)
+{
+  Pos pos(lonx(index), laty(index));
+  switch(index % 4)
+  {
+    case 0:
+      // 49.4449 -9.2015
+      return QString::number(pos.getLatY(), 'f', 6) + " " + QString::number(pos.getLonX(), 'f', 6);
+
+    case 1:
+      // N49° 26' 41.57" E9° 12' 5.49"
+      return QString("%1%2° %3' %4\" %5%6° %7' %8\"").
+             arg(pos.getLatY() < 0.f ? "S" : "N").arg(atools::absInt(pos.getLatYDeg())).
+             arg(atools::absInt(pos.getLatYMin())).arg(std::abs(pos.getLatYSec()), 0, 'f', 2).
+             arg(pos.getLonX() < 0.f ? "W" : "E").arg(atools::absInt(pos.getLonXDeg())).
+             arg(atools::absInt(pos.getLonXMin())).arg(std::abs(pos.getLonXSec()), 0, 'f', 2);
+
+    case 2:
+      // 481200N0112842E
+      return atools::fs::util::toDegMinSecFormat(pos);
+
+    default:
+      // N48194W123096
+      return atools::fs::util::toGfpFormat(pos);
+  }
+}
+
+/* Parses all strings and prints lines per second */
+void benchmarkParser(const QString& name, const QStringList& lines, const std::function<Pos(const QString&)>& func)
+{
+  QElapsedTimer timer;
+  timer.start();
+  int numValid = 0;
+  for(const QString& line : lines)
+  {
+    if(func(line).isValid())
+      numValid++;
+  }
+  double seconds = std::max(timer.nsecsElapsed(), static_cast<qint64>(1)) / 1.e9;
+
+  QTextStream(stdout) << name << ": " << lines.size() << " lines, " << numValid << " valid, "
+                      << QString::number(seconds * 1000., 'f', 1) << " ms, "
+                      << static_cast<qint64>(lines.size() / seconds) << " lines/s" << endl;
+}
+
+/* Writes an OpenAir file with polygons and circles, imports it and prints lines per second.
+ * Returns true if all airspaces were imported. */
+bool benchmarkOpenAirImport(const QTemporaryDir& dir, int numAirspaces)
+{
+  const int NUM_POINTS = 20;
+  QString filepath = dir.filePath("openair.txt");
+  QFile file(filepath);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    throw atools::Exception(QString("Cannot open \"%1\"").arg(filepath));
+
+  int numLines = 0;
+  QTextStream stream(&file);
+  for(int i = 0; i < numAirspaces; i++)
+  {
+    stream << "* Airspace " << i << endl << "AC R" << endl << "AN Restricted " << i << endl
+           << "AH FL" << 100 + i % 200 << endl << "AL GND" << endl;
+    numLines += 5;
+
+    if(i % 4 == 0)
+    {
+      // Circle with center variable
+      stream << "V X=" << openAirCoord(laty(i), lonx(i)) << endl << "DC 5" << endl;
+      numLines += 2;
+    }
+    else
+    {
+      for(int j = 0; j < NUM_POINTS; j++)
+      {
+        double angle = 2. * M_PI * j / NUM_POINTS;
+        stream << "DP " << openAirCoord(laty(i) + 0.05 * std::sin(angle), lonx(i) + 0.05 * std::cos(angle)) << endl;
+      }
+      numLines += NUM_POINTS;
+    }
+    stream << endl;
+    numLines++;
+  }
+  file.close();
+
+  int numImported = 0;
+  QElapsedTimer timer;
+  {
+    SqlDatabase db = SqlDatabase::addDatabase("QSQLITE", "coordinatesbench");
+    db.setDatabaseName(dir.filePath("airspaces.sqlite"));
+    db.open();
+    SqlScript(&db, false /* verbose */).executeScript(":/atools/resources/sql/fs/db/create_boundary_schema.sql");
+    db.commit();
+
+    timer.start();
+    AirspaceReaderOpenAir reader(&db);
+    reader.readFile(filepath);
+    db.commit();
+    numImported = reader.getNumAirspacesRead();
+    db.close();
+  }
+  SqlDatabase::removeDatabase("coordinatesbench");
+
+  double seconds = std::max(timer.elapsed(), static_cast<qint64>(1)) / 1000.;
+  bool ok = numImported == numAirspaces;
+  QTextStream(stdout) << "OpenAir import: " << numLines << " lines, " << numImported << " airspaces imported, "
+                      << numAirspaces << " expected, " << timer.elapsed() << " ms, "
+                      << static_cast<qint64>(numLines / seconds) << " lines/s" << (ok ? "" : " FAILED") << endl;
+  return ok;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  // Resources of the static library contain the database schema
+  Q_INIT_RESOURCE(atools);
+
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("coordinatesbench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Conformance check and benchmark for the coordinate parsers.");
+  parser.addHelpOption();
+  QCommandLineOption corpusOpt(QStringList({"c", "corpus"}), "Corpus file with inputs and expected results.",
+                               "file", COORDINATES_CORPUS);
+  QCommandLineOption linesOpt(QStringList({"n", "lines"}), "Number of coordinates for the parser benchmarks.",
+                              "number", "1000000");
+  QCommandLineOption airspacesOpt(QStringList({"a", "airspaces"}), "Number of airspaces for the OpenAir import.",
+                                  "number", "50000");
+  parser.addOptions({corpusOpt, linesOpt, airspacesOpt});
+  parser.process(app);
+
+  const int numLines = parser.value(linesOpt).toInt(), numAirspaces = parser.value(airspacesOpt).toInt();
+  if(numLines <= 0 || numAirspaces <= 0)
+  {
+    QTextStream(stderr) << "Invalid arguments" << endl;
+    return 2;
+  }
+
+  // Corpus was recorded with a period as decimal point
+  QLocale::setDefault(QLocale::c());
+
+  // Keep messages of the airspace reader out of the output
+  QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+  bool ok = true;
+  QTemporaryDir dir;
+  try
+  {
+    ok &= checkCorpus(parser.value(corpusOpt));
+
+    QStringList openAirLines, userpointLines;
+    for(int i = 0; i < numLines; i++)
+    {
+      openAirLines.append(openAirCoord(laty(i), lonx(i)));
+      userpointLines.append(userpointCoord(i));
+    }
+
+    benchmarkParser("OpenAir coordinates", openAirLines, [](const QString& str) -> Pos {
+            return atools::fs::util::fromOpenAirFormat(str);
+          });
+    benchmarkParser("Userpoint coordinates", userpointLines, [](const QString& str) -> Pos {
+            return atools::fs::util::fromAnyFormat(str, nullptr);
+          });
+
+    ok &= benchmarkOpenAirImport(dir, numAirspaces);
+  }
+  catch(const atools::Exception& e)
+  {
+    QTextStream(stderr) << "Error: " << e.getMessage() << endl;
+    return 1;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,420 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/*
+ * Load generator for the HTTP server comparing the thread per connection pool with the event loop mode.
+ *
+ * Starts a HttpListener on a free local port for each mode and runs the given number of keep-alive connections
+ * distributed over several client threads. Each connection sends its requests one after the other and waits for
+ * the full response. Prints requests per second, latency percentiles and the peak memory of the process.
+ *
+ * Requests either go to a small generated page or to a static file served by StaticFileController. Files larger
+ * than 64 KB are not cached and are streamed by the controller which shows the memory usage for large downloads.
+ * The peak memory is measured for the whole process. Run the modes separately to compare memory usage.
+ *
+ * Usage: httpbench [options] - see httpbench --help
+ * Returns 0 if all requests were answered with status 200.
+ */
+
+#include "httpserver/httplistener.h"
+#include "httpserver/httprequest.h"
+#include "httpserver/httprequesthandler.h"
+#include "httpserver/httpresponse.h"
+#include "httpserver/staticfilecontroller.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHostAddress>
+#include <QLoggingCategory>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+
+using stefanfrings::HttpListener;
+using stefanfrings::HttpRequest;
+using stefanfrings::HttpRequestHandler;
+using stefanfrings::HttpResponse;
+using stefanfrings::StaticFileController;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+using Qt::endl;
+#endif
+
+namespace {
+
+/* Give up waiting for responses after this time */
+const int TIMEOUT_MS = 300000;
+
+/* Serves static files below "/file" and a generated page for all other paths */
+class BenchRequestHandler :
+  public HttpRequestHandler
+{
+public:
+  BenchRequestHandler(const QHash<QString, QVariant>& settings, int pageSize)
+    : staticFiles(settings), page(pageSize, 'x')
+  {
+  }
+
+  virtual void service(HttpRequest& request, HttpResponse& response) override
+  {
+    if(request.getPath().startsWith("/file"))
+      staticFiles.service(request, response);
+    else
+    {
+      response.setHeader("Content-Type", "text/plain");
+      response.write(page, true);
+    }
+  }
+
+private:
+  StaticFileController staticFiles;
+  QByteArray page;
+};
+
+/* Runs client connections in its own thread and collects the latency of each request */
+class LoadThread :
+  public QThread
+{
+public:
+  LoadThread(quint16 portParam, int numConnectionsParam, int numRequestsParam, const QByteArray& requestParam)
+    : port(portParam), numConnections(numConnectionsParam), numRequests(numRequestsParam), request(requestParam)
+  {
+  }
+
+  /* Nanoseconds from sending the request to receiving the last byte of the response */
+  QVector<qint64> latencies;
+
+  /* Responses not having status 200 and requests which were not answered */
+  int errors = 0;
+
+protected:
+  virtual void run() override;
+
+private:
+  /* State of one keep-alive connection */
+  struct Connection
+  {
+    QTcpSocket *socket = nullptr;
+    QByteArray buffer;
+    QElapsedTimer sent;
+    int remaining = 0, status = 0;
+    qint64 contentLength = -1, bodyRead = 0;
+    bool done = false;
+  };
+
+  /* Read available data and send the next request once the response is complete */
+  void readResponses(Connection& connection);
+  void sendRequest(Connection& connection);
+  void finish(Connection& connection);
+
+  quint16 port;
+  int numConnections, numRequests, active = 0;
+  QByteArray request;
+  QEventLoop *eventLoop = nullptr;
+};
+
+void LoadThread::run()
+{
+  QEventLoop loop;
+  eventLoop = &loop;
+
+  // Created in this thread - vector is not resized afterwards which keeps references valid
+  QVector<Connection> connections(numConnections);
+  active = numConnections;
+  for(Connection& connection : connections)
+  {
+    connection.remaining = numRequests;
+    connection.socket = new QTcpSocket;
+    Connection *conn = &connection;
+    QObject::connect(connection.socket, &QTcpSocket::connected, [this, conn]() {
+            sendRequest(*conn);
+          });
+    QObject::connect(connection.socket, &QTcpSocket::readyRead, [this, conn]() {
+            readResponses(*conn);
+          });
+    QObject::connect(connection.socket, &QTcpSocket::disconnected, [this, conn]() {
+            // Closed by server before all requests were answered
+            finish(*conn);
+          });
+    connection.socket->connectToHost(QHostAddress::LocalHost, port);
+  }
+
+  if(active > 0)
+  {
+    QTimer::singleShot(TIMEOUT_MS, &loop, &QEventLoop::quit);
+    loop.exec();
+  }
+
+  for(Connection& connection : connections)
+  {
+    errors += connection.remaining;
+    connection.socket->abort();
+    delete connection.socket;
+  }
+  eventLoop = nullptr;
+}
+
+void LoadThread::sendRequest(Connection& connection)
+{
+  connection.sent.start();
+  connection.socket->write(request);
+}
+
+void LoadThread::readResponses(Connection& connection)
+{
+  connection.buffer.append(connection.socket->readAll());
+
+  while(!connection.done)
+  {
+    if(connection.contentLength < 0)
+    {
+      // Wait for the complete header
+      int headerEnd = connection.buffer.indexOf("\r\n\r\n");
+      if(headerEnd < 0)
+        return;
+
+      // Status line like "HTTP/1.1 200 OK"
+      QList<QByteArray> lines = connection.buffer.left(headerEnd).split('\n');
+      connection.status = lines.first().split(' ').value(1).toInt();
+      connection.contentLength = 0;
+      for(const QByteArray& line : qAsConst(lines))
+      {
+        if(line.toLower().startsWith("content-length:"))
+          connection.contentLength = line.mid(15).trimmed().toLongLong();
+      }
+      connection.bodyRead = 0;
+      connection.buffer.remove(0, headerEnd + 4);
+    }
+
+    // Count and discard the body to keep memory usage of the client low
+    qint64 bodyPart = std::min(static_cast<qint64>(connection.buffer.size()),
+                               connection.contentLength - connection.bodyRead);
+    connection.bodyRead += bodyPart;
+    connection.buffer.remove(0, static_cast<int>(bodyPart));
+    if(connection.bodyRead < connection.contentLength)
+      return;
+
+    // Response complete
+    latencies.append(connection.sent.nsecsElapsed());
+    if(connection.status != 200)
+      errors++;
+    connection.contentLength = -1;
+
+    if(--connection.remaining > 0)
+      sendRequest(connection);
+    else
+      finish(connection);
+  }
+}
+
+void LoadThread::finish(Connection& connection)
+{
+  if(!connection.done)
+  {
+    connection.done = true;
+    connection.socket->disconnectFromHost();
+    if(--active == 0)
+      eventLoop->quit();
+  }
+}
+
+/* Value at the given percentile from sorted values */
+qint64 percentile(const QVector<qint64>& sorted, double percent)
+{
+  if(sorted.isEmpty())
+    return 0;
+  int index = static_cast<int>(percent / 100. * (sorted.size() - 1) + 0.5);
+  return sorted.at(std::min(std::max(index, 0), sorted.size() - 1));
+}
+
+/* Peak resident memory of this process in KB from procfs on Linux or -1 if not available */
+qint64 peakMemoryKb()
+{
+#ifdef Q_OS_LINUX
+  QFile file("/proc/self/status");
+  if(file.open(QIODevice::ReadOnly))
+  {
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    for(const QByteArray& line : lines)
+    {
+      if(line.startsWith("VmHWM:"))
+        return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+  }
+#endif
+  return -1;
+}
+
+/* Peak memory for printing or "unavailable" on other systems */
+QString peakMemoryStr()
+{
+  qint64 peak = peakMemoryKb();
+  return peak < 0 ? QString("unavailable") : QString::number(peak) + " KB";
+}
+
+/* Runs the load against a listener with the given settings and prints the result. Returns false on errors. */
+bool runBenchmark(const QString& name, const QHash<QString, QVariant>& settings, HttpRequestHandler *handler,
+                  int numConnections, int numRequests, int numClientThreads, const QByteArray& path)
+{
+  HttpListener listener(settings, handler);
+  if(!listener.isListening())
+  {
+    QTextStream(stderr) << name << ": cannot start listener: " << listener.errorString() << endl;
+    return false;
+  }
+
+  QByteArray request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n";
+
+  // Listener accepts connections in this thread - run the event loop until all clients are done
+  QEventLoop loop;
+  QVector<LoadThread *> threads;
+  int running = 0;
+  for(int i = 0; i < numClientThreads; i++)
+  {
+    // Distribute remaining connections to the first threads
+    int num = numConnections / numClientThreads + (i < numConnections % numClientThreads ? 1 : 0);
+    LoadThread *thread = new LoadThread(listener.serverPort(), num, numRequests, request);
+    QObject::connect(thread, &QThread::finished, &loop, [&running, &loop]() {
+            if(--running == 0)
+              loop.quit();
+          });
+    threads.append(thread);
+    running++;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  for(LoadThread *thread : qAsConst(threads))
+    thread->start();
+  loop.exec();
+  qint64 elapsedNs = std::max(timer.nsecsElapsed(), static_cast<qint64>(1));
+
+  QVector<qint64> latencies;
+  int errors = 0;
+  for(LoadThread *thread : qAsConst(threads))
+  {
+    thread->wait();
+    latencies.append(thread->latencies);
+    errors += thread->errors;
+    delete thread;
+  }
+  listener.close();
+
+  std::sort(latencies.begin(), latencies.end());
+  QTextStream(stdout) << name << ": " << latencies.size() << " requests in "
+                      << QString::number(elapsedNs / 1.e9, 'f', 2) << " s, "
+                      << static_cast<qint64>(latencies.size() / (elapsedNs / 1.e9)) << " requests/s, latency p50 "
+                      << QString::number(percentile(latencies, 50.) / 1.e6, 'f', 3) << " ms, p99 "
+                      << QString::number(percentile(latencies, 99.) / 1.e6, 'f', 3) << " ms, max "
+                      << QString::number(percentile(latencies, 100.) / 1.e6, 'f', 3) << " ms, errors " << errors
+                      << ", peak memory " << peakMemoryStr() << endl;
+  return errors == 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("httpbench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Load generator for the HTTP server comparing thread pool and event loop mode.");
+  parser.addHelpOption();
+  QCommandLineOption modeOpt(QStringList({"m", "mode"}), "Server mode \"pool\", \"eventloop\" or \"both\".",
+                             "mode", "both");
+  QCommandLineOption connectionsOpt(QStringList({"c", "connections"}), "Number of keep-alive connections.",
+                                    "number", "100");
+  QCommandLineOption requestsOpt(QStringList({"r", "requests"}), "Number of requests per connection.",
+                                 "number", "200");
+  QCommandLineOption threadsOpt(QStringList({"t", "threads"}), "Number of client threads.", "number", "4");
+  QCommandLineOption loopsOpt(QStringList({"l", "loops"}), "Number of server event loop threads.", "number", "2");
+  QCommandLineOption workersOpt(QStringList({"w", "workers"}),
+                                "Number of server worker threads. 0 uses the number of CPU cores.", "number", "0");
+  QCommandLineOption pageOpt(QStringList({"p", "page-size"}), "Size of the generated page in bytes.",
+                             "bytes", "2048");
+  QCommandLineOption fileOpt(QStringList({"f", "file-size"}),
+                             "Request a static file of this size instead of the generated page.", "bytes", "0");
+  parser.addOptions({modeOpt, connectionsOpt, requestsOpt, threadsOpt, loopsOpt, workersOpt, pageOpt, fileOpt});
+  parser.process(app);
+
+  const QString mode = parser.value(modeOpt);
+  const int numConnections = parser.value(connectionsOpt).toInt(), numRequests = parser.value(requestsOpt).toInt();
+  const int numThreads = parser.value(threadsOpt).toInt(), fileSize = parser.value(fileOpt).toInt();
+  if(numConnections <= 0 || numRequests <= 0 || numThreads <= 0 || fileSize < 0 ||
+     (mode != "pool" && mode != "eventloop" && mode != "both"))
+  {
+    QTextStream(stderr) << "Invalid arguments" << endl;
+    return 2;
+  }
+
+  // Keep connection messages of the server out of the output
+  QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+  QTemporaryDir dir;
+  QByteArray path = "/page";
+  if(fileSize > 0)
+  {
+    QFile file(dir.filePath("file.bin"));
+    if(!file.open(QIODevice::WriteOnly) || file.write(QByteArray(fileSize, 'x')) != fileSize)
+    {
+      QTextStream(stderr) << "Cannot write " << file.fileName() << endl;
+      return 1;
+    }
+    file.close();
+    path = "/file.bin";
+  }
+
+  QHash<QString, QVariant> settings;
+  settings.insert("port", 0);
+  settings.insert("readTimeout", TIMEOUT_MS);
+  settings.insert("path", dir.path());
+
+  // Allow all connections in both modes
+  settings.insert("minThreads", 4);
+  settings.insert("maxThreads", numConnections + 10);
+  settings.insert("maxConnections", numConnections + 10);
+  settings.insert("workerThreads", parser.value(workersOpt).toInt());
+
+  BenchRequestHandler handler(settings, parser.value(pageOpt).toInt());
+
+  QTextStream(stdout) << numConnections << " connections, " << numRequests << " requests each, " << numThreads
+                      << " client threads, " << (fileSize > 0 ? "static file of " : "generated page of ")
+                      << (fileSize > 0 ? fileSize : parser.value(pageOpt).toInt()) << " bytes" << endl;
+
+  bool ok = true;
+  if(mode == "pool" || mode == "both")
+  {
+    settings.insert("eventLoopThreads", 0);
+    ok &= runBenchmark("Thread pool", settings, &handler, numConnections, numRequests, numThreads, path);
+  }
+
+  if(mode == "eventloop" || mode == "both")
+  {
+    settings.insert("eventLoopThreads", std::max(1, parser.value(loopsOpt).toInt()));
+    ok &= runBenchmark("Event loop", settings, &handler, numConnections, numRequests, numThreads, path);
+  }
+
+  return ok ? 0 : 1;
+}
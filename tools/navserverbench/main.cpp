@@ -0,0 +1,413 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/*
+ * Benchmark for the simulator data path DataReaderThread -> NavServer -> clients.
+ *
+ * Uses the TrafficGeneratorHandler as data source and connects the given number of TCP clients on localhost.
+ * Clients read all packets and answer with replies like Little Navmap does. Clients can optionally send weather
+ * requests.
+ *
+ * Prints per tick latency from the data reader posting a packet to the client having fully read it, server time
+ * for serialization and fan-out per tick and the throughput. The first ticks are not measured to allow all
+ * clients to connect and switch to the delta protocol. All clients run in the main thread which means that the
+ * latency also contains the time waiting for other clients to read their packets.
+ *
+ * Can be used as load test for the NavServer which serializes each packet only once for all clients:
+ * Every client checks that it got all generated objects in each packet. Option "--mixed" connects full and delta
+ * protocol clients at the same time and option "--verify" compares the decoded content of each packet between all
+ * clients. Verification adds to the measured latency.
+ *
+ * Usage: navserverbench [options] - see navserverbench --help
+ * Returns 0 if all clients received valid packets without errors.
+ */
+
+#include "fs/ns/navserver.h"
+#include "fs/sc/datareaderthread.h"
+#include "fs/sc/simconnectdata.h"
+#include "fs/sc/simconnectdelta.h"
+#include "fs/sc/simconnectreply.h"
+#include "fs/sc/trafficgeneratorhandler.h"
+#include "geo/pos.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+
+using atools::fs::ns::NavServer;
+using atools::fs::sc::DataReaderThread;
+using atools::fs::sc::SimConnectData;
+using atools::fs::sc::SimConnectDeltaDecoder;
+using atools::fs::sc::SimConnectReply;
+using atools::fs::sc::TrafficGeneratorHandler;
+using atools::fs::sc::TrafficGeneratorOptions;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+using Qt::endl;
+#endif
+
+namespace {
+
+/* Packets with lower ids are not measured */
+const int WARMUP_TICKS = 10;
+
+/* Nanoseconds since start of the benchmark for a packet. Written in the data reader thread. */
+struct TickTimes
+{
+  qint64 posted = 0, served = 0;
+};
+
+/* One client connection */
+struct Client
+{
+  QTcpSocket *socket = nullptr;
+  SimConnectData *data = nullptr;
+  SimConnectDeltaDecoder decoder;
+  bool delta = false;
+  int packets = 0, weatherReplies = 0, missed = 0, invalid = 0, lastPacketId = 0;
+
+  /* Bytes of the measured packets and bytes read for the current packet */
+  qint64 bytes = 0, packetBytes = 0;
+};
+
+/* Hash over the AI objects of a decoded packet to compare packets received by different clients */
+QByteArray contentHash(const SimConnectData& data)
+{
+  QByteArray bytes;
+  QDataStream out(&bytes, QIODevice::WriteOnly);
+  for(const atools::fs::sc::SimConnectAircraft& aircraft : data.getAiAircraftConst())
+    out << aircraft.getObjectId() << aircraft.getPosition().getLonX() << aircraft.getPosition().getLatY()
+        << aircraft.getPosition().getAltitude() << aircraft.getHeadingDegTrue() << aircraft.getGroundSpeedKts()
+        << aircraft.getAirplaneRegistration();
+  return QCryptographicHash::hash(bytes, QCryptographicHash::Md5);
+}
+
+/* Value at the given percentile from sorted values */
+qint64 percentile(const QVector<qint64>& sorted, double percent)
+{
+  if(sorted.isEmpty())
+    return 0;
+  int index = static_cast<int>(percent / 100. * (sorted.size() - 1) + 0.5);
+  return sorted.at(std::min(std::max(index, 0), sorted.size() - 1));
+}
+
+/* Prints average, median, p99 and maximum for nanosecond values in milliseconds */
+void printTimes(const QString& name, QVector<qint64> values)
+{
+  std::sort(values.begin(), values.end());
+  qint64 sum = 0;
+  for(qint64 value : qAsConst(values))
+    sum += value;
+
+  QTextStream(stdout) << name << ": avg " << QString::number(sum / std::max(values.size(), 1) / 1.e6, 'f', 3)
+                      << " ms, p50 " << QString::number(percentile(values, 50.) / 1.e6, 'f', 3)
+                      << " ms, p99 " << QString::number(percentile(values, 99.) / 1.e6, 'f', 3)
+                      << " ms, max " << QString::number(percentile(values, 100.) / 1.e6, 'f', 3)
+                      << " ms (" << values.size() << " samples)" << endl;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("navserverbench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Benchmark for DataReaderThread -> NavServer -> clients using generated traffic.");
+  parser.addHelpOption();
+  QCommandLineOption clientsOpt(QStringList({"c", "clients"}), "Number of TCP clients.", "number", "10");
+  QCommandLineOption aircraftOpt(QStringList({"a", "aircraft"}), "Number of AI aircraft.", "number", "2000");
+  QCommandLineOption boatsOpt(QStringList({"b", "boats"}), "Number of AI boats.", "number", "100");
+  QCommandLineOption ticksOpt(QStringList({"t", "ticks"}), "Number of measured ticks.", "number", "200");
+  QCommandLineOption rateOpt(QStringList({"r", "rate"}), "Update rate of the data reader in milliseconds.",
+                             "ms", "100");
+  QCommandLineOption weatherOpt(QStringList({"w", "weather"}),
+                                "Each client sends a weather request every given number of ticks. "
+                                "0 disables weather requests.", "ticks", "0");
+  QCommandLineOption seedOpt(QStringList({"s", "seed"}), "Seed for the traffic generator.", "number", "1");
+  QCommandLineOption deltaOpt(QStringList({"d", "delta"}), "Clients use the delta protocol.");
+  QCommandLineOption mixedOpt(QStringList({"m", "mixed"}),
+                              "Every second client uses the delta protocol and the others the full protocol.");
+  QCommandLineOption verifyOpt(QStringList({"v", "verify"}), "Compare packet content between all clients.");
+  parser.addOptions({clientsOpt, aircraftOpt, boatsOpt, ticksOpt, rateOpt, weatherOpt, seedOpt, deltaOpt, mixedOpt,
+                     verifyOpt});
+  parser.process(app);
+
+  const int numClients = parser.value(clientsOpt).toInt(), numTicks = parser.value(ticksOpt).toInt();
+  const int updateRateMs = parser.value(rateOpt).toInt(), weatherTicks = parser.value(weatherOpt).toInt();
+  const bool delta = parser.isSet(deltaOpt), mixed = parser.isSet(mixedOpt), verify = parser.isSet(verifyOpt);
+  if(numClients <= 0 || numTicks <= 0 || updateRateMs <= 0 || weatherTicks < 0)
+  {
+    QTextStream(stderr) << "Invalid arguments" << endl;
+    return 2;
+  }
+
+  // Keep connection messages of server and workers out of the output
+  QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+  QElapsedTimer timer;
+  timer.start();
+
+  QMutex timesMutex;
+  QHash<int, TickTimes> times;
+  std::atomic_int lastPacketId(0);
+
+  // Data reader with traffic generator ===================================================
+  TrafficGeneratorOptions generatorOptions;
+  generatorOptions.numAircraft = parser.value(aircraftOpt).toInt();
+  generatorOptions.numBoats = parser.value(boatsOpt).toInt();
+  generatorOptions.seed = parser.value(seedOpt).toUInt();
+  generatorOptions.timeStepMs = updateRateMs;
+  TrafficGeneratorHandler handler(generatorOptions);
+  const int numObjects = generatorOptions.numAircraft + generatorOptions.numBoats;
+
+  DataReaderThread reader(nullptr, false /* verbose */);
+  reader.setHandler(&handler);
+  reader.setUpdateRate(static_cast<unsigned int>(updateRateMs));
+  reader.setReconnectRateSec(1);
+
+  // Slots are called in order of connection - first one is called before the server serializes the packet
+  QObject::connect(&reader, &DataReaderThread::postSimConnectData, &reader, [&](const SimConnectData& data) {
+          if(data.getPacketId() > 0)
+          {
+            QMutexLocker locker(&timesMutex);
+            times[data.getPacketId()].posted = timer.nsecsElapsed();
+          }
+        }, Qt::DirectConnection);
+
+  // Server on a free port ===================================================
+  NavServer server(nullptr, atools::fs::ns::NONE, 0);
+  if(!server.startServer(&reader))
+  {
+    QTextStream(stderr) << "Cannot start server: " << server.errorString() << endl;
+    return 1;
+  }
+
+  // Called after the server has serialized the packet and queued it for all workers
+  QObject::connect(&reader, &DataReaderThread::postSimConnectData, &reader, [&](const SimConnectData& data) {
+          if(data.getPacketId() > 0)
+          {
+            {
+              QMutexLocker locker(&timesMutex);
+              times[data.getPacketId()].served = timer.nsecsElapsed();
+            }
+            lastPacketId.store(data.getPacketId());
+          }
+        }, Qt::DirectConnection);
+
+  // Clients ===================================================
+  QVector<Client> clients(numClients);
+  QVector<qint64> latencies;
+  bool error = false;
+
+  // Content hash of each packet from the first client receiving it
+  QHash<int, QByteArray> contentHashes;
+  int mismatches = 0;
+
+  // Read all available packets and reply to each one
+  auto readPackets = [&](Client& client) {
+                       while(client.socket->bytesAvailable() > 0)
+                       {
+                         if(client.data == nullptr)
+                           client.data = new SimConnectData;
+
+                         qint64 available = client.socket->bytesAvailable();
+                         bool complete = client.data->read(client.socket, client.delta ? &client.decoder : nullptr);
+                         client.packetBytes += available - client.socket->bytesAvailable();
+
+                         if(!complete)
+                         {
+                           if(client.data->getStatus() != atools::fs::sc::OK)
+                           {
+                             QTextStream(stderr) << "Client read error: " << client.data->getStatusText() << endl;
+                             client.socket->abort();
+                             error = true;
+                           }
+                           // Wait for more data
+                           break;
+                         }
+
+                         qint64 received = timer.nsecsElapsed();
+                         int packetId = client.data->getPacketId();
+                         qint64 packetBytes = client.packetBytes;
+
+                         if(packetId > 0)
+                         {
+                           // Generator sends all objects on each tick which has to arrive with both protocols
+                           if(client.data->getAiAircraftConst().size() != numObjects)
+                             client.invalid++;
+
+                           if(verify)
+                           {
+                             QByteArray hash = contentHash(*client.data);
+                             auto it = contentHashes.constFind(packetId);
+                             if(it == contentHashes.constEnd())
+                               contentHashes.insert(packetId, hash);
+                             else if(it.value() != hash)
+                               mismatches++;
+                           }
+                         }
+                         delete client.data;
+                         client.data = nullptr;
+                         client.packetBytes = 0;
+
+                         if(packetId == 0)
+                         {
+                           // Weather reply
+                           client.weatherReplies++;
+                           continue;
+                         }
+
+                         if(client.lastPacketId > 0 && packetId > client.lastPacketId + 1)
+                           // Dropped by worker since reply was late
+                           client.missed += packetId - client.lastPacketId - 1;
+                         client.lastPacketId = packetId;
+
+                         if(packetId > WARMUP_TICKS && packetId <= WARMUP_TICKS + numTicks)
+                         {
+                           client.packets++;
+                           client.bytes += packetBytes;
+                           QMutexLocker locker(&timesMutex);
+                           latencies.append(received - times.value(packetId).posted);
+                         }
+
+                         SimConnectReply reply;
+                         reply.setPacketId(packetId);
+                         if(client.delta)
+                           reply.requestDeltaProtocol(client.decoder);
+                         reply.write(client.socket);
+
+                         if(weatherTicks > 0 && packetId % weatherTicks == 0)
+                         {
+                           // Separate reply for weather as done by Little Navmap
+                           SimConnectReply weatherReply;
+                           weatherReply.setCommand(atools::fs::sc::CMD_WEATHER_REQUEST);
+                           atools::fs::sc::WeatherRequest request;
+                           request.setStation("EDDF");
+                           request.setPosition(atools::geo::Pos(8.570556f, 50.033333f));
+                           weatherReply.setWeatherRequest(request);
+                           if(client.delta)
+                             weatherReply.requestDeltaProtocol(client.decoder);
+                           weatherReply.write(client.socket);
+                         }
+                         client.socket->flush();
+                       }
+                     };
+
+  for(int i = 0; i < clients.size(); i++)
+  {
+    Client& client = clients[i];
+    client.delta = mixed ? i % 2 == 1 : delta;
+    client.socket = new QTcpSocket(&app);
+    QObject::connect(client.socket, &QTcpSocket::readyRead, &app, [&clients, &readPackets, i]() {
+            readPackets(clients[i]);
+          });
+
+    client.socket->connectToHost(QHostAddress::LocalHost, server.serverPort());
+    if(!client.socket->waitForConnected(5000))
+    {
+      QTextStream(stderr) << "Cannot connect client " << i << ": " << client.socket->errorString() << endl;
+      return 1;
+    }
+  }
+
+  // Start reading once the server has accepted all connections in the event loop
+  QTimer::singleShot(500, &app, [&reader]() {
+          reader.start();
+        });
+
+  // Stop after the last measured tick and give clients time to receive the remaining packets
+  QTimer pollTimer;
+  QObject::connect(&pollTimer, &QTimer::timeout, &app, [&]() {
+          if(lastPacketId.load() >= WARMUP_TICKS + numTicks && reader.isRunning())
+          {
+            pollTimer.stop();
+            reader.terminateThread();
+            QTimer::singleShot(1000, &app, &QCoreApplication::quit);
+          }
+        });
+  pollTimer.start(50);
+
+  app.exec();
+
+  for(Client& client : clients)
+  {
+    client.socket->abort();
+    delete client.data;
+    client.data = nullptr;
+  }
+
+  // Print results ===================================================
+  QVector<qint64> serverTimes;
+  qint64 firstPosted = 0, lastPosted = 0;
+  for(int packetId = WARMUP_TICKS + 1; packetId <= WARMUP_TICKS + numTicks; packetId++)
+  {
+    const TickTimes tickTimes = times.value(packetId);
+    serverTimes.append(tickTimes.served - tickTimes.posted);
+    if(firstPosted == 0)
+      firstPosted = tickTimes.posted;
+    lastPosted = tickTimes.posted;
+  }
+
+  int packets = 0, weatherReplies = 0, missed = 0, invalid = 0;
+  qint64 bytes = 0;
+  for(const Client& client : qAsConst(clients))
+  {
+    packets += client.packets;
+    weatherReplies += client.weatherReplies;
+    missed += client.missed;
+    invalid += client.invalid;
+    bytes += client.bytes;
+    if(client.packets == 0)
+      error = true;
+  }
+  error |= invalid > 0 || mismatches > 0;
+
+  double seconds = std::max(lastPosted - firstPosted, static_cast<qint64>(1)) / 1.e9;
+
+  QTextStream(stdout) << numClients << " clients using " << (mixed ? "mixed" : (delta ? "delta" : "full"))
+                      << " protocol, "
+                      << generatorOptions.numAircraft << " aircraft, " << generatorOptions.numBoats << " boats, "
+                      << "update rate " << updateRateMs << " ms, " << numTicks << " measured ticks" << endl;
+  QTextStream(stdout) << "Ticks: " << QString::number(numTicks / seconds, 'f', 2) << " ticks/s" << endl;
+  printTimes("Server serialization and fan-out per tick", serverTimes);
+  printTimes("Latency from data reader to client", latencies);
+  QTextStream(stdout) << "Received in measured ticks: " << packets << " packets, " << missed << " missed, "
+                      << weatherReplies << " weather replies, "
+                      << QString::number(bytes / 1048576., 'f', 1) << " MB, "
+                      << QString::number(bytes / 1048576. / seconds, 'f', 2) << " MB/s, "
+                      << static_cast<qint64>(static_cast<double>(packets) * numObjects / seconds)
+                      << " objects/s" << endl;
+  QTextStream(stdout) << "Checks: " << invalid << " packets with missing objects, " << mismatches
+                      << " content mismatches" << (verify ? "" : " (not verified)") << (error ? " FAILED" : "")
+                      << endl;
+
+  return error ? 1 : 0;
+}
@@ -0,0 +1,403 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/*
+ * Benchmark for loading the route network.
+ *
+ * Reads all queries of RouteNetworkLoader with the former SqlQuery path and with SqlCursor and prints both
+ * timings. The former path used the query string constructor which executes the query followed by another exec()
+ * and the checked typed getters of SqlQuery. Both paths read the same columns with the same types and compute
+ * a checksum of all values. Then measures RouteNetworkLoader::load() for airway and radio networks.
+ *
+ * Uses a given navdata database or a generated one with waypoints, airways, VOR and NDB.
+ *
+ * Usage: routeloadbench [options] - see routeloadbench --help
+ * Returns 0 if both paths read the same values and the loaded networks are not empty.
+ */
+
+#include "routing/routenetwork.h"
+#include "routing/routenetworkloader.h"
+#include "sql/sqlcursor.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlquery.h"
+#include "sql/sqlscript.h"
+#include "exception.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+using atools::routing::RouteNetwork;
+using atools::routing::RouteNetworkLoader;
+using atools::sql::SqlCursor;
+using atools::sql::SqlDatabase;
+using atools::sql::SqlQuery;
+using atools::sql::SqlScript;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+using Qt::endl;
+#endif
+
+namespace {
+
+/* Query of the route network loader. Types has one character per column:
+ * i = int, f = float, s = string and n = int which is checked for null before reading. */
+struct LoaderQuery
+{
+  QString name, query, types;
+};
+
+const QVector<LoaderQuery> LOADER_QUERIES({
+  {"Airway edges",
+   "select airway_id, from_waypoint_id, to_waypoint_id, minimum_altitude, maximum_altitude, airway_name, "
+   "route_type, airway_type, direction from airway", "iiiiissss"},
+  {"Waypoints",
+   "select w.waypoint_id, w.ident, w.type, w.lonx, w.laty "
+   "from waypoint w "
+   "where w.type in ('WN', 'WU', 'RNAV', 'OA') and w.airport_id is null and "
+   "w.num_jet_airway = 0 and w.num_victor_airway = 0", "issff"},
+  {"Airway waypoints",
+   "select w.waypoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway "
+   "from waypoint w "
+   "where w.type in ('WN', 'WU', 'RNAV') and (w.num_jet_airway > 0 or w.num_victor_airway > 0)", "issffii"},
+  {"Airway VOR",
+   "select w.waypoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway, "
+   "v.range, v.type as radiotype, v.dme_altitude,  v.dme_only "
+   "from waypoint w join vor v on w.nav_id = v.vor_id "
+   "where w.type = 'V' and (w.num_jet_airway > 0 or w.num_victor_airway > 0)", "issffiiisni"},
+  {"Airway NDB",
+   "select w.waypoint_id, w.ident, w.type, w.lonx, w.laty, w.num_jet_airway, w.num_victor_airway, "
+   "n.range "
+   "from waypoint w join ndb n on w.nav_id = n.ndb_id "
+   "where w.type = 'N' and (w.num_jet_airway > 0 or w.num_victor_airway > 0)", "issffiii"},
+  {"Radio VOR",
+   "select v.vor_id, v.lonx, v.laty, v.range, "
+   "case when v.dme_altitude is null then 0 else 1 end as has_dme "
+   "from vor v where type <> 'TC' and dme_only = 0", "iffii"},
+  {"Radio NDB",
+   "select n.ndb_id, n.lonx, n.laty, n.range, null as has_dme from ndb n", "iffin"}
+});
+
+/* Sum of all values which has to be equal for both paths */
+struct Checksum
+{
+  qint64 rows = 0, ints = 0, chars = 0;
+  double floats = 0.;
+
+  bool operator==(const Checksum& other) const
+  {
+    return rows == other.rows && ints == other.ints && chars == other.chars && floats == other.floats;
+  }
+};
+
+/* Read all rows with the former path using the checked getters of SqlQuery */
+Checksum readQuery(SqlDatabase& db, const LoaderQuery& loaderQuery)
+{
+  Checksum sum;
+  const QString& types = loaderQuery.types;
+
+  // String constructor executes the query and exec() runs it again as the loader did before
+  SqlQuery query(loaderQuery.query, db);
+  query.exec();
+  while(query.next())
+  {
+    sum.rows++;
+    for(int col = 0; col < types.size(); col++)
+    {
+      switch(types.at(col).toLatin1())
+      {
+        case 'n':
+          if(query.isNull(col))
+            break;
+          sum.ints += query.valueInt(col);
+          break;
+
+        case 'i':
+          sum.ints += query.valueInt(col);
+          break;
+
+        case 'f':
+          sum.floats += query.valueFloat(col);
+          break;
+
+        case 's':
+          sum.chars += query.valueStr(col).size();
+          break;
+      }
+    }
+  }
+  return sum;
+}
+
+/* Read all rows with a forward only cursor */
+Checksum readCursor(SqlDatabase& db, const LoaderQuery& loaderQuery)
+{
+  Checksum sum;
+  const QString& types = loaderQuery.types;
+
+  SqlQuery sqlQuery(db);
+  SqlCursor query(sqlQuery);
+  query.exec(loaderQuery.query);
+  while(query.next())
+  {
+    sum.rows++;
+    for(int col = 0; col < types.size(); col++)
+    {
+      switch(types.at(col).toLatin1())
+      {
+        case 'n':
+          if(query.isNull(col))
+            break;
+          sum.ints += query.valueInt(col);
+          break;
+
+        case 'i':
+          sum.ints += query.valueInt(col);
+          break;
+
+        case 'f':
+          sum.floats += query.valueFloat(col);
+          break;
+
+        case 's':
+          sum.chars += query.valueStr(col).size();
+          break;
+      }
+    }
+  }
+  return sum;
+}
+
+/* Runs func the given number of times and returns the best time in ms */
+qint64 bestOf(int repeat, const std::function<void()>& func)
+{
+  qint64 best = std::numeric_limits<qint64>::max();
+  QElapsedTimer timer;
+  for(int i = 0; i < repeat; i++)
+  {
+    timer.start();
+    func();
+    best = std::min(best, timer.elapsed());
+  }
+  return best;
+}
+
+/* Fill navdata tables with waypoints on a 0.5 degree grid. Every fourth waypoint is not on an airway and
+ * every twentieth is a VOR or NDB waypoint. Airways connect neighboring waypoints in east-west direction. */
+void generateDatabase(SqlDatabase& db, int numWaypoints)
+{
+  SqlScript(&db, false /* verbose */).executeScript(":/atools/resources/sql/fs/db/create_nav_schema.sql");
+
+  SqlQuery waypointQuery(db), vorQuery(db), ndbQuery(db), airwayQuery(db);
+  waypointQuery.prepare("insert into waypoint (waypoint_id, file_id, nav_id, ident, region, type, "
+                        "num_victor_airway, num_jet_airway, mag_var, lonx, laty) "
+                        "values(?, 1, ?, ?, 'ZZ', ?, ?, ?, 0, ?, ?)");
+  vorQuery.prepare("insert into vor (vor_id, file_id, ident, type, frequency, range, dme_only, dme_altitude, "
+                   "lonx, laty) values(?, 1, ?, 'H', 114000, 130, 0, ?, ?, ?)");
+  ndbQuery.prepare("insert into ndb (ndb_id, file_id, ident, type, frequency, range, mag_var, lonx, laty) "
+                   "values(?, 1, ?, 'H', 35000, 50, 0, ?, ?)");
+  airwayQuery.prepare("insert into airway (airway_id, airway_name, airway_type, route_type, airway_fragment_no, "
+                      "sequence_no, from_waypoint_id, to_waypoint_id, direction, minimum_altitude, "
+                      "maximum_altitude, left_lonx, top_laty, right_lonx, bottom_laty, "
+                      "from_lonx, from_laty, to_lonx, to_laty) "
+                      "values(?, ?, 'J', 'O', 1, ?, ?, ?, 'N', 5000, 45000, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+  const int numCols = 720;
+  int airwayId = 1;
+  for(int i = 0; i < numWaypoints; i++)
+  {
+    int id = i + 1;
+    double lonx = -180. + (i % numCols) * 0.5, laty = -80. + (i / numCols % 320) * 0.5;
+    bool airway = i % 4 != 0;
+    QString ident = "W" + QString::number(i, 36).toUpper().rightJustified(4, '0');
+    QString type = "WN";
+    QVariant navId;
+
+    if(airway && i % 20 == 1)
+    {
+      type = "V";
+      navId = id;
+      vorQuery.bindValue(0, id);
+      vorQuery.bindValue(1, ident.right(3));
+      vorQuery.bindValue(2, i % 40 == 1 ? QVariant(1000) : QVariant(QVariant::Int));
+      vorQuery.bindValue(3, lonx);
+      vorQuery.bindValue(4, laty);
+      vorQuery.exec();
+    }
+    else if(airway && i % 20 == 11)
+    {
+      type = "N";
+      navId = id;
+      ndbQuery.bindValue(0, id);
+      ndbQuery.bindValue(1, ident.right(2));
+      ndbQuery.bindValue(2, lonx);
+      ndbQuery.bindValue(3, laty);
+      ndbQuery.exec();
+    }
+
+    waypointQuery.bindValue(0, id);
+    waypointQuery.bindValue(1, navId);
+    waypointQuery.bindValue(2, ident);
+    waypointQuery.bindValue(3, type);
+    waypointQuery.bindValue(4, airway ? 1 : 0);
+    waypointQuery.bindValue(5, airway ? 1 : 0);
+    waypointQuery.bindValue(6, lonx);
+    waypointQuery.bindValue(7, laty);
+    waypointQuery.exec();
+
+    // Connect to the previous airway waypoint in the same row
+    int prev = i - 1;
+    if(airway && i % numCols != 0 && prev % 4 != 0)
+    {
+      double prevLonx = lonx - 0.5;
+      airwayQuery.bindValue(0, airwayId);
+      airwayQuery.bindValue(1, "J" + QString::number(i / numCols % 1000));
+      airwayQuery.bindValue(2, airwayId++);
+      airwayQuery.bindValue(3, prev + 1);
+      airwayQuery.bindValue(4, id);
+      airwayQuery.bindValue(5, prevLonx);
+      airwayQuery.bindValue(6, laty);
+      airwayQuery.bindValue(7, lonx);
+      airwayQuery.bindValue(8, laty);
+      airwayQuery.bindValue(9, prevLonx);
+      airwayQuery.bindValue(10, laty);
+      airwayQuery.bindValue(11, lonx);
+      airwayQuery.bindValue(12, laty);
+      airwayQuery.exec();
+    }
+  }
+  db.commit();
+}
+
+/* Measure reading of all loader queries with both paths and print timings. Returns false if checksums differ. */
+bool benchmarkQueries(SqlDatabase& db, int repeat)
+{
+  bool ok = true;
+  qint64 totalQuery = 0, totalCursor = 0;
+  for(const LoaderQuery& loaderQuery : LOADER_QUERIES)
+  {
+    Checksum querySum, cursorSum;
+    qint64 queryMs = bestOf(repeat, [&db, &loaderQuery, &querySum]() -> void {
+            querySum = readQuery(db, loaderQuery);
+          });
+    qint64 cursorMs = bestOf(repeat, [&db, &loaderQuery, &cursorSum]() -> void {
+            cursorSum = readCursor(db, loaderQuery);
+          });
+    totalQuery += queryMs;
+    totalCursor += cursorMs;
+
+    bool equal = querySum == cursorSum;
+    ok &= equal;
+    QTextStream(stdout) << loaderQuery.name << ": " << querySum.rows << " rows, SqlQuery " << queryMs
+                        << " ms, SqlCursor " << cursorMs << " ms" << (equal ? "" : " FAILED checksum") << endl;
+  }
+  QTextStream(stdout) << "All queries: SqlQuery " << totalQuery << " ms, SqlCursor " << totalCursor << " ms" << endl;
+  return ok;
+}
+
+/* Measure RouteNetworkLoader::load() and print timing. Returns false if the network is empty. */
+bool benchmarkLoader(SqlDatabase& db, atools::routing::DataSource source, const QString& name, int repeat)
+{
+  RouteNetwork network(source);
+  qint64 loadMs = bestOf(repeat, [&db, &network]() -> void {
+          RouteNetworkLoader(&db, nullptr).load(&network);
+        });
+
+  int numNodes = network.getNodes().size();
+  QTextStream(stdout) << name << " network: " << numNodes << " nodes, load " << loadMs << " ms"
+                      << (numNodes > 0 ? "" : " FAILED") << endl;
+  return numNodes > 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  // Resources of the static library contain the database schema
+  Q_INIT_RESOURCE(atools);
+
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("routeloadbench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Benchmark for loading the route network with SqlQuery and SqlCursor.");
+  parser.addHelpOption();
+  QCommandLineOption databaseOpt(QStringList({"d", "database"}),
+                                 "Navdata database to read. A database is generated if not given.", "file");
+  QCommandLineOption waypointsOpt(QStringList({"w", "waypoints"}), "Number of waypoints for generated database.",
+                                  "number", "250000");
+  QCommandLineOption repeatOpt(QStringList({"r", "repeat"}), "Number of runs. The best time is printed.",
+                               "number", "3");
+  parser.addOptions({databaseOpt, waypointsOpt, repeatOpt});
+  parser.process(app);
+
+  const int numWaypoints = parser.value(waypointsOpt).toInt(), repeat = parser.value(repeatOpt).toInt();
+  if(numWaypoints <= 0 || repeat <= 0)
+  {
+    QTextStream(stderr) << "Invalid arguments" << endl;
+    return 2;
+  }
+
+  // Keep messages of the loader out of the output
+  QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+  bool ok = true;
+  QTemporaryDir dir;
+  try
+  {
+    {
+      SqlDatabase db = SqlDatabase::addDatabase("QSQLITE", "routeloadbench");
+      if(parser.isSet(databaseOpt))
+      {
+        db.setDatabaseName(parser.value(databaseOpt));
+        db.setReadonly();
+        db.open();
+      }
+      else
+      {
+        QElapsedTimer timer;
+        timer.start();
+        db.setDatabaseName(dir.filePath("navdata.sqlite"));
+        db.open();
+        generateDatabase(db, numWaypoints);
+        QTextStream(stdout) << "Generated database with " << numWaypoints << " waypoints in "
+                            << timer.elapsed() << " ms" << endl;
+      }
+
+      ok &= benchmarkQueries(db, repeat);
+      ok &= benchmarkLoader(db, atools::routing::SOURCE_AIRWAY, "Airway", repeat);
+      ok &= benchmarkLoader(db, atools::routing::SOURCE_RADIO, "Radio", repeat);
+
+      db.close();
+    }
+    SqlDatabase::removeDatabase("routeloadbench");
+  }
+  catch(const atools::Exception& e)
+  {
+    QTextStream(stderr) << "Error: " << e.getMessage() << endl;
+    return 1;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+#*****************************************************************************
+# Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#****************************************************************************
+
+# Common settings for all tools - see tools.pro
+
+QT += sql xml core network svg widgets
+
+versionAtLeast(QT_VERSION, 6.0.0): QT += core5compat
+CONFIG += c++14 console
+CONFIG -= app_bundle debug_and_release debug_and_release_target
+
+TEMPLATE = app
+
+CONFIG(debug, debug|release) : CONF_TYPE=debug
+CONFIG(release, debug|release) : CONF_TYPE=release
+
+ATOOLS_LIB_PATH=$$(ATOOLS_LIB_PATH)
+isEmpty(ATOOLS_LIB_PATH) : ATOOLS_LIB_PATH=$$PWD/../../build-atools-$$CONF_TYPE
+
+INCLUDEPATH += $$PWD/../src
+DEPENDPATH += $$PWD/../src
+
+win32 {
+  DEFINES += _USE_MATH_DEFINES NOMINMAX
+}
+
+LIBS += -L$$ATOOLS_LIB_PATH -latools
+PRE_TARGETDEPS += $$ATOOLS_LIB_PATH/libatools.a
+
+DEFINES += QT_NO_CAST_FROM_BYTEARRAY
+DEFINES += QT_NO_CAST_TO_ASCII
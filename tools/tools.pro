@@ -0,0 +1,45 @@
+#*****************************************************************************
+# Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#****************************************************************************
+
+# =============================================================================
+# Console tools to benchmark and check atools components. Not part of the library build.
+#
+# Build atools first. The tools link the static library from ATOOLS_LIB_PATH which defaults
+# to "../../build-atools-debug" or "../../build-atools-release" relative to this folder.
+#
+# Example:
+# cd build-atools-tools-release && qmake ../atools/tools/tools.pro CONFIG+=release && make
+# ./userpointimportbench/userpointimportbench 500000
+# ./coordinatesbench/coordinatesbench --lines 1000000 --airspaces 50000
+# ./navserverbench/navserverbench --clients 20 --aircraft 2000 --delta
+# ./navserverbench/navserverbench --clients 50 --mixed --verify
+# ./httpbench/httpbench --connections 200 --mode both
+# ./routeloadbench/routeloadbench --database little_navmap_navigraph.sqlite
+# ./undobench/undobench --rows 1000,10000,100000
+# ./whazzupbench/whazzupbench --method sax && ./whazzupbench/whazzupbench --method document
+# =============================================================================
+
+TEMPLATE = subdirs
+
+SUBDIRS = \
+  coordinatesbench \
+  httpbench \
+  navserverbench \
+  routeloadbench \
+  undobench \
+  userpointimportbench \
+  whazzupbench
@@ -0,0 +1,245 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/*
+ * Benchmark for the set based undo and redo of the userdata and logbook managers.
+ *
+ * Fills a temporary database with the given numbers of rows for each manager. Then measures a bulk update of one
+ * column for all rows followed by undo and redo, and a bulk delete of all rows followed by undo and redo.
+ * Checks row count and the updated column after each step.
+ *
+ * Usage: undobench [options] - see undobench --help
+ * Returns 0 if all row counts and values match after each step.
+ */
+
+#include "fs/userdata/logdatamanager.h"
+#include "fs/userdata/userdatamanager.h"
+#include "sql/datamanagerbase.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlrecord.h"
+#include "exception.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <functional>
+
+using atools::fs::userdata::LogdataManager;
+using atools::fs::userdata::UserdataManager;
+using atools::sql::DataManagerBase;
+using atools::sql::SqlDatabase;
+using atools::sql::SqlRecord;
+using atools::sql::SqlRecordList;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+using Qt::endl;
+#endif
+
+namespace {
+
+/* Fills values of an empty record for row index */
+typedef std::function<void (SqlRecord& record, int index)> FillFuncType;
+
+void fillUserdata(SqlRecord& record, int index)
+{
+  record.setValue("type", "Waypoint");
+  record.setValue("name", QString("Waypoint %1").arg(index));
+  record.setValue("ident", QString("W%1").arg(index));
+  record.setValue("description", QString("Description %1").arg(index));
+  record.setValue("last_edit_timestamp", "2023-01-01T10:00:00");
+  record.setValue("lonx", -179. + (index / 1600 % 3580) * 0.1);
+  record.setValue("laty", -80. + (index % 1600) * 0.1);
+}
+
+void fillLogbook(SqlRecord& record, int index)
+{
+  record.setValue("aircraft_name", "Cessna 172");
+  record.setValue("aircraft_type", "C172");
+  record.setValue("departure_ident", "EDDF");
+  record.setValue("destination_ident", "EDDM");
+  record.setValue("distance", 165. + index % 100);
+  record.setValue("description", QString("Description %1").arg(index));
+}
+
+/* Prints an error and returns false if the number of rows differs */
+bool checkRows(const QString& name, const DataManagerBase& manager, int expected)
+{
+  int rows = manager.rowCount();
+  if(rows != expected)
+    QTextStream(stderr) << name << ": " << rows << " rows but expected " << expected << endl;
+  return rows == expected;
+}
+
+/* Prints an error and returns false if the description of the first row differs */
+bool checkDescription(const QString& name, const DataManagerBase& manager, const QString& expected)
+{
+  QString description = manager.getValue(1, "description").toString();
+  if(description != expected)
+    QTextStream(stderr) << name << ": description \"" << description << "\" but expected \"" << expected << "\""
+                        << endl;
+  return description == expected;
+}
+
+/* Runs all steps on a filled table and prints one line with times in ms. Returns false if a check failed. */
+bool runBenchmark(const QString& name, DataManagerBase& manager, SqlDatabase& db, int numRows, const FillFuncType& fill)
+{
+  QElapsedTimer timer;
+  bool ok = true;
+
+  // Fill table - ids start at one in an empty table
+  SqlRecordList records;
+  SqlRecord emptyRecord = manager.getEmptyRecord();
+  for(int i = 0; i < numRows; i++)
+  {
+    SqlRecord record(emptyRecord);
+    fill(record, i);
+    records.append(record);
+  }
+
+  timer.start();
+  manager.insertRecords(records);
+  db.commit();
+  qint64 insertMs = timer.elapsed();
+  ok &= checkRows(name + " insert", manager, numRows);
+
+  QSet<int> ids;
+  for(int id = 1; id <= numRows; id++)
+    ids.insert(id);
+
+  // Update ===============================
+  timer.restart();
+  manager.updateField("description", ids, "Updated");
+  db.commit();
+  qint64 updateMs = timer.elapsed();
+  ok &= checkDescription(name + " update", manager, "Updated");
+
+  timer.restart();
+  manager.undo();
+  db.commit();
+  qint64 updateUndoMs = timer.elapsed();
+  ok &= checkDescription(name + " undo update", manager, "Description 0");
+
+  timer.restart();
+  manager.redo();
+  db.commit();
+  qint64 updateRedoMs = timer.elapsed();
+  ok &= checkDescription(name + " redo update", manager, "Updated");
+
+  // Delete ===============================
+  timer.restart();
+  manager.deleteRows(ids);
+  db.commit();
+  qint64 deleteMs = timer.elapsed();
+  ok &= checkRows(name + " delete", manager, 0);
+
+  timer.restart();
+  manager.undo();
+  db.commit();
+  qint64 deleteUndoMs = timer.elapsed();
+  ok &= checkRows(name + " undo delete", manager, numRows);
+
+  timer.restart();
+  manager.redo();
+  db.commit();
+  qint64 deleteRedoMs = timer.elapsed();
+  ok &= checkRows(name + " redo delete", manager, 0);
+
+  QTextStream(stdout) << name << " " << numRows << " rows: insert " << insertMs
+                      << " ms, update " << updateMs << " ms, undo " << updateUndoMs << " ms, redo " << updateRedoMs
+                      << " ms, delete " << deleteMs << " ms, undo " << deleteUndoMs << " ms, redo " << deleteRedoMs
+                      << " ms" << (ok ? "" : " FAILED") << endl;
+  return ok;
+}
+
+/* Creates a temporary database with the schema of the manager and runs the benchmark */
+template<typename MANAGER>
+bool runManager(const QString& name, const QTemporaryDir& dir, int numRows, const FillFuncType& fill)
+{
+  bool ok = true;
+  QString connection = QString("undobench_%1_%2").arg(name).arg(numRows);
+  {
+    SqlDatabase db = SqlDatabase::addDatabase("QSQLITE", connection);
+    db.setDatabaseName(dir.filePath(connection + ".sqlite"));
+    db.open();
+
+    MANAGER manager(&db);
+    manager.createSchema(false /* verbose */);
+    ok = runBenchmark(name, manager, db, numRows, fill);
+
+    db.close();
+  }
+  SqlDatabase::removeDatabase(connection);
+  return ok;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  // Resources of the static library contain the database schema
+  Q_INIT_RESOURCE(atools);
+
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("undobench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Benchmark for bulk changes with undo and redo of the userdata and logbook.");
+  parser.addHelpOption();
+  QCommandLineOption rowsOpt(QStringList({"r", "rows"}), "Comma separated list of row numbers.",
+                             "numbers", "1000,10000,100000");
+  parser.addOptions({rowsOpt});
+  parser.process(app);
+
+  QVector<int> rowNumbers;
+  const QStringList rowNumberStrs = parser.value(rowsOpt).split(',');
+  for(const QString& str : rowNumberStrs)
+  {
+    int num = str.trimmed().toInt();
+    if(num <= 0)
+    {
+      QTextStream(stderr) << "Invalid number of rows \"" << str << "\"" << endl;
+      return 2;
+    }
+    rowNumbers.append(num);
+  }
+
+  // Keep messages of the managers out of the output
+  QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+  bool ok = true;
+  QTemporaryDir dir;
+  try
+  {
+    for(int numRows : rowNumbers)
+    {
+      ok &= runManager<UserdataManager>("Userdata", dir, numRows, fillUserdata);
+      ok &= runManager<LogdataManager>("Logbook", dir, numRows, fillLogbook);
+    }
+  }
+  catch(const atools::Exception& e)
+  {
+    QTextStream(stderr) << "Error: " << e.getMessage() << endl;
+    return 1;
+  }
+
+  return ok ? 0 : 1;
+}
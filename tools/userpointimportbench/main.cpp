@@ -0,0 +1,171 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/*
+ * Benchmark and check for the userpoint import.
+ *
+ * Generates an X-Plane user_fix.dat and two CSV files with the given number of waypoints and imports them into a
+ * temporary userdata database. Prints time and rows per second for each import.
+ *
+ * The second CSV file contains the same waypoints as the first one with other last edit timestamps and fewer
+ * decimals. These have to be detected as duplicates.
+ *
+ * Usage: userpointimportbench [number of waypoints, default 500000]
+ * Returns 0 if the number of imported rows matches the expected number.
+ */
+
+#include "fs/userdata/userdatamanager.h"
+#include "sql/sqldatabase.h"
+#include "exception.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+
+using atools::sql::SqlDatabase;
+using atools::fs::userdata::UserdataManager;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+using Qt::endl;
+#endif
+
+namespace {
+
+/* Waypoints are placed on a 0.1 degree grid which gives unique coordinates for several million points */
+QString ident(int index)
+{
+  return "W" + QString::number(index, 36).toUpper().rightJustified(5, '0');
+}
+
+double laty(int index)
+{
+  return -80. + (index % 1600) * 0.1;
+}
+
+double lonx(int index)
+{
+  return -179. + (index / 1600 % 3580) * 0.1;
+}
+
+void writeXplane(const QString& filepath, int numWaypoints)
+{
+  QFile file(filepath);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    throw atools::Exception(QString("Cannot open \"%1\"").arg(filepath));
+
+  // 46.646819444 -123.722388889 AAYRR KSEA  K1 4530263
+  QTextStream stream(&file);
+  stream << "I" << endl << "1101 Version - generated by userpointimportbench" << endl << endl;
+  for(int i = 0; i < numWaypoints; i++)
+    stream << QString::number(laty(i), 'f', 9) << " " << QString::number(lonx(i), 'f', 9) << " " << ident(i)
+           << " ENRT ZZ 0 WAYPOINT " << i << endl;
+  stream << "99" << endl;
+  file.close();
+}
+
+void writeCsv(const QString& filepath, int numWaypoints, const QString& lastEdit, int decimals)
+{
+  QFile file(filepath);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    throw atools::Exception(QString("Cannot open \"%1\"").arg(filepath));
+
+  // Type,Name,Ident,Latitude,Longitude,Elevation,Magnetic Declination,Tags,Description,Region,Visible From,
+  // Last Edit,Import Filename
+  QTextStream stream(&file);
+  for(int i = 0; i < numWaypoints; i++)
+    stream << "Waypoint,Waypoint " << i << "," << ident(i) << ","
+           << QString::number(laty(i), 'f', decimals) << "," << QString::number(lonx(i), 'f', decimals)
+           << ",1000,,Tag,Description " << i << ",ZZ,250," << lastEdit << "," << endl;
+  file.close();
+}
+
+/* Prints result and returns true if the number of rows is as expected */
+bool report(const QString& name, int numLines, int numImported, int numExpected, qint64 elapsedMs)
+{
+  double seconds = std::max(elapsedMs, static_cast<qint64>(1)) / 1000.;
+  bool ok = numImported == numExpected;
+  QTextStream(stdout) << name << ": " << numLines << " lines, " << numImported << " rows imported, "
+                      << numExpected << " expected, " << elapsedMs << " ms, "
+                      << static_cast<qint64>(numImported / seconds) << " rows/s"
+                      << (ok ? "" : " FAILED") << endl;
+  return ok;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  // Resources of the static library contain the database schema
+  Q_INIT_RESOURCE(atools);
+
+  QCoreApplication app(argc, argv);
+
+  int numWaypoints = argc > 1 ? QString(argv[1]).toInt() : 500000;
+  if(numWaypoints <= 0)
+  {
+    QTextStream(stderr) << "Usage: userpointimportbench [number of waypoints]" << endl;
+    return 2;
+  }
+
+  bool ok = true;
+  QTemporaryDir dir;
+  try
+  {
+    QString xplaneFile = dir.filePath("user_fix.dat"), csvFile1 = dir.filePath("userpoints1.csv"),
+            csvFile2 = dir.filePath("userpoints2.csv");
+
+    QElapsedTimer timer;
+    timer.start();
+    writeXplane(xplaneFile, numWaypoints);
+    writeCsv(csvFile1, numWaypoints, "2023-01-01T10:00:00", 8);
+    writeCsv(csvFile2, numWaypoints, "2023-06-01T12:30:00", 6);
+    QTextStream(stdout) << "Generated files in " << timer.elapsed() << " ms" << endl;
+
+    {
+      SqlDatabase db = SqlDatabase::addDatabase("QSQLITE", "userpointimportbench");
+      db.setDatabaseName(dir.filePath("userdata.sqlite"));
+      db.open({"PRAGMA foreign_keys = ON"});
+
+      UserdataManager manager(&db);
+      manager.createSchema(false /* verbose */);
+
+      timer.restart();
+      int numImported = manager.importXplane(xplaneFile);
+      ok &= report("X-Plane user_fix.dat", numWaypoints, numImported, numWaypoints, timer.elapsed());
+
+      // Same waypoints in two files with different timestamps and decimals
+      timer.restart();
+      numImported = manager.importCsv({csvFile1, csvFile2});
+      ok &= report("CSV with duplicates", numWaypoints * 2, numImported, numWaypoints, timer.elapsed());
+
+      db.close();
+    }
+    SqlDatabase::removeDatabase("userpointimportbench");
+  }
+  catch(const atools::Exception& e)
+  {
+    QTextStream(stderr) << "Error: " << e.getMessage() << endl;
+    return 1;
+  }
+
+  return ok ? 0 : 1;
+}
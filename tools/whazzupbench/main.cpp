@@ -0,0 +1,453 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/*
+ * Benchmark for reading the VATSIM JSON version 3 feed and the transceivers file.
+ *
+ * Reads the same feed and transceivers file with the streaming SAX parser in WhazzupTextParser and with
+ * QJsonDocument. The QJsonDocument method parses the whole file into a document and reads the same keys for
+ * each row as the former reader did. Prints time and peak memory for each method and file.
+ * Reading the feed with WhazzupTextParser includes writing all rows into a temporary database.
+ *
+ * Peak memory is measured on Linux only by resetting the high water mark in procfs before each run. Run the
+ * methods separately with --method to avoid effects of memory which is kept by the allocator.
+ *
+ * Uses the given files or generated ones.
+ *
+ * Usage: whazzupbench [options] - see whazzupbench --help
+ * Returns 0 if both methods find the same number of pilots, prefiles and controllers.
+ */
+
+#include "fs/online/whazzuptextparser.h"
+#include "sql/sqldatabase.h"
+#include "sql/sqlscript.h"
+#include "exception.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QPointF>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+using atools::fs::online::WhazzupTextParser;
+using atools::sql::SqlDatabase;
+using atools::sql::SqlScript;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+using Qt::endl;
+#endif
+
+namespace {
+
+/* Keys read for each row of the feed sections as used by the former reader. Dots separate nested objects. */
+const QStringList FLIGHTPLAN_KEYS({"flight_plan.flight_rules", "flight_plan.aircraft", "flight_plan.departure",
+                                   "flight_plan.arrival", "flight_plan.alternate", "flight_plan.cruise_tas",
+                                   "flight_plan.altitude", "flight_plan.deptime", "flight_plan.enroute_time",
+                                   "flight_plan.fuel_time", "flight_plan.remarks", "flight_plan.route"});
+
+const QHash<QString, QStringList> SECTION_KEYS({
+  {"pilots", QStringList({"cid", "name", "callsign", "latitude", "longitude", "altitude", "groundspeed", "server",
+                          "transponder", "heading", "logon_time"}) + FLIGHTPLAN_KEYS},
+  {"controllers", QStringList({"cid", "name", "callsign", "frequency", "facility", "server", "visual_range",
+                               "text_atis", "last_updated", "logon_time", "latitude", "longitude"})},
+  {"servers", QStringList({"ident", "hostname_or_ip", "location", "name"})},
+  {"prefiles", QStringList({"cid", "name", "callsign"}) + FLIGHTPLAN_KEYS}
+});
+
+#ifdef Q_OS_LINUX
+/* Value of a field like "VmHWM" from procfs in KB or -1 if not found */
+qint64 statusKb(const QByteArray& field)
+{
+  QFile file("/proc/self/status");
+  if(file.open(QIODevice::ReadOnly))
+  {
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    for(const QByteArray& line : lines)
+    {
+      if(line.startsWith(field + ":"))
+        return line.mid(field.size() + 1).trimmed().split(' ').first().toLongLong();
+    }
+  }
+  return -1;
+}
+
+#endif
+
+/* Resets the peak resident memory to the current value. Returns the current value in KB or -1 if not available. */
+qint64 resetPeakMemoryKb()
+{
+#ifdef Q_OS_LINUX
+  QFile file("/proc/self/clear_refs");
+  if(file.open(QIODevice::WriteOnly) && file.write("5") == 1)
+  {
+    file.close();
+    return statusKb("VmRSS");
+  }
+#endif
+  return -1;
+}
+
+/* Peak resident memory in KB since last reset or -1 if not available */
+qint64 peakMemoryKb()
+{
+#ifdef Q_OS_LINUX
+  return statusKb("VmHWM");
+
+#else
+  return -1;
+
+#endif
+}
+
+/* Result of a method for one file */
+struct Result
+{
+  qint64 bestMs = std::numeric_limits<qint64>::max(), peakKb = -1;
+  int rows = -1; /* -1 if not available */
+};
+
+/* Runs func repeat times and records best time and the largest peak memory increase.
+ * prepare is called before each run and not measured. func returns the number of rows. */
+Result measure(int repeat, const std::function<void()>& prepare, const std::function<int()>& func)
+{
+  Result result;
+  QElapsedTimer timer;
+  for(int i = 0; i < repeat; i++)
+  {
+    prepare();
+    qint64 baseKb = resetPeakMemoryKb();
+
+    timer.start();
+    result.rows = func();
+    result.bestMs = std::min(result.bestMs, timer.elapsed());
+
+    qint64 peakKb = peakMemoryKb();
+    if(baseKb >= 0 && peakKb >= 0)
+      result.peakKb = std::max(result.peakKb, peakKb - baseKb);
+  }
+  return result;
+}
+
+void printResult(const QString& name, const Result& result)
+{
+  QTextStream(stdout) << name << ": " << (result.rows < 0 ? QString("-") : QString::number(result.rows))
+                      << " rows, " << result.bestMs << " ms, peak memory "
+                      << (result.peakKb < 0 ? QString("unavailable") : "+" + QString::number(result.peakKb) + " KB")
+                      << endl;
+}
+
+/* Get value for a key where dots separate nested objects */
+QJsonValue pathValue(const QJsonObject& obj, const QString& key)
+{
+  int dot = key.indexOf('.');
+  if(dot == -1)
+    return obj.value(key);
+  else
+    return obj.value(key.left(dot)).toObject().value(key.mid(dot + 1));
+}
+
+/* Parse feed into a document and read all keys of all rows into string lists.
+ * Returns number of pilots, prefiles and controllers. */
+int readFeedDocument(const QByteArray& feed)
+{
+  QJsonObject root = QJsonDocument::fromJson(feed).object();
+  int rows = 0;
+
+  for(auto it = SECTION_KEYS.constBegin(); it != SECTION_KEYS.constEnd(); ++it)
+  {
+    const QJsonArray array = root.value(it.key()).toArray();
+    for(const QJsonValue& value : array)
+    {
+      QJsonObject obj = value.toObject();
+      QStringList columns;
+      for(const QString& key : it.value())
+      {
+        QJsonValue keyValue = pathValue(obj, key);
+        if(keyValue.isArray())
+        {
+          QStringList lines;
+          const QJsonArray lineArray = keyValue.toArray();
+          for(const QJsonValue& line : lineArray)
+            lines.append(line.toString());
+          columns.append(lines.join('\n'));
+        }
+        else
+          columns.append(keyValue.toVariant().toString());
+      }
+      if(it.key() != "servers")
+        rows++;
+    }
+  }
+
+  // General section is read but not counted
+  QJsonObject general = root.value("general").toObject();
+  QDateTime::fromString(general.value("update_timestamp").toString(), Qt::ISODate);
+  return rows;
+}
+
+/* Parse transceivers into a document and read callsign, frequency and position. Returns number of transceivers. */
+int readTransceiversDocument(const QByteArray& transceivers)
+{
+  const QJsonArray array = QJsonDocument::fromJson(transceivers).array();
+  QMultiHash<QString, std::pair<int, QPointF> > transceiverMap;
+  for(const QJsonValue& value : array)
+  {
+    QJsonObject obj = value.toObject();
+    QString callsign = obj.value("callsign").toString();
+    const QJsonArray transceiverArray = obj.value("transceivers").toArray();
+    for(const QJsonValue& transceiverValue : transceiverArray)
+    {
+      QJsonObject transceiver = transceiverValue.toObject();
+      int frequency = static_cast<int>(transceiver.value("frequency").toDouble() / 1000.);
+      QPointF pos(transceiver.value("lonDeg").toDouble(), transceiver.value("latDeg").toDouble());
+      transceiverMap.insert(callsign, std::make_pair(frequency, pos));
+    }
+  }
+  return transceiverMap.size();
+}
+
+/* Generated feed and transceivers similar to a busy VATSIM network */
+QJsonObject flightplan(int i)
+{
+  return QJsonObject({
+    {"flight_rules", "I"}, {"aircraft", "B738/M-SDE2E3FGHIJ2J3J4J5M1RWXY/LB1"}, {"aircraft_faa", "H/B738/L"},
+    {"aircraft_short", "B738"}, {"departure", "EDDF"}, {"arrival", "LEPA"}, {"alternate", "LEIB"},
+    {"cruise_tas", "454"}, {"altitude", "37000"}, {"deptime", "1530"}, {"enroute_time", "0205"},
+    {"fuel_time", "0345"}, {"remarks", QString("PBN/A1B1C1D1O1S2 DOF/230101 REG/DABC%1 /v/").arg(i % 1000)},
+    {"route", "MARUN Y180 BITSI T161 DKB UN850 MAXIR UN853 ARPUS UN869 BADEP UM984 VERSO UN853 KUTEK UN975 MHN"},
+    {"revision_id", 1}, {"assigned_transponder", "0000"}
+  });
+}
+
+void generateFiles(int numPilots, QByteArray& feed, QByteArray& transceivers)
+{
+  QJsonArray pilots, controllers, atis, servers, prefiles, transceiverArr;
+  for(int i = 0; i < numPilots; i++)
+  {
+    double laty = -60. + (i % 1200) * 0.1, lonx = -180. + (i / 1200 % 3600) * 0.1;
+    QString callsign = QString("DLH%1").arg(i);
+    pilots.append(QJsonObject({
+      {"cid", 1000000 + i}, {"name", QString("Pilot %1").arg(i)}, {"callsign", callsign},
+      {"server", "GERMANY"}, {"pilot_rating", 0}, {"latitude", laty}, {"longitude", lonx},
+      {"altitude", 37000 - i % 500}, {"groundspeed", 450}, {"transponder", "2000"}, {"heading", i % 360},
+      {"qnh_i_hg", 29.92}, {"qnh_mb", 1013}, {"flight_plan", flightplan(i)},
+      {"logon_time", "2023-01-01T10:00:00.0000000Z"}, {"last_updated", "2023-01-01T12:00:00.0000000Z"}
+    }));
+    transceiverArr.append(QJsonObject({
+      {"callsign", callsign},
+      {"transceivers", QJsonArray({
+         QJsonObject({{"id", 0}, {"frequency", 122800000 + (i % 100) * 25000}, {"latDeg", laty}, {"lonDeg", lonx},
+                      {"heightMslM", 11000.}, {"heightAglM", 11000.}})
+       })}
+    }));
+
+    if(i % 5 == 0)
+    {
+      int num = i / 5;
+      QString atcCallsign = QString("EDDF_%1_TWR").arg(num);
+      controllers.append(QJsonObject({
+        {"cid", 2000000 + num}, {"name", QString("Controller %1").arg(num)}, {"callsign", atcCallsign},
+        {"frequency", "119.900"}, {"facility", 4}, {"rating", 5}, {"server", "GERMANY"}, {"visual_range", 50},
+        {"text_atis", QJsonArray({"Frankfurt Tower", "Information at vatger.de"})},
+        {"last_updated", "2023-01-01T12:00:00.0000000Z"}, {"logon_time", "2023-01-01T10:00:00.0000000Z"}
+      }));
+      transceiverArr.append(QJsonObject({
+        {"callsign", atcCallsign},
+        {"transceivers", QJsonArray({
+           QJsonObject({{"id", 0}, {"frequency", 119900000}, {"latDeg", laty}, {"lonDeg", lonx},
+                        {"heightMslM", 100.}, {"heightAglM", 30.}}),
+           QJsonObject({{"id", 1}, {"frequency", 119900000}, {"latDeg", laty + 0.5}, {"lonDeg", lonx},
+                        {"heightMslM", 100.}, {"heightAglM", 30.}})
+         })}
+      }));
+    }
+
+    if(i % 10 == 0)
+      prefiles.append(QJsonObject({
+        {"cid", 3000000 + i}, {"name", QString("Prefile %1").arg(i)}, {"callsign", QString("EWG%1").arg(i)},
+        {"flight_plan", flightplan(i)}, {"last_updated", "2023-01-01T12:00:00.0000000Z"}
+      }));
+  }
+
+  for(int i = 0; i < 10; i++)
+    servers.append(QJsonObject({
+      {"ident", QString("SERVER%1").arg(i)}, {"hostname_or_ip", QString("10.0.0.%1").arg(i)},
+      {"location", "Europe"}, {"name", QString("SERVER%1").arg(i)}, {"clients_connection_allowed", 1}
+    }));
+
+  QJsonObject root({
+    {"general", QJsonObject({
+       {"version", 3}, {"reload", 1}, {"update", "20230101120000"},
+       {"update_timestamp", "2023-01-01T12:00:00.0000000Z"},
+       {"connected_clients", pilots.size() + controllers.size()}, {"unique_users", pilots.size() + controllers.size()}
+     })},
+    {"pilots", pilots}, {"controllers", controllers}, {"atis", atis}, {"servers", servers}, {"prefiles", prefiles},
+    {"facilities", QJsonArray()}, {"ratings", QJsonArray()}, {"pilot_ratings", QJsonArray()}
+  });
+
+  feed = QJsonDocument(root).toJson(QJsonDocument::Compact);
+  transceivers = QJsonDocument(transceiverArr).toJson(QJsonDocument::Compact);
+}
+
+QByteArray readFile(const QString& filename)
+{
+  QFile file(filename);
+  if(!file.open(QIODevice::ReadOnly))
+    throw atools::Exception(QString("Cannot open \"%1\"").arg(filename));
+  return file.readAll();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  // Resources of the static library contain the database schema
+  Q_INIT_RESOURCE(atools);
+
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("whazzupbench");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Benchmark for the VATSIM JSON feed comparing SAX parser and QJsonDocument.");
+  parser.addHelpOption();
+  QCommandLineOption feedOpt(QStringList({"f", "feed"}), "VATSIM JSON version 3 feed. Generated if not given.",
+                             "file");
+  QCommandLineOption transceiversOpt(QStringList({"t", "transceivers"}),
+                                     "VATSIM transceivers file. Generated if not given.", "file");
+  QCommandLineOption pilotsOpt(QStringList({"p", "pilots"}), "Number of pilots for generated files.",
+                               "number", "5000");
+  QCommandLineOption methodOpt(QStringList({"m", "method"}), "Method \"sax\", \"document\" or \"both\".",
+                               "method", "both");
+  QCommandLineOption repeatOpt(QStringList({"r", "repeat"}), "Number of runs. The best time is printed.",
+                               "number", "5");
+  parser.addOptions({feedOpt, transceiversOpt, pilotsOpt, methodOpt, repeatOpt});
+  parser.process(app);
+
+  const int numPilots = parser.value(pilotsOpt).toInt(), repeat = parser.value(repeatOpt).toInt();
+  const QString method = parser.value(methodOpt);
+  if(numPilots <= 0 || repeat <= 0 || !QStringList({"sax", "document", "both"}).contains(method))
+  {
+    QTextStream(stderr) << "Invalid arguments" << endl;
+    return 2;
+  }
+
+  // Keep messages of the parser out of the output
+  QLoggingCategory::setFilterRules("*.debug=false\n*.info=false");
+
+  bool ok = true;
+  QTemporaryDir dir;
+  try
+  {
+    QByteArray feed, transceivers;
+    generateFiles(numPilots, feed, transceivers);
+    if(parser.isSet(feedOpt))
+      feed = readFile(parser.value(feedOpt));
+    if(parser.isSet(transceiversOpt))
+      transceivers = readFile(parser.value(transceiversOpt));
+
+    // Parser takes the file content as string
+    const QString feedStr = QString::fromUtf8(feed), transceiversStr = QString::fromUtf8(transceivers);
+    QTextStream(stdout) << "Feed " << feed.size() / 1024 << " KB, transceivers " << transceivers.size() / 1024
+                        << " KB" << endl;
+
+    Result saxFeed, saxTransceivers, documentFeed, documentTransceivers;
+    if(method == "sax" || method == "both")
+    {
+      SqlDatabase db = SqlDatabase::addDatabase("QSQLITE", "whazzupbench");
+      db.setDatabaseName(dir.filePath("online.sqlite"));
+      db.open();
+
+      {
+        WhazzupTextParser whazzup(&db, false);
+        // Parser does not expose the number of transceivers
+        saxTransceivers = measure(repeat, []() -> void {}, [&whazzup, &transceiversStr]() -> int {
+            whazzup.readTransceivers(transceiversStr);
+            return -1;
+          });
+      }
+
+      // Fresh tables and parser for each run so that all rows are inserted and counted in the changes
+      QScopedPointer<WhazzupTextParser> whazzup;
+      saxFeed = measure(repeat, [&db, &whazzup, &transceiversStr]() -> void {
+          SqlScript script(&db, false /* verbose */);
+          script.executeScript(":/atools/resources/sql/fs/online/create_online_schema.sql");
+          db.commit();
+          whazzup.reset(new WhazzupTextParser(&db, false));
+          whazzup->initQueries();
+          whazzup->readTransceivers(transceiversStr);
+        }, [&db, &whazzup, &feedStr]() -> int {
+          whazzup->read(feedStr, atools::fs::online::VATSIM_JSON3, QDateTime());
+          db.commit();
+          const atools::fs::online::OnlineChanges& changes = whazzup->getChanges();
+          return changes.clientsInserted.size() + changes.atcInserted.size();
+        });
+      whazzup.reset();
+
+      db.close();
+    }
+
+    if(method == "document" || method == "both")
+    {
+      documentTransceivers = measure(repeat, []() -> void {}, [&transceivers]() -> int {
+          return readTransceiversDocument(transceivers);
+        });
+      documentFeed = measure(repeat, []() -> void {}, [&feed]() -> int {
+          return readFeedDocument(feed);
+        });
+    }
+
+    if(method == "sax" || method == "both")
+    {
+      printResult("Transceivers SAX", saxTransceivers);
+      printResult("Feed SAX with database", saxFeed);
+    }
+    if(method == "document" || method == "both")
+    {
+      printResult("Transceivers QJsonDocument", documentTransceivers);
+      printResult("Feed QJsonDocument", documentFeed);
+    }
+
+    if(method == "both")
+    {
+      if(saxFeed.rows != documentFeed.rows)
+      {
+        QTextStream(stderr) << "Number of rows differs" << endl;
+        ok = false;
+      }
+    }
+  }
+  catch(const atools::Exception& e)
+  {
+    QTextStream(stderr) << "Error: " << e.getMessage() << endl;
+    return 1;
+  }
+  SqlDatabase::removeDatabase("whazzupbench");
+
+  return ok ? 0 : 1;
+}